@@ -0,0 +1,429 @@
+/**
+Class         : CSC-615-01 - Embedded Linux - Fall 2024
+Team Name     : Wayno
+Github        : nhannguyensf
+Project       : Final Assignment - Robot Car
+File          : bench.c
+Description:
+This file holds the microbenchmarks of the code the car runs on every control iteration: the line position, the
+color math and the float and table classification of a raw reading, a full pid_control tick in FOLLOWING_LINE
+against mock sensors, Motor_Run and the PCA9685 writes on the counting fake bus, and getCurrentDistances while
+the echo poll thread runs. It is linked from the car's
+objects, so it measures the flags the car was built with (make bench PROFILE=1 against make bench).
+Every benchmark runs one warmup pass and then a number of timed passes, the median, fastest and slowest pass are
+reported in ns per call. The JSON has the same benchmarks, keys and order on every run, so two builds can be
+compared line by line. The echo benchmark needs pigpio and root and only runs with -e, otherwise it is skipped.
+    car_bench [-n scale] [-r repeats] [-o json_file] [-e]
+*
+Team Members:
+Kiran Poudel
+Nhan Nguyen
+Yuvraj Gupta
+Fernando Abel Malca Luque
+
+*
+**/
+#include "pid.h"
+#include "tcs34725.h"
+#include "MotorDriver.h"
+#include "PCA9685.h"
+#include "echoSensor.h"
+#include "bus.h"
+#include "tlog.h"
+#include "Debug.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#define BENCH_SCHEMA 1
+#define DEFAULT_REPEATS 5
+#define MAX_REPEATS 101
+#define MOCK_PERIOD_US 10000
+#define MOCK_DISTANCE_CM 150.0  // Further than any threshold, so the controller keeps following the line
+#define NUM_COLORS 256
+
+typedef struct {
+    const char* name;
+    long iterations;
+    long (*run)(long iterations);  // Returns a value derived from the results so the calls are not optimized out
+    BusType bus;                   // Bus whose transfers are counted, BUS_NUM_TYPES for none
+    unsigned device;
+    int needs_echo;
+} Benchmark;
+
+typedef struct {
+    int skipped;
+    int repeats;
+    double median_ns;
+    double min_ns;
+    double max_ns;
+    double transactions;  // Bus transfers and bytes per call
+    double bytes;
+} BenchResult;
+
+static volatile long sink;
+
+// Inputs prepared once, so the timed loops only run the code under test
+static int line_patterns[1 << NUM_SENSORS][NUM_SENSORS];
+static uint8_t colors[NUM_COLORS][3];
+static hsv_t hsv_colors[NUM_COLORS];
+static float gamma_inputs[NUM_COLORS];
+static uint16_t readings[NUM_COLORS][4];  // Raw readings, the channels add up to about the clear channel
+
+static int64_t now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (int64_t)ts.tv_sec * 1000000000LL + ts.tv_nsec;
+}
+
+static void prepare_inputs(void) {
+    for (int mask = 0; mask < (1 << NUM_SENSORS); mask++) {
+        for (int i = 0; i < NUM_SENSORS; i++) {
+            line_patterns[mask][i] = (mask >> i) & 1;
+        }
+    }
+    unsigned seed = 1;
+    for (int i = 0; i < NUM_COLORS; i++) {
+        for (int c = 0; c < 3; c++) {
+            colors[i][c] = rand_r(&seed) & 0xff;
+        }
+        hsv_colors[i] = rgb_to_hsv(colors[i][0], colors[i][1], colors[i][2]);
+        gamma_inputs[i] = i / (float)(NUM_COLORS - 1);
+        readings[i][3] = 1 + rand_r(&seed) % 65535;
+        for (int c = 0; c < 3; c++) {
+            readings[i][c] = (uint16_t)((uint32_t)readings[i][3] * (rand_r(&seed) % 1001) / 1000);
+        }
+    }
+    color_tables_init();
+}
+
+// ---- Kernels ----
+
+static long run_line_position(long iterations) {
+    double sum = 0;
+    for (long i = 0; i < iterations; i++) {
+        sum += calculate_line_position(line_patterns[i & ((1 << NUM_SENSORS) - 1)]);
+    }
+    return (long)sum;
+}
+
+static long run_rgb_to_hsv(long iterations) {
+    float sum = 0;
+    for (long i = 0; i < iterations; i++) {
+        const uint8_t* c = colors[i & (NUM_COLORS - 1)];
+        sum += rgb_to_hsv(c[0], c[1], c[2]).hue;
+    }
+    return (long)sum;
+}
+
+static long run_apply_gamma(long iterations) {
+    long sum = 0;
+    for (long i = 0; i < iterations; i++) {
+        sum += apply_gamma(gamma_inputs[i & (NUM_COLORS - 1)], 2.2f);
+    }
+    return sum;
+}
+
+static long run_get_hsb_color(long iterations) {
+    long sum = 0;
+    for (long i = 0; i < iterations; i++) {
+        const hsv_t* hsv = &hsv_colors[i & (NUM_COLORS - 1)];
+        sum += get_hsb_color(hsv->hue, hsv->saturation, hsv->brightness).color;
+    }
+    return sum;
+}
+
+static long run_classify_color_float(long iterations) {
+    long sum = 0;
+    for (long i = 0; i < iterations; i++) {
+        const uint16_t* c = readings[i & (NUM_COLORS - 1)];
+        sum += classify_color_float(c[0], c[1], c[2], c[3]).color;
+    }
+    return sum;
+}
+
+static long run_classify_color(long iterations) {
+    long sum = 0;
+    for (long i = 0; i < iterations; i++) {
+        const uint16_t* c = readings[i & (NUM_COLORS - 1)];
+        sum += classify_color(c[0], c[1], c[2], c[3]).color;
+    }
+    return sum;
+}
+
+// ---- pid_control against mock sensors ----
+
+// Line under the sensors while following, every pattern has the line under at least one sensor
+static const uint8_t following_masks[] = {0x04, 0x0c, 0x08, 0x0c, 0x04, 0x06, 0x02, 0x06};
+#define NUM_FOLLOWING_MASKS (sizeof(following_masks) / sizeof(following_masks[0]))
+
+typedef struct {
+    int64_t now_us;
+    unsigned tick;
+    int left;
+    int right;
+} MockRobot;
+
+static void mock_begin_tick(void* ctx) {
+    MockRobot* robot = ctx;
+    robot->now_us += MOCK_PERIOD_US;
+    robot->tick++;
+}
+
+static int64_t mock_now_us(void* ctx) {
+    return ((MockRobot*)ctx)->now_us;
+}
+
+static void mock_read_line(void* ctx, int sensor_states[NUM_SENSORS]) {
+    uint8_t mask = following_masks[((MockRobot*)ctx)->tick % NUM_FOLLOWING_MASKS];
+    for (int i = 0; i < NUM_SENSORS; i++) {
+        sensor_states[i] = (mask >> i) & 1;
+    }
+}
+
+static int mock_get_distances(void* ctx, double distances[NUM_SENSORS]) {
+    for (int i = 0; i < NUM_SENSORS; i++) {
+        distances[i] = MOCK_DISTANCE_CM;
+    }
+    return 0;
+}
+
+// Encoders and color are read outside pid_control
+static int mock_read_encoders(void* ctx, int32_t counts[RIO_NUM_ENCODERS]) {
+    return -1;
+}
+
+static int mock_read_color(void* ctx, uint16_t rgbc[4]) {
+    return -1;
+}
+
+static void mock_motor_run(void* ctx, int left, int right) {
+    MockRobot* robot = ctx;
+    robot->left = left;
+    robot->right = right;
+}
+
+static int mock_refresh_params(void* ctx, ControlParams* params) {
+    return 0;
+}
+
+static const RobotIO mock_io = {
+    .name = "bench",
+    .begin_tick = mock_begin_tick,
+    .now_us = mock_now_us,
+    .read_line = mock_read_line,
+    .get_distances = mock_get_distances,
+    .read_encoders = mock_read_encoders,
+    .read_color = mock_read_color,
+    .motor_run = mock_motor_run,
+    .refresh_params = mock_refresh_params,
+};
+
+static MockRobot mock_robot;
+
+static long run_pid_control(long iterations) {
+    for (long i = 0; i < iterations; i++) {
+        pid_control();
+    }
+    return mock_robot.left - mock_robot.right;
+}
+
+// 1 when the car's controller is still in FOLLOWING_LINE
+static int still_following(void) {
+    const char* names[FR_MAX_STATES];
+    int count = pid_state_names(names, FR_MAX_STATES);
+    FrRecord rec;
+    pid_record(&rec);
+    return rec.state < count && strcmp(names[rec.state], "FOLLOWING_LINE") == 0;
+}
+
+// ---- Motor driver on the fake bus ----
+
+// The PCA9685 is never initialized here, the fake bus takes the writes on the default address 0
+static long run_motor_run(long iterations) {
+    for (long i = 0; i < iterations; i++) {
+        Motor_Run(i & 1 ? MOTORB : MOTORA, (int)(i % 201) - 100);
+    }
+    return iterations;
+}
+
+static long run_pca9685(long iterations) {
+    for (long i = 0; i < iterations; i++) {
+        PCA9685_SetPwmDutyCycle(PWMA, i % 101);
+    }
+    return iterations;
+}
+
+// ---- Echo distances ----
+
+static long run_get_distances(long iterations) {
+    double distances[NUM_SENSORS];
+    long sum = 0;
+    for (long i = 0; i < iterations; i++) {
+        sum += getCurrentDistances(distances);
+    }
+    return sum;
+}
+
+// The echo module prints while it starts, keep stdout for the JSON
+static int start_echo(void) {
+    fflush(stdout);
+    int saved = dup(STDOUT_FILENO);
+    dup2(STDERR_FILENO, STDOUT_FILENO);
+    int ret = initEchoSensors();
+    fflush(stdout);
+    dup2(saved, STDOUT_FILENO);
+    close(saved);
+    return ret;
+}
+
+static const Benchmark benchmarks[] = {
+    {"calculate_line_position", 2000000, run_line_position, BUS_NUM_TYPES, 0, 0},
+    {"rgb_to_hsv", 2000000, run_rgb_to_hsv, BUS_NUM_TYPES, 0, 0},
+    {"apply_gamma", 2000000, run_apply_gamma, BUS_NUM_TYPES, 0, 0},
+    {"get_hsb_color", 2000000, run_get_hsb_color, BUS_NUM_TYPES, 0, 0},
+    {"classify_color_float", 1000000, run_classify_color_float, BUS_NUM_TYPES, 0, 0},
+    {"classify_color", 2000000, run_classify_color, BUS_NUM_TYPES, 0, 0},
+    {"pid_control_following_line", 500000, run_pid_control, BUS_NUM_TYPES, 0, 0},
+    {"Motor_Run", 200000, run_motor_run, BUS_I2C, 0, 0},
+    {"PCA9685_SetPwmDutyCycle", 500000, run_pca9685, BUS_I2C, 0, 0},
+    {"getCurrentDistances_contended", 2000000, run_get_distances, BUS_NUM_TYPES, 0, 1},
+};
+#define NUM_BENCHMARKS (sizeof(benchmarks) / sizeof(benchmarks[0]))
+
+static int by_value(const void* a, const void* b) {
+    double da = *(const double*)a, db = *(const double*)b;
+    return (da > db) - (da < db);
+}
+
+static void run_benchmark(const Benchmark* bench, long iterations, int repeats, BenchResult* result) {
+    double ns[MAX_REPEATS];
+    sink += bench->run(iterations);  // Warmup, fills the caches and settles the clock frequency
+    bus_reset_stats();
+    for (int r = 0; r < repeats; r++) {
+        int64_t start = now_ns();
+        sink += bench->run(iterations);
+        ns[r] = (double)(now_ns() - start) / iterations;
+    }
+    qsort(ns, repeats, sizeof(ns[0]), by_value);
+    result->repeats = repeats;
+    result->median_ns = ns[repeats / 2];
+    result->min_ns = ns[0];
+    result->max_ns = ns[repeats - 1];
+    if (bench->bus != BUS_NUM_TYPES) {
+        BusStats stats;
+        bus_device_stats(bench->bus, bench->device, &stats);
+        double calls = (double)iterations * repeats;
+        result->transactions = atomic_load(&stats.transactions) / calls;
+        result->bytes = atomic_load(&stats.bytes) / calls;
+    }
+}
+
+static void write_json(FILE* out, const long* iterations, const BenchResult* results) {
+#ifdef ENABLE_PROFILING
+    const char* profiling = "true";
+#else
+    const char* profiling = "false";
+#endif
+#ifdef ENABLE_TRACING
+    const char* tracing = "true";
+#else
+    const char* tracing = "false";
+#endif
+    fprintf(out, "{\n");
+    fprintf(out, "  \"schema\": %d,\n", BENCH_SCHEMA);
+    fprintf(out, "  \"build\": {\"log_level\": %d, \"profiling\": %s, \"tracing\": %s},\n",
+            LOG_LEVEL, profiling, tracing);
+    fprintf(out, "  \"benchmarks\": [\n");
+    for (size_t i = 0; i < NUM_BENCHMARKS; i++) {
+        const BenchResult* r = &results[i];
+        fprintf(out, "    {\"name\": \"%s\", \"unit\": \"ns/op\", \"iterations\": %ld, \"repeats\": %d, ",
+                benchmarks[i].name, iterations[i], r->repeats);
+        if (r->skipped) {
+            fprintf(out, "\"skipped\": true");
+        } else {
+            fprintf(out, "\"skipped\": false, \"median\": %.3f, \"min\": %.3f, \"max\": %.3f",
+                    r->median_ns, r->min_ns, r->max_ns);
+        }
+        if (benchmarks[i].bus != BUS_NUM_TYPES) {
+            fprintf(out, ", \"bus_transactions_per_op\": %.3f, \"bus_bytes_per_op\": %.3f",
+                    r->transactions, r->bytes);
+        }
+        fprintf(out, "}%s\n", i + 1 < NUM_BENCHMARKS ? "," : "");
+    }
+    fprintf(out, "  ]\n");
+    fprintf(out, "}\n");
+}
+
+int main(int argc, char* argv[]) {
+    double scale = 1.0;
+    int repeats = DEFAULT_REPEATS;
+    const char* out_file = NULL;
+    int echo = 0;
+    int opt;
+    while ((opt = getopt(argc, argv, "n:r:o:e")) != -1) {
+        switch (opt) {
+            case 'n': scale = atof(optarg); break;
+            case 'r': repeats = atoi(optarg); break;
+            case 'o': out_file = optarg; break;
+            case 'e': echo = 1; break;
+            default:
+                fprintf(stderr, "Usage: %s [-n scale] [-r repeats] [-o json_file] [-e]\n", argv[0]);
+                return 2;
+        }
+    }
+    if (scale <= 0 || repeats < 1 || repeats > MAX_REPEATS) {
+        fprintf(stderr, "The scale must be positive and the repeats between 1 and %d\n", MAX_REPEATS);
+        return 2;
+    }
+
+    // Logs would measure the log file instead of the code
+    tlog_init("/dev/null", 0);
+    prepare_inputs();
+    rio_init(&mock_io, &mock_robot);
+    bus_fake_reset();
+    bus_init(&bus_fake_backend);
+    if (echo && start_echo() < 0) {
+        fprintf(stderr, "The echo sensors could not be started\n");
+        echo = 0;
+    }
+
+    long iterations[NUM_BENCHMARKS];
+    BenchResult results[NUM_BENCHMARKS];
+    memset(results, 0, sizeof(results));
+    for (size_t i = 0; i < NUM_BENCHMARKS; i++) {
+        iterations[i] = (long)(benchmarks[i].iterations * scale);
+        if (iterations[i] < 1) iterations[i] = 1;
+        if (benchmarks[i].needs_echo && !echo) {
+            results[i].skipped = 1;
+            results[i].repeats = repeats;
+            continue;
+        }
+        fprintf(stderr, "%s\n", benchmarks[i].name);
+        run_benchmark(&benchmarks[i], iterations[i], repeats, &results[i]);
+    }
+    if (echo) {
+        cleanupEchoSensors();
+    }
+
+    int status = 0;
+    if (!still_following()) {
+        fprintf(stderr, "pid_control left FOLLOWING_LINE, its numbers are not those of line following\n");
+        status = 1;
+    }
+
+    FILE* out = out_file ? fopen(out_file, "w") : stdout;
+    if (!out) {
+        perror(out_file);
+        tlog_shutdown();
+        return 1;
+    }
+    write_json(out, iterations, results);
+    if (out != stdout) {
+        fclose(out);
+    }
+    tlog_shutdown();
+    return status;
+}
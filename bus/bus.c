@@ -0,0 +1,308 @@
+/**
+Class         : CSC-615-01 - Embedded Linux - Fall 2024
+Team Name     : Wayno
+Github        : nhannguyensf
+Project       : Final Assignment - Robot Car
+File          : bus.c
+Description:
+This file contains the bus accounting layer. Every transfer is timed with the backend clock and its time on the
+wire is computed from the bits it puts on the bus (start, address and data bytes with their acknowledge bits and
+stop for I2C, eight bits a byte for SPI). The counters are kept per bus, per device and per call site; call
+sites register themselves on their first transfer. Utilization is tracked in one second windows so the report
+shows the last complete second and the busiest one next to the average.
+*
+Team Members:
+Kiran Poudel
+Nhan Nguyen
+Yuvraj Gupta
+Fernando Abel Malca Luque
+
+*
+**/
+#include "bus.h"
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+
+// Utilization of one bus in one second windows
+typedef struct {
+    _Atomic int64_t second;
+    _Atomic uint64_t wire_ns;       // Current second
+    _Atomic uint64_t last_wire_ns;  // Last complete second
+    _Atomic uint64_t peak_wire_ns;  // Busiest second
+    BusStats total;
+} BusWindow;
+
+static const BusBackend* backend = NULL;
+static int64_t start_ns = 0;
+static BusWindow buses[BUS_NUM_TYPES];
+static BusStats i2c_devices[BUS_I2C_ADDRESSES];
+static BusStats spi_devices[BUS_SPI_CS];
+static uint8_t handle_addr[BUS_MAX_HANDLES];
+
+static BusSite* sites[BUS_MAX_SITES];
+static _Atomic int num_sites = 0;
+static pthread_mutex_t site_lock = PTHREAD_MUTEX_INITIALIZER;
+
+static const char* const type_names[BUS_NUM_TYPES] = {"i2c", "spi"};
+
+static void clear_stats(BusStats* stats) {
+    atomic_store(&stats->transactions, 0);
+    atomic_store(&stats->bytes, 0);
+    atomic_store(&stats->errors, 0);
+    atomic_store(&stats->wall_ns, 0);
+    atomic_store(&stats->wire_ns, 0);
+}
+
+static void add_stats(BusStats* stats, unsigned bytes, int failed, uint64_t wall, uint64_t wire) {
+    atomic_fetch_add_explicit(&stats->transactions, 1, memory_order_relaxed);
+    atomic_fetch_add_explicit(&stats->bytes, bytes, memory_order_relaxed);
+    if (failed) atomic_fetch_add_explicit(&stats->errors, 1, memory_order_relaxed);
+    atomic_fetch_add_explicit(&stats->wall_ns, wall, memory_order_relaxed);
+    atomic_fetch_add_explicit(&stats->wire_ns, wire, memory_order_relaxed);
+}
+
+static void copy_stats(BusStats* out, BusStats* in) {
+    atomic_store(&out->transactions, atomic_load(&in->transactions));
+    atomic_store(&out->bytes, atomic_load(&in->bytes));
+    atomic_store(&out->errors, atomic_load(&in->errors));
+    atomic_store(&out->wall_ns, atomic_load(&in->wall_ns));
+    atomic_store(&out->wire_ns, atomic_load(&in->wire_ns));
+}
+
+void bus_reset_stats(void) {
+    for (int t = 0; t < BUS_NUM_TYPES; t++) {
+        clear_stats(&buses[t].total);
+        atomic_store(&buses[t].second, 0);
+        atomic_store(&buses[t].wire_ns, 0);
+        atomic_store(&buses[t].last_wire_ns, 0);
+        atomic_store(&buses[t].peak_wire_ns, 0);
+    }
+    for (int i = 0; i < BUS_I2C_ADDRESSES; i++) clear_stats(&i2c_devices[i]);
+    for (int i = 0; i < BUS_SPI_CS; i++) clear_stats(&spi_devices[i]);
+    int count = atomic_load(&num_sites);
+    for (int i = 0; i < count; i++) clear_stats(&sites[i]->stats);
+    start_ns = backend ? backend->now_ns() : 0;
+}
+
+void bus_init(const BusBackend* selected) {
+    backend = selected;
+    bus_reset_stats();
+}
+
+static void register_site(BusSite* site) {
+    pthread_mutex_lock(&site_lock);
+    if (!atomic_load(&site->registered)) {
+        int count = atomic_load(&num_sites);
+        if (count < BUS_MAX_SITES) {
+            sites[count] = site;
+            atomic_store(&num_sites, count + 1);
+        }
+        atomic_store(&site->registered, 1);
+    }
+    pthread_mutex_unlock(&site_lock);
+}
+
+// Move to a new one second window when the clock has passed into the next second
+static void roll_window(BusWindow* bus, int64_t now) {
+    int64_t second = now / 1000000000LL;
+    int64_t current = atomic_load_explicit(&bus->second, memory_order_relaxed);
+    if (second == current) return;
+    if (!atomic_compare_exchange_strong(&bus->second, &current, second)) return;
+
+    uint64_t done = atomic_exchange(&bus->wire_ns, 0);
+    // A gap of idle seconds leaves the last complete second empty
+    atomic_store(&bus->last_wire_ns, second == current + 1 ? done : 0);
+    if (done > atomic_load(&bus->peak_wire_ns)) {
+        atomic_store(&bus->peak_wire_ns, done);
+    }
+}
+
+// Count one finished transfer
+static void account(BusSite* site, BusType type, unsigned device, unsigned bytes, unsigned bits,
+                    int64_t start, int result) {
+    uint64_t hz = type == BUS_I2C ? BUS_I2C_HZ : BUS_SPI_BB_HZ;
+    uint64_t wire = (uint64_t)bits * 1000000000ull / hz;
+    if (backend->advance) {
+        backend->advance(wire);
+    }
+    int64_t end = backend->now_ns();
+    uint64_t wall = end > start ? (uint64_t)(end - start) : 0;
+    int failed = result < 0;
+
+    if (!atomic_load_explicit(&site->registered, memory_order_acquire)) {
+        register_site(site);
+    }
+    site->type = type;
+    site->device = device;
+    add_stats(&site->stats, bytes, failed, wall, wire);
+
+    BusStats* dev = type == BUS_I2C ? &i2c_devices[device % BUS_I2C_ADDRESSES] : &spi_devices[device % BUS_SPI_CS];
+    add_stats(dev, bytes, failed, wall, wire);
+
+    BusWindow* bus = &buses[type];
+    roll_window(bus, end);
+    atomic_fetch_add_explicit(&bus->wire_ns, wire, memory_order_relaxed);
+    add_stats(&bus->total, bytes, failed, wall, wire);
+}
+
+// Bits of an I2C write of len bytes: start, address, data, each byte with its acknowledge, stop
+static unsigned i2c_write_bits(unsigned len) {
+    return 1 + 9 + 9 * len + 1;
+}
+
+// Bits of an I2C register read: the register write, a repeated start, the address and len data bytes
+static unsigned i2c_read_bits(unsigned len) {
+    return 1 + 9 + 9 + 1 + 9 + 9 * len + 1;
+}
+
+// Transfers before bus_init fail, the message is only printed once
+static int no_backend(void) {
+    static _Atomic int reported = 0;
+    if (!atomic_exchange(&reported, 1)) {
+        fprintf(stderr, "bus: transfer before bus_init\n");
+    }
+    return -1;
+}
+
+static unsigned handle_device(int handle) {
+    return (handle >= 0 && handle < BUS_MAX_HANDLES) ? handle_addr[handle] : 0;
+}
+
+int bus_i2c_write(BusSite* site, uint8_t addr, const uint8_t* data, unsigned len) {
+    if (!backend) return no_backend();
+    int64_t start = backend->now_ns();
+    int ret = backend->i2c_write(addr, data, len);
+    account(site, BUS_I2C, addr, len, i2c_write_bits(len), start, ret);
+    return ret;
+}
+
+int bus_i2c_read_reg(BusSite* site, uint8_t addr, uint8_t reg, uint8_t* data, unsigned len) {
+    if (!backend) return no_backend();
+    int64_t start = backend->now_ns();
+    int ret = backend->i2c_read_reg(addr, reg, data, len);
+    account(site, BUS_I2C, addr, len + 1, i2c_read_bits(len), start, ret);
+    return ret;
+}
+
+int bus_i2c_open(unsigned i2c_bus, unsigned addr) {
+    if (!backend) return no_backend();
+    int handle = backend->i2c_open(i2c_bus, addr);
+    if (handle >= 0 && handle < BUS_MAX_HANDLES) {
+        handle_addr[handle] = (uint8_t)addr;
+    }
+    return handle;
+}
+
+int bus_i2c_close(int handle) {
+    if (!backend) return no_backend();
+    return backend->i2c_close(handle);
+}
+
+int bus_i2c_write_byte_data(BusSite* site, int handle, unsigned reg, unsigned value) {
+    if (!backend) return no_backend();
+    int64_t start = backend->now_ns();
+    int ret = backend->i2c_write_byte_data(handle, reg, value);
+    account(site, BUS_I2C, handle_device(handle), 2, i2c_write_bits(2), start, ret);
+    return ret;
+}
+
+int bus_i2c_read_byte_data(BusSite* site, int handle, unsigned reg) {
+    if (!backend) return no_backend();
+    int64_t start = backend->now_ns();
+    int ret = backend->i2c_read_byte_data(handle, reg);
+    account(site, BUS_I2C, handle_device(handle), 2, i2c_read_bits(1), start, ret);
+    return ret;
+}
+
+int bus_i2c_read_block_data(BusSite* site, int handle, unsigned reg, uint8_t* data, unsigned len) {
+    if (!backend) return no_backend();
+    int64_t start = backend->now_ns();
+    int ret = backend->i2c_read_block_data(handle, reg, data, len);
+    account(site, BUS_I2C, handle_device(handle), len + 1, i2c_read_bits(len), start, ret);
+    return ret;
+}
+
+int bus_spi_xfer(BusSite* site, unsigned cs, const char* tx, char* rx, unsigned len) {
+    if (!backend) return no_backend();
+    int64_t start = backend->now_ns();
+    int ret = backend->spi_xfer(cs, tx, rx, len);
+    account(site, BUS_SPI, cs, len, 8 * len, start, ret);
+    return ret;
+}
+
+void bus_device_stats(BusType type, unsigned device, BusStats* out) {
+    copy_stats(out, type == BUS_I2C ? &i2c_devices[device % BUS_I2C_ADDRESSES] : &spi_devices[device % BUS_SPI_CS]);
+}
+
+// Bus time of a call site: the wire time on the fake bus, the caller's time on real hardware
+static uint64_t site_time(const BusSite* site) {
+    uint64_t wall = atomic_load(&site->stats.wall_ns);
+    uint64_t wire = atomic_load(&site->stats.wire_ns);
+    return wall > wire ? wall : wire;
+}
+
+static int by_time(const void* a, const void* b) {
+    uint64_t ta = site_time(*(BusSite* const*)a);
+    uint64_t tb = site_time(*(BusSite* const*)b);
+    return (ta < tb) - (ta > tb);
+}
+
+static void print_stats(FILE* out, const char* label, BusStats* stats) {
+    fprintf(out, "  %-28s %9llu %9llu %10.3f %10.3f %6llu\n", label,
+            (unsigned long long)atomic_load(&stats->transactions), (unsigned long long)atomic_load(&stats->bytes),
+            atomic_load(&stats->wall_ns) / 1e6, atomic_load(&stats->wire_ns) / 1e6,
+            (unsigned long long)atomic_load(&stats->errors));
+}
+
+void bus_report(FILE* out, int top) {
+    if (!backend) return;
+    double elapsed = (backend->now_ns() - start_ns) / 1e9;
+    fprintf(out, "Bus traffic on the %s bus over %.1f s:\n", backend->name, elapsed);
+    for (int t = 0; t < BUS_NUM_TYPES; t++) {
+        BusWindow* bus = &buses[t];
+        if (atomic_load(&bus->total.transactions) == 0) continue;
+        double average = elapsed > 0 ? atomic_load(&bus->total.wire_ns) / (elapsed * 1e9) * 100.0 : 0.0;
+        double caller = elapsed > 0 ? atomic_load(&bus->total.wall_ns) / (elapsed * 1e9) * 100.0 : 0.0;
+        fprintf(out, "  %s utilization %.2f %% average, %.2f %% last second, %.2f %% peak second, "
+                     "callers blocked %.2f %% of the time\n", type_names[t], average,
+                atomic_load(&bus->last_wire_ns) / 1e7, atomic_load(&bus->peak_wire_ns) / 1e7, caller);
+    }
+
+    fprintf(out, "  %-28s %9s %9s %10s %10s %6s\n", "device", "xfers", "bytes", "wall ms", "wire ms", "errors");
+    char label[64];
+    for (unsigned a = 0; a < BUS_I2C_ADDRESSES; a++) {
+        if (atomic_load(&i2c_devices[a].transactions) == 0) continue;
+        snprintf(label, sizeof(label), "i2c 0x%02x", a);
+        print_stats(out, label, &i2c_devices[a]);
+    }
+    for (unsigned cs = 0; cs < BUS_SPI_CS; cs++) {
+        if (atomic_load(&spi_devices[cs].transactions) == 0) continue;
+        snprintf(label, sizeof(label), "spi cs gpio %u", cs);
+        print_stats(out, label, &spi_devices[cs]);
+    }
+
+    // Call sites sorted by bus time, the first ones are the top offenders
+    BusSite* sorted[BUS_MAX_SITES];
+    int count = 0;
+    int registered = atomic_load(&num_sites);
+    for (int i = 0; i < registered; i++) {
+        if (atomic_load(&sites[i]->stats.transactions) > 0) sorted[count++] = sites[i];
+    }
+    qsort(sorted, count, sizeof(BusSite*), by_time);
+
+    uint64_t total = 0;
+    for (int i = 0; i < count; i++) total += site_time(sorted[i]);
+    if (top > count) top = count;
+    fprintf(out, "  Top %d call sites by bus time:\n", top);
+    for (int i = 0; i < top; i++) {
+        BusSite* site = sorted[i];
+        const char* file = strrchr(site->file, '/');
+        file = file ? file + 1 : site->file;
+        snprintf(label, sizeof(label), "%s:%d", file, site->line);
+        fprintf(out, site->type == BUS_I2C ? "  %2d. %5.1f %% %-24s %-26s i2c 0x%02x, %llu xfers\n"
+                                           : "  %2d. %5.1f %% %-24s %-26s spi cs %u, %llu xfers\n",
+                i + 1, total ? site_time(site) * 100.0 / total : 0.0, label, site->function, site->device,
+                (unsigned long long)atomic_load(&site->stats.transactions));
+    }
+}
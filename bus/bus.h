@@ -0,0 +1,120 @@
+/**
+Class         : CSC-615-01 - Embedded Linux - Fall 2024
+Team Name     : Wayno
+Github        : nhannguyensf
+Project       : Final Assignment - Robot Car
+File          : bus.h
+Description:
+This file is the header file for the bus.c file. It declares the bus accounting layer that every I2C and SPI
+transfer of the car goes through: the PCA9685 writes (bcm2835 I2C), the TCS34725 reads (pigpio I2C) and the
+LS7366R transfers (pigpio bit banged SPI). Each transfer is handed to a backend, either the real hardware or a
+fake bus for host side runs, and counted per device address and per call site with its bytes, its wall time and
+its time on the wire. BUS_SITE() creates the call site record at the place it is written.
+*
+Team Members:
+Kiran Poudel
+Nhan Nguyen
+Yuvraj Gupta
+Fernando Abel Malca Luque
+
+*
+**/
+#ifndef BUS_H
+#define BUS_H
+
+#include <stdatomic.h>
+#include <stdint.h>
+#include <stdio.h>
+
+// Clock rates used for the time on the wire
+#define BUS_I2C_HZ 100000      // bcm2835 and pigpio default
+#define BUS_SPI_BB_HZ 100000   // Baud rate given to bbSPIOpen for the encoders
+
+#define BUS_MAX_HANDLES 64
+#define BUS_MAX_SITES 64
+#define BUS_I2C_ADDRESSES 128
+#define BUS_SPI_CS 32
+
+typedef enum {
+    BUS_I2C,
+    BUS_SPI,
+    BUS_NUM_TYPES
+} BusType;
+
+// Transfer counters, updated with atomic adds since several threads use the buses
+typedef struct {
+    _Atomic uint64_t transactions;
+    _Atomic uint64_t bytes;
+    _Atomic uint64_t errors;
+    _Atomic uint64_t wall_ns;  // Time the caller spent in the transfer
+    _Atomic uint64_t wire_ns;  // Time the transfer occupies the bus at its clock rate
+} BusStats;
+
+// One place in the code that uses a bus
+typedef struct {
+    const char* file;
+    int line;
+    const char* function;
+    _Atomic int registered;
+    BusType type;
+    unsigned device;  // I2C address or chip select of the last transfer
+    BusStats stats;
+} BusSite;
+
+// Every transfer through the site sets its type and device, and the first one registers it
+#define BUS_SITE() ({                                                                               \
+    static BusSite bus_site_ = {.file = __FILE__, .line = __LINE__, .function = __func__, .registered = 0, \
+                                .type = BUS_I2C, .device = 0, .stats = {0}};                        \
+    &bus_site_;                                                                                     \
+})
+
+// Backend that performs the transfers, all functions return a negative value on failure
+typedef struct {
+    const char* name;
+    // I2C with the slave address given on every call (bcm2835 style)
+    int (*i2c_write)(uint8_t addr, const uint8_t* data, unsigned len);
+    int (*i2c_read_reg)(uint8_t addr, uint8_t reg, uint8_t* data, unsigned len);
+    // I2C through handles (pigpio style)
+    int (*i2c_open)(unsigned i2c_bus, unsigned addr);
+    int (*i2c_close)(int handle);
+    int (*i2c_write_byte_data)(int handle, unsigned reg, unsigned value);
+    int (*i2c_read_byte_data)(int handle, unsigned reg);
+    int (*i2c_read_block_data)(int handle, unsigned reg, uint8_t* data, unsigned len);
+    // Bit banged SPI, tx and rx are both len bytes
+    int (*spi_xfer)(unsigned cs, const char* tx, char* rx, unsigned len);
+    // Clock used for wall time and the utilization windows
+    int64_t (*now_ns)(void);
+    // Let a simulated transfer take its time on the wire, NULL for real hardware
+    void (*advance)(uint64_t ns);
+} BusBackend;
+
+extern const BusBackend bus_real_backend;
+extern const BusBackend bus_fake_backend;
+
+// Select the backend and clear the counters, must be called before the first transfer
+void bus_init(const BusBackend* backend);
+
+int bus_i2c_write(BusSite* site, uint8_t addr, const uint8_t* data, unsigned len);
+int bus_i2c_read_reg(BusSite* site, uint8_t addr, uint8_t reg, uint8_t* data, unsigned len);
+int bus_i2c_open(unsigned i2c_bus, unsigned addr);
+int bus_i2c_close(int handle);
+int bus_i2c_write_byte_data(BusSite* site, int handle, unsigned reg, unsigned value);
+int bus_i2c_read_byte_data(BusSite* site, int handle, unsigned reg);
+int bus_i2c_read_block_data(BusSite* site, int handle, unsigned reg, uint8_t* data, unsigned len);
+int bus_spi_xfer(BusSite* site, unsigned cs, const char* tx, char* rx, unsigned len);
+
+// Clear all counters, e.g. between two runs on the fake bus
+void bus_reset_stats(void);
+// Totals of one device
+void bus_device_stats(BusType type, unsigned device, BusStats* out);
+// Print utilization, per device totals and the call sites using the most bus time
+void bus_report(FILE* out, int top);
+
+// Fake bus: a register file per I2C address, SPI reads return zeros. Its clock only moves by the time of
+// the transfers and by bus_fake_advance, so the utilization is that of the modeled car.
+void bus_fake_reset(void);
+void bus_fake_advance(uint64_t ns);
+void bus_fake_set_reg(uint8_t addr, uint8_t reg, uint8_t value);
+uint8_t bus_fake_get_reg(uint8_t addr, uint8_t reg);
+
+#endif
@@ -0,0 +1,149 @@
+/**
+Class         : CSC-615-01 - Embedded Linux - Fall 2024
+Team Name     : Wayno
+Github        : nhannguyensf
+Project       : Final Assignment - Robot Car
+File          : bus_fake.c
+Description:
+This file contains the fake backend of the bus accounting layer for host side runs. Every I2C address has a
+register file of 256 bytes, writes store into it starting at the register in the first byte and reads return
+consecutive registers. The TCS34725 color sensor's command byte is decoded into its register and auto-increment
+bit, so the driver's transfers read what the sensor would return. Handles map to the address they were opened for. SPI transfers succeed and read zeros.
+The clock is virtual: it moves by the wire time of each transfer and by bus_fake_advance.
+*
+Team Members:
+Kiran Poudel
+Nhan Nguyen
+Yuvraj Gupta
+Fernando Abel Malca Luque
+
+*
+**/
+#include "bus.h"
+#include <string.h>
+
+#define FAKE_TCS34725_ADDR 0x29
+#define FAKE_TCS34725_CMD 0x80
+#define FAKE_TCS34725_AUTO_INC 0x20
+#define FAKE_TCS34725_REG_MASK 0x1f
+
+static uint8_t registers[BUS_I2C_ADDRESSES][256];
+static int handles[BUS_MAX_HANDLES];  // Address of an open handle, -1 when closed
+static int handles_ready = 0;
+static _Atomic int64_t fake_clock_ns = 0;
+
+void bus_fake_reset(void) {
+    memset(registers, 0, sizeof(registers));
+    for (int i = 0; i < BUS_MAX_HANDLES; i++) handles[i] = -1;
+    handles_ready = 1;
+    atomic_store(&fake_clock_ns, 0);
+}
+
+void bus_fake_advance(uint64_t ns) {
+    atomic_fetch_add(&fake_clock_ns, (int64_t)ns);
+}
+
+void bus_fake_set_reg(uint8_t addr, uint8_t reg, uint8_t value) {
+    registers[addr % BUS_I2C_ADDRESSES][reg] = value;
+}
+
+uint8_t bus_fake_get_reg(uint8_t addr, uint8_t reg) {
+    return registers[addr % BUS_I2C_ADDRESSES][reg];
+}
+
+// Register the i-th byte of a transfer starting at reg goes to. The TCS34725 color sensor takes a command byte
+// instead of a register address: the low five bits are the register, and without the auto-increment bit every
+// byte of the transfer stays on that register.
+static uint8_t* fake_register(uint8_t addr, unsigned reg, unsigned i) {
+    addr %= BUS_I2C_ADDRESSES;
+    if (addr == FAKE_TCS34725_ADDR && (reg & FAKE_TCS34725_CMD)) {
+        unsigned step = (reg & FAKE_TCS34725_AUTO_INC) ? i : 0;
+        return &registers[addr][(reg + step) & FAKE_TCS34725_REG_MASK];
+    }
+    return &registers[addr][(uint8_t)(reg + i)];
+}
+
+static int fake_i2c_write(uint8_t addr, const uint8_t* data, unsigned len) {
+    if (len == 0) return 0;
+    uint8_t reg = data[0];
+    for (unsigned i = 1; i < len; i++) {
+        *fake_register(addr, reg, i - 1) = data[i];
+    }
+    return 0;
+}
+
+static int fake_i2c_read_reg(uint8_t addr, uint8_t reg, uint8_t* data, unsigned len) {
+    for (unsigned i = 0; i < len; i++) {
+        data[i] = *fake_register(addr, reg, i);
+    }
+    return 0;
+}
+
+// Address of a handle, or -1 when it is not open
+static int handle_address(int handle) {
+    if (!handles_ready || handle < 0 || handle >= BUS_MAX_HANDLES) return -1;
+    return handles[handle];
+}
+
+static int fake_i2c_open(unsigned i2c_bus, unsigned addr) {
+    (void)i2c_bus;
+    if (!handles_ready) bus_fake_reset();
+    for (int i = 0; i < BUS_MAX_HANDLES; i++) {
+        if (handles[i] < 0) {
+            handles[i] = addr % BUS_I2C_ADDRESSES;
+            return i;
+        }
+    }
+    return -1;
+}
+
+static int fake_i2c_close(int handle) {
+    if (handle_address(handle) < 0) return -1;
+    handles[handle] = -1;
+    return 0;
+}
+
+static int fake_i2c_write_byte_data(int handle, unsigned reg, unsigned value) {
+    int addr = handle_address(handle);
+    if (addr < 0) return -1;
+    *fake_register(addr, reg & 0xff, 0) = (uint8_t)value;
+    return 0;
+}
+
+static int fake_i2c_read_byte_data(int handle, unsigned reg) {
+    int addr = handle_address(handle);
+    if (addr < 0) return -1;
+    return *fake_register(addr, reg & 0xff, 0);
+}
+
+static int fake_i2c_read_block_data(int handle, unsigned reg, uint8_t* data, unsigned len) {
+    int addr = handle_address(handle);
+    if (addr < 0) return -1;
+    fake_i2c_read_reg((uint8_t)addr, (uint8_t)reg, data, len);
+    return (int)len;
+}
+
+static int fake_spi_xfer(unsigned cs, const char* tx, char* rx, unsigned len) {
+    (void)cs;
+    (void)tx;
+    memset(rx, 0, len);
+    return (int)len;
+}
+
+static int64_t fake_now_ns(void) {
+    return atomic_load(&fake_clock_ns);
+}
+
+const BusBackend bus_fake_backend = {
+    .name = "fake",
+    .i2c_write = fake_i2c_write,
+    .i2c_read_reg = fake_i2c_read_reg,
+    .i2c_open = fake_i2c_open,
+    .i2c_close = fake_i2c_close,
+    .i2c_write_byte_data = fake_i2c_write_byte_data,
+    .i2c_read_byte_data = fake_i2c_read_byte_data,
+    .i2c_read_block_data = fake_i2c_read_block_data,
+    .spi_xfer = fake_spi_xfer,
+    .now_ns = fake_now_ns,
+    .advance = bus_fake_advance,
+};
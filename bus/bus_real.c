@@ -0,0 +1,100 @@
+/**
+Class         : CSC-615-01 - Embedded Linux - Fall 2024
+Team Name     : Wayno
+Github        : nhannguyensf
+Project       : Final Assignment - Robot Car
+File          : bus_real.c
+Description:
+This file contains the hardware backend of the bus accounting layer. The address based I2C transfers of the
+motor board go to the bcm2835 library, the handle based I2C transfers of the color sensor and the bit banged SPI
+of the encoders go to pigpio.
+*
+Team Members:
+Kiran Poudel
+Nhan Nguyen
+Yuvraj Gupta
+Fernando Abel Malca Luque
+
+*
+**/
+#include "bus.h"
+#include <pigpio.h>
+#include <time.h>
+#ifdef USE_BCM2835_LIB
+#include <bcm2835.h>
+#endif
+
+#ifdef USE_BCM2835_LIB
+// Slave address the bcm2835 controller is set to, only changed when another device is addressed
+static uint8_t slave_address = 0xff;
+
+static void select_slave(uint8_t addr) {
+    if (addr != slave_address) {
+        bcm2835_i2c_setSlaveAddress(addr);
+        slave_address = addr;
+    }
+}
+#endif
+
+static int real_i2c_write(uint8_t addr, const uint8_t* data, unsigned len) {
+#ifdef USE_BCM2835_LIB
+    select_slave(addr);
+    return bcm2835_i2c_write((const char*)data, len) == BCM2835_I2C_REASON_OK ? 0 : -1;
+#else
+    return -1;
+#endif
+}
+
+static int real_i2c_read_reg(uint8_t addr, uint8_t reg, uint8_t* data, unsigned len) {
+#ifdef USE_BCM2835_LIB
+    select_slave(addr);
+    char regaddr = (char)reg;
+    return bcm2835_i2c_read_register_rs(&regaddr, (char*)data, len) == BCM2835_I2C_REASON_OK ? 0 : -1;
+#else
+    return -1;
+#endif
+}
+
+static int real_i2c_open(unsigned i2c_bus, unsigned addr) {
+    return i2cOpen(i2c_bus, addr, 0);
+}
+
+static int real_i2c_close(int handle) {
+    return i2cClose(handle);
+}
+
+static int real_i2c_write_byte_data(int handle, unsigned reg, unsigned value) {
+    return i2cWriteByteData(handle, reg, value);
+}
+
+static int real_i2c_read_byte_data(int handle, unsigned reg) {
+    return i2cReadByteData(handle, reg);
+}
+
+static int real_i2c_read_block_data(int handle, unsigned reg, uint8_t* data, unsigned len) {
+    return i2cReadI2CBlockData(handle, reg, (char*)data, len);
+}
+
+static int real_spi_xfer(unsigned cs, const char* tx, char* rx, unsigned len) {
+    return bbSPIXfer(cs, (char*)tx, rx, len);
+}
+
+static int64_t real_now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (int64_t)ts.tv_sec * 1000000000LL + ts.tv_nsec;
+}
+
+const BusBackend bus_real_backend = {
+    .name = "real",
+    .i2c_write = real_i2c_write,
+    .i2c_read_reg = real_i2c_read_reg,
+    .i2c_open = real_i2c_open,
+    .i2c_close = real_i2c_close,
+    .i2c_write_byte_data = real_i2c_write_byte_data,
+    .i2c_read_byte_data = real_i2c_read_byte_data,
+    .i2c_read_block_data = real_i2c_read_block_data,
+    .spi_xfer = real_spi_xfer,
+    .now_ns = real_now_ns,
+    .advance = NULL,
+};
@@ -0,0 +1,148 @@
+/**
+Class         : CSC-615-01 - Embedded Linux - Fall 2024
+Team Name     : Wayno
+Github        : nhannguyensf
+Project       : Final Assignment - Robot Car
+File          : bus_sim.c
+Description:
+This file is a host side run of the car's bus traffic on the fake bus. Every control period both motors are set
+through the real PCA9685 driver (one duty cycle and two direction levels each, as Motor_Run does), both encoders
+are read over SPI and the color is read by the real TCS34725 driver's read_color_data, so the report shows the
+transactions and bus time of the drivers the car runs. Before the run read_color_data is checked on a fake
+TCS34725 holding known channel values, with and without the AVALID status bit.
+    bus_sim [-s seconds] [-p period_us] [-c color_every]
+*
+Team Members:
+Kiran Poudel
+Nhan Nguyen
+Yuvraj Gupta
+Fernando Abel Malca Luque
+
+*
+**/
+#include "bus.h"
+#include "DEV_Config.h"
+#include "PCA9685.h"
+#include "MotorDriver.h"
+#include "tcs34725.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#define PCA9685_ADDR 0x40
+#define ENCODER_CS_A 8
+#define ENCODER_CS_B 7
+
+static const char readCounterMsg[5] = {0x60, 0, 0, 0, 0};
+
+// Same register traffic as Motor_Run
+static void run_motor(UBYTE pwm, UBYTE in1, UBYTE in2, int speed) {
+    PCA9685_SetPwmDutyCycle(pwm, speed < 0 ? -speed : speed);
+    PCA9685_SetLevel(in1, speed < 0);
+    PCA9685_SetLevel(in2, speed >= 0);
+}
+
+// Read known channel values through the driver on a fake sensor, returns -1 when they do not come back
+static int check_color_read(void) {
+    static const uint8_t channels[8] = {0x34, 0x12, 0x78, 0x56, 0xbc, 0x9a, 0xf0, 0xde};
+    bus_fake_reset();
+    for (int i = 0; i < 8; i++) {
+        bus_fake_set_reg(TCS34725_ADDR, TCS34725_CDATAL + i, channels[i]);
+    }
+    int color = bus_i2c_open(1, TCS34725_ADDR);
+    uint16_t r, g, b, c;
+    int before = read_color_data(color, &r, &g, &b, &c);  // No integration has completed yet
+    bus_fake_set_reg(TCS34725_ADDR, TCS34725_STATUS, TCS34725_STATUS_AVALID);
+    int after = read_color_data(color, &r, &g, &b, &c);
+    bus_i2c_close(color);
+    if (before != TCS34725_NOT_VALID || after != 0 || r != 0x5678 || g != 0x9abc || b != 0xdef0 || c != 0x1234) {
+        fprintf(stderr, "Color read check failed: status %d then %d, r %04x g %04x b %04x c %04x instead of "
+                        "r 5678 g 9abc b def0 c 1234\n", before, after, r, g, b, c);
+        return -1;
+    }
+    printf("Color read check passed: r %04x g %04x b %04x c %04x, AVALID honored\n", r, g, b, c);
+    return 0;
+}
+
+// Run the car's traffic for the given time, returns the color sensor's totals and the number of color reads
+static long run(double seconds, long period_us, int color_every, BusStats* color_stats) {
+    bus_fake_reset();
+    bus_reset_stats();
+    PCA9685_Init(PCA9685_ADDR);
+    PCA9685_SetPWMFreq(200);
+    int color = bus_i2c_open(1, TCS34725_ADDR);
+
+    long ticks = (long)(seconds * 1e6 / period_us);
+    int64_t next = bus_fake_backend.now_ns();
+    char rx[5];
+    uint16_t r, g, b, c;
+    long color_reads = 0;
+    for (long tick = 0; tick < ticks; tick++) {
+        int speed = (int)(tick % 200) - 100;
+        run_motor(PWMA, AIN1, AIN2, speed);
+        run_motor(PWMB, BIN1, BIN2, -speed);
+        bus_spi_xfer(BUS_SITE(), ENCODER_CS_A, readCounterMsg, rx, 5);
+        bus_spi_xfer(BUS_SITE(), ENCODER_CS_B, readCounterMsg, rx, 5);
+        if (tick % color_every == 0) {
+            read_color_data(color, &r, &g, &b, &c);
+            color_reads++;
+        }
+
+        // Idle until the next period, a tick longer than the period starts the next one late
+        next += period_us * 1000LL;
+        int64_t now = bus_fake_backend.now_ns();
+        if (now < next) {
+            bus_fake_advance(next - now);
+        }
+    }
+
+    printf("\n");
+    bus_report(stdout, 10);
+    bus_device_stats(BUS_I2C, TCS34725_ADDR, color_stats);
+    bus_i2c_close(color);
+    return color_reads;
+}
+
+static void print_per_read(const BusStats* stats, long reads) {
+    double n = reads > 0 ? reads : 1;
+    printf("\nColor sensor: %.1f ms on the wire, %.1f transactions %.1f bytes %.1f us on the wire per read\n",
+           atomic_load(&stats->wire_ns) / 1e6, atomic_load(&stats->transactions) / n, atomic_load(&stats->bytes) / n,
+           atomic_load(&stats->wire_ns) / n / 1e3);
+}
+
+int main(int argc, char* argv[]) {
+    double seconds = 10.0;
+    long period_us = 10000;
+    int color_every = 1;
+    int opt;
+    while ((opt = getopt(argc, argv, "s:p:c:")) != -1) {
+        switch (opt) {
+            case 's':
+                seconds = atof(optarg);
+                break;
+            case 'p':
+                period_us = atol(optarg);
+                break;
+            case 'c':
+                color_every = atoi(optarg);
+                break;
+            default:
+                fprintf(stderr, "Usage: %s [-s seconds] [-p period_us] [-c color_every]\n", argv[0]);
+                return 1;
+        }
+    }
+    if (seconds <= 0 || period_us <= 0 || color_every <= 0) {
+        fprintf(stderr, "seconds, period and color_every must be positive\n");
+        return 1;
+    }
+
+    bus_init(&bus_fake_backend);
+    if (check_color_read() < 0) {
+        return 1;
+    }
+    BusStats color_stats;
+    long color_reads = run(seconds, period_us, color_every, &color_stats);
+    print_per_read(&color_stats, color_reads);
+    return 0;
+}
@@ -8,7 +8,22 @@ Description:
 This file is the main file for the robot car project. 
 It initializes all the systems, including the motor system, echo sensors, encoders, and the TCS34725 sensor. 
 It then enters the main control loop, which uses a PID controller to control the car's movement. 
-The control loop also uses the TCS34725 sensor to detect the color of the LED and adjust the car's movement accordingly. 
+The control loop runs at a fixed rate through the control executive; the command line options are described
+at parseOptions. The sensors are sampled on the sensor hub thread, and every control tick reads one consistent
+snapshot of them without locks. While the car runs, the control parameters live in a shared memory block that
+the paramctl tool can change, and the PID gains are loaded from pid_gains.conf when it exists.
+Messages from the control loop are written to the binary log car.tlog, which tlog_decode turns into text.
+Every control iteration is kept in the flight recorder file car.flight (the previous run in car.flight.1),
+fr_export writes a time window of it as CSV.
+The TCS34725 color sensor is read on its own thread once per integration, with an integration time and gain
+that follow the light, and the control loop only checks the class that thread has published after seeing it
+for a few readings in a row. The classes come from color_cal.conf and what the car does on each from
+color_actions.conf; without a calibration the car stops on red.
+Sending SIGUSR2 prints the loop timing statistics, how old each input was when the control loop used it, the
+time from reading the line sensors to the motor command that reacts to them and the I2C and SPI bus traffic.
+When built with make PROFILE=1, sending SIGUSR1 prints the latency percentiles of every stage of the control
+loop and writes them to car_prof.json. When built with make TRACE=1, a timeline of the control, echo and I2C
+activity is written to car_trace.json at exit.
 The program exits when the user presses Ctrl+C, and all systems are cleaned up.
 *
 Team Members:
@@ -20,6 +35,7 @@ Fernando Abel Malca Luque
 *
 **/ 
 #include "car.h"
+#include <errno.h>
 #include <fcntl.h>
 #include <poll.h>
 #include <sys/mman.h>
@@ -31,9 +47,31 @@ Fernando Abel Malca Luque
 #include <pigpio.h>
 #include <bcm2835.h>
 #include <signal.h>
+#include "executive/control_exec.h"
+#include "prof/prof.h"
+#include "trace/trace.h"
+#include "bus/bus.h"
+#include "robotio/robotio.h"
+#include "hub/sensor_hub.h"
+#include "pipeline/pipeline.h"
+#include "events/evloop.h"
+#include "events/gpio_events.h"
+#include "rgb/color_monitor.h"
+#include "rgb/color_cal.h"
+#include "rgb/color_exposure.h"
 
 volatile sig_atomic_t stop = 0; 
-static int color_result = 0;
+static int tuneRule = -1;
+static Autotune autotune;
+static int autotuneResult = 0;
+static const char* recordPath = NULL;
+static const char* calibrateName = NULL;
+static bool pipelineMode = false;
+static bool eventMode = false;
+static ColorCalibration colorCalibration;
+static const ColorCalibration* colorCal = NULL;  // NULL when the built in red test is used
+static ColorAction colorActions[COLOR_CAL_MAX_CLASSES];
+static int colorClass = -1;
 
 // Signal handler to stop the motor safely and set stop flag
 void Handler(int signo)
@@ -43,59 +81,522 @@ void Handler(int signo)
     stop = 1;
 }
 
+// Signal handler to request a dump of the control loop statistics
+void StatsHandler(int signo)
+{
+    exec_request_dump();
+}
+
+// Signal handler to request a dump of the stage latency histograms
+void ProfHandler(int signo)
+{
+    prof_request_dump();
+}
+
+// Statistics printed on SIGUSR2 next to the loop timing
+static void dumpStats(FILE* out)
+{
+    pid_print_stats(out);
+    if (eventMode) {
+        evloop_print_stats(out);
+    } else {
+        sensor_hub_print_stats(out);
+    }
+    if (pipelineMode) {
+        pipeline_print_stats(out);
+    }
+    ColorMonitorStats color;
+    color_monitor_get_stats(&color);
+    fprintf(out, "Color monitor: %llu readings, %llu before the first integration, %llu errors, %llu changes, "
+            "%llu exposure changes, exposure step %d\n", (unsigned long long)color.readings,
+            (unsigned long long)color.not_valid, (unsigned long long)color.errors, (unsigned long long)color.changes,
+            (unsigned long long)color.exposure_changes, color.exposure_step);
+    bus_report(out, 10);
+}
+
+// Append what this iteration saw and commanded to the flight recorder.
+// The encoder counts come from the tick's sensor snapshot.
+static void recordIteration(void)
+{
+    PROF_BEGIN(PROF_RECORDER);
+    FrRecord rec;
+    pid_record(&rec);
+    int32_t counts[RIO_NUM_ENCODERS];
+    if (rio_read_encoders(counts) == 0) {
+        rec.encoders[0] = counts[0];
+        rec.encoders[1] = counts[1];
+        rec.flags |= FR_FLAG_ENCODER_VALID;
+    }
+    fr_append(&rec);
+    PROF_END(PROF_RECORDER);
+}
+
+// One iteration of the main control loop
+static void controlTick(void)
+{
+    // Use PID control to adjust the car's movement based on sensor feedback.
+    pid_control();
+    recordIteration();
+    // Act on a new color class, the color monitor has already filtered the readings
+    int64_t since;
+    int cls = color_monitor_class(&since);
+    if (cls == colorClass) {
+        return;
+    }
+    colorClass = cls;
+    if (cls < 0) {
+        return;
+    }
+    ColorAction action = colorCal ? colorActions[cls] : COLOR_ACTION_STOP;
+    if (action != COLOR_ACTION_NONE) {
+        LOG_INFO("Seeing %s since %lld us, %s\n", colorCal ? colorCal->classes[cls].name : "red", (long long)since,
+                 color_action_name(action));
+    }
+    if (action == COLOR_ACTION_STOP) {
+        stop = 1;
+    }
+}
+
+// One iteration of the relay autotune experiment
+static void autotuneTick(void)
+{
+    autotuneResult = pid_autotune_tick(&autotune);
+    recordIteration();
+    if (autotuneResult != 0) {
+        stop = 1;
+    }
+}
+
+// Derive the gains from a finished autotune experiment and save them
+static void saveAutotuneGains(void)
+{
+    PidGains gains;
+    if (autotuneResult != 1 || autotune_gains(&autotune, tuneRule, &gains) < 0) {
+        printf("Autotune did not finish, gains unchanged\n");
+        return;
+    }
+    printf("Autotune: Ku %.3f, Tu %.3f s -> %s gains kp %.3f ki %.3f kd %.4f\n",
+           autotune.ku, autotune.tu, tune_rule_name(tuneRule), gains.kp, gains.ki, gains.kd);
+    if (gains_save(GAINS_FILE, &gains) < 0) {
+        printf("Failed to write %s\n", GAINS_FILE);
+    } else {
+        printf("Gains written to %s\n", GAINS_FILE);
+    }
+}
+
+// Record the marker under the sensor as the color class of the given name
+static int calibrateColor(const char* name)
+{
+    // Start without classes only when there is no calibration yet, saving would drop the classes of a file that
+    // cannot be read
+    if (color_cal_load(&colorCalibration, COLOR_CAL_FILE) < 0) {
+        if (errno != ENOENT) {
+            printf("Cannot read %s, fix or remove it before adding a class\n", COLOR_CAL_FILE);
+            return 1;
+        }
+        color_cal_init(&colorCalibration);
+    }
+    if (gpioInitialise() < 0) {
+        printf("Failed to initialize pigpio\n");
+        return 1;
+    }
+    bus_init(&bus_real_backend);
+    int step = COLOR_EXPOSURE_REF_STEP;
+    ColorExposure exposure = color_exposure_step(step);
+    int tcs34725 = init_TCS34725(exposure.atime, exposure.gain);
+    if (tcs34725 < 0 || set_led_brightness(LED_PIN, 100) < 0) {
+        printf("Failed to initialize the TCS34725 sensor\n");
+        gpioTerminate();
+        return 1;
+    }
+
+    // One reading per integration with the same auto exposure as the color monitor, the sensor reports a reading
+    // as not valid until the first integration has completed
+    signal(SIGINT, Handler);
+    printf("Reading %s, keep the sensor over the marker...\n", name);
+    ColorCalAccum accum;
+    color_cal_accum_init(&accum);
+    long wait_us = tcs34725_integration_us(exposure.atime);
+    int attempts = 0;
+    while (!stop && accum.n < COLOR_CAL_SAMPLES && attempts++ < 4 * COLOR_CAL_SAMPLES) {
+        usleep(wait_us);
+        wait_us = tcs34725_integration_us(exposure.atime);
+        uint16_t raw[4];
+        if (read_color_data(tcs34725, &raw[0], &raw[1], &raw[2], &raw[3]) != 0) {
+            continue;
+        }
+        int next = color_exposure_next(step, raw[3]);
+        if (next != step && color_exposure_apply(tcs34725, next) == 0) {
+            step = next;
+            exposure = color_exposure_step(step);
+            // Let the integration in progress finish before the first one at the new exposure
+            wait_us += tcs34725_integration_us(exposure.atime);
+            continue;
+        }
+        uint32_t rgbc[4];
+        double f[COLOR_CAL_FEATURES];
+        color_exposure_scale(step, raw, rgbc);
+        if (color_cal_features(rgbc[0], rgbc[1], rgbc[2], rgbc[3], f) == 0) {
+            color_cal_accum_add(&accum, f);
+        }
+    }
+    set_led_brightness(LED_PIN, 0);
+    bus_i2c_close(tcs34725);
+    gpioTerminate();
+
+    if (color_cal_set_class(&colorCalibration, name, &accum) < 0) {
+        printf("Only %ld readings or too many classes, %s not calibrated\n", accum.n, name);
+        return 1;
+    }
+    if (color_cal_save(&colorCalibration, COLOR_CAL_FILE) < 0) {
+        printf("Failed to write %s\n", COLOR_CAL_FILE);
+        return 1;
+    }
+    printf("%s from %ld readings at exposure step %d: red %.3f green %.3f blue %.3f of clear, log2(clear) %.2f, "
+           "written to %s\n", name, accum.n, step, accum.mean[0], accum.mean[1], accum.mean[2], accum.mean[3],
+           COLOR_CAL_FILE);
+    return 0;
+}
+
+// Load the color classes and their actions, the built in red test is used without a calibration
+static void loadColorCalibration(void)
+{
+    if (color_cal_load(&colorCalibration, COLOR_CAL_FILE) < 0 || colorCalibration.num_classes == 0
+        || color_cal_build(&colorCalibration) < 0) {
+        printf("No usable color calibration in %s, stopping on red\n", COLOR_CAL_FILE);
+        return;
+    }
+    colorCal = &colorCalibration;
+    if (color_actions_load(COLOR_ACTIONS_FILE, colorCal, colorActions) < 0) {
+        printf("Color actions from %s incomplete, red stops the car\n", COLOR_ACTIONS_FILE);
+    }
+    for (int c = 0; c < colorCal->num_classes; c++) {
+        printf("Color class %s: %s\n", colorCal->classes[c].name, color_action_name(colorActions[c]));
+    }
+}
+
+// ---- Event loop mode ----
+
+static void eventControlTick(void* ctx, uint64_t expirations)
+{
+    controlTick();
+    if (stop) {
+        evloop_stop();
+    }
+}
+
+// A line sensor changed, run a control tick now instead of at the next period
+static int64_t lineEdges(void* ctx, int fd)
+{
+    GpioEvent events[GPIO_EVENTS_BUFFER];
+    int64_t first = 0;
+    int count;
+    while ((count = gpio_events_read(fd, events, GPIO_EVENTS_BUFFER)) > 0) {
+        if (first == 0) {
+            first = events[0].time_us;
+        }
+    }
+    if (first > 0) {
+        eventControlTick(ctx, 1);
+    }
+    return first;
+}
+
+static void echoPing(void* ctx, uint64_t expirations)
+{
+    echoEventsPing();
+}
+
+// The control tick reads the counts polled last, the SPI transfers run on their own timer
+static void encoderPoll(void* ctx, uint64_t expirations)
+{
+    rio_hw_poll_encoders();
+}
+
+static int64_t echoEdges(void* ctx, int fd)
+{
+    return echoEventsHandle(fd);
+}
+
+static void eventSignal(void* ctx, int signo)
+{
+    if (signo == SIGINT) {
+        Handler(signo);
+        evloop_stop();
+    } else if (signo == SIGUSR2) {
+        // Handlers run on the loop's thread, so the statistics can be printed right away
+        dumpStats(stdout);
+    } else if (signo == SIGUSR1) {
+        prof_request_dump();
+    }
+}
+
+// Run the control loop, the echo sensors and the signals on the event loop until stop
+static void runEventLoop(long period_us, int echoFd, const sigset_t* signals)
+{
+    static const unsigned linePins[] = {SENSOR_0_PIN, SENSOR_1_PIN, SENSOR_2_PIN, SENSOR_3_PIN, SENSOR_4_PIN};
+    rio_hw_poll_encoders();
+    if (evloop_init() < 0 || evloop_add_signals(signals, eventSignal, NULL) < 0
+        || evloop_add_timer("control", period_us, eventControlTick, NULL) < 0
+        || evloop_add_timer("encoders", HUB_ENCODER_EVERY * period_us, encoderPoll, NULL) < 0
+        || evloop_add_timer("echo_ping", ECHO_PING_PERIOD_US, echoPing, NULL) < 0
+        || evloop_add_fd("echo", echoFd, echoEdges, NULL) < 0) {
+        printf("Failed to set up the event loop\n");
+        evloop_close();
+        return;
+    }
+    int lineFd = gpio_events_open(linePins, NUM_SENSORS, "car-line");
+    if (lineFd < 0 || evloop_add_fd("line", lineFd, lineEdges, NULL) < 0) {
+        printf("Line sensor edges disabled, the line is read on every tick\n");
+    }
+    evloop_run();
+    evloop_close();
+    gpio_events_close(lineFd);
+}
+
+// Parse the command line:
+//     car [-p period_us] [-r rt_priority] [-c cpu] [-m] [-t rule] [-R recording] [-k color] [-P] [-E]
+// -p, -r, -c and -m set the period, real time priority, CPU and memory locking of the control executive.
+// -t runs a relay autotune experiment on the line instead, derives new gains with the given rule (zn, pessen,
+// some-overshoot, no-overshoot, tyreus-luyben) and writes them to pid_gains.conf.
+// -R records every sensor read, clock read and motor command of the control loop to the given file, and
+// rio_replay feeds the recording back through pid_control to check that the motor commands come out the same.
+// -k only calibrates: it takes COLOR_CAL_SAMPLES readings of the marker under the sensor and stores them as the
+// class of that name in color_cal.conf, e.g. car -k green.
+// -P runs the control loop as a pipeline: the sensor hub on CPU 1, the control tick on every snapshot on CPU 2
+// (or the -c CPU) and the motor writes on CPU 3, all at the -r priority. The hub hands its snapshots over through
+// a lock-free queue and the control tick its motor command through a slot that always holds the newest one.
+// -E runs everything on a single threaded event loop: the control ticks and the encoder reads, every fifth
+// period like the hub's, come from timerfds, the line sensor and echo edges from GPIO edge events and the
+// signals from a signalfd, and the thread sleeps in epoll_wait between them. A line sensor edge runs a control
+// tick right away, and SIGUSR2 also prints the time from every event to its handler.
+static int parseOptions(int argc, char* argv[], ExecConfig* config)
+{
+    int opt;
+    exec_default_config(config);
+    while ((opt = getopt(argc, argv, "p:r:c:mt:R:k:PE")) != -1) {
+        switch (opt) {
+            case 'p':
+                config->period_us = atol(optarg);
+                break;
+            case 'r':
+                config->rt_priority = atoi(optarg);
+                break;
+            case 'c':
+                config->cpu = atoi(optarg);
+                break;
+            case 'm':
+                config->lock_memory = true;
+                break;
+            case 't':
+                tuneRule = tune_rule_from_name(optarg);
+                if (tuneRule < 0) {
+                    fprintf(stderr, "Unknown tuning rule: %s\n", optarg);
+                    return -1;
+                }
+                break;
+            case 'R':
+                recordPath = optarg;
+                break;
+            case 'k':
+                calibrateName = optarg;
+                break;
+            case 'P':
+                pipelineMode = true;
+                break;
+            case 'E':
+                eventMode = true;
+                break;
+            default:
+                fprintf(stderr, "Usage: %s [-p period_us] [-r rt_priority] [-c cpu] [-m] [-t rule] [-R recording] "
+                        "[-k color] [-P] [-E]\n", argv[0]);
+                return -1;
+        }
+    }
+    return 0;
+}
+
+
+int main(int argc, char* argv[]) {
+    ExecConfig execConfig;
+    if (parseOptions(argc, argv, &execConfig) < 0) {
+        return 1;
+    }
+    if (calibrateName) {
+        return calibrateColor(calibrateName);
+    }
+    if ((pipelineMode || eventMode) && tuneRule >= 0) {
+        printf("The autotune experiment runs in the single loop, ignoring -P and -E\n");
+        pipelineMode = false;
+        eventMode = false;
+    }
+    if (pipelineMode && eventMode) {
+        printf("The event loop runs everything on one thread, ignoring -P\n");
+        pipelineMode = false;
+    }
+    // The event loop takes the signals from a signalfd, so no thread may handle them
+    sigset_t loopSignals;
+    sigemptyset(&loopSignals);
+    sigaddset(&loopSignals, SIGINT);
+    sigaddset(&loopSignals, SIGUSR1);
+    sigaddset(&loopSignals, SIGUSR2);
+    if (eventMode) {
+        pthread_sigmask(SIG_BLOCK, &loopSignals, NULL);
+    }
+    if (pipelineMode && execConfig.cpu < 0) {
+        execConfig.cpu = PIPELINE_CONTROL_CPU;
+    }
+
+    // Every I2C and SPI transfer goes through the bus accounting layer, the control loop reads the sensors
+    // from the hub's snapshots, or directly on the event loop's thread with the encoders polled on their own timer
+    bus_init(&bus_real_backend);
+    rio_init(eventMode ? &rio_hardware : pipelineMode ? &rio_pipeline : &rio_hub, NULL);
 
-int main(void) {
     // Initialize all systems
     printf("Initializing motor system...\n");
     initializeMotorSystem();
 
     printf("Initializing echo sensors...\n");
-    if (initEchoSensors() < 0) {
+    int echoFd = eventMode ? initEchoSensorsEvents() : initEchoSensors();
+    if (echoFd < 0) {
         printf("Failed to initialize echo sensors\n");
         return 1;
     }
 
-    // Set up signal handler
-    signal(SIGINT, Handler);
+    // Set up signal handlers
+    if (!eventMode) {
+        signal(SIGINT, Handler);
+        signal(SIGUSR2, StatsHandler);
+        signal(SIGUSR1, ProfHandler);
+    }
     // Set up the encoder
     printf("Initializing encoders...\n");
     initializeEncoder(SPI0_CE0, "Motor A");
     initializeEncoder(SPI0_CE1, "Motor B");
 
-    /*
     printf("Initializing TCS34725 sensor...\n");
-    int tcs34725 = init_TCS34725("101ms", "60X");
-    if (tcs34725 < 0) {
+    loadColorCalibration();
+    ColorExposure exposure = color_exposure_step(COLOR_EXPOSURE_REF_STEP);
+    int tcs34725 = init_TCS34725(exposure.atime, exposure.gain);
+    rio_hw_set_color_handle(tcs34725);
+    if (tcs34725 < 0 || set_led_brightness(LED_PIN, 100) < 0
+        || color_monitor_start(tcs34725, COLOR_EXPOSURE_REF_STEP, colorCal) < 0) {
+        printf("Color monitor disabled, the car will not react to colors\n");
+    }
+    // From here on log messages go to the binary telemetry log, read it with tlog_decode
+    if (tlog_init(TLOG_FILE, 1) < 0) {
+        printf("Telemetry log disabled, messages are printed directly\n");
+    }
+
+    if (prof_init() < 0) {
+        printf("Stage latency dumps disabled\n");
+    }
+
+    // Configure the fixed rate control executive
+    if (exec_init(&execConfig) < 0) {
+        color_monitor_stop();
+        tlog_shutdown();
+        stopMotors();
+        cleanupEchoSensors();
         gpioTerminate();
-        return EXIT_FAILURE;
+        DEV_ModuleExit();
+        return 1;
+    }
+
+    // Record every control iteration, the file survives a crash of the program
+    if (fr_open(FR_FILE, FR_DEFAULT_RECORDS) == 0) {
+        const char* stateNames[FR_MAX_STATES];
+        int numStates = pid_state_names(stateNames, FR_MAX_STATES);
+        fr_set_state_names(stateNames, numStates);
+    } else {
+        printf("Flight recorder disabled\n");
     }
-    */
+
     //Begin the robot car's main operational loop, where it reacts to sensor inputs in real-time.
     printf("All systems initialized. Starting control loop...\n");
 
-    // Main control loop
-    while(!stop) {
-        // Use PID control to adjust the car's movement based on sensor feedback.
-        pid_control();
-        // Use the TCS34725 sensor to detect the color of the LED and stop the car.
-        /*
-        if (detect_and_adjust_led(tcs34725, &color_result) < 0) {
+    // Main control loop, controlTick runs once per period
+    trace_thread_name("control");
+    exec_set_dump_hook(dumpStats);
+    if (eventMode) {
+        // Nothing runs next to the event loop
+    } else if (pipelineMode) {
+        PipelineConfig pipelineConfig;
+        pipeline_default_config(&pipelineConfig);
+        pipelineConfig.period_us = execConfig.period_us;
+        pipelineConfig.rt_priority = execConfig.rt_priority;
+        if (pipeline_start(&pipelineConfig) < 0) {
+            printf("Failed to start the pipeline\n");
             stop = 1;
         }
-
-        if(!color_result) {
+    } else {
+        SensorHubConfig hubConfig;
+        sensor_hub_default_config(&hubConfig);
+        if (sensor_hub_start(&hubConfig) < 0) {
+            printf("Failed to start the sensor hub\n");
             stop = 1;
         }
-        */
+    }
+    if (tuneRule >= 0) {
+        printf("Running relay autotune on the line...\n");
+        pid_autotune_start(&autotune);
+        exec_run(autotuneTick, &stop);
+        saveAutotuneGains();
+    } else {
+        pid_load_gains(GAINS_FILE);
+        ControlParams params;
+        pid_get_params(&params);
+        if (params_create_shared(&params) < 0) {
+            printf("Live parameter tuning disabled\n");
+        }
+        if (recordPath && rio_record_start(recordPath, &params) < 0) {
+            printf("Sensor recording disabled\n");
+        }
+        if (eventMode) {
+            runEventLoop(execConfig.period_us, echoFd, &loopSignals);
+        } else if (pipelineMode) {
+            pipeline_run(controlTick, &stop);
+        } else {
+            exec_run(controlTick, &stop);
+        }
+        rio_record_stop();
+        params_close_shared();
+        params_unlink_shared();
+    }
+    if (pipelineMode) {
+        pipeline_stop();
+    } else if (!eventMode) {
+        sensor_hub_stop();
+    }
+
+    fr_close();
+    tlog_shutdown();
+    if (tlog_dropped() > 0) {
+        printf("%llu log messages were dropped\n", (unsigned long long)tlog_dropped());
     }
 
     // Once the program exits, ensure all resources are safely released and motors are stopped.
     printf("\nCleaning up...\n");
     stopMotors();
-//    i2cClose(tcs34725);
+    if (eventMode) {
+        dumpStats(stdout);
+    } else {
+        exec_dump_stats(stdout);
+    }
+    prof_dump(stdout);
+    color_monitor_stop();
+    if (tcs34725 >= 0) {
+        bus_i2c_close(tcs34725);
+    }
     cleanupEchoSensors();
     gpioTerminate();
     DEV_ModuleExit();
+#ifdef ENABLE_TRACING
+    // The echo thread has stopped, so every trace buffer is complete
+    if (trace_write(TRACE_FILE) == 0) {
+        printf("Trace written to %s, open it in ui.perfetto.dev or chrome://tracing\n", TRACE_FILE);
+    }
+#endif
     printf("Program exited successfully.\n");
     return 0;
 }
@@ -36,5 +36,7 @@ Fernando Abel Malca Luque
 #include "encoder/ls7336r.h"
 #include "encoder/motor.h"
 #include "rgb/tcs34725.h"
+#include "echoSensor/echoSensor.h"
+#include "pid/pid.h"
 
 #endif
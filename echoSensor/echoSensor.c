@@ -7,6 +7,8 @@ File          : echoSensor.c
 Description:
 This file is the echo sensor file for the robot car project. 
 It initializes the echo sensors and provides functions to read the distances from the sensors.
+The sensors are either polled on their own thread, or pinged from the event loop with the echo edges arriving
+as GPIO edge events, timestamped by the kernel.
 *
 Team Members:
 Kiran Poudel
@@ -22,6 +24,10 @@ Fernando Abel Malca Luque
 #include <unistd.h>
 #include <pthread.h>
 #include <stdbool.h>
+#include <stdint.h>
+#include "../prof/prof.h"
+#include "../trace/trace.h"
+#include "../events/gpio_events.h"
 
 // Number of sensors
 #define NUM_SENSORS 3
@@ -41,18 +47,27 @@ static const SensorPins sensorPins[NUM_SENSORS] = {
 
 // Global variables
 static double sensorDistances[NUM_SENSORS] = {0};
+static int64_t sensorTimes[NUM_SENSORS] = {0};  // CLOCK_MONOTONIC time each distance was measured, in us
 static pthread_mutex_t distanceMutex = PTHREAD_MUTEX_INITIALIZER;
 static bool isRunning = false;
+static bool pollThreadStarted = false;
 static pthread_t pollThread;
 
+// Event loop mode
+#define ECHO_TIMEOUT_US 60000   // Longer echoes are out of range, the HC-SR04 gives up after about 38 ms
+static int echoFd = -1;
+static int pingIndex = NUM_SENSORS - 1;  // Sensor pinged last
+static bool pingPending = false;         // No falling edge yet for the last ping
+static int64_t echoStartUs = 0;          // Rising edge of the current echo, 0 before it
+
 // Function declarations
 static double getDistance(const SensorPins* sensor);
 static void* pollSensorsSequentially(void* arg);
+static void storeDistance(int sensorIdx, double distance, int64_t measured);
+static int64_t monotonicUs(void);
 
-// Initialize the echo sensor system
-int initEchoSensors() {
-    if (isRunning) return 0;
-
+// Initialize pigpio and the pins of all sensors
+static int setupSensorPins(void) {
     if (gpioInitialise() < 0) {
         printf("pigpio initialization failed\n");
         return -1;
@@ -67,6 +82,13 @@ int initEchoSensors() {
                i, sensorPins[i].trig, sensorPins[i].echo);
         gpioWrite(sensorPins[i].trig, 0);
     }
+    return 0;
+}
+
+// Initialize the echo sensor system
+int initEchoSensors() {
+    if (isRunning) return 0;
+    if (setupSensorPins() < 0) return -1;
 
     // Create a thread for sequential polling
     if (pthread_create(&pollThread, NULL, pollSensorsSequentially, NULL) != 0) {
@@ -75,10 +97,91 @@ int initEchoSensors() {
         return -1;
     }
 
+    pollThreadStarted = true;
     isRunning = true;
     return 0;
 }
 
+// Initialize the echo sensors for the event loop, returns the descriptor the echo edges arrive on
+int initEchoSensorsEvents(void) {
+    if (isRunning) return echoFd;
+    if (setupSensorPins() < 0) return -1;
+
+    unsigned echoPins[NUM_SENSORS];
+    for (int i = 0; i < NUM_SENSORS; i++) {
+        echoPins[i] = sensorPins[i].echo;
+    }
+    echoFd = gpio_events_open(echoPins, NUM_SENSORS, "car-echo");
+    if (echoFd < 0) {
+        gpioTerminate();
+        return -1;
+    }
+    isRunning = true;
+    return echoFd;
+}
+
+static void storeDistance(int sensorIdx, double distance, int64_t measured) {
+    // Counter names for the trace, left, front and right
+    static const char* const traceNames[] = {"distance_left", "distance_front", "distance_right"};
+    TRACE_COUNTER(traceNames[sensorIdx], distance);
+    pthread_mutex_lock(&distanceMutex);
+    sensorDistances[sensorIdx] = distance;
+    sensorTimes[sensorIdx] = measured;
+    pthread_mutex_unlock(&distanceMutex);
+}
+
+// Ping the next sensor, a sensor whose echo has not ended since the last ping reads as out of range
+void echoEventsPing(void) {
+    if (pingPending) {
+        storeDistance(pingIndex, -1, monotonicUs());
+    }
+    pingIndex = (pingIndex + 1) % NUM_SENSORS;
+    echoStartUs = 0;
+    pingPending = true;
+    gpioTrigger(sensorPins[pingIndex].trig, 10, 1);
+}
+
+// Read the echo edges, returns the kernel time of the first one, 0 if there was none
+int64_t echoEventsHandle(int fd) {
+    GpioEvent events[GPIO_EVENTS_BUFFER];
+    int count = gpio_events_read(fd, events, GPIO_EVENTS_BUFFER);
+    for (int i = 0; i < count; i++) {
+        // Edges of the other sensors are late echoes of earlier pings
+        if (!pingPending || events[i].pin != (unsigned)sensorPins[pingIndex].echo) continue;
+        if (events[i].rising) {
+            echoStartUs = events[i].time_us;
+        } else if (echoStartUs > 0 && events[i].time_us - echoStartUs < ECHO_TIMEOUT_US) {
+            // Calculate distance in cm
+            storeDistance(pingIndex, ((events[i].time_us - echoStartUs) * 0.0343) / 2.0, events[i].time_us);
+            pingPending = false;
+        }
+    }
+    return count > 0 ? events[0].time_us : 0;
+}
+
+static int64_t monotonicUs(void) {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (int64_t)now.tv_sec * 1000000 + now.tv_nsec / 1000;
+}
+
+// Get the current distances from all sensors and the time the oldest of them was measured
+int getCurrentDistancesAt(double distances[NUM_SENSORS], int64_t* measuredUs) {
+    if (!isRunning) return -1;
+
+    pthread_mutex_lock(&distanceMutex);
+    int64_t oldest = sensorTimes[0];
+    for (int i = 0; i < NUM_SENSORS; i++) {
+        distances[i] = sensorDistances[i];
+        if (sensorTimes[i] < oldest) {
+            oldest = sensorTimes[i];
+        }
+    }
+    pthread_mutex_unlock(&distanceMutex);
+    *measuredUs = oldest;
+    return 0;
+}
+
 // Get the current distances from all sensors
 int getCurrentDistances(double distances[NUM_SENSORS]) {
     if (!isRunning) return -1;
@@ -96,7 +199,12 @@ void cleanupEchoSensors() {
     if (!isRunning) return;
 
     isRunning = false;
-    pthread_join(pollThread, NULL);
+    if (pollThreadStarted) {
+        pthread_join(pollThread, NULL);
+        pollThreadStarted = false;
+    }
+    gpio_events_close(echoFd);
+    echoFd = -1;
     gpioTerminate();
 }
 
@@ -118,6 +226,7 @@ static double getDistance(const SensorPins* sensor) {
     if (timeout >= 10000) return -1;
 
     startTick = gpioTick();
+    TRACE_BEGIN("echo_window");
 
     // Wait for Echo to go low 
     timeout = 0;
@@ -125,6 +234,7 @@ static double getDistance(const SensorPins* sensor) {
         timeout++;
         usleep(1);
     }
+    TRACE_END("echo_window");
     if (timeout >= 10000) return -1;
 
     endTick = gpioTick();
@@ -136,17 +246,20 @@ static double getDistance(const SensorPins* sensor) {
 
 // Poll sensors 
 static void* pollSensorsSequentially(void* arg) {
+    trace_thread_name("echo");
     while (isRunning) {
         // Poll sensors sequentially this was done because we initially had 5 sensors
         // but it was too much of a bottleneck so we only use 3 sensors now
         int sensors_to_poll[] = {0, 1, 2};
         for (int i = 0; i < 3; i++) {
             int sensor_idx = sensors_to_poll[i];
+            PROF_BEGIN(PROF_ECHO_PING);
+            TRACE_BEGIN("echo_ping");
             double distance = getDistance(&sensorPins[sensor_idx]);
-            
-            pthread_mutex_lock(&distanceMutex);
-            sensorDistances[sensor_idx] = distance;
-            pthread_mutex_unlock(&distanceMutex);
+            int64_t measured = monotonicUs();
+            TRACE_END("echo_ping");
+            PROF_END(PROF_ECHO_PING);
+            storeDistance(sensor_idx, distance, measured);
             
             usleep(20000); // 20ms delay between readings
         }
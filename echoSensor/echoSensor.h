@@ -19,6 +19,7 @@ Fernando Abel Malca Luque
 #define ECHO_SENSOR_H
 
 #include <stdbool.h>
+#include <stdint.h>
 
 #define NUM_SENSORS 5
 
@@ -30,9 +31,18 @@ typedef struct {
     int recommended_direction; // -1 for left, 1 for right, 0 for no clear path
 } ObjectDetectionState;
 
+#define ECHO_PING_PERIOD_US 30000  // Event loop mode pings one sensor per period, like the polling thread
+
 int initEchoSensors();
+// Event loop mode: no polling thread, call echoEventsPing every ECHO_PING_PERIOD_US and echoEventsHandle when
+// the returned descriptor is readable
+int initEchoSensorsEvents(void);
+void echoEventsPing(void);
+int64_t echoEventsHandle(int fd);
 void cleanupEchoSensors();
 int getCurrentDistances(double distances[NUM_SENSORS]);
+// Same as getCurrentDistances, measuredUs is the CLOCK_MONOTONIC time of the oldest distance, 0 before all were measured
+int getCurrentDistancesAt(double distances[NUM_SENSORS], int64_t* measuredUs);
 void updateObjectDetection(double distances[NUM_SENSORS]);
 void getObjectDetectionState(ObjectDetectionState* state);
 void printSensorDistances();
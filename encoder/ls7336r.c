@@ -14,6 +14,8 @@
 #include <string.h>
 #include <unistd.h>
 #include <pigpio.h>
+#include "../motor/Debug.h"
+#include "../bus/bus.h"
 
 // Commands  
 #define	CLEAR_COUNTER	0x20		// 00 (WR) 100 (CNTR)
@@ -97,7 +99,7 @@ unsigned char readCounterMsg[] = { READ_COUNTER, 0, 0, 0, 0};
 int readLS7336RCounter (int ChipEnable)
 	{
 	char dataFromChip[20];
-    bbSPIXfer(ChipEnable, readCounterMsg, dataFromChip, 5);
+    bus_spi_xfer(BUS_SITE(), ChipEnable, readCounterMsg, dataFromChip, 5);
     int result = (((int)dataFromChip[1]) << 24) + (((int)dataFromChip[2]) << 16) + 
     	                        (((int)dataFromChip[3]) << 8) + ((int)dataFromChip[4]);
     return (result);
@@ -123,11 +125,11 @@ int clearLS7336RCounter (int ChipEnable)
     char dataFromChip[20];
     
     // Clear the counter
-    ret = bbSPIXfer(ChipEnable, clearCounter, dataFromChip, 1);
+    ret = bus_spi_xfer(BUS_SITE(), ChipEnable, clearCounter, dataFromChip, 1);
     if (ret < 0) {
-        printf("Error clearing counter. Error code: %d\n", ret);
+        LOG_ERROR("Error clearing counter. Error code: %d\n", ret);
     } else {
-        printf("Counter cleared successfully.\n");
+        LOG_DEBUG("Counter cleared successfully.\n");
     }
     if (ret >= 0) // xfer succeeded
         {
@@ -169,7 +171,7 @@ int initLS7336RChip (int ChipEnable)
         {
     	usleep (10000);
     	//set MDR0 to 4x counter mode
-        ret = bbSPIXfer(ChipEnable, setMDR0, dataFromChip, 2);  //Set MDR0 
+        ret = bus_spi_xfer(BUS_SITE(), ChipEnable, setMDR0, dataFromChip, 2);  //Set MDR0 
     		if (ret < 0) {
         		printf("Error setting MDR0. Error code: %d\n", ret);
         		return ret;
@@ -180,7 +182,7 @@ int initLS7336RChip (int ChipEnable)
             {
             usleep (10000);
             // set MDR1 to 4 byte counter mode
-            ret = bbSPIXfer(ChipEnable, setMDR1, dataFromChip, 2);  //Set MDR1 
+            ret = bus_spi_xfer(BUS_SITE(), ChipEnable, setMDR1, dataFromChip, 2);  //Set MDR1 
                 if (ret < 0) {
                         printf("Error setting MDR0. Error code: %d\n", ret);
                         return ret;
@@ -191,7 +193,7 @@ int initLS7336RChip (int ChipEnable)
             if (ret >= 0)  //xfer succeeded
                 {
                 // Clear status
-                ret = bbSPIXfer(ChipEnable, clearStatus, dataFromChip, 1);
+                ret = bus_spi_xfer(BUS_SITE(), ChipEnable, clearStatus, dataFromChip, 1);
                 if (ret < 0) {
                         printf("Error setting MDR0. Error code: %d\n", ret);
                         return ret;
@@ -59,7 +59,7 @@ void readEncoder(int cePin, int* lastCount, const char* motorName) {
     }
 
     // Log raw data
-    printf("Raw data from %s encoder: %08X\n", motorName, result);
+    LOG_DEBUG("Raw data from %s encoder: %08X\n", motorName, result);
 
     // Calculate delta, including negative values for backward motion
     int delta = result - *lastCount;
@@ -70,10 +70,10 @@ void readEncoder(int cePin, int* lastCount, const char* motorName) {
 
     // Log processed data with motion direction
     if (delta < 0) {
-        printf("%s is moving backward. Count: %d, Delta: %d, Revolutions: %f, Speed: %f cm/s\n", 
+        LOG_INFO("%s is moving backward. Count: %d, Delta: %d, Revolutions: %f, Speed: %f cm/s\n", 
                motorName, result, delta, revolutions, speed);
     } else {
-        printf("%s is moving forward. Count: %d, Delta: %d, Revolutions: %f, Speed: %f cm/s\n", 
+        LOG_INFO("%s is moving forward. Count: %d, Delta: %d, Revolutions: %f, Speed: %f cm/s\n", 
                motorName, result, delta, revolutions, speed);
     }
 
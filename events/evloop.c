@@ -0,0 +1,235 @@
+/**
+Class         : CSC-615-01 - Embedded Linux - Fall 2024
+Team Name     : Wayno
+Github        : nhannguyensf
+Project       : Final Assignment - Robot Car
+File          : evloop.c
+Description:
+This file contains the epoll event loop. A timer keeps the absolute time of its next expiration, so the latency
+of a timer event is measured from the moment it was due; a file descriptor handler reports the time of its event
+itself, e.g. the kernel timestamp of a GPIO edge. Signals carry no time and only their handler time is measured.
+The loop also counts its wake ups and the time it spent asleep in epoll_wait.
+*
+Team Members:
+Kiran Poudel
+Nhan Nguyen
+Yuvraj Gupta
+Fernando Abel Malca Luque
+
+*
+**/
+#include "evloop.h"
+#include "../fsm/fsm.h"
+#include "../trace/trace.h"
+#include <errno.h>
+#include <stdbool.h>
+#include <string.h>
+#include <sys/epoll.h>
+#include <sys/signalfd.h>
+#include <sys/timerfd.h>
+#include <unistd.h>
+
+typedef enum {
+    EV_TIMER,
+    EV_SIGNAL,
+    EV_FD
+} EvSourceType;
+
+typedef struct {
+    EvSourceType type;
+    int fd;
+    void* ctx;
+    EvTimerHandler on_timer;
+    EvSignalHandler on_signal;
+    EvFdHandler on_fd;
+    long period_us;
+    int64_t next_us;  // Timer: time of the next expiration
+    EvSourceStats stats;
+} EvSource;
+
+static int epfd = -1;
+static EvSource sources[EVLOOP_MAX_SOURCES];
+static int num_sources = 0;
+static bool running = false;
+
+static uint64_t wakeups = 0;
+static int64_t asleep_us = 0;
+static int64_t run_us = 0;    // Time in evloop_run before the current call
+static int64_t start_us = 0;  // Start of the current call
+
+int evloop_init(void) {
+    epfd = epoll_create1(EPOLL_CLOEXEC);
+    if (epfd < 0) {
+        printf("Failed to create the event loop: %s\n", strerror(errno));
+        return -1;
+    }
+    num_sources = 0;
+    return 0;
+}
+
+static int add_source(const char* name, EvSourceType type, int fd, void* ctx) {
+    if (epfd < 0 || num_sources >= EVLOOP_MAX_SOURCES) return -1;
+    EvSource* src = &sources[num_sources];
+    memset(src, 0, sizeof(*src));
+    src->type = type;
+    src->fd = fd;
+    src->ctx = ctx;
+    src->stats.name = name;
+
+    struct epoll_event ev = { .events = EPOLLIN, .data.u32 = num_sources };
+    if (epoll_ctl(epfd, EPOLL_CTL_ADD, fd, &ev) < 0) {
+        printf("Failed to add %s to the event loop: %s\n", name, strerror(errno));
+        return -1;
+    }
+    return num_sources++;
+}
+
+int evloop_add_timer(const char* name, long period_us, EvTimerHandler fn, void* ctx) {
+    int fd = timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC);
+    if (fd < 0) return -1;
+    int index = add_source(name, EV_TIMER, fd, ctx);
+    if (index < 0) {
+        close(fd);
+        return -1;
+    }
+    EvSource* src = &sources[index];
+    src->on_timer = fn;
+    src->period_us = period_us;
+    src->next_us = fsm_monotonic_us(NULL) + period_us;
+
+    // Absolute expirations on the same clock as next_us
+    struct itimerspec spec = {
+        .it_interval = { period_us / 1000000, (period_us % 1000000) * 1000 },
+        .it_value = { src->next_us / 1000000, (src->next_us % 1000000) * 1000 },
+    };
+    if (timerfd_settime(fd, TFD_TIMER_ABSTIME, &spec, NULL) < 0) {
+        printf("Failed to start the %s timer: %s\n", name, strerror(errno));
+        return -1;
+    }
+    return 0;
+}
+
+int evloop_add_signals(const sigset_t* signals, EvSignalHandler fn, void* ctx) {
+    int fd = signalfd(-1, signals, SFD_NONBLOCK | SFD_CLOEXEC);
+    if (fd < 0) return -1;
+    int index = add_source("signals", EV_SIGNAL, fd, ctx);
+    if (index < 0) {
+        close(fd);
+        return -1;
+    }
+    sources[index].on_signal = fn;
+    return 0;
+}
+
+int evloop_add_fd(const char* name, int fd, EvFdHandler fn, void* ctx) {
+    int index = add_source(name, EV_FD, fd, ctx);
+    if (index < 0) return -1;
+    sources[index].on_fd = fn;
+    return 0;
+}
+
+// Run the handler of a ready source, returns the time of the event or 0
+static int64_t dispatch(EvSource* src) {
+    int64_t event_us = 0;
+    switch (src->type) {
+        case EV_TIMER: {
+            uint64_t expirations;
+            if (read(src->fd, &expirations, sizeof(expirations)) != sizeof(expirations) || expirations == 0) {
+                return -1;
+            }
+            // Measure from the last expiration, the earlier ones are counted as overruns
+            event_us = src->next_us + (int64_t)(expirations - 1) * src->period_us;
+            src->next_us += (int64_t)expirations * src->period_us;
+            src->stats.overruns += expirations - 1;
+            src->on_timer(src->ctx, expirations);
+            break;
+        }
+        case EV_SIGNAL: {
+            struct signalfd_siginfo info;
+            while (read(src->fd, &info, sizeof(info)) == sizeof(info)) {
+                src->on_signal(src->ctx, info.ssi_signo);
+            }
+            break;
+        }
+        case EV_FD:
+            event_us = src->on_fd(src->ctx, src->fd);
+            break;
+    }
+    return event_us;
+}
+
+void evloop_run(void) {
+    struct epoll_event ready[EVLOOP_MAX_SOURCES];
+    start_us = fsm_monotonic_us(NULL);
+    running = true;
+    while (running) {
+        int64_t before = fsm_monotonic_us(NULL);
+        int n = epoll_wait(epfd, ready, EVLOOP_MAX_SOURCES, -1);
+        int64_t woke = fsm_monotonic_us(NULL);
+        asleep_us += woke - before;
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            printf("Event loop failed: %s\n", strerror(errno));
+            break;
+        }
+        wakeups++;
+
+        for (int i = 0; i < n; i++) {
+            EvSource* src = &sources[ready[i].data.u32];
+            TRACE_BEGIN(src->stats.name);
+            int64_t entry = fsm_monotonic_us(NULL);
+            int64_t event_us = dispatch(src);
+            int64_t done = fsm_monotonic_us(NULL);
+            TRACE_END(src->stats.name);
+            if (event_us < 0) continue;
+            src->stats.events++;
+            if (event_us > 0) {
+                exec_hist_add(&src->stats.latency, (long)(entry - event_us));
+            }
+            exec_hist_add(&src->stats.handler, (long)(done - entry));
+        }
+    }
+    run_us += fsm_monotonic_us(NULL) - start_us;
+}
+
+void evloop_stop(void) {
+    running = false;
+}
+
+int evloop_get_stats(EvSourceStats* stats, int max) {
+    int n = num_sources < max ? num_sources : max;
+    for (int i = 0; i < n; i++) {
+        stats[i] = sources[i].stats;
+    }
+    return n;
+}
+
+void evloop_print_stats(FILE* out) {
+    // Also called from a handler while the loop runs
+    int64_t total_us = run_us + (running ? fsm_monotonic_us(NULL) - start_us : 0);
+    fprintf(out, "Event loop: %llu wake ups, asleep %.1f%% of %.1f s\n", (unsigned long long)wakeups,
+            total_us > 0 ? 100.0 * asleep_us / total_us : 0.0, total_us / 1e6);
+    for (int i = 0; i < num_sources; i++) {
+        const EvSourceStats* stats = &sources[i].stats;
+        fprintf(out, "%s: %llu events, %llu overruns\n", stats->name, (unsigned long long)stats->events,
+                (unsigned long long)stats->overruns);
+        if (stats->latency.count > 0) {
+            exec_hist_print(out, "  Event to handler", &stats->latency);
+        }
+        exec_hist_print(out, "  Handler time", &stats->handler);
+    }
+}
+
+void evloop_close(void) {
+    // The sources stay in the table, so their statistics can still be printed
+    for (int i = 0; i < num_sources; i++) {
+        if (sources[i].type != EV_FD && sources[i].fd >= 0) {
+            close(sources[i].fd);
+        }
+        sources[i].fd = -1;
+    }
+    if (epfd >= 0) {
+        close(epfd);
+        epfd = -1;
+    }
+}
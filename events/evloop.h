@@ -0,0 +1,63 @@
+/**
+Class         : CSC-615-01 - Embedded Linux - Fall 2024
+Team Name     : Wayno
+Github        : nhannguyensf
+Project       : Final Assignment - Robot Car
+File          : evloop.h
+Description:
+This file is the header file for the evloop.c file. The event loop runs every handler of the car on one thread:
+periodic work comes from timerfd timers, signals from a signalfd and anything else from a readable file
+descriptor, such as the GPIO edge events. All of them are waited for with a single epoll_wait, so the thread
+sleeps in the kernel until the next event. For every source the loop measures the time from the event to the
+start of its handler and the time the handler took.
+*
+Team Members:
+Kiran Poudel
+Nhan Nguyen
+Yuvraj Gupta
+Fernando Abel Malca Luque
+
+*
+**/
+#ifndef EVLOOP_H
+#define EVLOOP_H
+
+#include <signal.h>
+#include <stdint.h>
+#include <stdio.h>
+#include "../executive/control_exec.h"
+
+#define EVLOOP_MAX_SOURCES 8
+
+// Handler of a timer, expirations is more than 1 when the loop fell behind
+typedef void (*EvTimerHandler)(void* ctx, uint64_t expirations);
+typedef void (*EvSignalHandler)(void* ctx, int signo);
+// Handler of a readable file descriptor, returns the CLOCK_MONOTONIC time in us of the oldest event it handled,
+// 0 when the event carries no time
+typedef int64_t (*EvFdHandler)(void* ctx, int fd);
+
+typedef struct {
+    const char* name;
+    uint64_t events;
+    uint64_t overruns;      // Timer expirations that were handled late together with the next one
+    ExecHistogram latency;  // Event to the start of the handler, for the events with a time
+    ExecHistogram handler;  // Time spent in the handler
+} EvSourceStats;
+
+int evloop_init(void);
+// Call fn every period_us, starting one period from now
+int evloop_add_timer(const char* name, long period_us, EvTimerHandler fn, void* ctx);
+// Call fn for every one of the signals, which must already be blocked in every thread of the process
+int evloop_add_signals(const sigset_t* signals, EvSignalHandler fn, void* ctx);
+// Call fn when the file descriptor is readable, fn must read until it would block
+int evloop_add_fd(const char* name, int fd, EvFdHandler fn, void* ctx);
+// Wait for events and run their handlers until evloop_stop is called from a handler
+void evloop_run(void);
+void evloop_stop(void);
+int evloop_get_stats(EvSourceStats* stats, int max);
+void evloop_print_stats(FILE* out);
+// Close the timers and the signalfd, the file descriptors added with evloop_add_fd stay open. The statistics stay
+// until the next evloop_init.
+void evloop_close(void);
+
+#endif
@@ -0,0 +1,83 @@
+/**
+Class         : CSC-615-01 - Embedded Linux - Fall 2024
+Team Name     : Wayno
+Github        : nhannguyensf
+Project       : Final Assignment - Robot Car
+File          : gpio_events.c
+Description:
+This file contains the GPIO edge events on top of the version 2 GPIO character device interface of linux/gpio.h,
+the interface libgpiod wraps. The line request is made non-blocking so a reader drains exactly the edges that are
+waiting.
+*
+Team Members:
+Kiran Poudel
+Nhan Nguyen
+Yuvraj Gupta
+Fernando Abel Malca Luque
+
+*
+**/
+#include "gpio_events.h"
+#include <errno.h>
+#include <fcntl.h>
+#include <linux/gpio.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/ioctl.h>
+#include <unistd.h>
+
+int gpio_events_open(const unsigned* pins, int num_pins, const char* consumer) {
+    if (num_pins <= 0 || num_pins > GPIO_EVENTS_MAX_LINES) return -1;
+    int chip = open(GPIO_EVENTS_CHIP, O_RDONLY | O_CLOEXEC);
+    if (chip < 0) {
+        printf("Failed to open %s: %s\n", GPIO_EVENTS_CHIP, strerror(errno));
+        return -1;
+    }
+
+    struct gpio_v2_line_request req;
+    memset(&req, 0, sizeof(req));
+    for (int i = 0; i < num_pins; i++) {
+        req.offsets[i] = pins[i];
+    }
+    req.num_lines = num_pins;
+    strncpy(req.consumer, consumer, sizeof(req.consumer) - 1);
+    // The edges are timestamped with CLOCK_MONOTONIC unless another clock is asked for
+    req.config.flags = GPIO_V2_LINE_FLAG_INPUT | GPIO_V2_LINE_FLAG_EDGE_RISING | GPIO_V2_LINE_FLAG_EDGE_FALLING;
+    req.event_buffer_size = GPIO_EVENTS_BUFFER;
+    int ret = ioctl(chip, GPIO_V2_GET_LINE_IOCTL, &req);
+    close(chip);
+    if (ret < 0) {
+        printf("Failed to request edge events for %s: %s\n", consumer, strerror(errno));
+        return -1;
+    }
+
+    int flags = fcntl(req.fd, F_GETFL);
+    if (flags < 0 || fcntl(req.fd, F_SETFL, flags | O_NONBLOCK) < 0) {
+        close(req.fd);
+        return -1;
+    }
+    return req.fd;
+}
+
+int gpio_events_read(int fd, GpioEvent* events, int max) {
+    struct gpio_v2_line_event raw[GPIO_EVENTS_BUFFER];
+    if (max > GPIO_EVENTS_BUFFER) max = GPIO_EVENTS_BUFFER;
+    ssize_t n = read(fd, raw, max * sizeof(raw[0]));
+    if (n < 0) {
+        return errno == EAGAIN ? 0 : -1;
+    }
+    int count = n / sizeof(raw[0]);
+    for (int i = 0; i < count; i++) {
+        events[i].pin = raw[i].offset;
+        events[i].rising = raw[i].id == GPIO_V2_LINE_EVENT_RISING_EDGE;
+        events[i].time_us = (int64_t)(raw[i].timestamp_ns / 1000);
+        events[i].seqno = raw[i].seqno;
+    }
+    return count;
+}
+
+void gpio_events_close(int fd) {
+    if (fd >= 0) {
+        close(fd);
+    }
+}
@@ -0,0 +1,44 @@
+/**
+Class         : CSC-615-01 - Embedded Linux - Fall 2024
+Team Name     : Wayno
+Github        : nhannguyensf
+Project       : Final Assignment - Robot Car
+File          : gpio_events.h
+Description:
+This file is the header file for the gpio_events.c file. It requests GPIO lines from the kernel's GPIO character
+device with edge detection on both edges. The kernel timestamps every edge in its interrupt handler and queues
+it on a file descriptor, which becomes readable when an edge is waiting, so the edges can be waited for with
+epoll instead of polling the level of the pin.
+*
+Team Members:
+Kiran Poudel
+Nhan Nguyen
+Yuvraj Gupta
+Fernando Abel Malca Luque
+
+*
+**/
+#ifndef GPIO_EVENTS_H
+#define GPIO_EVENTS_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#define GPIO_EVENTS_CHIP "/dev/gpiochip0"  // The GPIO header of the Raspberry Pi
+#define GPIO_EVENTS_MAX_LINES 8
+#define GPIO_EVENTS_BUFFER 64              // Edges the kernel keeps while nobody reads them
+
+typedef struct {
+    unsigned pin;        // BCM pin number, the line offset on the chip
+    bool rising;
+    int64_t time_us;     // CLOCK_MONOTONIC time the kernel saw the edge
+    uint32_t seqno;      // Edges on all the lines of the request so far, a gap means the kernel dropped edges
+} GpioEvent;
+
+// Request the pins as inputs with both edges detected, returns the file descriptor of the request or -1
+int gpio_events_open(const unsigned* pins, int num_pins, const char* consumer);
+// Read up to max waiting edges without blocking, returns how many were read, 0 for none and -1 on error
+int gpio_events_read(int fd, GpioEvent* events, int max);
+void gpio_events_close(int fd);
+
+#endif
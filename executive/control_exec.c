@@ -0,0 +1,230 @@
+/**
+Class         : CSC-615-01 - Embedded Linux - Fall 2024
+Team Name     : Wayno
+Github        : nhannguyensf
+Project       : Final Assignment - Robot Car
+File          : control_exec.c
+Description:
+This file contains the fixed rate control executive for the robot car project. The loop sleeps with
+clock_nanosleep on absolute CLOCK_MONOTONIC deadlines so the control rate does not drift with bus timing or
+printing. It can optionally run with SCHED_FIFO priority, pinned to one CPU and with its memory locked.
+Every iteration records the execution time and the wake up jitter into histograms, which are printed
+when a dump is requested (for example from a signal handler). The histograms and the thread settings are also
+used by the threads that run next to the loop.
+*
+Team Members:
+Kiran Poudel
+Nhan Nguyen
+Yuvraj Gupta
+Fernando Abel Malca Luque
+
+*
+**/
+#define _GNU_SOURCE
+#include "control_exec.h"
+#include <errno.h>
+#include <pthread.h>
+#include <sched.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <time.h>
+
+#define NSEC_PER_SEC 1000000000L
+
+static ExecConfig exec_config;
+static ExecStats exec_stats;
+static volatile sig_atomic_t dump_requested = 0;
+static void (*dump_hook)(FILE* out) = NULL;
+
+// Fill in the default configuration
+void exec_default_config(ExecConfig* config) {
+    config->period_us = EXEC_DEFAULT_PERIOD_US;
+    config->rt_priority = 0;
+    config->cpu = -1;
+    config->lock_memory = false;
+}
+
+// Apply the scheduling, affinity and memory settings to the calling thread
+int exec_init(const ExecConfig* config) {
+    exec_config = *config;
+    memset(&exec_stats, 0, sizeof(exec_stats));
+
+    if (exec_config.period_us <= 0) {
+        printf("Invalid control period: %ld us\n", exec_config.period_us);
+        return -1;
+    }
+
+    if (exec_config.lock_memory && mlockall(MCL_CURRENT | MCL_FUTURE) != 0) {
+        printf("mlockall failed: %s\n", strerror(errno));
+        return -1;
+    }
+
+    if (exec_config.cpu >= 0) {
+        cpu_set_t cpus;
+        CPU_ZERO(&cpus);
+        CPU_SET(exec_config.cpu, &cpus);
+        int ret = pthread_setaffinity_np(pthread_self(), sizeof(cpus), &cpus);
+        if (ret != 0) {
+            printf("Failed to pin control loop to CPU %d: %s\n", exec_config.cpu, strerror(ret));
+            return -1;
+        }
+    }
+
+    if (exec_config.rt_priority > 0) {
+        struct sched_param param = { .sched_priority = exec_config.rt_priority };
+        int ret = pthread_setschedparam(pthread_self(), SCHED_FIFO, &param);
+        if (ret != 0) {
+            printf("Failed to set SCHED_FIFO priority %d: %s\n", exec_config.rt_priority, strerror(ret));
+            return -1;
+        }
+    }
+
+    printf("Control executive: period %ld us, priority %d, cpu %d, mlock %s\n",
+           exec_config.period_us, exec_config.rt_priority, exec_config.cpu,
+           exec_config.lock_memory ? "on" : "off");
+    return 0;
+}
+
+// Start a thread with the given affinity and SCHED_FIFO priority, a normal thread for priority 0, even when it is
+// started from a real time thread
+int exec_thread_create(pthread_t* thread, void* (*fn)(void*), void* arg, int cpu, int rt_priority) {
+    pthread_attr_t attr;
+    struct sched_param param = { .sched_priority = rt_priority > 0 ? rt_priority : 0 };
+    pthread_attr_init(&attr);
+    pthread_attr_setinheritsched(&attr, PTHREAD_EXPLICIT_SCHED);
+    pthread_attr_setschedpolicy(&attr, rt_priority > 0 ? SCHED_FIFO : SCHED_OTHER);
+    pthread_attr_setschedparam(&attr, &param);
+    if (cpu >= 0) {
+        cpu_set_t cpus;
+        CPU_ZERO(&cpus);
+        CPU_SET(cpu, &cpus);
+        pthread_attr_setaffinity_np(&attr, sizeof(cpus), &cpus);
+    }
+    int ret = pthread_create(thread, &attr, fn, arg);
+    pthread_attr_destroy(&attr);
+    if (ret != 0) {
+        printf("Failed to start a thread on CPU %d with priority %d: %s\n", cpu, rt_priority, strerror(ret));
+        return -1;
+    }
+    return 0;
+}
+
+// Add a duration to a histogram
+void exec_hist_add(ExecHistogram* hist, long duration_us) {
+    if (duration_us < 0) duration_us = 0;
+    long bin = duration_us / EXEC_HIST_BIN_US;
+    if (bin > EXEC_HIST_BINS) bin = EXEC_HIST_BINS;
+    hist->bins[bin]++;
+    hist->count++;
+    hist->sum_us += duration_us;
+    if (duration_us > hist->max_us) hist->max_us = duration_us;
+}
+
+// Upper edge of the bin holding the given percentile
+static long hist_percentile(const ExecHistogram* hist, double percentile) {
+    if (hist->count == 0) return 0;
+    uint64_t target = (uint64_t)(hist->count * percentile / 100.0);
+    uint64_t seen = 0;
+    for (int i = 0; i <= EXEC_HIST_BINS; i++) {
+        seen += hist->bins[i];
+        if (seen > target) {
+            return i == EXEC_HIST_BINS ? (long)hist->max_us : (long)(i + 1) * EXEC_HIST_BIN_US;
+        }
+    }
+    return hist->max_us;
+}
+
+void exec_hist_print(FILE* out, const char* name, const ExecHistogram* hist) {
+    fprintf(out, "%s: mean %.1f us, p50 %ld us, p99 %ld us, p99.9 %ld us, max %u us\n", name,
+            hist->count ? (double)hist->sum_us / hist->count : 0.0,
+            hist_percentile(hist, 50.0), hist_percentile(hist, 99.0),
+            hist_percentile(hist, 99.9), hist->max_us);
+    for (int i = 0; i <= EXEC_HIST_BINS; i++) {
+        if (hist->bins[i] == 0) continue;
+        if (i == EXEC_HIST_BINS) {
+            fprintf(out, "  >=%6d us: %u\n", i * EXEC_HIST_BIN_US, hist->bins[i]);
+        } else {
+            fprintf(out, "  %6d-%-6d us: %u\n", i * EXEC_HIST_BIN_US, (i + 1) * EXEC_HIST_BIN_US, hist->bins[i]);
+        }
+    }
+}
+
+// Print the loop statistics
+void exec_dump_stats(FILE* out) {
+    fprintf(out, "Control loop: %llu iterations, %llu missed deadlines (period %ld us)\n",
+            (unsigned long long)exec_stats.iterations,
+            (unsigned long long)exec_stats.missed_deadlines, exec_config.period_us);
+    exec_hist_print(out, "Execution time", &exec_stats.exec_time);
+    exec_hist_print(out, "Wake up jitter", &exec_stats.jitter);
+    if (dump_hook) {
+        dump_hook(out);
+    }
+    fflush(out);
+}
+
+// Register extra statistics to print with the loop statistics
+void exec_set_dump_hook(void (*hook)(FILE* out)) {
+    dump_hook = hook;
+}
+
+// Ask the loop to print its statistics at the next iteration, safe to call from a signal handler
+void exec_request_dump(void) {
+    dump_requested = 1;
+}
+
+// Print the statistics if a dump was requested, for loops that do not run in exec_run
+void exec_poll_dump(void) {
+    if (dump_requested) {
+        dump_requested = 0;
+        exec_dump_stats(stdout);
+    }
+}
+
+// Copy the current statistics
+void exec_get_stats(ExecStats* stats) {
+    *stats = exec_stats;
+}
+
+static long diff_us(const struct timespec* a, const struct timespec* b) {
+    return (a->tv_sec - b->tv_sec) * 1000000L + (a->tv_nsec - b->tv_nsec) / 1000;
+}
+
+static void add_ns(struct timespec* t, long ns) {
+    t->tv_nsec += ns;
+    while (t->tv_nsec >= NSEC_PER_SEC) {
+        t->tv_nsec -= NSEC_PER_SEC;
+        t->tv_sec++;
+    }
+}
+
+// Run the tick function once per period until the stop flag is set
+void exec_run(void (*tick)(void), volatile sig_atomic_t* stop) {
+    long period_ns = exec_config.period_us * 1000L;
+    struct timespec deadline, start, end;
+
+    clock_gettime(CLOCK_MONOTONIC, &deadline);
+    while (!*stop) {
+        clock_gettime(CLOCK_MONOTONIC, &start);
+        exec_hist_add(&exec_stats.jitter, diff_us(&start, &deadline));
+
+        tick();
+
+        clock_gettime(CLOCK_MONOTONIC, &end);
+        exec_hist_add(&exec_stats.exec_time, diff_us(&end, &start));
+        exec_stats.iterations++;
+        exec_poll_dump();
+
+        add_ns(&deadline, period_ns);
+        if (diff_us(&end, &deadline) > 0) {
+            // Overran the next deadline, skip the missed periods instead of bursting to catch up
+            exec_stats.missed_deadlines++;
+            while (diff_us(&end, &deadline) > 0) {
+                add_ns(&deadline, period_ns);
+            }
+        }
+
+        while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &deadline, NULL) == EINTR) {
+            if (*stop) break;
+        }
+    }
+}
@@ -0,0 +1,71 @@
+/**
+Class         : CSC-615-01 - Embedded Linux - Fall 2024
+Team Name     : Wayno
+Github        : nhannguyensf
+Project       : Final Assignment - Robot Car
+File          : control_exec.h
+Description:
+This file is the header file for the control_exec.c file. It declares the fixed rate control executive that runs
+the control loop on absolute deadlines and keeps execution time, jitter and missed deadline statistics.
+*
+Team Members:
+Kiran Poudel
+Nhan Nguyen
+Yuvraj Gupta
+Fernando Abel Malca Luque
+
+*
+**/
+#ifndef CONTROL_EXEC_H
+#define CONTROL_EXEC_H
+
+#include <stdio.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <signal.h>
+#include <pthread.h>
+
+// Default loop period (100 Hz)
+#define EXEC_DEFAULT_PERIOD_US 10000
+// Histogram layout, 50 us bins up to 20 ms plus one overflow bin
+#define EXEC_HIST_BIN_US 50
+#define EXEC_HIST_BINS 400
+
+// Executive configuration
+typedef struct {
+    long period_us;    // Loop period in microseconds
+    int rt_priority;   // SCHED_FIFO priority, 0 keeps the normal scheduler
+    int cpu;           // CPU to pin the loop to, -1 for no affinity
+    bool lock_memory;  // mlockall() to avoid page faults in the loop
+} ExecConfig;
+
+// Histogram of durations in microseconds
+typedef struct {
+    uint32_t bins[EXEC_HIST_BINS + 1];
+    uint64_t count;
+    uint64_t sum_us;
+    uint32_t max_us;
+} ExecHistogram;
+
+// Statistics collected by the executive
+typedef struct {
+    uint64_t iterations;
+    uint64_t missed_deadlines;
+    ExecHistogram exec_time;  // Time spent inside the tick function
+    ExecHistogram jitter;     // Wake up lateness relative to the deadline
+} ExecStats;
+
+// Function declarations
+void exec_default_config(ExecConfig* config);
+int exec_init(const ExecConfig* config);
+void exec_run(void (*tick)(void), volatile sig_atomic_t* stop);
+void exec_set_dump_hook(void (*hook)(FILE* out));
+void exec_request_dump(void);
+void exec_get_stats(ExecStats* stats);
+void exec_dump_stats(FILE* out);
+void exec_poll_dump(void);
+int exec_thread_create(pthread_t* thread, void* (*fn)(void*), void* arg, int cpu, int rt_priority);
+void exec_hist_add(ExecHistogram* hist, long duration_us);
+void exec_hist_print(FILE* out, const char* name, const ExecHistogram* hist);
+
+#endif // CONTROL_EXEC_H
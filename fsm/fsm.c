@@ -0,0 +1,206 @@
+/**
+Class         : CSC-615-01 - Embedded Linux - Fall 2024
+Team Name     : Wayno
+Github        : nhannguyensf
+Project       : Final Assignment - Robot Car
+File          : fsm.c
+Description:
+This file contains the table driven hierarchical state machine engine used for the robot behaviours.
+At init the transition rows are flattened into a state x event table where every event a state does not
+handle is resolved to the handler of its nearest parent, so dispatching an event is a single table lookup.
+A tick runs the tick handlers from the outermost parent down to the current state and dispatches the first
+event returned. Transitions run the exit and entry handlers up to the common parent and are recorded in a
+ring buffer. The clock is a function pointer so the machine can run against a fake or simulated clock.
+*
+Team Members:
+Kiran Poudel
+Nhan Nguyen
+Yuvraj Gupta
+Fernando Abel Malca Luque
+
+*
+**/
+#include "fsm.h"
+#include <string.h>
+#include <time.h>
+
+// Default clock, CLOCK_MONOTONIC in microseconds
+int64_t fsm_monotonic_us(void* clock_ctx) {
+    struct timespec now;
+    (void)clock_ctx;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (int64_t)now.tv_sec * 1000000 + now.tv_nsec / 1000;
+}
+
+// Build the flattened tables for a machine, returns -1 if the table does not fit the engine limits
+int fsm_init(Fsm* fsm, const FsmTable* table, int initial, void* user) {
+    if (table->num_states > FSM_MAX_STATES || table->num_events > FSM_MAX_EVENTS ||
+        initial < 0 || initial >= table->num_states) {
+        return -1;
+    }
+
+    memset(fsm, 0, sizeof(*fsm));
+    fsm->table = table;
+    fsm->user = user;
+    fsm->now_us = fsm_monotonic_us;
+    fsm->current = initial;
+
+    // Ancestor path of every state, outermost first, the state itself last
+    for (int s = 0; s < table->num_states; s++) {
+        int chain[FSM_MAX_DEPTH];
+        int depth = 0;
+        for (int p = s; p != FSM_NO_STATE; p = table->states[p].parent) {
+            if (depth == FSM_MAX_DEPTH || p < 0 || p >= table->num_states) {
+                return -1;
+            }
+            chain[depth++] = p;
+        }
+        fsm->depth[s] = depth;
+        for (int i = 0; i < depth; i++) {
+            fsm->path[s][i] = chain[depth - 1 - i];
+        }
+    }
+
+    // Transitions declared directly on each state
+    int8_t direct[FSM_MAX_STATES][FSM_MAX_EVENTS];
+    memset(direct, FSM_NO_STATE, sizeof(direct));
+    for (int i = 0; i < table->num_transitions; i++) {
+        const FsmTransition* t = &table->transitions[i];
+        if (t->state < 0 || t->state >= table->num_states || t->target < 0 ||
+            t->target >= table->num_states || t->event <= FSM_NO_EVENT || t->event >= table->num_events) {
+            return -1;
+        }
+        direct[t->state][t->event] = t->target;
+    }
+
+    // Resolve unhandled events to the nearest parent that handles them
+    for (int s = 0; s < table->num_states; s++) {
+        for (int e = 0; e < FSM_MAX_EVENTS; e++) {
+            fsm->next[s][e] = FSM_NO_STATE;
+            for (int i = fsm->depth[s] - 1; i >= 0; i--) {
+                int target = direct[fsm->path[s][i]][e];
+                if (target != FSM_NO_STATE) {
+                    fsm->next[s][e] = target;
+                    break;
+                }
+            }
+        }
+    }
+    return 0;
+}
+
+// Replace the clock used for state timing and the trace
+void fsm_set_clock(Fsm* fsm, int64_t (*now_us)(void* clock_ctx), void* clock_ctx) {
+    fsm->now_us = now_us;
+    fsm->clock_ctx = clock_ctx;
+}
+
+// Run the entry handlers of the initial state
+void fsm_start(Fsm* fsm) {
+    int s = fsm->current;
+    fsm->entered_us = fsm_now_us(fsm);
+    for (int i = 0; i < fsm->depth[s]; i++) {
+        const FsmStateDef* def = &fsm->table->states[fsm->path[s][i]];
+        if (def->on_entry) def->on_entry(fsm);
+    }
+}
+
+// Dispatch an event, returns 1 if it caused a transition
+int fsm_dispatch(Fsm* fsm, int event) {
+    if (event <= FSM_NO_EVENT || event >= FSM_MAX_EVENTS) return 0;
+
+    int from = fsm->current;
+    int to = fsm->next[from][event];
+    if (to == FSM_NO_STATE) return 0;
+
+    // Length of the shared ancestor path, the target itself is always exited and re-entered
+    int common = 0;
+    while (common < fsm->depth[from] && common < fsm->depth[to] &&
+           fsm->path[from][common] == fsm->path[to][common]) {
+        common++;
+    }
+    if (common == fsm->depth[to]) common--;
+
+    for (int i = fsm->depth[from] - 1; i >= common; i--) {
+        const FsmStateDef* def = &fsm->table->states[fsm->path[from][i]];
+        if (def->on_exit) def->on_exit(fsm);
+    }
+
+    int64_t now = fsm_now_us(fsm);
+    FsmTraceEntry* entry = &fsm->trace[fsm->trace_count++ & (FSM_TRACE_SIZE - 1)];
+    entry->time_us = now;
+    entry->from = from;
+    entry->to = to;
+    entry->event = event;
+
+    fsm->current = to;
+    fsm->entered_us = now;
+    for (int i = common; i < fsm->depth[to]; i++) {
+        const FsmStateDef* def = &fsm->table->states[fsm->path[to][i]];
+        if (def->on_entry) def->on_entry(fsm);
+    }
+    return 1;
+}
+
+// Run the tick handlers from the outermost parent to the current state, the first event wins
+void fsm_tick(Fsm* fsm) {
+    int s = fsm->current;
+    for (int i = 0; i < fsm->depth[s]; i++) {
+        const FsmStateDef* def = &fsm->table->states[fsm->path[s][i]];
+        if (!def->on_tick) continue;
+        int event = def->on_tick(fsm);
+        if (fsm->current != s) return;  // Handler dispatched on its own
+        if (event != FSM_NO_EVENT) {
+            fsm_dispatch(fsm, event);
+            return;
+        }
+    }
+}
+
+// Current leaf state
+int fsm_state(const Fsm* fsm) {
+    return fsm->current;
+}
+
+const char* fsm_state_name(const Fsm* fsm, int state) {
+    if (state < 0 || state >= fsm->table->num_states) return "?";
+    return fsm->table->states[state].name;
+}
+
+// True if the machine is in the state or in one of its children
+int fsm_in_state(const Fsm* fsm, int state) {
+    int s = fsm->current;
+    for (int i = 0; i < fsm->depth[s]; i++) {
+        if (fsm->path[s][i] == state) return 1;
+    }
+    return 0;
+}
+
+int64_t fsm_now_us(const Fsm* fsm) {
+    return fsm->now_us(fsm->clock_ctx);
+}
+
+// Time spent in the current state
+int64_t fsm_elapsed_us(const Fsm* fsm) {
+    return fsm_now_us(fsm) - fsm->entered_us;
+}
+
+static const char* event_name(const Fsm* fsm, int event) {
+    if (fsm->table->event_names && event < fsm->table->num_events) {
+        return fsm->table->event_names[event];
+    }
+    return "?";
+}
+
+// Print the newest traced transitions, oldest first
+void fsm_dump_trace(const Fsm* fsm, FILE* out, int max_entries) {
+    uint32_t available = fsm->trace_count < FSM_TRACE_SIZE ? fsm->trace_count : FSM_TRACE_SIZE;
+    uint32_t n = (max_entries > 0 && (uint32_t)max_entries < available) ? (uint32_t)max_entries : available;
+    fprintf(out, "State transitions (%u total, last %u):\n", fsm->trace_count, n);
+    for (uint32_t i = fsm->trace_count - n; i != fsm->trace_count; i++) {
+        const FsmTraceEntry* entry = &fsm->trace[i & (FSM_TRACE_SIZE - 1)];
+        fprintf(out, "  %12.3f s  %-20s --%s--> %s\n", entry->time_us / 1e6,
+                fsm_state_name(fsm, entry->from), event_name(fsm, entry->event),
+                fsm_state_name(fsm, entry->to));
+    }
+}
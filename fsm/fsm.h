@@ -0,0 +1,101 @@
+/**
+Class         : CSC-615-01 - Embedded Linux - Fall 2024
+Team Name     : Wayno
+Github        : nhannguyensf
+Project       : Final Assignment - Robot Car
+File          : fsm.h
+Description:
+This file is the header file for the fsm.c file. It declares a small table driven hierarchical state machine
+engine. States have entry, tick and exit handlers and an optional parent state, transitions are listed in a
+static table of (state, event, target) rows, and every transition is traced into a ring buffer.
+*
+Team Members:
+Kiran Poudel
+Nhan Nguyen
+Yuvraj Gupta
+Fernando Abel Malca Luque
+
+*
+**/
+#ifndef FSM_H
+#define FSM_H
+
+#include <stdio.h>
+#include <stdint.h>
+
+// Engine limits
+#define FSM_MAX_STATES 32
+#define FSM_MAX_EVENTS 16
+#define FSM_MAX_DEPTH 4
+#define FSM_TRACE_SIZE 256  // Must be a power of two
+
+// Reserved ids
+#define FSM_NO_EVENT 0   // Tick handlers return this when nothing happened
+#define FSM_NO_STATE (-1)
+
+typedef struct Fsm Fsm;
+
+// One state of the machine
+typedef struct {
+    const char* name;
+    int parent;                  // Parent state or FSM_NO_STATE
+    void (*on_entry)(Fsm* fsm);  // Optional
+    int (*on_tick)(Fsm* fsm);    // Optional, returns an event or FSM_NO_EVENT
+    void (*on_exit)(Fsm* fsm);   // Optional
+} FsmStateDef;
+
+// One row of the transition table, events not handled by a state fall through to its parent
+typedef struct {
+    int state;
+    int event;
+    int target;
+} FsmTransition;
+
+// Static description of a machine
+typedef struct {
+    const FsmStateDef* states;
+    int num_states;
+    const FsmTransition* transitions;
+    int num_transitions;
+    const char* const* event_names;  // Optional, indexed by event
+    int num_events;
+} FsmTable;
+
+// One traced transition
+typedef struct {
+    int64_t time_us;
+    uint8_t from;
+    uint8_t to;
+    uint8_t event;
+} FsmTraceEntry;
+
+// Running instance of a machine
+struct Fsm {
+    const FsmTable* table;
+    void* user;                              // Context for the handlers
+    int64_t (*now_us)(void* clock_ctx);      // Clock, replaceable for tests and simulation
+    void* clock_ctx;
+    int current;                             // Current leaf state
+    int64_t entered_us;                      // Time the current state was entered
+    int8_t next[FSM_MAX_STATES][FSM_MAX_EVENTS];    // Resolved targets, FSM_NO_STATE if unhandled
+    int8_t path[FSM_MAX_STATES][FSM_MAX_DEPTH];     // Ancestors of each state, outermost first
+    uint8_t depth[FSM_MAX_STATES];
+    FsmTraceEntry trace[FSM_TRACE_SIZE];
+    uint32_t trace_count;
+};
+
+// Function declarations
+int64_t fsm_monotonic_us(void* clock_ctx);
+int fsm_init(Fsm* fsm, const FsmTable* table, int initial, void* user);
+void fsm_set_clock(Fsm* fsm, int64_t (*now_us)(void* clock_ctx), void* clock_ctx);
+void fsm_start(Fsm* fsm);
+void fsm_tick(Fsm* fsm);
+int fsm_dispatch(Fsm* fsm, int event);
+int fsm_state(const Fsm* fsm);
+const char* fsm_state_name(const Fsm* fsm, int state);
+int fsm_in_state(const Fsm* fsm, int state);
+int64_t fsm_now_us(const Fsm* fsm);
+int64_t fsm_elapsed_us(const Fsm* fsm);
+void fsm_dump_trace(const Fsm* fsm, FILE* out, int max_entries);
+
+#endif // FSM_H
@@ -0,0 +1,122 @@
+/**
+Class         : CSC-615-01 - Embedded Linux - Fall 2024
+Team Name     : Wayno
+Github        : nhannguyensf
+Project       : Final Assignment - Robot Car
+File          : fsm_check.c
+Description:
+This file checks the state machine engine against a fake clock. A small machine with a parent state is driven
+through its transitions: the entry and exit handlers must run in order up to the common parent, an event the
+child does not handle must fall through to its parent, a timed transition must fire exactly when the fake clock
+reaches its deadline and the trace must record every transition at the fake time. Exits with 1 on a failure.
+    fsm_check
+*
+Team Members:
+Kiran Poudel
+Nhan Nguyen
+Yuvraj Gupta
+Fernando Abel Malca Luque
+
+*
+**/
+#include "fsm.h"
+#include <stdio.h>
+#include <string.h>
+
+#define STEP_TIMEOUT_US 500000
+
+enum { IDLE, ACTIVE, STEP_A, STEP_B, NUM_STATES };
+enum { EV_NONE = FSM_NO_EVENT, EV_GO, EV_TIMEOUT, EV_ABORT, NUM_EVENTS };
+
+static int64_t fake_us = 1000000;
+static char handler_log[256];
+static int failures = 0;
+
+static int64_t fake_clock(void* ctx) {
+    return *(int64_t*)ctx;
+}
+
+static void log_handler(const char* what) {
+    strncat(handler_log, what, sizeof(handler_log) - strlen(handler_log) - 1);
+}
+
+static void idle_entry(Fsm* fsm) { log_handler("+idle "); }
+static void idle_exit(Fsm* fsm) { log_handler("-idle "); }
+static void active_entry(Fsm* fsm) { log_handler("+active "); }
+static void active_exit(Fsm* fsm) { log_handler("-active "); }
+static void a_entry(Fsm* fsm) { log_handler("+a "); }
+static void a_exit(Fsm* fsm) { log_handler("-a "); }
+static void b_entry(Fsm* fsm) { log_handler("+b "); }
+static void b_exit(Fsm* fsm) { log_handler("-b "); }
+
+static int a_tick(Fsm* fsm) {
+    return fsm_elapsed_us(fsm) >= STEP_TIMEOUT_US ? EV_TIMEOUT : FSM_NO_EVENT;
+}
+
+static const FsmStateDef states[NUM_STATES] = {
+    [IDLE] = {"IDLE", FSM_NO_STATE, idle_entry, NULL, idle_exit},
+    [ACTIVE] = {"ACTIVE", FSM_NO_STATE, active_entry, NULL, active_exit},
+    [STEP_A] = {"STEP_A", ACTIVE, a_entry, a_tick, a_exit},
+    [STEP_B] = {"STEP_B", ACTIVE, b_entry, NULL, b_exit},
+};
+
+static const FsmTransition transitions[] = {
+    {IDLE, EV_GO, STEP_A},
+    {STEP_A, EV_TIMEOUT, STEP_B},
+    {ACTIVE, EV_ABORT, IDLE},
+};
+
+static const char* const event_names[NUM_EVENTS] = {"none", "go", "timeout", "abort"};
+
+static const FsmTable table = {
+    states, NUM_STATES, transitions, sizeof(transitions) / sizeof(transitions[0]), event_names, NUM_EVENTS
+};
+
+static void expect(int ok, const char* what) {
+    printf("%s: %s\n", ok ? "ok" : "FAILED", what);
+    if (!ok) failures++;
+}
+
+static void expect_log(const char* expected, const char* what) {
+    int ok = strcmp(handler_log, expected) == 0;
+    if (!ok) {
+        printf("  handlers ran \"%s\", expected \"%s\"\n", handler_log, expected);
+    }
+    expect(ok, what);
+    handler_log[0] = '\0';
+}
+
+int main(void) {
+    static Fsm fsm;
+    expect(fsm_init(&fsm, &table, IDLE, NULL) == 0, "table accepted");
+    fsm_set_clock(&fsm, fake_clock, &fake_us);
+    fsm_start(&fsm);
+    expect_log("+idle ", "start enters the initial state");
+
+    expect(fsm_dispatch(&fsm, EV_ABORT) == 0 && fsm_state(&fsm) == IDLE, "unhandled event is ignored");
+    expect(fsm_dispatch(&fsm, EV_GO) == 1 && fsm_state(&fsm) == STEP_A, "go enters STEP_A");
+    expect_log("-idle +active +a ", "entering a child enters its parent first");
+    expect(fsm_in_state(&fsm, ACTIVE), "STEP_A is inside ACTIVE");
+
+    fake_us += STEP_TIMEOUT_US - 1;
+    fsm_tick(&fsm);
+    expect(fsm_state(&fsm) == STEP_A, "no timeout one microsecond before the deadline");
+    fake_us += 1;
+    expect(fsm_elapsed_us(&fsm) == STEP_TIMEOUT_US, "elapsed time follows the fake clock");
+    fsm_tick(&fsm);
+    expect(fsm_state(&fsm) == STEP_B, "timeout at the deadline");
+    expect_log("-a +b ", "a sibling transition keeps the parent");
+
+    fake_us += 1234;
+    expect(fsm_dispatch(&fsm, EV_ABORT) == 1 && fsm_state(&fsm) == IDLE, "abort falls through to the parent");
+    expect_log("-b -active +idle ", "leaving the parent exits the child first");
+
+    expect(fsm.trace_count == 3, "three transitions traced");
+    expect(fsm.trace[1].from == STEP_A && fsm.trace[1].to == STEP_B && fsm.trace[1].event == EV_TIMEOUT
+           && fsm.trace[1].time_us == 1000000 + STEP_TIMEOUT_US, "timeout traced at the fake time");
+    expect(fsm.trace[2].time_us == 1000000 + STEP_TIMEOUT_US + 1234, "abort traced at the fake time");
+    fsm_dump_trace(&fsm, stdout, 0);
+
+    printf("%d failures\n", failures);
+    return failures ? 1 : 0;
+}
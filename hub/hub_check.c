@@ -0,0 +1,131 @@
+/**
+Class         : CSC-615-01 - Embedded Linux - Fall 2024
+Team Name     : Wayno
+Github        : nhannguyensf
+Project       : Final Assignment - Robot Car
+File          : hub_check.c
+Description:
+This file stress tests the triple buffer of the sensor hub. A producer thread publishes numbered values as fast as
+it can, each filling every word of a slot the size of a SensorSnapshot from its number, while the consumer takes
+the newest value in a tight loop. Both sides now and then yield the CPU halfway through a slot, so the other one
+runs while a slot is half written or half read even on a single core. Every value the consumer reads must have
+all of its words from the same number, or it was written while the consumer held it, and the numbers must never
+go backwards. Prints the values taken, the ones taken twice and the time per publish.
+Exits with 1 on any torn or out of order value.
+    hub_check [-n publishes]
+*
+Team Members:
+Kiran Poudel
+Nhan Nguyen
+Yuvraj Gupta
+Fernando Abel Malca Luque
+
+*
+**/
+#include "triple_buffer.h"
+#include "sensor_hub.h"
+#include <inttypes.h>
+#include <pthread.h>
+#include <sched.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <unistd.h>
+
+#define CHECK_WORDS (sizeof(SensorSnapshot) / sizeof(uint64_t))
+#define CHECK_YIELD_EVERY 64  // Both sides yield halfway through a slot this often, so even one CPU interleaves them
+
+typedef struct {
+    uint64_t seq;
+    uint64_t words[CHECK_WORDS];
+} CheckSlot;
+
+static CheckSlot slots[3];
+static TripleBuffer buffer;
+static uint64_t publishes = 20000000;
+static _Atomic int done = 0;
+
+static int64_t now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (int64_t)ts.tv_sec * 1000000000LL + ts.tv_nsec;
+}
+
+// Word i of the value numbered seq, different in every word so a mix of two values shows
+static inline uint64_t word_of(uint64_t seq, unsigned i) {
+    return seq * 0x9e3779b97f4a7c15ull + i;
+}
+
+// Fill the back slot with the value numbered seq and publish it
+static void publish(uint64_t seq) {
+    CheckSlot* slot = &slots[triple_back(&buffer)];
+    slot->seq = seq;
+    for (unsigned i = 0; i < CHECK_WORDS; i++) {
+        slot->words[i] = word_of(seq, i);
+        if (i == CHECK_WORDS / 2 && seq % CHECK_YIELD_EVERY == 0) sched_yield();
+    }
+    triple_publish(&buffer);
+}
+
+static void* producer_main(void* arg) {
+    for (uint64_t seq = 1; seq <= publishes; seq++) publish(seq);
+    atomic_store(&done, 1);
+    return NULL;
+}
+
+int main(int argc, char* argv[]) {
+    int opt;
+    while ((opt = getopt(argc, argv, "n:")) != -1) {
+        switch (opt) {
+            case 'n': publishes = strtoull(optarg, NULL, 10); break;
+            default:
+                fprintf(stderr, "Usage: %s [-n publishes]\n", argv[0]);
+                return 2;
+        }
+    }
+
+    // Value 0 is published before the consumer starts, so its first read is a whole value like every later one
+    triple_init(&buffer);
+    publish(0);
+    pthread_t producer;
+    int64_t start = now_ns();
+    if (pthread_create(&producer, NULL, producer_main, NULL) != 0) {
+        perror("pthread_create");
+        return 1;
+    }
+
+    uint64_t taken = 0;
+    uint64_t repeated = 0;
+    uint64_t torn = 0;
+    uint64_t backwards = 0;
+    uint64_t last = 0;
+    for (;;) {
+        // Read the flag first, a value published before it was set is still taken afterwards
+        int finished = atomic_load(&done);
+        const CheckSlot* slot = &slots[triple_acquire(&buffer)];
+        uint64_t seq = slot->seq;
+        for (unsigned i = 0; i < CHECK_WORDS; i++) {
+            if (i == CHECK_WORDS / 2 && taken % CHECK_YIELD_EVERY == 0) sched_yield();
+            if (slot->words[i] != word_of(seq, i)) {
+                torn++;
+                break;
+            }
+        }
+        if (seq < last) {
+            backwards++;
+        } else if (seq == last) {
+            repeated++;
+        }
+        last = seq;
+        taken++;
+        if (finished) break;
+    }
+    pthread_join(producer, NULL);
+    double elapsed_ns = (double)(now_ns() - start);
+
+    printf("%" PRIu64 " publishes of %zu bytes, %.1f ns each\n", publishes, sizeof(CheckSlot),
+           publishes ? elapsed_ns / publishes : 0.0);
+    printf("%" PRIu64 " values taken, %" PRIu64 " taken twice, last %" PRIu64 "\n", taken, repeated, last);
+    printf("%" PRIu64 " torn, %" PRIu64 " out of order\n", torn, backwards);
+    return torn || backwards || last != publishes ? 1 : 0;
+}
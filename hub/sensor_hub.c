@@ -0,0 +1,272 @@
+/**
+Class         : CSC-615-01 - Embedded Linux - Fall 2024
+Team Name     : Wayno
+Github        : nhannguyensf
+Project       : Final Assignment - Robot Car
+File          : sensor_hub.c
+Description:
+This file contains the sensor hub. Snapshots go through a triple buffer (triple_buffer.h): the hub thread fills
+its back slot and swaps it with the middle one, the control loop swaps its front slot with the middle one when the
+middle holds a snapshot it has not seen. Both swaps are a single atomic exchange, so neither side waits for the
+other and the control loop always owns the snapshot it is reading. The ages of the inputs are measured when the control loop
+takes a snapshot.
+*
+Team Members:
+Kiran Poudel
+Nhan Nguyen
+Yuvraj Gupta
+Fernando Abel Malca Luque
+
+*
+**/
+#include "sensor_hub.h"
+#include "triple_buffer.h"
+#include "../echoSensor/echoSensor.h"
+#include "../encoder/ls7336r.h"
+#include "../fsm/fsm.h"
+#include "../rgb/color_monitor.h"
+#include "../trace/trace.h"
+#include <pthread.h>
+#include <stdatomic.h>
+#include <string.h>
+#include <time.h>
+
+static SensorSnapshot slots[3];
+static TripleBuffer buffer = {1, 0, 2};
+
+static pthread_t hub_thread;
+static _Atomic int running = 0;
+static SensorHubConfig hub_config;
+static const SensorSnapshot* current = &slots[2];  // Snapshot rio_hub reads from
+static SensorSnapshot latest;  // Hub thread, the inputs not read in a period keep their last values
+static uint64_t samples = 0;
+
+static _Atomic uint64_t published = 0;
+static _Atomic uint64_t acquired = 0;
+static _Atomic uint64_t repeated = 0;
+static _Atomic int64_t max_age[HUB_NUM_INPUTS];
+static _Atomic int64_t sum_age[HUB_NUM_INPUTS];
+static _Atomic uint64_t aged[HUB_NUM_INPUTS];
+static uint64_t last_seq = UINT64_MAX;
+static ExecHistogram motor_latency;
+
+static const char* const input_names[HUB_NUM_INPUTS] = {"line", "distances", "encoders", "color"};
+
+const char* sensor_hub_input_name(int input) {
+    return input >= 0 && input < HUB_NUM_INPUTS ? input_names[input] : "unknown";
+}
+
+// Read the sensors due in this period into the latest values
+static void sample(SensorSnapshot* snap) {
+    read_line_sensors(snap->line_states);
+    snap->captured_us[HUB_LINE] = fsm_monotonic_us(NULL);
+
+    int64_t measured_us;
+    if (getCurrentDistancesAt(snap->distances, &measured_us) == 0) {
+        snap->distances_valid = true;
+        snap->captured_us[HUB_DISTANCES] = measured_us;
+    }
+
+    if (samples % HUB_ENCODER_EVERY == 0) {
+        TRACE_BEGIN("hub_encoders");
+        snap->encoders[0] = readLS7336RCounter(SPI0_CE0);
+        snap->encoders[1] = readLS7336RCounter(SPI0_CE1);
+        TRACE_END("hub_encoders");
+        snap->encoders_valid = true;
+        snap->captured_us[HUB_ENCODERS] = fsm_monotonic_us(NULL);
+    }
+
+    snap->color_class = color_monitor_class(&snap->color_since_us);
+    snap->color_red = color_monitor_red(NULL);
+    snap->captured_us[HUB_COLOR] = color_monitor_reading_us();
+    samples++;
+}
+
+static void publish(void) {
+    SensorSnapshot* snap = &slots[triple_back(&buffer)];
+    latest.seq = atomic_load_explicit(&published, memory_order_relaxed);
+    latest.published_us = fsm_monotonic_us(NULL);
+    *snap = latest;
+    triple_publish(&buffer);
+    atomic_fetch_add_explicit(&published, 1, memory_order_relaxed);
+    if (hub_config.queue) {
+        spsc_push(hub_config.queue, &latest);
+    }
+}
+
+static void* hub_main(void* arg) {
+    trace_thread_name("hub");
+    struct timespec next;
+    clock_gettime(CLOCK_MONOTONIC, &next);
+    while (atomic_load(&running)) {
+        next.tv_nsec += hub_config.period_us * 1000L;
+        while (next.tv_nsec >= 1000000000L) {
+            next.tv_nsec -= 1000000000L;
+            next.tv_sec++;
+        }
+        clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &next, NULL);
+
+        TRACE_BEGIN("hub_sample");
+        sample(&latest);
+        publish();
+        TRACE_END("hub_sample");
+    }
+    return NULL;
+}
+
+void sensor_hub_default_config(SensorHubConfig* config) {
+    config->period_us = HUB_DEFAULT_PERIOD_US;
+    config->cpu = -1;
+    config->rt_priority = 0;
+    config->queue = NULL;
+}
+
+int sensor_hub_start(const SensorHubConfig* config) {
+    if (atomic_load(&running)) return 0;
+    hub_config = *config;
+    if (hub_config.period_us <= 0) {
+        hub_config.period_us = HUB_DEFAULT_PERIOD_US;
+    }
+
+    // The control loop finds a complete snapshot from its first tick on
+    memset(&latest, 0, sizeof(latest));
+    latest.color_class = -1;
+    samples = 0;
+    sample(&latest);
+    publish();
+
+    atomic_store(&running, 1);
+    if (exec_thread_create(&hub_thread, hub_main, NULL, hub_config.cpu, hub_config.rt_priority) < 0) {
+        atomic_store(&running, 0);
+        return -1;
+    }
+    return 0;
+}
+
+void sensor_hub_stop(void) {
+    if (!atomic_load(&running)) return;
+    atomic_store(&running, 0);
+    pthread_join(hub_thread, NULL);
+}
+
+void sensor_hub_ages(const SensorSnapshot* snap, int64_t now_us, int64_t ages[HUB_NUM_INPUTS]) {
+    for (int i = 0; i < HUB_NUM_INPUTS; i++) {
+        ages[i] = snap->captured_us[i] > 0 ? now_us - snap->captured_us[i] : -1;
+    }
+}
+
+const SensorSnapshot* sensor_hub_acquire(void) {
+    const SensorSnapshot* snap = &slots[triple_acquire(&buffer)];
+    sensor_hub_use(snap);
+    return snap;
+}
+
+void sensor_hub_use(const SensorSnapshot* snap) {
+    current = snap;
+    atomic_fetch_add_explicit(&acquired, 1, memory_order_relaxed);
+    if (snap->seq == last_seq) {
+        atomic_fetch_add_explicit(&repeated, 1, memory_order_relaxed);
+    }
+    last_seq = snap->seq;
+
+    int64_t ages[HUB_NUM_INPUTS];
+    sensor_hub_ages(snap, fsm_monotonic_us(NULL), ages);
+    for (int i = 0; i < HUB_NUM_INPUTS; i++) {
+        if (ages[i] < 0) continue;
+        if (ages[i] > atomic_load_explicit(&max_age[i], memory_order_relaxed)) {
+            atomic_store_explicit(&max_age[i], ages[i], memory_order_relaxed);
+        }
+        atomic_fetch_add_explicit(&sum_age[i], ages[i], memory_order_relaxed);
+        atomic_fetch_add_explicit(&aged[i], 1, memory_order_relaxed);
+    }
+}
+
+const SensorSnapshot* sensor_hub_current(void) {
+    return current;
+}
+
+void sensor_hub_record_motor(int64_t sensed_us) {
+    exec_hist_add(&motor_latency, (long)(fsm_monotonic_us(NULL) - sensed_us));
+}
+
+void sensor_hub_get_stats(SensorHubStats* out) {
+    out->published = atomic_load(&published);
+    out->acquired = atomic_load(&acquired);
+    out->repeated = atomic_load(&repeated);
+    for (int i = 0; i < HUB_NUM_INPUTS; i++) {
+        uint64_t n = atomic_load(&aged[i]);
+        out->max_age_us[i] = atomic_load(&max_age[i]);
+        out->mean_age_us[i] = n ? (double)atomic_load(&sum_age[i]) / n : 0.0;
+    }
+    out->queue_full = hub_config.queue ? hub_config.queue->full : 0;
+    out->motor_latency = motor_latency;
+}
+
+void sensor_hub_print_stats(FILE* out) {
+    SensorHubStats stats;
+    sensor_hub_get_stats(&stats);
+    fprintf(out, "Sensor hub: %llu snapshots published, %llu taken, %llu taken twice\n",
+            (unsigned long long)stats.published, (unsigned long long)stats.acquired,
+            (unsigned long long)stats.repeated);
+    for (int i = 0; i < HUB_NUM_INPUTS; i++) {
+        fprintf(out, "  %-10s age mean %8.0f us, max %8lld us\n", input_names[i], stats.mean_age_us[i],
+                (long long)stats.max_age_us[i]);
+    }
+    if (hub_config.queue) {
+        fprintf(out, "  %llu snapshots did not fit in the queue\n", (unsigned long long)stats.queue_full);
+    }
+    exec_hist_print(out, "Sensor to motor latency", &stats.motor_latency);
+}
+
+// ---- Control loop backend ----
+
+static void hub_begin_tick(void* ctx) {
+    sensor_hub_acquire();
+}
+
+static int64_t hub_now_us(void* ctx) {
+    return rio_hardware.now_us(ctx);
+}
+
+static void hub_read_line(void* ctx, int sensor_states[NUM_SENSORS]) {
+    memcpy(sensor_states, current->line_states, sizeof(current->line_states));
+}
+
+static int hub_get_distances(void* ctx, double distances[NUM_SENSORS]) {
+    const SensorSnapshot* snap = current;
+    if (!snap->distances_valid) return -1;
+    memcpy(distances, snap->distances, sizeof(snap->distances));
+    return 0;
+}
+
+static int hub_read_encoders(void* ctx, int32_t counts[RIO_NUM_ENCODERS]) {
+    const SensorSnapshot* snap = current;
+    if (!snap->encoders_valid) return -1;
+    memcpy(counts, snap->encoders, sizeof(snap->encoders));
+    return 0;
+}
+
+static int hub_read_color(void* ctx, uint16_t rgbc[4]) {
+    return rio_hardware.read_color(ctx, rgbc);
+}
+
+static void hub_motor_run(void* ctx, int left, int right) {
+    rio_hardware.motor_run(ctx, left, right);
+    sensor_hub_record_motor(current->captured_us[HUB_LINE]);
+}
+
+static int hub_refresh_params(void* ctx, ControlParams* params) {
+    return rio_hardware.refresh_params(ctx, params);
+}
+
+const RobotIO rio_hub = {
+    .name = "hub",
+    .begin_tick = hub_begin_tick,
+    .now_us = hub_now_us,
+    .read_line = hub_read_line,
+    .get_distances = hub_get_distances,
+    .read_encoders = hub_read_encoders,
+    .read_color = hub_read_color,
+    .motor_run = hub_motor_run,
+    .refresh_params = hub_refresh_params,
+};
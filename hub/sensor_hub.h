@@ -0,0 +1,101 @@
+/**
+Class         : CSC-615-01 - Embedded Linux - Fall 2024
+Team Name     : Wayno
+Github        : nhannguyensf
+Project       : Final Assignment - Robot Car
+File          : sensor_hub.h
+Description:
+This file is the header file for the sensor_hub.c file. The sensor hub samples every sensor of the car on its own
+thread and publishes the results together as one snapshot: the line sensors, the echo distances, the encoder
+counts and the color monitor's class, each with the time it was captured. The control loop takes the newest
+snapshot once per tick through the rio_hub backend, so all the inputs of a tick come from the same snapshot and
+reading them never waits for a lock or a bus transfer. With a queue in the configuration every snapshot is also
+pushed to it, for the pipeline's control stage. The time from capturing the line sensors to the motor command
+that reacts to them is measured for every command.
+*
+Team Members:
+Kiran Poudel
+Nhan Nguyen
+Yuvraj Gupta
+Fernando Abel Malca Luque
+
+*
+**/
+#ifndef SENSOR_HUB_H
+#define SENSOR_HUB_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include "../robotio/robotio.h"
+#include "../executive/control_exec.h"
+#include "../pipeline/spsc.h"
+
+#define HUB_DEFAULT_PERIOD_US 2000  // A snapshot is at most this old when the control loop takes it
+#define HUB_ENCODER_EVERY 5         // Reading both encoders takes about 0.8 ms, so they are read every 5th period
+
+// Inputs of a snapshot, each with its own capture time
+typedef enum {
+    HUB_LINE,
+    HUB_DISTANCES,
+    HUB_ENCODERS,
+    HUB_COLOR,
+    HUB_NUM_INPUTS
+} HubInput;
+
+// Everything the control loop reads in one tick. A published snapshot is never written again until the
+// control loop has moved on to a newer one.
+typedef struct {
+    uint64_t seq;                         // Published snapshots before this one
+    int64_t published_us;
+    int64_t captured_us[HUB_NUM_INPUTS];  // fsm_monotonic_us time of each input, 0 if it was never captured
+    int line_states[NUM_SENSORS];
+    double distances[NUM_SENSORS];
+    bool distances_valid;
+    int32_t encoders[RIO_NUM_ENCODERS];
+    bool encoders_valid;
+    int color_class;                      // color_monitor_class, -1 for none
+    bool color_red;
+    int64_t color_since_us;
+} SensorSnapshot;
+
+typedef struct {
+    long period_us;
+    int cpu;            // CPU to pin the hub thread to, -1 for no affinity
+    int rt_priority;    // SCHED_FIFO priority, 0 for a normal thread
+    SpscQueue* queue;   // Also push every snapshot here, NULL for none
+} SensorHubConfig;
+
+typedef struct {
+    uint64_t published;
+    uint64_t acquired;
+    uint64_t repeated;                  // Ticks that got the same snapshot as the tick before
+    int64_t max_age_us[HUB_NUM_INPUTS]; // Age of the inputs when the control loop took the snapshot
+    double mean_age_us[HUB_NUM_INPUTS];
+    uint64_t queue_full;                // Snapshots the queue had no room for
+    ExecHistogram motor_latency;        // Line sensor capture to motor command written
+} SensorHubStats;
+
+// Control loop backend: sensor reads come from the snapshot taken at the start of the tick, the clock, motors and
+// parameters go to the hardware
+extern const RobotIO rio_hub;
+
+void sensor_hub_default_config(SensorHubConfig* config);
+// Take a first snapshot and start sampling every period
+int sensor_hub_start(const SensorHubConfig* config);
+void sensor_hub_stop(void);
+// Newest snapshot, only to be called from one thread. It stays valid until the next call.
+const SensorSnapshot* sensor_hub_acquire(void);
+// Make the snapshot the one rio_hub reads from, for a snapshot taken from the queue
+void sensor_hub_use(const SensorSnapshot* snap);
+// Snapshot rio_hub reads from
+const SensorSnapshot* sensor_hub_current(void);
+// A motor command reacting to the line sensors captured at sensed_us has been written, from one thread at a time
+void sensor_hub_record_motor(int64_t sensed_us);
+// Age of every input at now_us, -1 for an input that was never captured
+void sensor_hub_ages(const SensorSnapshot* snap, int64_t now_us, int64_t ages[HUB_NUM_INPUTS]);
+void sensor_hub_get_stats(SensorHubStats* out);
+void sensor_hub_print_stats(FILE* out);
+const char* sensor_hub_input_name(int input);
+
+#endif
@@ -0,0 +1,68 @@
+/**
+Class         : CSC-615-01 - Embedded Linux - Fall 2024
+Team Name     : Wayno
+Github        : nhannguyensf
+Project       : Final Assignment - Robot Car
+File          : triple_buffer.h
+Description:
+This file contains the exchange protocol of a triple buffer between one producer and one consumer thread. The
+caller owns the three slots, the buffer only hands out their indices: the producer fills its back slot and swaps
+it with the middle one, the consumer swaps its front slot with the middle one when the middle holds a value it has
+not taken. Both swaps are a single atomic exchange, so neither side waits for the other, and the slot a side owns
+is never touched by the other one.
+*
+Team Members:
+Kiran Poudel
+Nhan Nguyen
+Yuvraj Gupta
+Fernando Abel Malca Luque
+
+*
+**/
+#ifndef TRIPLE_BUFFER_H
+#define TRIPLE_BUFFER_H
+
+#include <stdatomic.h>
+#include <stdbool.h>
+
+#define TRIPLE_SLOT_MASK 0x3u
+#define TRIPLE_FRESH 0x4u  // The middle slot holds a value the consumer has not taken
+
+typedef struct {
+    _Atomic unsigned middle;
+    unsigned back;   // Producer
+    unsigned front;  // Consumer
+} TripleBuffer;
+
+static inline void triple_init(TripleBuffer* tb) {
+    atomic_init(&tb->middle, 1);
+    tb->back = 0;
+    tb->front = 2;
+}
+
+// Producer: slot to fill before the next publish
+static inline unsigned triple_back(const TripleBuffer* tb) {
+    return tb->back;
+}
+
+// Producer: hand the filled back slot to the consumer and take over the middle one
+static inline void triple_publish(TripleBuffer* tb) {
+    tb->back = atomic_exchange_explicit(&tb->middle, tb->back | TRIPLE_FRESH, memory_order_acq_rel)
+               & TRIPLE_SLOT_MASK;
+}
+
+// Consumer: whether a value was published since the last acquire
+static inline bool triple_fresh(TripleBuffer* tb) {
+    return atomic_load_explicit(&tb->middle, memory_order_relaxed) & TRIPLE_FRESH;
+}
+
+// Consumer: take the newest value if there is one, returns the slot to read, which stays the consumer's until the
+// next call
+static inline unsigned triple_acquire(TripleBuffer* tb) {
+    if (triple_fresh(tb)) {
+        tb->front = atomic_exchange_explicit(&tb->middle, tb->front, memory_order_acq_rel) & TRIPLE_SLOT_MASK;
+    }
+    return tb->front;
+}
+
+#endif
@@ -0,0 +1,155 @@
+/**
+Class         : CSC-615-01 - Embedded Linux - Fall 2024
+Team Name     : Wayno
+Github        : nhannguyensf
+Project       : Final Assignment - Robot Car
+File          : line_history.c
+Description:
+This file contains the long duration line sensor history. Readings are stored as one byte masks in a ring buffer
+together with a 16-bit delta from the previous entry, and a new entry is only written when the mask changes.
+The buffer keeps the latest time each sensor was active so "when did sensor k last see the line" is O(1), and it
+can walk the pattern history backwards for intersection and curve detection.
+*
+Team Members:
+Kiran Poudel
+Nhan Nguyen
+Yuvraj Gupta
+Fernando Abel Malca Luque
+
+*
+**/
+#include "line_history.h"
+#include <string.h>
+
+#define INDEX_MASK (LINE_HISTORY_CAPACITY - 1)
+
+// Append a run to the ring, dropping the oldest run when full
+static void append_run(LineHistory* hist, uint8_t mask, uint16_t delta) {
+    if (hist->count == LINE_HISTORY_CAPACITY) {
+        // The run after the oldest one becomes the new oldest
+        uint32_t oldest = (hist->head - hist->count) & INDEX_MASK;
+        hist->oldest_tick += hist->deltas[(oldest + 1) & INDEX_MASK];
+        hist->count--;
+    }
+    hist->masks[hist->head] = mask;
+    hist->deltas[hist->head] = delta;
+    hist->head = (hist->head + 1) & INDEX_MASK;
+    hist->count++;
+}
+
+// Initialize an empty history
+void line_history_init(LineHistory* hist) {
+    memset(hist, 0, sizeof(*hist));
+}
+
+// Add one sample, consecutive identical masks are merged into one run
+void line_history_push(LineHistory* hist, uint8_t mask, uint64_t now_us) {
+    uint64_t tick = now_us / LINE_HISTORY_TICK_US;
+    mask &= LINE_MASK_ALL;
+
+    if (hist->count == 0) {
+        append_run(hist, mask, 0);
+        hist->newest_tick = tick;
+        hist->oldest_tick = tick;
+    } else if (mask != line_history_current(hist) && tick >= hist->newest_tick) {
+        // Split gaps that do not fit in 16 bits into repeats of the previous mask
+        uint8_t previous = line_history_current(hist);
+        while (tick - hist->newest_tick > LINE_HISTORY_MAX_DELTA) {
+            append_run(hist, previous, LINE_HISTORY_MAX_DELTA);
+            hist->newest_tick += LINE_HISTORY_MAX_DELTA;
+        }
+        append_run(hist, mask, (uint16_t)(tick - hist->newest_tick));
+        hist->newest_tick = tick;
+    }
+
+    // Ticks are stored off by one so that zero means "never active"
+    for (int i = 0; i < NUM_SENSORS; i++) {
+        if (mask & (1u << i)) {
+            hist->last_active_tick[i] = tick + 1;
+        }
+    }
+    hist->last_sample_tick = tick;
+    hist->samples++;
+}
+
+// Mask of the newest run
+uint8_t line_history_current(const LineHistory* hist) {
+    if (hist->count == 0) return 0;
+    return hist->masks[(hist->head - 1) & INDEX_MASK];
+}
+
+// Latest time sensor k saw the line in microseconds, 0 if it never did
+uint64_t line_history_last_active_us(const LineHistory* hist, int sensor) {
+    if (sensor < 0 || sensor >= NUM_SENSORS || hist->last_active_tick[sensor] == 0) {
+        return 0;
+    }
+    return (hist->last_active_tick[sensor] - 1) * LINE_HISTORY_TICK_US;
+}
+
+// Walk the runs newest first, calling back until the visitor returns nonzero
+static int walk_runs(const LineHistory* hist, int (*visit)(const LineEvent*, void*), void* arg) {
+    uint64_t start = hist->newest_tick;
+    uint64_t end = hist->last_sample_tick;
+    uint32_t idx = (hist->head - 1) & INDEX_MASK;
+
+    for (uint32_t n = 0; n < hist->count; n++) {
+        LineEvent event;
+        event.mask = hist->masks[idx];
+        event.start_us = start * LINE_HISTORY_TICK_US;
+        event.duration_us = (end - start) * LINE_HISTORY_TICK_US;
+        if (visit(&event, arg)) {
+            return 1;
+        }
+        end = start;
+        start -= hist->deltas[idx];
+        idx = (idx - 1) & INDEX_MASK;
+    }
+    return 0;
+}
+
+typedef struct {
+    uint8_t want;
+    uint8_t care;
+    LineEvent* found;
+} FindArgs;
+
+static int visit_find(const LineEvent* event, void* arg) {
+    FindArgs* find = arg;
+    if ((event->mask & find->care) == find->want) {
+        *find->found = *event;
+        return 1;
+    }
+    return 0;
+}
+
+// Find the newest run where (mask & care) == want, returns 1 if found
+int line_history_find(const LineHistory* hist, uint8_t want, uint8_t care, LineEvent* event) {
+    FindArgs find = {want, care, event};
+    return walk_runs(hist, visit_find, &find);
+}
+
+typedef struct {
+    LineEvent* events;
+    int max_events;
+    int filled;
+} RecentArgs;
+
+static int visit_recent(const LineEvent* event, void* arg) {
+    RecentArgs* recent = arg;
+    recent->events[recent->filled++] = *event;
+    return recent->filled >= recent->max_events;
+}
+
+// Copy up to max_events of the newest runs, newest first, returns the number copied
+int line_history_recent(const LineHistory* hist, LineEvent* events, int max_events) {
+    if (max_events <= 0) return 0;
+    RecentArgs recent = {events, max_events, 0};
+    walk_runs(hist, visit_recent, &recent);
+    return recent.filled;
+}
+
+// Length of time covered by the history in microseconds
+uint64_t line_history_span_us(const LineHistory* hist) {
+    if (hist->count == 0) return 0;
+    return (hist->last_sample_tick - hist->oldest_tick) * LINE_HISTORY_TICK_US;
+}
@@ -0,0 +1,65 @@
+/**
+Class         : CSC-615-01 - Embedded Linux - Fall 2024
+Team Name     : Wayno
+Github        : nhannguyensf
+Project       : Final Assignment - Robot Car
+File          : line_history.h
+Description:
+This file is the header file for the line_history.c file. It declares a fixed size ring buffer that keeps
+a long history of line sensor readings as packed 5-bit masks (one byte per entry) with delta encoded timestamps.
+Consecutive identical readings are merged into one entry, so the buffer holds hours of data at kHz sample rates.
+*
+Team Members:
+Kiran Poudel
+Nhan Nguyen
+Yuvraj Gupta
+Fernando Abel Malca Luque
+
+*
+**/
+#ifndef LINE_HISTORY_H
+#define LINE_HISTORY_H
+
+#include <stdint.h>
+#include "line_sensor.h"
+
+// Number of entries in the ring (must be a power of two), 3 bytes per entry
+#define LINE_HISTORY_CAPACITY 65536
+// Timestamp resolution of the history in microseconds
+#define LINE_HISTORY_TICK_US 100
+// Largest delta that fits in one entry, longer gaps are split into repeat entries
+#define LINE_HISTORY_MAX_DELTA 0xFFFF
+
+// Mask with every line sensor active (intersection / stop bar)
+#define LINE_MASK_ALL ((1u << NUM_SENSORS) - 1)
+
+// One run of identical readings returned by the history queries
+typedef struct {
+    uint8_t mask;          // Bit i set when sensor i saw the line
+    uint64_t start_us;     // Time the run started
+    uint64_t duration_us;  // How long the run lasted
+} LineEvent;
+
+// Ring buffer of run length encoded line sensor masks
+typedef struct {
+    uint8_t masks[LINE_HISTORY_CAPACITY];    // Mask of each run
+    uint16_t deltas[LINE_HISTORY_CAPACITY];  // Ticks since the previous run started
+    uint32_t head;                           // Next slot to write
+    uint32_t count;                          // Number of valid runs
+    uint64_t newest_tick;                    // Start tick of the newest run
+    uint64_t oldest_tick;                    // Start tick of the oldest run
+    uint64_t last_sample_tick;               // Tick of the latest sample pushed
+    uint64_t last_active_tick[NUM_SENSORS];  // Latest tick each sensor was active, 0 if never
+    uint64_t samples;                        // Total samples pushed
+} LineHistory;
+
+// Function Prototypes
+void line_history_init(LineHistory* hist);
+void line_history_push(LineHistory* hist, uint8_t mask, uint64_t now_us);
+uint8_t line_history_current(const LineHistory* hist);
+uint64_t line_history_last_active_us(const LineHistory* hist, int sensor);
+int line_history_find(const LineHistory* hist, uint8_t want, uint8_t care, LineEvent* event);
+int line_history_recent(const LineHistory* hist, LineEvent* events, int max_events);
+uint64_t line_history_span_us(const LineHistory* hist);
+
+#endif // LINE_HISTORY_H
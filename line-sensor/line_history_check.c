@@ -0,0 +1,208 @@
+/**
+Class         : CSC-615-01 - Embedded Linux - Fall 2024
+Team Name     : Wayno
+Github        : nhannguyensf
+Project       : Final Assignment - Robot Car
+File          : line_history_check.c
+Description:
+This file checks the line sensor history against a brute-force reference that keeps every sample and every run in
+plain growing arrays. Random masks are pushed with random sub-tick times in phases: short gaps that wrap the ring
+several times, gaps around and far beyond the largest 16-bit delta, and long stretches where a sensor stays dark.
+After every push the current mask and the "last time sensor k was active" queries are compared with a backwards
+scan of all samples, and at checkpoints the whole ring returned by line_history_recent, the span and random
+line_history_find patterns are compared with the reference runs. Exits with 1 on any difference.
+    line_history_check
+*
+Team Members:
+Kiran Poudel
+Nhan Nguyen
+Yuvraj Gupta
+Fernando Abel Malca Luque
+
+*
+**/
+#include "line_history.h"
+#include <stdio.h>
+#include <stdlib.h>
+
+#define CHECKPOINT_PUSHES 4096  // Pushes between full comparisons of the ring
+#define FIND_QUERIES 64         // Random patterns looked up at each checkpoint
+
+typedef struct {
+    uint8_t mask;
+    uint64_t tick;
+} RefEntry;
+
+// Every sample pushed and every run the history should hold, oldest first
+typedef struct {
+    RefEntry* samples;
+    size_t num_samples;
+    size_t max_samples;
+    RefEntry* runs;  // tick is the start of the run
+    size_t num_runs;
+    size_t max_runs;
+} Reference;
+
+static LineHistory hist;
+static Reference ref;
+static LineEvent events[LINE_HISTORY_CAPACITY];
+static uint64_t now_us;
+static long failures = 0;
+
+static void fail(const char* what, uint64_t got, uint64_t want) {
+    if (failures++ < 20) {
+        printf("FAIL after %zu samples: %s is %llu, the reference %llu\n", ref.num_samples, what,
+               (unsigned long long)got, (unsigned long long)want);
+    }
+}
+
+static void append(RefEntry** list, size_t* count, size_t* capacity, uint8_t mask, uint64_t tick) {
+    if (*count == *capacity) {
+        *capacity = *capacity ? 2 * *capacity : 4096;
+        *list = realloc(*list, *capacity * sizeof(RefEntry));
+        if (!*list) {
+            perror("realloc");
+            exit(2);
+        }
+    }
+    (*list)[*count].mask = mask;
+    (*list)[*count].tick = tick;
+    (*count)++;
+}
+
+// The runs as documented: a new run per mask change, and a gap too long for 16 bits is filled with repeats of
+// the previous mask every LINE_HISTORY_MAX_DELTA ticks
+static void ref_push(uint8_t mask, uint64_t us) {
+    uint64_t tick = us / LINE_HISTORY_TICK_US;
+    mask &= LINE_MASK_ALL;
+    append(&ref.samples, &ref.num_samples, &ref.max_samples, mask, tick);
+    if (ref.num_runs > 0 && ref.runs[ref.num_runs - 1].mask == mask) return;
+    while (ref.num_runs > 0 && tick - ref.runs[ref.num_runs - 1].tick > LINE_HISTORY_MAX_DELTA) {
+        const RefEntry* last = &ref.runs[ref.num_runs - 1];
+        append(&ref.runs, &ref.num_runs, &ref.max_runs, last->mask, last->tick + LINE_HISTORY_MAX_DELTA);
+    }
+    append(&ref.runs, &ref.num_runs, &ref.max_runs, mask, tick);
+}
+
+// Latest sample with the sensor active, scanning back from the newest
+static uint64_t ref_last_active_us(int sensor) {
+    for (size_t i = ref.num_samples; i-- > 0;) {
+        if (ref.samples[i].mask & (1u << sensor)) return ref.samples[i].tick * LINE_HISTORY_TICK_US;
+    }
+    return 0;
+}
+
+// The n-th newest run the ring still holds as the history reports it
+static LineEvent ref_event(size_t n) {
+    size_t i = ref.num_runs - 1 - n;
+    uint64_t end = n == 0 ? ref.samples[ref.num_samples - 1].tick : ref.runs[i + 1].tick;
+    LineEvent event = {ref.runs[i].mask, ref.runs[i].tick * LINE_HISTORY_TICK_US,
+                       (end - ref.runs[i].tick) * LINE_HISTORY_TICK_US};
+    return event;
+}
+
+static size_t ref_retained(void) {
+    return ref.num_runs < LINE_HISTORY_CAPACITY ? ref.num_runs : LINE_HISTORY_CAPACITY;
+}
+
+static int same_event(const LineEvent* a, const LineEvent* b) {
+    return a->mask == b->mask && a->start_us == b->start_us && a->duration_us == b->duration_us;
+}
+
+static void push(uint8_t mask) {
+    line_history_push(&hist, mask, now_us);
+    ref_push(mask, now_us);
+    uint8_t want = ref.runs[ref.num_runs - 1].mask;
+    if (line_history_current(&hist) != want) fail("current mask", line_history_current(&hist), want);
+    for (int k = 0; k < NUM_SENSORS; k++) {
+        uint64_t got = line_history_last_active_us(&hist, k);
+        uint64_t expected = ref_last_active_us(k);
+        if (got != expected) fail("last active time", got, expected);
+    }
+}
+
+// Compare the whole ring, the span and random patterns with the reference
+static void checkpoint(unsigned* seed) {
+    size_t retained = ref_retained();
+    int count = line_history_recent(&hist, events, LINE_HISTORY_CAPACITY);
+    if ((size_t)count != retained) fail("number of runs", count, retained);
+    for (int n = 0; n < count && (size_t)n < retained; n++) {
+        LineEvent want = ref_event(n);
+        if (!same_event(&events[n], &want)) {
+            fail("run start", events[n].start_us, want.start_us);
+            break;
+        }
+    }
+    uint64_t span = (ref.samples[ref.num_samples - 1].tick - ref.runs[ref.num_runs - retained].tick)
+                    * LINE_HISTORY_TICK_US;
+    if (line_history_span_us(&hist) != span) fail("span", line_history_span_us(&hist), span);
+
+    for (int q = 0; q < FIND_QUERIES; q++) {
+        uint8_t care = rand_r(seed) & LINE_MASK_ALL;
+        uint8_t want = rand_r(seed) & care;
+        LineEvent got, expected;
+        int found = line_history_find(&hist, want, care, &got);
+        int ref_found = 0;
+        for (size_t n = 0; n < retained && !ref_found; n++) {
+            expected = ref_event(n);
+            ref_found = (expected.mask & care) == want;
+        }
+        if (found != ref_found) {
+            fail("pattern found", found, ref_found);
+        } else if (found && !same_event(&got, &expected)) {
+            fail("pattern run start", got.start_us, expected.start_us);
+        }
+    }
+}
+
+// Push count samples after gaps of min_us to max_us, each mask held with probability hold in 256 and never
+// lighting the sensors of dark_mask
+static void phase(const char* name, unsigned* seed, long count, uint64_t min_us, uint64_t max_us, int hold,
+                  uint8_t dark_mask) {
+    long before = failures;
+    size_t runs_before = ref.num_runs;
+    uint8_t mask = line_history_current(&hist);
+    for (long i = 0; i < count; i++) {
+        uint64_t r = ((uint64_t)rand_r(seed) << 31) | (uint64_t)rand_r(seed);
+        now_us += min_us + r % (max_us - min_us + 1);
+        if (rand_r(seed) % 256 >= (unsigned)hold) {
+            mask = rand_r(seed) & LINE_MASK_ALL & ~dark_mask;
+        }
+        push(mask);
+        if ((i + 1) % CHECKPOINT_PUSHES == 0 || i + 1 == count) {
+            checkpoint(seed);
+        }
+    }
+    printf("  %-34s %8ld samples, %8zu runs, %s\n", name, count, ref.num_runs - runs_before,
+           failures == before ? "ok" : "FAILED");
+}
+
+int main(void) {
+    unsigned seed = 1;
+    line_history_init(&hist);
+    LineEvent event;
+    if (line_history_current(&hist) != 0 || line_history_recent(&hist, events, 1) != 0
+        || line_history_find(&hist, 0, 0, &event) != 0 || line_history_span_us(&hist) != 0) {
+        fail("empty history", 1, 0);
+    }
+    if (line_history_last_active_us(&hist, -1) != 0 || line_history_last_active_us(&hist, NUM_SENSORS) != 0) {
+        fail("unknown sensor", 1, 0);
+    }
+
+    uint64_t tick = LINE_HISTORY_TICK_US;
+    uint64_t max_gap = (uint64_t)LINE_HISTORY_MAX_DELTA * tick;
+    now_us = 123456789;
+    printf("Line history of %d runs, %d us ticks, deltas up to %d ticks\n", LINE_HISTORY_CAPACITY,
+           LINE_HISTORY_TICK_US, LINE_HISTORY_MAX_DELTA);
+    phase("sensor 4 dark, sub-tick gaps", &seed, 20000, 0, 3 * tick, 64, 1u << 4);
+    phase("short gaps, wraps the ring", &seed, 4L * LINE_HISTORY_CAPACITY, 1, 40 * tick, 128, 0);
+    phase("gaps around the largest delta", &seed, 30000, max_gap - 2 * tick, max_gap + 2 * tick, 32, 0);
+    phase("gaps of up to 40 deltas", &seed, 8000, 0, 40 * max_gap, 64, 0);
+    phase("sensors 0 and 2 dark, long gaps", &seed, 20000, 0, 3 * max_gap, 200, 0x05);
+    phase("short gaps again, wraps the ring", &seed, 2L * LINE_HISTORY_CAPACITY, 0, 10 * tick, 128, 0);
+
+    printf("%zu samples, %zu runs, %ld failures\n", ref.num_samples, ref.num_runs, failures);
+    free(ref.samples);
+    free(ref.runs);
+    return failures ? 1 : 0;
+}
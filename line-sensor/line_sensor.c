@@ -16,14 +16,15 @@ Fernando Abel Malca Luque
 *
 **/ 
 #include "line_sensor.h"
+#include "line_history.h"
 #include <bcm2835.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <time.h>
 #include <unistd.h>
 
-// Array to store sensor readings
-int sensor_readings[MAX_READINGS][NUM_SENSORS];
+// History of sensor readings recorded by the test
+static LineHistory history;
 int reading_index = 0;
 
 // Initialize the line sensors GPIO pins
@@ -50,10 +51,22 @@ void read_line_sensors(int* sensor_states) {
     sensor_states[4] = bcm2835_gpio_lev(SENSOR_4_PIN);
 }
 
+// Read the state of all line sensors packed as a mask, bit i is sensor i
+unsigned char read_line_mask(void) {
+    return (bcm2835_gpio_lev(SENSOR_0_PIN) << 0) |
+           (bcm2835_gpio_lev(SENSOR_1_PIN) << 1) |
+           (bcm2835_gpio_lev(SENSOR_2_PIN) << 2) |
+           (bcm2835_gpio_lev(SENSOR_3_PIN) << 3) |
+           (bcm2835_gpio_lev(SENSOR_4_PIN) << 4);
+}
+
 // Test the line sensors and store results in an array
 void test_line_sensors() {
     time_t start_time = time(NULL);
     time_t current_time;
+    struct timespec now;
+
+    line_history_init(&history);
 
     while (1) {
         current_time = time(NULL);
@@ -63,20 +76,33 @@ void test_line_sensors() {
             break;
         }
 
-        // Read the sensor states and store them in the array
-        if (reading_index < MAX_READINGS) {
-            read_line_sensors(sensor_readings[reading_index]);
-            reading_index++;
-        }
+        // Read the sensor states and store them in the history
+        unsigned char mask = read_line_mask();
+        clock_gettime(CLOCK_MONOTONIC, &now);
+        line_history_push(&history, mask, (uint64_t)now.tv_sec * 1000000 + now.tv_nsec / 1000);
+        reading_index++;
 
         // Print the states of the line sensors as 1 or 0
         printf("Reading #%d:", reading_index);
         for (int i = 0; i < NUM_SENSORS; i++) {
-            printf(" %d", sensor_readings[reading_index - 1][i]);
+            printf(" %d", (mask >> i) & 1);
         }
         printf("\n");
 
         fflush(stdout);  // Ensure output is displayed immediately
         usleep(50000);   // Sleep for 50ms
     }
+
+    // Summarize how much history was kept
+    printf("History: %u runs covering %.1f s\n", history.count,
+           line_history_span_us(&history) / 1e6);
+    for (int i = 0; i < NUM_SENSORS; i++) {
+        uint64_t last = line_history_last_active_us(&history, i);
+        if (last) {
+            printf("Sensor %d last active %.3f s ago\n", i,
+                   (double)(history.last_sample_tick * LINE_HISTORY_TICK_US - last) / 1e6);
+        } else {
+            printf("Sensor %d never active\n", i);
+        }
+    }
 }
@@ -25,17 +25,21 @@
 // Define total number of sensors
 #define NUM_SENSORS 5
 
-// Define time duration and array size
+// Geometry of the sensor bar, sensor 0 is on the right and sensor 4 on the left
+#define LINE_SENSOR_SPACING_CM 1.5    // Distance between neighbouring sensors
+#define LINE_SENSOR_LOOKAHEAD_CM 6.0  // Distance of the bar in front of the wheel axle
+#define LINE_SENSOR_SPOT_CM 0.5       // Diameter of the spot each sensor sees on the floor
+
+// Define test duration
 #define TIME_DURATION_SECONDS 20
-#define MAX_READINGS 400  // Assuming 50ms intervals for 20 seconds
 
-// Array to store sensor readings
-extern int sensor_readings[MAX_READINGS][NUM_SENSORS];
+// Number of readings taken by the test
 extern int reading_index;
 
 // Function Prototypes
 void line_sensors_init();                 // Initialize GPIO pins for line sensors
 void read_line_sensors(int* sensor_states); // Read the states of all sensors
+unsigned char read_line_mask(void);       // Read all sensors packed as a bit mask
 void test_line_sensors();                 // Test the line sensors and log data
 
 #endif // LINE_SENSOR_H
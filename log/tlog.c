@@ -0,0 +1,392 @@
+/**
+Class         : CSC-615-01 - Embedded Linux - Fall 2024
+Team Name     : Wayno
+Github        : nhannguyensf
+Project       : Final Assignment - Robot Car
+File          : tlog.c
+Description:
+This file contains the binary telemetry logger. Every thread that logs gets its own single producer single
+consumer ring of fixed size records, so a log call is a timestamp, a few stores and one release store of the
+ring head. The writer thread polls the rings, gives every call site a small id the first time it sees it and
+writes the site (file, line, format) once and after that only the id and the raw arguments. Repeated messages
+from one call site are rate limited and the number of suppressed messages is carried by the next record that
+gets through. When the logger is not running the messages are printed directly like before.
+*
+Team Members:
+Kiran Poudel
+Nhan Nguyen
+Yuvraj Gupta
+Fernando Abel Malca Luque
+
+*
+**/
+#include "tlog.h"
+#include <pthread.h>
+#include <stdatomic.h>
+#include <string.h>
+#include <time.h>
+
+#define RING_MASK (TLOG_RING_SIZE - 1)
+// How long the writer sleeps when all rings are empty
+#define WRITER_IDLE_NS 5000000L
+
+typedef struct {
+    int64_t ts_ns;
+    TlogSite* site;
+    uint32_t suppressed;
+    uint8_t nargs;
+    TlogArg args[TLOG_MAX_ARGS];
+    char strings[TLOG_MAX_STRING];  // String arguments point in here
+} TlogRecord;
+
+// Head and tail live on their own cache lines so the producer and the writer do not share one
+typedef struct {
+    _Alignas(64) _Atomic uint32_t head;  // Written by the logging thread only
+    _Alignas(64) _Atomic uint32_t tail;  // Written by the writer only
+    _Atomic uint64_t dropped;
+    TlogRecord records[TLOG_RING_SIZE];
+} TlogRing;
+
+static TlogRing rings[TLOG_MAX_THREADS];
+static _Atomic int num_rings = 0;
+static _Atomic uint64_t unregistered_dropped = 0;
+static _Thread_local int thread_slot = -1;
+
+static _Atomic int running = 0;
+static pthread_t writer_thread;
+static FILE* log_file = NULL;
+static int echo_messages = 0;
+
+// Writer side state
+static uint16_t next_site_id = 1;
+static uint64_t reported_dropped[TLOG_MAX_THREADS];
+
+static int64_t now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (int64_t)ts.tv_sec * 1000000000LL + ts.tv_nsec;
+}
+
+const char* tlog_level_name(int level) {
+    static const char* names[] = {"ERROR", "WARN", "INFO", "DEBUG"};
+    if (level < 0 || level > TLOG_LEVEL_DEBUG) return "?";
+    return names[level];
+}
+
+static int64_t arg_as_int(const TlogArg* a) {
+    switch (a->type) {
+        case TLOG_ARG_UINT: return (int64_t)a->value.u;
+        case TLOG_ARG_DOUBLE: return (int64_t)a->value.d;
+        case TLOG_ARG_STRING: return 0;
+        default: return a->value.i;
+    }
+}
+
+static double arg_as_double(const TlogArg* a) {
+    switch (a->type) {
+        case TLOG_ARG_INT: return (double)a->value.i;
+        case TLOG_ARG_UINT: return (double)a->value.u;
+        case TLOG_ARG_STRING: return 0.0;
+        default: return a->value.d;
+    }
+}
+
+// printf subset: flags, width and precision are kept, length modifiers are replaced to match the stored type
+int tlog_format(char* out, size_t size, const char* fmt, const TlogArg* args, int nargs) {
+    size_t len = 0;
+    int next = 0;
+    if (size == 0) return 0;
+
+    const char* p = fmt;
+    while (*p && len + 1 < size) {
+        if (*p != '%') {
+            out[len++] = *p++;
+            continue;
+        }
+        if (p[1] == '%') {
+            out[len++] = '%';
+            p += 2;
+            continue;
+        }
+
+        char spec[24];
+        size_t n = 0;
+        spec[n++] = *p++;
+        while (*p && strchr("-+ #0123456789.", *p)) {
+            if (n < sizeof(spec) - 4) spec[n++] = *p;
+            p++;
+        }
+        while (*p && strchr("hlLqjzt", *p)) p++;
+        char conv = *p;
+        if (!conv) break;
+        p++;
+
+        const TlogArg* a = next < nargs ? &args[next++] : NULL;
+        int written;
+        if (!a) {
+            written = snprintf(out + len, size - len, "<?>");
+        } else if (strchr("di", conv)) {
+            spec[n++] = 'l'; spec[n++] = 'l'; spec[n++] = conv; spec[n] = '\0';
+            written = snprintf(out + len, size - len, spec, (long long)arg_as_int(a));
+        } else if (strchr("uxXo", conv)) {
+            spec[n++] = 'l'; spec[n++] = 'l'; spec[n++] = conv; spec[n] = '\0';
+            written = snprintf(out + len, size - len, spec, (unsigned long long)arg_as_int(a));
+        } else if (strchr("eEfFgGaA", conv)) {
+            spec[n++] = conv; spec[n] = '\0';
+            written = snprintf(out + len, size - len, spec, arg_as_double(a));
+        } else if (conv == 'c') {
+            spec[n++] = conv; spec[n] = '\0';
+            written = snprintf(out + len, size - len, spec, (int)arg_as_int(a));
+        } else if (conv == 's') {
+            spec[n++] = conv; spec[n] = '\0';
+            const char* s = (a->type == TLOG_ARG_STRING && a->value.s) ? a->value.s : "<?>";
+            written = snprintf(out + len, size - len, spec, s);
+        } else {
+            written = snprintf(out + len, size - len, "<%%%c?>", conv);
+        }
+        if (written > 0) {
+            len += ((size_t)written < size - len) ? (size_t)written : size - len - 1;
+        }
+    }
+    out[len] = '\0';
+    return (int)len;
+}
+
+// Print one message as text on its own line, dropping the newline of the format
+static void print_message(FILE* out, const char* fmt, const TlogArg* args, int nargs, uint32_t suppressed) {
+    char text[256];
+    int len = tlog_format(text, sizeof(text), fmt, args, nargs);
+    while (len > 0 && (text[len - 1] == '\n' || text[len - 1] == '\r')) {
+        text[--len] = '\0';
+    }
+    if (suppressed) {
+        fprintf(out, "%s (%u similar messages suppressed)\n", text, suppressed);
+    } else {
+        fprintf(out, "%s\n", text);
+    }
+}
+
+// Token window per call site. Threads sharing a call site may race here, which only skews the counts.
+static int rate_allow(TlogSite* site, int64_t now, uint32_t* suppressed) {
+    if (now - site->window_start_ns >= TLOG_RATE_WINDOW_NS) {
+        site->window_start_ns = now;
+        site->in_window = 0;
+    }
+    if (site->in_window >= TLOG_RATE_BURST) {
+        site->suppressed++;
+        return 0;
+    }
+    site->in_window++;
+    *suppressed = site->suppressed;
+    site->suppressed = 0;
+    return 1;
+}
+
+static TlogRing* thread_ring(void) {
+    if (thread_slot < 0) {
+        int slot = atomic_fetch_add_explicit(&num_rings, 1, memory_order_acq_rel);
+        thread_slot = slot < TLOG_MAX_THREADS ? slot : TLOG_MAX_THREADS;
+    }
+    return thread_slot < TLOG_MAX_THREADS ? &rings[thread_slot] : NULL;
+}
+
+void tlog_write(TlogSite* site, const TlogArg* args, int nargs) {
+    int64_t now = now_ns();
+    uint32_t suppressed;
+    if (!rate_allow(site, now, &suppressed)) {
+        return;
+    }
+
+    if (!atomic_load_explicit(&running, memory_order_acquire)) {
+        print_message(stdout, site->fmt, args, nargs, suppressed);
+        return;
+    }
+
+    TlogRing* ring = thread_ring();
+    if (!ring) {
+        atomic_fetch_add_explicit(&unregistered_dropped, 1, memory_order_relaxed);
+        return;
+    }
+
+    uint32_t head = atomic_load_explicit(&ring->head, memory_order_relaxed);
+    uint32_t tail = atomic_load_explicit(&ring->tail, memory_order_acquire);
+    if (head - tail >= TLOG_RING_SIZE) {
+        atomic_fetch_add_explicit(&ring->dropped, 1, memory_order_relaxed);
+        return;
+    }
+
+    TlogRecord* rec = &ring->records[head & RING_MASK];
+    rec->ts_ns = now;
+    rec->site = site;
+    rec->suppressed = suppressed;
+    rec->nargs = (uint8_t)(nargs < TLOG_MAX_ARGS ? nargs : TLOG_MAX_ARGS);
+    memcpy(rec->args, args, rec->nargs * sizeof(TlogArg));
+    size_t used = 0;
+    for (int i = 0; i < rec->nargs; i++) {
+        if (rec->args[i].type != TLOG_ARG_STRING) continue;
+        const char* s = rec->args[i].value.s ? rec->args[i].value.s : "(null)";
+        size_t len = strnlen(s, TLOG_MAX_STRING - 1 - used);
+        memcpy(rec->strings + used, s, len);
+        rec->strings[used + len] = '\0';
+        rec->args[i].value.s = rec->strings + used;
+        used += len + 1;
+        if (used > TLOG_MAX_STRING - 1) used = TLOG_MAX_STRING - 1;  // Later strings come out empty
+    }
+    atomic_store_explicit(&ring->head, head + 1, memory_order_release);
+}
+
+uint64_t tlog_dropped(void) {
+    uint64_t total = atomic_load_explicit(&unregistered_dropped, memory_order_relaxed);
+    for (int i = 0; i < TLOG_MAX_THREADS; i++) {
+        total += atomic_load_explicit(&rings[i].dropped, memory_order_relaxed);
+    }
+    return total;
+}
+
+// Little endian field writers, the car and the machines running tlog_decode are all little endian
+static void put(FILE* f, const void* data, size_t size) {
+    fwrite(data, 1, size, f);
+}
+
+static void put_u8(FILE* f, uint8_t v) { put(f, &v, sizeof(v)); }
+static void put_u16(FILE* f, uint16_t v) { put(f, &v, sizeof(v)); }
+static void put_u32(FILE* f, uint32_t v) { put(f, &v, sizeof(v)); }
+static void put_i64(FILE* f, int64_t v) { put(f, &v, sizeof(v)); }
+
+static void put_string(FILE* f, const char* s, size_t max) {
+    size_t len = strlen(s);
+    if (len > max) len = max;
+    put_u16(f, (uint16_t)len);
+    put(f, s, len);
+}
+
+static void write_site(TlogSite* site) {
+    site->id = next_site_id++;
+    put_u8(log_file, TLOG_REC_SITE);
+    put_u16(log_file, site->id);
+    put_u8(log_file, (uint8_t)site->level);
+    put_u32(log_file, (uint32_t)site->line);
+    put_string(log_file, site->file, 0xffff);
+    put_string(log_file, site->fmt, 0xffff);
+}
+
+static void write_record(int thread, const TlogRecord* rec) {
+    // Only the writer touches the id, so a site is written the first time one of its records is drained
+    TlogSite* site = rec->site;
+    if (site->id == 0) {
+        write_site(site);
+    }
+
+    put_u8(log_file, TLOG_REC_MESSAGE);
+    put_i64(log_file, rec->ts_ns);
+    put_u16(log_file, site->id);
+    put_u8(log_file, (uint8_t)thread);
+    put_u32(log_file, rec->suppressed);
+    put_u8(log_file, rec->nargs);
+    for (int i = 0; i < rec->nargs; i++) {
+        const TlogArg* a = &rec->args[i];
+        put_u8(log_file, a->type);
+        if (a->type == TLOG_ARG_STRING) {
+            put_string(log_file, a->value.s, TLOG_MAX_STRING);
+        } else {
+            put(log_file, &a->value, 8);
+        }
+    }
+
+    if (echo_messages) {
+        print_message(stdout, site->fmt, rec->args, rec->nargs, rec->suppressed);
+    }
+}
+
+// Move everything queued so far to the file, returns the number of records written
+static int drain_rings(void) {
+    int written = 0;
+    int count = atomic_load_explicit(&num_rings, memory_order_acquire);
+    if (count > TLOG_MAX_THREADS) count = TLOG_MAX_THREADS;
+
+    for (int i = 0; i < count; i++) {
+        TlogRing* ring = &rings[i];
+        uint32_t tail = atomic_load_explicit(&ring->tail, memory_order_relaxed);
+        uint32_t head = atomic_load_explicit(&ring->head, memory_order_acquire);
+        while (tail != head) {
+            write_record(i, &ring->records[tail & RING_MASK]);
+            tail++;
+            written++;
+        }
+        atomic_store_explicit(&ring->tail, tail, memory_order_release);
+
+        uint64_t dropped = atomic_load_explicit(&ring->dropped, memory_order_relaxed);
+        if (dropped != reported_dropped[i]) {
+            put_u8(log_file, TLOG_REC_DROPPED);
+            put_i64(log_file, now_ns());
+            put_u8(log_file, (uint8_t)i);
+            put(log_file, &dropped, sizeof(dropped));
+            reported_dropped[i] = dropped;
+            written++;
+        }
+    }
+
+    if (written) {
+        fflush(log_file);
+        if (echo_messages) fflush(stdout);
+    }
+    return written;
+}
+
+static void* writer_main(void* arg) {
+    (void)arg;
+    struct timespec idle = {0, WRITER_IDLE_NS};
+    while (atomic_load_explicit(&running, memory_order_acquire)) {
+        if (drain_rings() == 0) {
+            nanosleep(&idle, NULL);
+        }
+    }
+    drain_rings();
+    return NULL;
+}
+
+int tlog_init(const char* path, int echo) {
+    if (atomic_load(&running)) return 0;
+
+    log_file = fopen(path, "wb");
+    if (!log_file) {
+        perror("tlog: fopen");
+        return -1;
+    }
+    echo_messages = echo;
+
+    struct timespec wall;
+    clock_gettime(CLOCK_REALTIME, &wall);
+    put_u32(log_file, TLOG_FILE_MAGIC);
+    put_u32(log_file, TLOG_FILE_VERSION);
+    put_i64(log_file, now_ns());
+    put_i64(log_file, (int64_t)wall.tv_sec * 1000000000LL + wall.tv_nsec);
+    fflush(log_file);
+
+    // The writer runs as a normal thread even when it is started from a real time thread
+    pthread_attr_t attr;
+    struct sched_param param = {0};
+    pthread_attr_init(&attr);
+    pthread_attr_setinheritsched(&attr, PTHREAD_EXPLICIT_SCHED);
+    pthread_attr_setschedpolicy(&attr, SCHED_OTHER);
+    pthread_attr_setschedparam(&attr, &param);
+
+    atomic_store(&running, 1);
+    int ret = pthread_create(&writer_thread, &attr, writer_main, NULL);
+    pthread_attr_destroy(&attr);
+    if (ret != 0) {
+        atomic_store(&running, 0);
+        fclose(log_file);
+        log_file = NULL;
+        return -1;
+    }
+    return 0;
+}
+
+void tlog_shutdown(void) {
+    if (!atomic_load(&running)) return;
+    atomic_store(&running, 0);
+    pthread_join(writer_thread, NULL);
+    fclose(log_file);
+    log_file = NULL;
+}
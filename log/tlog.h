@@ -0,0 +1,143 @@
+/**
+Class         : CSC-615-01 - Embedded Linux - Fall 2024
+Team Name     : Wayno
+Github        : nhannguyensf
+Project       : Final Assignment - Robot Car
+File          : tlog.h
+Description:
+This file is the header file for the tlog.c file. It declares the binary telemetry logger. A log call does not
+format anything: it copies a timestamp, a pointer to its call site and up to six arguments into a fixed size
+record in the ring of the calling thread. A background writer drains the rings into a binary log file that
+tlog_decode renders as text. Use the LOG_* macros from Debug.h instead of TLOG directly so the compile time
+log level applies.
+*
+Team Members:
+Kiran Poudel
+Nhan Nguyen
+Yuvraj Gupta
+Fernando Abel Malca Luque
+
+*
+**/
+#ifndef TLOG_H
+#define TLOG_H
+
+#include <stdio.h>
+#include <stdint.h>
+
+// Log levels, lower is more important
+#define TLOG_LEVEL_ERROR 0
+#define TLOG_LEVEL_WARN 1
+#define TLOG_LEVEL_INFO 2
+#define TLOG_LEVEL_DEBUG 3
+
+// Maximum number of arguments of one message
+#define TLOG_MAX_ARGS 6
+// Records per thread ring, must be a power of two
+#define TLOG_RING_SIZE 512
+// Maximum number of threads that can log
+#define TLOG_MAX_THREADS 8
+// Each call site may log this many messages per window, the rest are counted and reported later
+#define TLOG_RATE_BURST 5
+#define TLOG_RATE_WINDOW_NS 1000000000LL
+// Space for the string arguments of one record, longer strings are cut
+#define TLOG_MAX_STRING 64
+
+// Default log file of the car
+#define TLOG_FILE "car.tlog"
+
+// File format identification
+#define TLOG_FILE_MAGIC 0x474f4c54u  // "TLOG"
+#define TLOG_FILE_VERSION 1
+
+// Record kinds in the log file
+enum {
+    TLOG_REC_SITE = 1,
+    TLOG_REC_MESSAGE = 2,
+    TLOG_REC_DROPPED = 3,
+};
+
+// Argument types
+enum {
+    TLOG_ARG_INT,
+    TLOG_ARG_UINT,
+    TLOG_ARG_DOUBLE,
+    TLOG_ARG_STRING,
+};
+
+typedef struct {
+    uint8_t type;
+    union {
+        int64_t i;
+        uint64_t u;
+        double d;
+        const char* s;  // Copied into the record when logged
+    } value;
+} TlogArg;
+
+// One static instance per log call site
+typedef struct {
+    int level;
+    const char* fmt;
+    const char* file;
+    int line;
+    // Filled in on first use
+    uint16_t id;
+    // Rate limiting state
+    int64_t window_start_ns;
+    uint32_t in_window;
+    uint32_t suppressed;
+} TlogSite;
+
+// Start the logger writing to path; with echo set the writer also prints the messages to stdout
+int tlog_init(const char* path, int echo);
+// Drain the remaining records and stop the writer
+void tlog_shutdown(void);
+// Copy one message into the ring of the calling thread, never blocks
+void tlog_write(TlogSite* site, const TlogArg* args, int nargs);
+// Number of records dropped because a ring was full
+uint64_t tlog_dropped(void);
+
+// Render a message as text the way printf would, used by the writer and by tlog_decode
+int tlog_format(char* out, size_t size, const char* fmt, const TlogArg* args, int nargs);
+const char* tlog_level_name(int level);
+
+// Argument packing, the argument type is picked at compile time
+static inline TlogArg tlog_arg_int(int64_t v) { TlogArg a = {TLOG_ARG_INT, {.i = v}}; return a; }
+static inline TlogArg tlog_arg_uint(uint64_t v) { TlogArg a = {TLOG_ARG_UINT, {.u = v}}; return a; }
+static inline TlogArg tlog_arg_double(double v) { TlogArg a = {TLOG_ARG_DOUBLE, {.d = v}}; return a; }
+static inline TlogArg tlog_arg_string(const char* v) { TlogArg a = {TLOG_ARG_STRING, {.s = v}}; return a; }
+
+#define TLOG_ARG(x) _Generic((x), \
+    char*: tlog_arg_string, \
+    const char*: tlog_arg_string, \
+    float: tlog_arg_double, \
+    double: tlog_arg_double, \
+    unsigned char: tlog_arg_uint, \
+    unsigned short: tlog_arg_uint, \
+    unsigned int: tlog_arg_uint, \
+    unsigned long: tlog_arg_uint, \
+    unsigned long long: tlog_arg_uint, \
+    default: tlog_arg_int)(x)
+
+// Argument counting and mapping, each mapped argument carries its leading comma
+#define TLOG_NARGS(...) TLOG_NARGS_(_0, ##__VA_ARGS__, 7, 6, 5, 4, 3, 2, 1, 0)
+#define TLOG_NARGS_(_0, _1, _2, _3, _4, _5, _6, _7, N, ...) N
+#define TLOG_CAT(a, b) TLOG_CAT_(a, b)
+#define TLOG_CAT_(a, b) a##b
+#define TLOG_MAP_0()
+#define TLOG_MAP_1(a) , TLOG_ARG(a)
+#define TLOG_MAP_2(a, ...) , TLOG_ARG(a) TLOG_MAP_1(__VA_ARGS__)
+#define TLOG_MAP_3(a, ...) , TLOG_ARG(a) TLOG_MAP_2(__VA_ARGS__)
+#define TLOG_MAP_4(a, ...) , TLOG_ARG(a) TLOG_MAP_3(__VA_ARGS__)
+#define TLOG_MAP_5(a, ...) , TLOG_ARG(a) TLOG_MAP_4(__VA_ARGS__)
+#define TLOG_MAP_6(a, ...) , TLOG_ARG(a) TLOG_MAP_5(__VA_ARGS__)
+// More than TLOG_MAX_ARGS arguments expand to the undefined TLOG_MAP_7 and fail to compile
+
+#define TLOG(level, fmt, ...) do { \
+        static TlogSite tlog_site_ = {(level), (fmt), __FILE__, __LINE__, 0, 0, 0, 0}; \
+        const TlogArg tlog_args_[] = { {0} TLOG_CAT(TLOG_MAP_, TLOG_NARGS(__VA_ARGS__))(__VA_ARGS__) }; \
+        tlog_write(&tlog_site_, tlog_args_ + 1, TLOG_NARGS(__VA_ARGS__)); \
+    } while (0)
+
+#endif
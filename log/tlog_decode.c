@@ -0,0 +1,186 @@
+/**
+Class         : CSC-615-01 - Embedded Linux - Fall 2024
+Team Name     : Wayno
+Github        : nhannguyensf
+Project       : Final Assignment - Robot Car
+File          : tlog_decode.c
+Description:
+This file is the offline decoder of the binary telemetry log. It reads the call sites and the messages the car
+wrote and prints one line per message with the time since the logger started, the level, the thread, the
+source location and the rendered text.
+    tlog_decode [-l max_level] [file]
+*
+Team Members:
+Kiran Poudel
+Nhan Nguyen
+Yuvraj Gupta
+Fernando Abel Malca Luque
+
+*
+**/
+#include "tlog.h"
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#define MAX_SITES 65536
+
+typedef struct {
+    int level;
+    int line;
+    char* file;
+    char* fmt;
+} Site;
+
+static Site* sites[MAX_SITES];
+
+static int get(FILE* f, void* data, size_t size) {
+    return fread(data, 1, size, f) == size ? 0 : -1;
+}
+
+// Read a length prefixed string into a new buffer
+static char* get_string(FILE* f) {
+    uint16_t len;
+    if (get(f, &len, sizeof(len)) < 0) return NULL;
+    char* s = malloc(len + 1u);
+    if (!s) return NULL;
+    if (get(f, s, len) < 0) {
+        free(s);
+        return NULL;
+    }
+    s[len] = '\0';
+    return s;
+}
+
+static int read_site(FILE* f) {
+    uint16_t id;
+    uint8_t level;
+    uint32_t line;
+    if (get(f, &id, sizeof(id)) < 0 || get(f, &level, 1) < 0 || get(f, &line, sizeof(line)) < 0) return -1;
+
+    Site* site = calloc(1, sizeof(Site));
+    if (!site) return -1;
+    site->level = level;
+    site->line = (int)line;
+    site->file = get_string(f);
+    site->fmt = get_string(f);
+    if (!site->file || !site->fmt) return -1;
+    sites[id] = site;
+    return 0;
+}
+
+static int read_message(FILE* f, int64_t start_ns, int max_level) {
+    int64_t ts;
+    uint16_t id;
+    uint8_t thread, nargs;
+    uint32_t suppressed;
+    if (get(f, &ts, sizeof(ts)) < 0 || get(f, &id, sizeof(id)) < 0 || get(f, &thread, 1) < 0 ||
+        get(f, &suppressed, sizeof(suppressed)) < 0 || get(f, &nargs, 1) < 0) {
+        return -1;
+    }
+    if (nargs > TLOG_MAX_ARGS) return -1;
+
+    TlogArg args[TLOG_MAX_ARGS];
+    char strings[TLOG_MAX_ARGS][TLOG_MAX_STRING + 1];
+    for (int i = 0; i < nargs; i++) {
+        if (get(f, &args[i].type, 1) < 0) return -1;
+        if (args[i].type == TLOG_ARG_STRING) {
+            uint16_t len;
+            if (get(f, &len, sizeof(len)) < 0 || len > TLOG_MAX_STRING || get(f, strings[i], len) < 0) return -1;
+            strings[i][len] = '\0';
+            args[i].value.s = strings[i];
+        } else if (get(f, &args[i].value, 8) < 0) {
+            return -1;
+        }
+    }
+
+    Site* site = sites[id];
+    if (!site) {
+        fprintf(stderr, "Message for unknown call site %u\n", id);
+        return 0;
+    }
+    if (site->level > max_level) return 0;
+
+    char text[512];
+    int len = tlog_format(text, sizeof(text), site->fmt, args, nargs);
+    while (len > 0 && (text[len - 1] == '\n' || text[len - 1] == '\r')) {
+        text[--len] = '\0';
+    }
+
+    const char* file = strrchr(site->file, '/');
+    file = file ? file + 1 : site->file;
+    printf("%12.6f %-5s T%u %s:%d %s", (ts - start_ns) / 1e9, tlog_level_name(site->level), thread,
+           file, site->line, text);
+    if (suppressed) {
+        printf(" (%u similar messages suppressed)", suppressed);
+    }
+    printf("\n");
+    return 0;
+}
+
+static int read_dropped(FILE* f, int64_t start_ns) {
+    int64_t ts;
+    uint8_t thread;
+    uint64_t dropped;
+    if (get(f, &ts, sizeof(ts)) < 0 || get(f, &thread, 1) < 0 || get(f, &dropped, sizeof(dropped)) < 0) return -1;
+    printf("%12.6f WARN  T%u %llu messages dropped so far, ring was full\n", (ts - start_ns) / 1e9, thread,
+           (unsigned long long)dropped);
+    return 0;
+}
+
+int main(int argc, char* argv[]) {
+    int max_level = TLOG_LEVEL_DEBUG;
+    int opt;
+    while ((opt = getopt(argc, argv, "l:")) != -1) {
+        switch (opt) {
+            case 'l':
+                max_level = atoi(optarg);
+                break;
+            default:
+                fprintf(stderr, "Usage: %s [-l max_level] [file]\n", argv[0]);
+                return 1;
+        }
+    }
+    const char* path = optind < argc ? argv[optind] : TLOG_FILE;
+
+    FILE* f = fopen(path, "rb");
+    if (!f) {
+        perror(path);
+        return 1;
+    }
+
+    uint32_t magic, version;
+    int64_t start_ns, wall_ns;
+    if (get(f, &magic, sizeof(magic)) < 0 || get(f, &version, sizeof(version)) < 0 ||
+        get(f, &start_ns, sizeof(start_ns)) < 0 || get(f, &wall_ns, sizeof(wall_ns)) < 0 ||
+        magic != TLOG_FILE_MAGIC || version != TLOG_FILE_VERSION) {
+        fprintf(stderr, "%s is not a telemetry log\n", path);
+        fclose(f);
+        return 1;
+    }
+
+    time_t wall = (time_t)(wall_ns / 1000000000LL);
+    char started[64];
+    strftime(started, sizeof(started), "%Y-%m-%d %H:%M:%S", localtime(&wall));
+    printf("Log started %s\n", started);
+
+    int kind;
+    int status = 0;
+    while ((kind = fgetc(f)) != EOF) {
+        switch (kind) {
+            case TLOG_REC_SITE: status = read_site(f); break;
+            case TLOG_REC_MESSAGE: status = read_message(f, start_ns, max_level); break;
+            case TLOG_REC_DROPPED: status = read_dropped(f, start_ns); break;
+            default: status = -1; break;
+        }
+        if (status < 0) {
+            // The car may have stopped in the middle of a record
+            fprintf(stderr, "Log ends with a truncated or unknown record\n");
+            break;
+        }
+    }
+
+    fclose(f);
+    return 0;
+}
@@ -1,9 +1,12 @@
 #include "DEV_Config.h"
+#include "../trace/trace.h"
+#include "../bus/bus.h"
 #include <unistd.h>
 #include <fcntl.h>
 
 uint32_t fd;
 int INT_PIN;
+static uint8_t i2c_address;
 static int DEV_Equipment_Testing(void)
 {
     int i;
@@ -168,6 +171,7 @@ void DEV_I2C_Init(uint8_t Add)
     bcm2835_i2c_begin();
     bcm2835_i2c_setSlaveAddress(Add);
 #endif
+    i2c_address = Add;
 #endif
 }
 
@@ -175,11 +179,11 @@ void I2C_Write_Byte(uint8_t Cmd, uint8_t value)
 {
 //    int ref;
 #if DEV_I2C
-#ifdef USE_BCM2835_LIB
-    char wbuf[2] = {Cmd, value};
-    bcm2835_i2c_write(wbuf, 2);
+    uint8_t wbuf[2] = {Cmd, value};
+    TRACE_BEGIN("i2c_write");
+    bus_i2c_write(BUS_SITE(), i2c_address, wbuf, 2);
+    TRACE_END("i2c_write");
 
-#endif
 #endif
 }
 
@@ -187,12 +191,12 @@ int I2C_Read_Byte(uint8_t Cmd)
 {
     int ref;
 #if DEV_I2C
-#ifdef USE_BCM2835_LIB
-    char rbuf[2] = {0};
-    bcm2835_i2c_read_register_rs((char *)&Cmd, (char *)rbuf, 1);
+    uint8_t rbuf[2] = {0};
+    TRACE_BEGIN("i2c_read");
+    bus_i2c_read_reg(BUS_SITE(), i2c_address, Cmd, rbuf, 1);
+    TRACE_END("i2c_read");
     ref = rbuf[0];
 
-#endif
 #endif
     return ref;
 }
@@ -201,12 +205,12 @@ int I2C_Read_Word(uint8_t Cmd)
 {
     int ref;
 #if DEV_I2C
-#ifdef USE_BCM2835_LIB
-    char rbuf[2] = {0};
-    bcm2835_i2c_read_register_rs((char *)&Cmd, (char *)rbuf, 2);
+    uint8_t rbuf[2] = {0};
+    TRACE_BEGIN("i2c_read");
+    bus_i2c_read_reg(BUS_SITE(), i2c_address, Cmd, rbuf, 2);
+    TRACE_END("i2c_read");
     ref = rbuf[1] << 8 | rbuf[0];
 
-#endif
 #endif
     return ref;
 }
@@ -1,13 +1,47 @@
 #ifndef __DEBUG_H
 #define __DEBUG_H
 
-#include <stdio.h>
+#include "../log/tlog.h"
 
 #define USE_DEBUG 1
+
+// Compile time log level, messages above it are not compiled in. Override with make LOG_LEVEL=n
+#ifndef LOG_LEVEL
 #if USE_DEBUG
-#define DEBUG(__info, ...) printf("Debug : " __info, ##__VA_ARGS__)
+#define LOG_LEVEL TLOG_LEVEL_DEBUG
+#else
+#define LOG_LEVEL TLOG_LEVEL_INFO
+#endif
+#endif
+
+// A disabled level still references its arguments, so variables that are only logged stay used, and checks the
+// format, but the call is never made
+#define LOG_DISABLED(...) do { if (0) printf(__VA_ARGS__); } while (0)
+
+#if LOG_LEVEL >= TLOG_LEVEL_ERROR
+#define LOG_ERROR(...) TLOG(TLOG_LEVEL_ERROR, __VA_ARGS__)
+#else
+#define LOG_ERROR(...) LOG_DISABLED(__VA_ARGS__)
+#endif
+
+#if LOG_LEVEL >= TLOG_LEVEL_WARN
+#define LOG_WARN(...) TLOG(TLOG_LEVEL_WARN, __VA_ARGS__)
+#else
+#define LOG_WARN(...) LOG_DISABLED(__VA_ARGS__)
+#endif
+
+#if LOG_LEVEL >= TLOG_LEVEL_INFO
+#define LOG_INFO(...) TLOG(TLOG_LEVEL_INFO, __VA_ARGS__)
 #else
-#define DEBUG(__info, ...)
+#define LOG_INFO(...) LOG_DISABLED(__VA_ARGS__)
 #endif
 
+#if LOG_LEVEL >= TLOG_LEVEL_DEBUG
+#define LOG_DEBUG(...) TLOG(TLOG_LEVEL_DEBUG, __VA_ARGS__)
+#else
+#define LOG_DEBUG(...) LOG_DISABLED(__VA_ARGS__)
+#endif
+
+#define DEBUG(__info, ...) LOG_DEBUG("Debug : " __info, ##__VA_ARGS__)
+
 #endif
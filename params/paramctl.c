@@ -0,0 +1,94 @@
+/**
+Class         : CSC-615-01 - Embedded Linux - Fall 2024
+Team Name     : Wayno
+Github        : nhannguyensf
+Project       : Final Assignment - Robot Car
+File          : paramctl.c
+Description:
+This file is the command line tool to read and change the control parameters of a running car through the
+shared memory parameter block. All values given in one set command are published as a single version, and a
+value outside the range of its parameter (list shows the ranges) rejects the whole command.
+    paramctl list
+    paramctl get <name>
+    paramctl set <name> <value> [<name> <value> ...]
+*
+Team Members:
+Kiran Poudel
+Nhan Nguyen
+Yuvraj Gupta
+Fernando Abel Malca Luque
+
+*
+**/
+#include "params.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+static void usage(const char* name) {
+    fprintf(stderr, "Usage: %s list | get <name> | set <name> <value> [<name> <value> ...]\n", name);
+}
+
+int main(int argc, char* argv[]) {
+    if (argc < 2) {
+        usage(argv[0]);
+        return 1;
+    }
+    if (params_open_shared() < 0) {
+        fprintf(stderr, "Cannot open the parameter block, is the car running?\n");
+        return 1;
+    }
+
+    ControlParams params;
+    uint32_t version;
+    if (params_read(&params, &version) < 0) {
+        params_close_shared();
+        return 1;
+    }
+
+    if (strcmp(argv[1], "list") == 0) {
+        printf("Parameter version %u\n", version);
+        for (int i = 0; i < params_count(); i++) {
+            const ParamInfo* info = params_info(i);
+            printf("  %-20s %12.4f %-3s  (%.10g to %.10g)\n", info->name, params_get_field(&params, i), info->unit,
+                   info->min, info->max);
+        }
+    } else if (strcmp(argv[1], "get") == 0 && argc == 3) {
+        int index = params_find(argv[2]);
+        if (index < 0) {
+            fprintf(stderr, "Unknown parameter: %s\n", argv[2]);
+            return 1;
+        }
+        printf("%g\n", params_get_field(&params, index));
+    } else if (strcmp(argv[1], "set") == 0 && argc >= 4 && argc % 2 == 0) {
+        int count = (argc - 2) / 2;
+        int indices[count];
+        double values[count];
+        for (int i = 0; i < count; i++) {
+            char* end;
+            indices[i] = params_find(argv[2 + 2 * i]);
+            values[i] = strtod(argv[3 + 2 * i], &end);
+            if (indices[i] < 0 || *end != '\0') {
+                fprintf(stderr, "Invalid parameter or value: %s %s\n", argv[2 + 2 * i], argv[3 + 2 * i]);
+                return 1;
+            }
+            if (params_check(indices[i], values[i]) < 0) {
+                const ParamInfo* info = params_info(indices[i]);
+                fprintf(stderr, "%s %s is out of range, it must be %.10g to %.10g %s\n", info->name, argv[3 + 2 * i],
+                        info->min, info->max, info->unit);
+                return 1;
+            }
+        }
+        if (params_update(indices, values, count) < 0 || params_read(&params, &version) < 0) {
+            params_close_shared();
+            return 1;
+        }
+        printf("Published parameter version %u\n", version);
+    } else {
+        usage(argv[0]);
+        return 1;
+    }
+
+    params_close_shared();
+    return 0;
+}
@@ -0,0 +1,259 @@
+/**
+Class         : CSC-615-01 - Embedded Linux - Fall 2024
+Team Name     : Wayno
+Github        : nhannguyensf
+Project       : Final Assignment - Robot Car
+File          : params.c
+Description:
+This file contains the live parameter block. The car creates a POSIX shared memory segment holding the
+control parameters and the paramctl tool attaches to it to read and change them while the car is running.
+Writers take the sequence lock with a compare and swap, and the control loop never waits: at the start of an
+iteration it checks the sequence number, and only when it changed does it copy the block and keep the copy
+if no write happened in between. A half written update is simply picked up on a later iteration.
+*
+Team Members:
+Kiran Poudel
+Nhan Nguyen
+Yuvraj Gupta
+Fernando Abel Malca Luque
+
+*
+**/
+#include "params.h"
+#include <fcntl.h>
+#include <sched.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
+
+// A write holds the sequence lock for a few microseconds, an odd sequence that lasts longer than this was left
+// by a writer that died in the middle of an update
+#define PARAMS_LOCK_TIMEOUT_US 100000
+
+static ParamBlock* block = NULL;
+static uint32_t seen_seq = 0;
+
+// Names of the parameters as used by paramctl, with the values the controller can work with. Speeds are motor
+// duty cycles, the thresholds lie in the 2 to 400 cm range of the HC-SR04, and a maneuver that takes no time or
+// more than 10 s would leave the car turning or driving blind.
+static const ParamInfo param_table[] = {
+    {"kp",                 "",    offsetof(ControlParams, kp),                 0.0,     1000.0},
+    {"ki",                 "1/s", offsetof(ControlParams, ki),                 0.0,     5000.0},
+    {"kd",                 "s",   offsetof(ControlParams, kd),                 0.0,     10.0},
+    {"base_speed",         "%",   offsetof(ControlParams, base_speed),         0.0,     100.0},
+    {"front_threshold",    "cm",  offsetof(ControlParams, front_threshold),    2.0,     400.0},
+    {"side_threshold",     "cm",  offsetof(ControlParams, side_threshold),     2.0,     400.0},
+    {"turn_speed",         "%",   offsetof(ControlParams, turn_speed),         1.0,     100.0},
+    {"avoid_speed",        "%",   offsetof(ControlParams, avoid_speed),        1.0,     100.0},
+    {"turn_90_time",       "us",  offsetof(ControlParams, turn_90_time),       10000.0, 10000000.0},
+    {"forward_short_time", "us",  offsetof(ControlParams, forward_short_time), 10000.0, 10000000.0},
+    {"forward_time",       "us",  offsetof(ControlParams, forward_time),       10000.0, 10000000.0},
+    {"forward_more_time",  "us",  offsetof(ControlParams, forward_more_time),  10000.0, 10000000.0},
+};
+
+#define NUM_PARAMS ((int)(sizeof(param_table) / sizeof(param_table[0])))
+
+// Map the shared memory object
+static int map_block(int flags) {
+    int fd = shm_open(PARAMS_SHM_NAME, flags, 0666);
+    if (fd < 0) {
+        return -1;
+    }
+    // The umask of a car started with sudo would leave the block writable by root only
+    if ((flags & O_CREAT) && (fchmod(fd, 0666) < 0 || ftruncate(fd, sizeof(ParamBlock)) < 0)) {
+        close(fd);
+        return -1;
+    }
+    void* addr = mmap(NULL, sizeof(ParamBlock), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    if (addr == MAP_FAILED) {
+        return -1;
+    }
+    block = addr;
+    return 0;
+}
+
+// Create (or take over) the parameter block and publish the initial values
+int params_create_shared(const ControlParams* initial) {
+    if (map_block(O_CREAT | O_RDWR) < 0) {
+        perror("params: shm_open");
+        return -1;
+    }
+    // Nobody else may be writing while the owner starts, so the block is reset outright
+    memcpy(&block->params, initial, sizeof(ControlParams));
+    block->magic = PARAMS_MAGIC;
+    block->layout_version = PARAMS_LAYOUT_VERSION;
+    atomic_store_explicit(&block->seq, 2, memory_order_release);
+    seen_seq = 2;
+    return 0;
+}
+
+// Attach to the parameter block of a running car
+int params_open_shared(void) {
+    if (map_block(O_RDWR) < 0) {
+        return -1;
+    }
+    if (block->magic != PARAMS_MAGIC || block->layout_version != PARAMS_LAYOUT_VERSION) {
+        fprintf(stderr, "params: parameter block has an unknown layout\n");
+        params_close_shared();
+        return -1;
+    }
+    return 0;
+}
+
+void params_close_shared(void) {
+    if (block) {
+        munmap(block, sizeof(ParamBlock));
+        block = NULL;
+    }
+}
+
+int params_unlink_shared(void) {
+    return shm_unlink(PARAMS_SHM_NAME);
+}
+
+// Pick up a new parameter version without waiting, returns 1 when local was updated.
+// Meant to be called at the iteration boundary of the control loop.
+int params_refresh(ControlParams* local) {
+    if (!block) return 0;
+
+    uint32_t seq = atomic_load_explicit(&block->seq, memory_order_acquire);
+    if (seq == seen_seq || (seq & 1)) {
+        return 0;  // Unchanged, or a write is in progress
+    }
+
+    ControlParams copy;
+    memcpy(&copy, &block->params, sizeof(copy));
+    atomic_thread_fence(memory_order_acquire);
+    if (atomic_load_explicit(&block->seq, memory_order_relaxed) != seq) {
+        return 0;  // Torn copy, retry on the next iteration
+    }
+
+    *local = copy;
+    seen_seq = seq;
+    return 1;
+}
+
+static int64_t monotonic_us(void) {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (int64_t)now.tv_sec * 1000000 + now.tv_nsec / 1000;
+}
+
+// Wait for another writer, returns -1 once the sequence has been odd for too long
+static int wait_for_writer(int64_t* deadline) {
+    if (*deadline == 0) {
+        *deadline = monotonic_us() + PARAMS_LOCK_TIMEOUT_US;
+    } else if (monotonic_us() > *deadline) {
+        fprintf(stderr, "params: the parameter block is stale or corrupt, a writer did not finish its update\n");
+        return -1;
+    }
+    sched_yield();
+    return 0;
+}
+
+// Read a consistent copy of the parameters, retrying while writes are in progress
+int params_read(ControlParams* params, uint32_t* version) {
+    if (!block) return -1;
+    int64_t deadline = 0;
+    for (;;) {
+        uint32_t seq = atomic_load_explicit(&block->seq, memory_order_acquire);
+        if (!(seq & 1)) {
+            memcpy(params, &block->params, sizeof(*params));
+            atomic_thread_fence(memory_order_acquire);
+            if (atomic_load_explicit(&block->seq, memory_order_relaxed) == seq) {
+                if (version) *version = seq / 2;
+                return 0;
+            }
+        }
+        if (wait_for_writer(&deadline) < 0) return -1;
+    }
+}
+
+// Take the sequence lock by moving it from even to odd, returns the even value or -1
+static int64_t begin_write(void) {
+    uint32_t seq = atomic_load_explicit(&block->seq, memory_order_relaxed);
+    int64_t deadline = 0;
+    for (;;) {
+        if (seq & 1) {
+            if (wait_for_writer(&deadline) < 0) return -1;
+            seq = atomic_load_explicit(&block->seq, memory_order_relaxed);
+            continue;
+        }
+        if (atomic_compare_exchange_weak_explicit(&block->seq, &seq, seq + 1,
+                                                  memory_order_acq_rel, memory_order_relaxed)) {
+            return seq;
+        }
+    }
+}
+
+// Release the sequence lock, publishing the next version
+static void end_write(uint32_t seq) {
+    atomic_store_explicit(&block->seq, seq + 2, memory_order_release);
+}
+
+// Publish a new set of parameters as one version, nothing is published if a value is out of range
+int params_write(const ControlParams* params) {
+    if (!block) return -1;
+    for (int i = 0; i < NUM_PARAMS; i++) {
+        if (params_check(i, params_get_field(params, i)) < 0) return -1;
+    }
+    int64_t seq = begin_write();
+    if (seq < 0) return -1;
+    memcpy(&block->params, params, sizeof(*params));
+    end_write((uint32_t)seq);
+    return 0;
+}
+
+// Change some of the parameters in place, all of them as one version or none if a value is out of range
+int params_update(const int* indices, const double* values, int count) {
+    if (!block) return -1;
+    for (int i = 0; i < count; i++) {
+        if (params_check(indices[i], values[i]) < 0) return -1;
+    }
+    int64_t seq = begin_write();
+    if (seq < 0) return -1;
+    for (int i = 0; i < count; i++) {
+        params_set_field(&block->params, indices[i], values[i]);
+    }
+    end_write((uint32_t)seq);
+    return 0;
+}
+
+int params_count(void) {
+    return NUM_PARAMS;
+}
+
+const ParamInfo* params_info(int index) {
+    if (index < 0 || index >= NUM_PARAMS) return NULL;
+    return &param_table[index];
+}
+
+// Index of a parameter by name, -1 if unknown
+int params_find(const char* name) {
+    for (int i = 0; i < NUM_PARAMS; i++) {
+        if (strcmp(param_table[i].name, name) == 0) return i;
+    }
+    return -1;
+}
+
+// 0 when the value is in the range of the parameter, -1 when it is not (NaN included) or the index is unknown
+int params_check(int index, double value) {
+    if (index < 0 || index >= NUM_PARAMS) return -1;
+    return value >= param_table[index].min && value <= param_table[index].max ? 0 : -1;
+}
+
+double params_get_field(const ControlParams* params, int index) {
+    return *(const double*)((const char*)params + param_table[index].offset);
+}
+
+// Set one parameter, an out of range value is rejected with -1 and leaves the parameter unchanged
+int params_set_field(ControlParams* params, int index, double value) {
+    if (params_check(index, value) < 0) return -1;
+    *(double*)((char*)params + param_table[index].offset) = value;
+    return 0;
+}
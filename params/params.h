@@ -0,0 +1,80 @@
+/**
+Class         : CSC-615-01 - Embedded Linux - Fall 2024
+Team Name     : Wayno
+Github        : nhannguyensf
+Project       : Final Assignment - Robot Car
+File          : params.h
+Description:
+This file is the header file for the params.c file. It declares the control parameters that can be tuned while
+the car is running and the versioned parameter block that shares them through POSIX shared memory.
+*
+Team Members:
+Kiran Poudel
+Nhan Nguyen
+Yuvraj Gupta
+Fernando Abel Malca Luque
+
+*
+**/
+#ifndef PARAMS_H
+#define PARAMS_H
+
+#include <stdint.h>
+#include <stdatomic.h>
+
+// Shared memory object holding the parameter block
+#define PARAMS_SHM_NAME "/wayno_params"
+#define PARAMS_MAGIC 0x50594157u  // "WAYP"
+#define PARAMS_LAYOUT_VERSION 1
+
+// Tunable control parameters, all stored as doubles so they can be handled by name
+typedef struct {
+    double kp;                    // PID gains (per second units)
+    double ki;
+    double kd;
+    double base_speed;            // Line following speed (percent)
+    double front_threshold;       // Distance to detect a front obstacle (cm)
+    double side_threshold;        // Distance to detect a side obstacle (cm)
+    double turn_speed;            // Speed for turning (percent)
+    double avoid_speed;           // Speed while avoiding an obstacle (percent)
+    double turn_90_time;          // Time to turn 90 degrees (us)
+    double forward_short_time;    // Drive time past the obstacle corner (us)
+    double forward_time;          // Drive time along the obstacle (us)
+    double forward_more_time;     // Drive time back towards the line (us)
+} ControlParams;
+
+// Parameter block in shared memory. seq is a sequence lock: it is odd while a writer is
+// updating the parameters, and every completed write adds 2, so seq / 2 is the version.
+typedef struct {
+    uint32_t magic;
+    uint32_t layout_version;
+    _Atomic uint32_t seq;
+    ControlParams params;
+} ParamBlock;
+
+// Description of one parameter for lookup by name
+typedef struct {
+    const char* name;
+    const char* unit;
+    int offset;
+    double min;    // Range of valid values, bounds included
+    double max;
+} ParamInfo;
+
+// Function declarations
+int params_create_shared(const ControlParams* initial);
+int params_open_shared(void);
+void params_close_shared(void);
+int params_unlink_shared(void);
+int params_refresh(ControlParams* local);
+int params_read(ControlParams* params, uint32_t* version);
+int params_write(const ControlParams* params);
+int params_update(const int* indices, const double* values, int count);
+int params_count(void);
+const ParamInfo* params_info(int index);
+int params_find(const char* name);
+int params_check(int index, double value);
+double params_get_field(const ControlParams* params, int index);
+int params_set_field(ControlParams* params, int index, double value);
+
+#endif // PARAMS_H
@@ -0,0 +1,176 @@
+/**
+Class         : CSC-615-01 - Embedded Linux - Fall 2024
+Team Name     : Wayno
+Github        : nhannguyensf
+Project       : Final Assignment - Robot Car
+File          : autotune.c
+Description:
+This file contains the relay feedback autotuner for the line following loop (Astrom-Hagglund method).
+The controller is replaced by a relay that drives +d or -d depending on the sign of the error, which makes the
+loop oscillate at its ultimate period. From the oscillation amplitude a the ultimate gain is
+Ku = 4d / (pi * sqrt(a^2 - h^2)) where h is the relay hysteresis. The ultimate gain and period are turned into
+PID gains with one of the classic tuning rules and written to a small text file that is loaded at startup.
+*
+Team Members:
+Kiran Poudel
+Nhan Nguyen
+Yuvraj Gupta
+Fernando Abel Malca Luque
+
+*
+**/
+#include "autotune.h"
+#include <math.h>
+#include <stdio.h>
+#include <string.h>
+
+#ifndef M_PI
+#define M_PI 3.14159265358979323846
+#endif
+
+// Tuning rules as (Kp / Ku, Ti / Tu, Td / Tu)
+static const struct {
+    const char* name;
+    double kp;
+    double ti;
+    double td;
+} tune_rules[NUM_TUNE_RULES] = {
+    [TUNE_ZIEGLER_NICHOLS] = {"zn",             0.60,  0.50, 0.125},
+    [TUNE_PESSEN]          = {"pessen",         0.70,  0.40, 0.15},
+    [TUNE_SOME_OVERSHOOT]  = {"some-overshoot", 0.33,  0.50, 0.33},
+    [TUNE_NO_OVERSHOOT]    = {"no-overshoot",   0.20,  0.50, 0.33},
+    [TUNE_TYREUS_LUYBEN]   = {"tyreus-luyben",  0.454, 2.20, 0.159},
+};
+
+// Start a relay experiment
+void autotune_init(Autotune* tune, double amplitude, double hysteresis, int cycles) {
+    memset(tune, 0, sizeof(*tune));
+    tune->amplitude = amplitude;
+    tune->hysteresis = hysteresis;
+    if (cycles < 1) cycles = 1;
+    if (cycles > AUTOTUNE_MAX_CYCLES) cycles = AUTOTUNE_MAX_CYCLES;
+    tune->cycles = cycles;
+    tune->relay = 1;
+    tune->cycle_max = -INFINITY;
+    tune->cycle_min = INFINITY;
+}
+
+// Average the measured cycles into the ultimate gain and period
+static void finish(Autotune* tune) {
+    double period = 0, amplitude = 0;
+    for (int i = 0; i < tune->cycles; i++) {
+        period += tune->periods[i];
+        amplitude += tune->amplitudes[i];
+    }
+    period /= tune->cycles;
+    amplitude /= tune->cycles;
+
+    double a2 = amplitude * amplitude - tune->hysteresis * tune->hysteresis;
+    if (a2 <= 0 || period <= 0) {
+        tune->done = -1;
+        return;
+    }
+    tune->tu = period;
+    tune->ku = 4.0 * tune->amplitude / (M_PI * sqrt(a2));
+    tune->done = 1;
+}
+
+// Run one step of the experiment and return the relay output
+double autotune_update(Autotune* tune, double setpoint, double measurement, int64_t now_us) {
+    if (tune->done) {
+        return 0;
+    }
+    if (!tune->started) {
+        tune->started = true;
+        tune->start_us = now_us;
+    }
+    if (now_us - tune->start_us > AUTOTUNE_TIMEOUT_US) {
+        tune->done = -1;
+        return 0;
+    }
+
+    if (measurement > tune->cycle_max) tune->cycle_max = measurement;
+    if (measurement < tune->cycle_min) tune->cycle_min = measurement;
+
+    double error = setpoint - measurement;
+    if (tune->relay < 0 && error > tune->hysteresis) {
+        // Rising switch closes one full cycle
+        tune->relay = 1;
+        if (tune->have_rise) {
+            // The first cycle is a transient from the starting position and is discarded
+            if (tune->completed > 0) {
+                int i = tune->completed - 1;
+                tune->periods[i] = (now_us - tune->last_rise_us) / 1e6;
+                tune->amplitudes[i] = (tune->cycle_max - tune->cycle_min) / 2.0;
+            }
+            tune->completed++;
+            if (tune->completed > tune->cycles) {
+                finish(tune);
+                return 0;
+            }
+        }
+        tune->have_rise = true;
+        tune->last_rise_us = now_us;
+        tune->cycle_max = measurement;
+        tune->cycle_min = measurement;
+    } else if (tune->relay > 0 && error < -tune->hysteresis) {
+        tune->relay = -1;
+    }
+    return tune->relay * tune->amplitude;
+}
+
+// Derive PID gains from a finished experiment
+int autotune_gains(const Autotune* tune, TuneRule rule, PidGains* gains) {
+    if (tune->done != 1 || rule < 0 || rule >= NUM_TUNE_RULES) {
+        return -1;
+    }
+    double ti = tune_rules[rule].ti * tune->tu;
+    double td = tune_rules[rule].td * tune->tu;
+    gains->kp = tune_rules[rule].kp * tune->ku;
+    gains->ki = gains->kp / ti;
+    gains->kd = gains->kp * td;
+    return 0;
+}
+
+const char* tune_rule_name(TuneRule rule) {
+    if (rule < 0 || rule >= NUM_TUNE_RULES) return "?";
+    return tune_rules[rule].name;
+}
+
+// Look up a rule by its name, -1 if unknown
+int tune_rule_from_name(const char* name) {
+    for (int i = 0; i < NUM_TUNE_RULES; i++) {
+        if (strcmp(name, tune_rules[i].name) == 0) return i;
+    }
+    return -1;
+}
+
+// Read "kp ki kd" lines from a gains file, missing keys keep their current value
+int gains_load(const char* path, PidGains* gains) {
+    FILE* file = fopen(path, "r");
+    if (!file) {
+        return -1;
+    }
+    char line[128];
+    char key[32];
+    double value;
+    while (fgets(line, sizeof(line), file)) {
+        if (line[0] == '#' || sscanf(line, "%31s %lf", key, &value) != 2) continue;
+        if (strcmp(key, "kp") == 0) gains->kp = value;
+        else if (strcmp(key, "ki") == 0) gains->ki = value;
+        else if (strcmp(key, "kd") == 0) gains->kd = value;
+    }
+    fclose(file);
+    return 0;
+}
+
+// Write the gains file
+int gains_save(const char* path, const PidGains* gains) {
+    FILE* file = fopen(path, "w");
+    if (!file) {
+        return -1;
+    }
+    fprintf(file, "# PID gains for line following (per second units)\n");
+    fprintf(file, "kp %.6f\nki %.6f\nkd %.6f\n", gains->kp, gains->ki, gains->kd);
+    return fclose(file) == 0 ? 0 : -1;
+}
@@ -0,0 +1,83 @@
+/**
+Class         : CSC-615-01 - Embedded Linux - Fall 2024
+Team Name     : Wayno
+Github        : nhannguyensf
+Project       : Final Assignment - Robot Car
+File          : autotune.h
+Description:
+This file is the header file for the autotune.c file. It declares the relay feedback (bang-bang) PID autotuner,
+the tuning rules that turn the measured ultimate gain and period into PID gains, and the gains file helpers.
+*
+Team Members:
+Kiran Poudel
+Nhan Nguyen
+Yuvraj Gupta
+Fernando Abel Malca Luque
+
+*
+**/
+#ifndef AUTOTUNE_H
+#define AUTOTUNE_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+// Default location of the tuned gains, loaded at startup
+#define GAINS_FILE "pid_gains.conf"
+
+// Limits of the relay experiment
+#define AUTOTUNE_MAX_CYCLES 16
+#define AUTOTUNE_TIMEOUT_US 30000000  // Give up after 30 s without a stable oscillation
+
+// Rules to derive PID gains from the ultimate gain and period
+typedef enum {
+    TUNE_ZIEGLER_NICHOLS,  // Classic Ziegler-Nichols, fast with overshoot
+    TUNE_PESSEN,           // Pessen integral rule, faster disturbance rejection
+    TUNE_SOME_OVERSHOOT,   // Ziegler-Nichols some overshoot
+    TUNE_NO_OVERSHOOT,     // Ziegler-Nichols no overshoot
+    TUNE_TYREUS_LUYBEN,    // Tyreus-Luyben, conservative and robust
+    NUM_TUNE_RULES
+} TuneRule;
+
+// PID gains in per second units
+typedef struct {
+    double kp;
+    double ki;
+    double kd;
+} PidGains;
+
+// Relay experiment state
+typedef struct {
+    // Settings
+    double amplitude;    // Relay output amplitude d
+    double hysteresis;   // Error band the relay ignores
+    int cycles;          // Oscillation cycles to average after the first one
+
+    // State
+    int relay;                  // +1 or -1
+    bool started;               // start_us holds the time of the first update
+    int64_t start_us;           // Time the experiment started
+    bool have_rise;             // last_rise_us holds a switch to +1
+    int64_t last_rise_us;       // Time of the last switch to +1
+    double cycle_max;           // Measurement extremes of the current cycle
+    double cycle_min;
+    int completed;              // Full cycles measured (the first one is discarded)
+    double periods[AUTOTUNE_MAX_CYCLES];
+    double amplitudes[AUTOTUNE_MAX_CYCLES];
+
+    // Result
+    int done;                   // 1 when finished, -1 when it timed out
+    double ku;                  // Ultimate gain
+    double tu;                  // Ultimate period in seconds
+} Autotune;
+
+// Function declarations
+void autotune_init(Autotune* tune, double amplitude, double hysteresis, int cycles);
+double autotune_update(Autotune* tune, double setpoint, double measurement, int64_t now_us);
+int autotune_gains(const Autotune* tune, TuneRule rule, PidGains* gains);
+const char* tune_rule_name(TuneRule rule);
+int tune_rule_from_name(const char* name);
+int gains_load(const char* path, PidGains* gains);
+int gains_save(const char* path, const PidGains* gains);
+
+#endif // AUTOTUNE_H
@@ -0,0 +1,169 @@
+/**
+Class         : CSC-615-01 - Embedded Linux - Fall 2024
+Team Name     : Wayno
+Github        : nhannguyensf
+Project       : Final Assignment - Robot Car
+File          : autotune_sim.c
+Description:
+This file is a host side simulation of the relay autotune experiment. A simple kinematic model of the car
+(two motors with a first order lag, the five line sensors on a bar in front of the axle and a straight line)
+is driven by the relay, the measured ultimate gain and period are turned into PID gains with the selected
+rule, and the gains are checked in a closed loop run before they are optionally written to a gains file.
+    autotune_sim [-r rule] [-o gains_file]
+*
+Team Members:
+Kiran Poudel
+Nhan Nguyen
+Yuvraj Gupta
+Fernando Abel Malca Luque
+
+*
+**/
+#include "autotune.h"
+#include "pid_controller.h"
+#include "pid_settings.h"
+#include "../executive/control_exec.h"
+#include "../sim/sim.h"
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+// The car model of the simulator without its dead band and traction limit, lengths in cm
+#define SPEED_PER_PERCENT (SIM_FULL_SPEED_CM_S / 100.0)  // Wheel speed in cm/s per percent of duty cycle
+#define LINE_HALF_WIDTH (TRACK_LINE_WIDTH_CM / 2.0)
+
+// The control executive's default period, the plant runs in finer steps
+#define CONTROL_DT (EXEC_DEFAULT_PERIOD_US / 1e6)
+#define PLANT_STEPS 10
+
+typedef struct {
+    double y;      // Lateral offset from the line, left positive
+    double theta;  // Heading relative to the line, counter clockwise positive
+    double vl;     // Wheel speeds
+    double vr;
+} Plant;
+
+// Advance the model by dt with the given motor commands in percent
+static void plant_step(Plant* plant, double left, double right, double dt) {
+    plant->vl += (left * SPEED_PER_PERCENT - plant->vl) * dt / SIM_MOTOR_TAU_S;
+    plant->vr += (right * SPEED_PER_PERCENT - plant->vr) * dt / SIM_MOTOR_TAU_S;
+    double v = (plant->vl + plant->vr) / 2.0;
+    plant->theta += (plant->vr - plant->vl) / SIM_WHEEL_BASE_CM * dt;
+    plant->y += v * sin(plant->theta) * dt;
+}
+
+// Weighted line position as computed by calculate_line_position in pid.c
+static double line_position(const Plant* plant, double last) {
+    static const double weights[NUM_SENSORS] = LINE_POSITION_WEIGHTS;
+    double line = -(plant->y + LINE_SENSOR_LOOKAHEAD_CM * sin(plant->theta));
+    double sum = 0;
+    int active = 0;
+    for (int i = 0; i < NUM_SENSORS; i++) {
+        if (fabs(line - (i - 2) * LINE_SENSOR_SPACING_CM) < LINE_HALF_WIDTH) {
+            sum += weights[i];
+            active++;
+        }
+    }
+    return active ? sum / active : last;
+}
+
+static double clamp(double value, double limit) {
+    return value > limit ? limit : (value < -limit ? -limit : value);
+}
+
+// Run the relay experiment, returns 0 when it produced a result
+static int run_relay(Autotune* tune) {
+    Plant plant = {1.0, 0, 0, 0};
+    double position = 0;
+    autotune_init(tune, AUTOTUNE_AMPLITUDE, AUTOTUNE_HYSTERESIS, AUTOTUNE_CYCLES);
+    for (int64_t t = 0; !tune->done; t += EXEC_DEFAULT_PERIOD_US) {
+        position = line_position(&plant, position);
+        double control = -autotune_update(tune, 0.0, position, t);
+        for (int i = 0; i < PLANT_STEPS; i++) {
+            plant_step(&plant, BASE_SPEED - control, BASE_SPEED + control, CONTROL_DT / PLANT_STEPS);
+        }
+    }
+    return tune->done == 1 ? 0 : -1;
+}
+
+// Closed loop check of a set of gains, returns the RMS lateral offset in cm
+static double run_closed_loop(const PidGains* gains, double seconds, int* line_lost) {
+    Plant plant = {2.0, 0, 0, 0};
+    PidController pid;
+    double position = 0, sum_sq = 0;
+    int steps = (int)(seconds / CONTROL_DT);
+    pid_ctrl_init(&pid, gains->kp, gains->ki, gains->kd, DERIVATIVE_TAU, -MAX_CONTROL, MAX_CONTROL, CONTROL_RATE_LIMIT);
+    *line_lost = 0;
+    for (int n = 0; n < steps; n++) {
+        double last = position;
+        position = line_position(&plant, NAN);
+        if (isnan(position)) {
+            (*line_lost)++;
+            position = last;
+        }
+        double control = clamp(-pid_ctrl_update(&pid, 0.0, position, CONTROL_DT), MAX_CONTROL);
+        for (int i = 0; i < PLANT_STEPS; i++) {
+            plant_step(&plant, BASE_SPEED - control, BASE_SPEED + control, CONTROL_DT / PLANT_STEPS);
+        }
+        sum_sq += plant.y * plant.y;
+    }
+    return sqrt(sum_sq / steps);
+}
+
+int main(int argc, char* argv[]) {
+    int rule = TUNE_ZIEGLER_NICHOLS;
+    const char* output = NULL;
+    int opt;
+    while ((opt = getopt(argc, argv, "r:o:")) != -1) {
+        switch (opt) {
+            case 'r':
+                rule = tune_rule_from_name(optarg);
+                if (rule < 0) {
+                    fprintf(stderr, "Unknown tuning rule: %s\n", optarg);
+                    return 1;
+                }
+                break;
+            case 'o':
+                output = optarg;
+                break;
+            default:
+                fprintf(stderr, "Usage: %s [-r rule] [-o gains_file]\n", argv[0]);
+                return 1;
+        }
+    }
+
+    Autotune tune;
+    if (run_relay(&tune) < 0) {
+        printf("Relay experiment did not produce a stable oscillation\n");
+        return 1;
+    }
+    printf("Relay experiment: Ku %.3f, Tu %.3f s\n", tune.ku, tune.tu);
+
+    // Hand tuned gains from pid.c for comparison
+    PidGains current = {KP, KI, KD};
+    int current_lost;
+    double current_rms = run_closed_loop(&current, 20.0, &current_lost);
+    printf("  %-15s kp %8.3f ki %8.3f kd %7.4f  rms %.3f cm, %d ticks without line\n",
+           "hand-tuned", current.kp, current.ki, current.kd, current_rms, current_lost);
+
+    for (int r = 0; r < NUM_TUNE_RULES; r++) {
+        PidGains gains;
+        int lost;
+        autotune_gains(&tune, r, &gains);
+        double rms = run_closed_loop(&gains, 20.0, &lost);
+        printf("%c %-15s kp %8.3f ki %8.3f kd %7.4f  rms %.3f cm, %d ticks without line\n",
+               r == rule ? '*' : ' ', tune_rule_name(r), gains.kp, gains.ki, gains.kd, rms, lost);
+    }
+
+    if (output) {
+        PidGains gains;
+        autotune_gains(&tune, rule, &gains);
+        if (gains_save(output, &gains) < 0) {
+            printf("Failed to write %s\n", output);
+            return 1;
+        }
+        printf("%s gains written to %s\n", tune_rule_name(rule), output);
+    }
+    return 0;
+}
@@ -8,6 +8,10 @@ Description:
 This file contains the PID control algorithm for the robot car project. This also includes the state machine for the robot's behavior for 
 line following and obstacle avoidance. The robot uses the PID algorithm to follow the line and avoid obstacles using the echo sensor which
 detect the distance from the obstacles and pause PID contorl to turn around the obstacle.
+The behaviours are expressed as data for the table driven state machine engine in fsm/fsm.c: every state has
+entry, tick and exit handlers, and the transitions between them are listed in one static table.
+All the state of the controller lives in a Controller instance that reaches the robot through its own robot I/O
+backend, so the simulator can run many of them side by side. The car uses one instance through the pid_ calls.
 *
 Team Members:
 Kiran Poudel
@@ -18,21 +22,22 @@ Fernando Abel Malca Luque
 *
 **/ 
 #include <stdio.h>
-#include "../motor/MotorDriver.h"
+#include "../motor/Debug.h"
 #include "../line-sensor/line_sensor.h"
 #include "../echoSensor/echoSensor.h"
-#include <unistd.h>
+#include "../fsm/fsm.h"
+#include "pid.h"
+#include "pid_controller.h"
+#include "pid_settings.h"
+#include "autotune.h"
+#include "../params/params.h"
+#include "../recorder/flight_recorder.h"
+#include "../prof/prof.h"
+#include "../trace/trace.h"
+#include "../robotio/robotio.h"
 #include <stdbool.h>
-#include <time.h>
-
-// PID constants
-#define KP 50.0  
-#define KI 1  
-#define KD 1  
-
-// Control limits
-#define MAX_CONTROL 100
-#define BASE_SPEED 60
+#include <stdint.h>
+#include <string.h>
 
 // Object detection thresholds
 #define FRONT_THRESHOLD 30.0  // Distance to detect front obstacle
@@ -40,90 +45,128 @@ Fernando Abel Malca Luque
 #define TURN_SPEED 15        // Speed for turning
 #define AVOID_SPEED 50       // Speed while avoiding obstacle
 
-// Turn timing (microseconds)
-#define TURN_90_TIME 1500000  // Time to turn 90 degrees
+// Maneuver timing (microseconds)
+#define TURN_90_TIME 1500000          // Time to turn 90 degrees
+#define STOP_WAIT_TIME 500000         // Pause after stopping for an obstacle
+#define SETTLE_TIME 50000             // Settle time after stopping before reading sensors
+#define FORWARD_SHORT_TIME 1500000    // Drive time past the obstacle corner
+#define FORWARD_TIME 1800000          // Drive time along the obstacle
+#define FORWARD_MORE_TIME 2000000     // Drive time back towards the line
+#define LINE_LOST_TIME 1000000        // Time without a line before searching for it
+#define SEARCH_SWEEP_TURNS 2          // The search turns at half TURN_SPEED, a quarter turn takes 2 TURN_90_TIME
 
 // Robot states
 typedef enum {
     FOLLOWING_LINE, // State for following the line
+    AVOIDING, // Parent state of the obstacle avoidance sequence
     STOPPING, // State for stopping the robot
     TURNING_RIGHT, // State for turning right
     CHECK_RIGHT, // State for checking right side for obstacle
+    DRIVING_PAST, // Parent state of the forward moves, restarts avoidance on a new obstacle
     MOVE_FORWARD_SHORT, // State for moving forward a short distance
     CHECK_LEFT, // State for checking left side for obstacle
     ALIGN_STRAIGHT, // State for aligning the robot straight
     MOVE_FORWARD, // State for moving forward
     TURNING_LEFT, // State for turning left
     MOVE_FORWARD_MORE, // State for moving forward more
-    FIND_LINE // State for finding the line
+    FIND_LINE, // State for finding the line
+    LINE_SEARCH_FAILED, // Stopped after the search swept both sides without finding the line
+    NUM_STATES
 } RobotState;
-// Global variables for robot state
-static RobotState current_state = FOLLOWING_LINE;
-static struct timespec turn_start_time;
-static bool turn_started = false;
 
-// Global variables for PID calculation
-static double last_error = 0;
-static double integral = 0;
+// Events raised by the tick handlers
+typedef enum {
+    EV_NONE = FSM_NO_EVENT,
+    EV_FRONT_OBSTACLE, // Obstacle closer than FRONT_THRESHOLD
+    EV_DONE, // Timed maneuver finished and settled
+    EV_SIDE_BLOCKED, // Side sensor sees an obstacle
+    EV_SIDE_CLEAR, // Side sensor is clear
+    EV_LINE_LOST, // No line for LINE_LOST_TIME
+    EV_LINE_FOUND, // A line sensor sees the line
+    EV_TIMEOUT, // The line search is over
+    NUM_EVENTS
+} RobotEvent;
+
+// Default parameters of a new controller
+static const ControlParams default_params = {
+    KP, KI, KD, BASE_SPEED, FRONT_THRESHOLD, SIDE_THRESHOLD, TURN_SPEED, AVOID_SPEED,
+    TURN_90_TIME, FORWARD_SHORT_TIME, FORWARD_TIME, FORWARD_MORE_TIME
+};
+
+// Controller of the car, driven by the pid_ functions through the robot I/O selected with rio_init
+static Controller car_controller;
+static bool car_controller_ready = false;
+
+static Controller* car(void) {
+    if (!car_controller_ready) {
+        controller_init(&car_controller, &rio_selected, NULL);
+        car_controller_ready = true;
+    }
+    return &car_controller;
+}
+
+// Command both motors and remember the command
+static void run_motors(Controller* ctl, int left_speed, int right_speed) {
+    PROF_BEGIN(PROF_MOTORS);
+    TRACE_BEGIN("motors");
+    ctl->io->motor_run(ctl->io_ctx, left_speed, right_speed);
+    TRACE_END("motors");
+    TRACE_COUNTER("motor_left", left_speed);
+    TRACE_COUNTER("motor_right", right_speed);
+    PROF_END(PROF_MOTORS);
+    ctl->motor_left = left_speed;
+    ctl->motor_right = right_speed;
+}
 
 // Function to safely stop motors
-static void stop_motors() {
-    Motor_Run(MOTORA, 0);
-    Motor_Run(MOTORB, 0);
-    usleep(50000); // Short delay after stopping
+static void stop_motors(Controller* ctl) {
+    run_motors(ctl, 0, 0);
 }
 
-// Function to start turn timer
-static void start_turn_timer() {
-    clock_gettime(CLOCK_MONOTONIC, &turn_start_time);
-    turn_started = true;
+// Stop a timed maneuver once its time is up, returns EV_DONE after the settle time
+static int maneuver_tick(Controller* ctl, long duration_us) {
+    int64_t elapsed = fsm_elapsed_us(&ctl->robot);
+    if (elapsed < duration_us) {
+        return EV_NONE;
+    }
+    if (!ctl->motors_stopped) {
+        stop_motors(ctl);
+        ctl->motors_stopped = true;
+    }
+    return elapsed >= duration_us + SETTLE_TIME ? EV_DONE : EV_NONE;
 }
 
-// Function to check if turn is complete
-static bool is_turn_complete() {
-    // Check if turn has started
-    if (!turn_started) return false;
-    // Get current time
-    struct timespec current_time;
-    clock_gettime(CLOCK_MONOTONIC, &current_time);
-    // Calculate elapsed time in microseconds
-    long elapsed_us = (current_time.tv_sec - turn_start_time.tv_sec) * 1000000 +
-                     (current_time.tv_nsec - turn_start_time.tv_nsec) / 1000;
-                     
-    return elapsed_us >= TURN_90_TIME;
+// Start a timed maneuver with the given motor speeds
+static void start_maneuver(Controller* ctl, int left_speed, int right_speed) {
+    run_motors(ctl, left_speed, right_speed);
+    ctl->motors_stopped = false;
 }
 
 // Function to check front sensor for obstacles
-static bool check_front_obstacle() {
-    double distances[NUM_SENSORS];
-    if (getCurrentDistances(distances) == 0) {
-        // Check middle sensor (index 1)
-        if (distances[1] > 0 && distances[1] < FRONT_THRESHOLD) {
-            printf("Front obstacle detected at %.2f cm!\n", distances[1]);
-            return true;
-        }
+static bool check_front_obstacle(Controller* ctl) {
+    // Check middle sensor (index 1)
+    if (ctl->distances_valid && ctl->distances[1] > 0 && ctl->distances[1] < ctl->params.front_threshold) {
+        LOG_INFO("Front obstacle detected at %.2f cm!\n", ctl->distances[1]);
+        return true;
     }
     return false;
 }
 
 // Function to check side sensors for obstacles
-static bool check_side_obstacle(int side) {
-    double distances[NUM_SENSORS];
-    if (getCurrentDistances(distances) == 0) {
-        // side 0 for left (index 0), side 2 for right (index 2)
-        if (distances[side] > 0 && distances[side] < SIDE_THRESHOLD) {
-            printf("%s obstacle detected at %.2f cm!\n", 
-                   side == 0 ? "Left" : "Right", distances[side]);
-            return true;
-        }
+static bool check_side_obstacle(Controller* ctl, int side) {
+    // side 0 for left (index 0), side 2 for right (index 2)
+    if (ctl->distances_valid && ctl->distances[side] > 0 && ctl->distances[side] < ctl->params.side_threshold) {
+        LOG_INFO("%s obstacle detected at %.2f cm!\n",
+               side == 0 ? "Left" : "Right", ctl->distances[side]);
+        return true;
     }
     return false;
 }
 
 // Function to calculate weighted position from line sensors
-double calculate_line_position(int* sensor_states) {
+double controller_line_position(const Controller* ctl, const int* sensor_states) {
     // Weights for each sensor
-    const double weights[] = {-3.0, -2.0, 0.0, 2.0, 3.0};
+    const double weights[] = LINE_POSITION_WEIGHTS;
     double weighted_sum = 0;
     int active_sensors = 0;
     // Calculate weighted sum of active sensors
@@ -133,206 +176,460 @@ double calculate_line_position(int* sensor_states) {
             active_sensors++;
         }
     }
-    
+
     if (active_sensors == 0) {
-        return last_error;
+        return ctl->last_error;
     }
     // Return weighted average
     return weighted_sum / active_sensors;
 }
 
+double calculate_line_position(int* sensor_states) {
+    return controller_line_position(car(), sensor_states);
+}
+
 // Function to check if we've found the line
-static bool check_for_line() {
-    int sensor_states[NUM_SENSORS];
-    read_line_sensors(sensor_states);
-    
+static bool check_for_line(Controller* ctl) {
     for (int i = 0; i < NUM_SENSORS; i++) {
-        if (sensor_states[i]) {
+        if (ctl->sensor_states[i]) {
             return true;
         }
     }
     return false;
 }
 
-// Main PID control function
-void pid_control() {
-    static int echo_check_counter = 0;
-    int sensor_states[NUM_SENSORS];
-
-    // State machine for robot behavior
-    switch (current_state) {
-        // Line following state
-        case FOLLOWING_LINE:
-            // Check for obstacles periodically
-            if (++echo_check_counter >= 1) {
-                echo_check_counter = 0;
-                if (check_front_obstacle()) {
-                    printf("Front obstacle detected! Stopping...\n");
-                    stop_motors();
-                    // Move to stopping state
-                    current_state = STOPPING;
-                    return;
-                }
-            }
-
-            // Normal line following
-            read_line_sensors(sensor_states);
-
-            // If no line detected, skip this loop iteration
-            int active_sensors = 0;
-            for (int i = 0; i < NUM_SENSORS; i++) {
-                if (sensor_states[i] == 1) {
-                    active_sensors++;
-                }
-            }
-            if (active_sensors == 0) {
-                printf("No line detected, skipping loop...\n");
-                return;  // Skip the rest of the loop if no line is detected
-            }
-            // Calculate PID control
-            double error = calculate_line_position(sensor_states);
-            integral += error;
-            double derivative = error - last_error;
-            
-            if (integral > MAX_CONTROL) integral = MAX_CONTROL;
-            if (integral < -MAX_CONTROL) integral = -MAX_CONTROL;
-            
-            double control = KP * error + KI * integral + KD * derivative;
-            if (control > MAX_CONTROL) control = MAX_CONTROL;
-            if (control < -MAX_CONTROL) control = -MAX_CONTROL;
-            
-            int left_speed = BASE_SPEED - control;
-            int right_speed = BASE_SPEED + control;
-            // Limit speed values
-            if (left_speed > 100) left_speed = 100;
-            if (left_speed < -100) left_speed = -100;
-            if (right_speed > 100) right_speed = 100;
-            if (right_speed < -100) right_speed = -100;
-            // Run motors
-            Motor_Run(MOTORA, left_speed);
-            Motor_Run(MOTORB, right_speed);
-            last_error = error;
-            break;
-        // Stopping state
-        case STOPPING:
-            printf("Robot stopped. Starting right turn...\n");
-            usleep(500000);  // Wait for 0.5 seconds
-            turn_started = false;
-            current_state = TURNING_RIGHT;
-            break;
-        // Right turn state
-        case TURNING_RIGHT:
-            if (!turn_started) {
-                printf("Starting 90-degree right turn\n");
-                start_turn_timer();
-                Motor_Run(MOTORA, TURN_SPEED);    // Left motor forward
-                Motor_Run(MOTORB, -TURN_SPEED);   // Right motor reverse
-            } else if (is_turn_complete()) {
-                printf("Right turn complete, checking right side\n");
-                stop_motors();
-                turn_started = false;
-                current_state = CHECK_RIGHT;
-            }
-            break;
-        // Check right side for obstacles
-        case CHECK_RIGHT:
-            if (check_side_obstacle(2)) {  // Check right sensor
-                printf("Right side blocked, cannot proceed\n");
-                current_state = TURNING_LEFT;
-            } else {
-                printf("Right side clear, moving forward\n");
-                current_state = MOVE_FORWARD_SHORT;
-            }
-            break;
-        // Move forward a short distance
-        case MOVE_FORWARD_SHORT:
-            Motor_Run(MOTORA, AVOID_SPEED);
-            Motor_Run(MOTORB, AVOID_SPEED);
-            usleep(1500000);  
-            stop_motors();
-            printf("Checking left side\n");
-            current_state = CHECK_LEFT;
-            break;
-        // Check left side for obstacles
-        case CHECK_LEFT:
-            if (check_side_obstacle(0)) {  // Check left sensor
-                printf("Left side blocked, continuing forward\n");
-                current_state = ALIGN_STRAIGHT;
-            } else {
-                printf("Left side clear, turning to face straight\n");
-                turn_started = false;
-                current_state = ALIGN_STRAIGHT;
-            }
-            break;
-        // Align robot straight
-        case ALIGN_STRAIGHT:
-            if (!turn_started) {
-                printf("Aligning straight\n");
-                start_turn_timer();
-                Motor_Run(MOTORA, -TURN_SPEED);   // Right motor reverse
-                Motor_Run(MOTORB, TURN_SPEED);    // left motor forward
-            } else if (is_turn_complete()) {
-                printf("Aligned straight, moving forward\n");
-                stop_motors();
-                turn_started = false;
-                current_state = MOVE_FORWARD;
-            }
-            break;
-        // Move forward state
-        case MOVE_FORWARD:
-            Motor_Run(MOTORA, AVOID_SPEED);
-            Motor_Run(MOTORB, AVOID_SPEED);
-            usleep(1800000);  // Move forward for 1 second
-            stop_motors();
-            
-            if (!check_side_obstacle(0)) {  // Check left side again
-                printf("Left side clear, starting full left turn\n");
-                turn_started = false;
-                current_state = TURNING_LEFT;
-            } else {
-                printf("Left side blocked, continuing line following\n");
-                current_state = FOLLOWING_LINE;
-            }
-            break;
-        // Move forward for a longer distance
-        case MOVE_FORWARD_MORE:
-            Motor_Run(MOTORA, AVOID_SPEED);
-            Motor_Run(MOTORB, AVOID_SPEED);
-            usleep(2000000);  // Move forward for 1 second
-            stop_motors();
-            
-            if (!check_side_obstacle(0)) {  // Check left side again
-                printf("Left side clear, starting full left turn\n");
-                turn_started = false;
-                current_state = FOLLOWING_LINE;
-            } else {
-                printf("Left side blocked, continuing line following\n");
-                current_state = FOLLOWING_LINE;
-            }
-            break;
-        // Left turn state
-        case TURNING_LEFT:
-            if (!turn_started) {
-                printf("Starting full left turn\n");
-                start_turn_timer();
-                Motor_Run(MOTORA, -TURN_SPEED);   // Right motor reverse
-                Motor_Run(MOTORB, TURN_SPEED);    // Left motor forward
-            } else if (is_turn_complete()) {
-                printf("Left turn complete, searching for line\n");
-                stop_motors();
-                current_state = MOVE_FORWARD_MORE;
-            }
-            break;
-        // Find line state
-        case FIND_LINE:
-            if (check_for_line()) {
-                printf("Line found! Resuming line following\n");
-                current_state = FOLLOWING_LINE;
-            } else {
-                // Continue turning slowly until line is found
-                Motor_Run(MOTORA, -TURN_SPEED/2);
-                Motor_Run(MOTORB, TURN_SPEED/2);
-            }
-            break;
+// Sample every sensor once at the start of a tick
+static void sample_sensors(Controller* ctl) {
+    PROF_BEGIN(PROF_LINE_SENSORS);
+    ctl->io->read_line(ctl->io_ctx, ctl->sensor_states);
+    PROF_END(PROF_LINE_SENSORS);
+
+    PROF_BEGIN(PROF_ECHO_READ);
+    ctl->distances_valid = ctl->io->get_distances(ctl->io_ctx, ctl->distances) == 0;
+    PROF_END(PROF_ECHO_READ);
+}
+
+// ---- State handlers ----
+
+static void following_entry(Fsm* fsm) {
+    Controller* ctl = fsm->user;
+    ctl->last_line_us = fsm_now_us(fsm);
+    ctl->last_pid_us = ctl->last_line_us;
+    pid_ctrl_reset(&ctl->line_pid);
+}
+
+// Line following with PID control
+static int following_tick(Fsm* fsm) {
+    Controller* ctl = fsm->user;
+    if (check_front_obstacle(ctl)) {
+        LOG_INFO("Front obstacle detected! Stopping...\n");
+        return EV_FRONT_OBSTACLE;
+    }
+
+    // If no line detected, skip this loop iteration
+    if (!check_for_line(ctl)) {
+        if (fsm_now_us(fsm) - ctl->last_line_us >= LINE_LOST_TIME) {
+            LOG_INFO("Line lost, searching...\n");
+            return EV_LINE_LOST;
+        }
+        LOG_DEBUG("No line detected, skipping loop...\n");
+        return EV_NONE;  // Skip the rest of the loop if no line is detected
+    }
+    int64_t now = fsm_now_us(fsm);
+    ctl->last_line_us = now;
+
+    // Time step since the previous PID update, bounded after skipped iterations
+    double dt = (now - ctl->last_pid_us) / 1e6;
+    if (dt > MAX_DT) dt = MAX_DT;
+    ctl->last_pid_us = now;
+
+    // Calculate PID control, the controller steers the line position back to the center
+    PROF_BEGIN(PROF_PID);
+    double error = controller_line_position(ctl, ctl->sensor_states);
+    double control = -pid_ctrl_update(&ctl->line_pid, 0.0, error, dt);
+    PROF_END(PROF_PID);
+    TRACE_COUNTER("line_error", error);
+
+    int left_speed = ctl->params.base_speed - control;
+    int right_speed = ctl->params.base_speed + control;
+    // Limit speed values
+    if (left_speed > 100) left_speed = 100;
+    if (left_speed < -100) left_speed = -100;
+    if (right_speed > 100) right_speed = 100;
+    if (right_speed < -100) right_speed = -100;
+    // Run motors
+    run_motors(ctl, left_speed, right_speed);
+    ctl->last_error = error;
+    return EV_NONE;
+}
+
+// Leaving the avoidance sequence always leaves the motors stopped
+static void avoiding_exit(Fsm* fsm) {
+    stop_motors(fsm->user);
+}
+
+static void stopping_entry(Fsm* fsm) {
+    stop_motors(fsm->user);
+    LOG_INFO("Robot stopped. Starting right turn...\n");
+}
+
+static int stopping_tick(Fsm* fsm) {
+    return fsm_elapsed_us(fsm) >= STOP_WAIT_TIME ? EV_DONE : EV_NONE;
+}
+
+static void turning_right_entry(Fsm* fsm) {
+    Controller* ctl = fsm->user;
+    LOG_INFO("Starting 90-degree right turn\n");
+    start_maneuver(ctl, ctl->params.turn_speed, -ctl->params.turn_speed);  // Left motor forward, right motor reverse
+}
+
+static int turn_tick(Fsm* fsm) {
+    Controller* ctl = fsm->user;
+    return maneuver_tick(ctl, ctl->params.turn_90_time);
+}
+
+static int check_right_tick(Fsm* fsm) {
+    if (check_side_obstacle(fsm->user, 2)) {  // Check right sensor
+        LOG_WARN("Right side blocked, cannot proceed\n");
+        return EV_SIDE_BLOCKED;
+    }
+    LOG_INFO("Right side clear, moving forward\n");
+    return EV_SIDE_CLEAR;
+}
+
+// Any forward move is restarted from STOPPING when a new obstacle shows up in front
+static int driving_past_tick(Fsm* fsm) {
+    if (check_front_obstacle(fsm->user)) {
+        LOG_INFO("Obstacle during %s, restarting avoidance\n", fsm_state_name(fsm, fsm_state(fsm)));
+        return EV_FRONT_OBSTACLE;
+    }
+    return EV_NONE;
+}
+
+static void forward_entry(Fsm* fsm) {
+    Controller* ctl = fsm->user;
+    start_maneuver(ctl, ctl->params.avoid_speed, ctl->params.avoid_speed);
+}
+
+static int forward_short_tick(Fsm* fsm) {
+    Controller* ctl = fsm->user;
+    return maneuver_tick(ctl, ctl->params.forward_short_time);
+}
+
+static int check_left_tick(Fsm* fsm) {
+    if (check_side_obstacle(fsm->user, 0)) {  // Check left sensor
+        LOG_INFO("Left side blocked, continuing forward\n");
+        return EV_SIDE_BLOCKED;
+    }
+    LOG_INFO("Left side clear, turning to face straight\n");
+    return EV_SIDE_CLEAR;
+}
+
+static void align_straight_entry(Fsm* fsm) {
+    Controller* ctl = fsm->user;
+    LOG_INFO("Aligning straight\n");
+    start_maneuver(ctl, -ctl->params.turn_speed, ctl->params.turn_speed);  // Left motor reverse, right motor forward
+}
+
+static int forward_tick(Fsm* fsm) {
+    Controller* ctl = fsm->user;
+    if (maneuver_tick(ctl, ctl->params.forward_time) != EV_DONE) {
+        return EV_NONE;
+    }
+    if (!check_side_obstacle(ctl, 0)) {  // Check left side again
+        LOG_INFO("Left side clear, starting full left turn\n");
+        return EV_SIDE_CLEAR;
+    }
+    LOG_INFO("Left side blocked, continuing line following\n");
+    return EV_SIDE_BLOCKED;
+}
+
+static void turning_left_entry(Fsm* fsm) {
+    Controller* ctl = fsm->user;
+    LOG_INFO("Starting full left turn\n");
+    start_maneuver(ctl, -ctl->params.turn_speed, ctl->params.turn_speed);  // Left motor reverse, right motor forward
+}
+
+static int forward_more_tick(Fsm* fsm) {
+    Controller* ctl = fsm->user;
+    if (check_for_line(ctl)) {
+        LOG_INFO("Line found while returning, resuming line following\n");
+        return EV_LINE_FOUND;
+    }
+    return maneuver_tick(ctl, ctl->params.forward_more_time);
+}
+
+// Turn in place at half the turning speed, 1 to the left and -1 to the right
+static void search_turn(Controller* ctl, int direction) {
+    run_motors(ctl, -direction * ctl->params.turn_speed/2, direction * ctl->params.turn_speed/2);
+}
+
+// Turn slowly about a quarter turn towards the side the line was last seen on
+static void find_line_entry(Fsm* fsm) {
+    Controller* ctl = fsm->user;
+    ctl->search_reversed = false;
+    search_turn(ctl, ctl->last_error >= 0 ? 1 : -1);
+}
+
+// Then sweep back past the heading the search started from to a quarter turn on the other side, and give up
+// there: spinning in place does not reach a line that is beside the car rather than around it
+static int find_line_tick(Fsm* fsm) {
+    Controller* ctl = fsm->user;
+    if (check_for_line(ctl)) {
+        LOG_INFO("Line found! Resuming line following\n");
+        return EV_LINE_FOUND;
+    }
+    int64_t sweep = (int64_t)SEARCH_SWEEP_TURNS * ctl->params.turn_90_time;
+    int64_t elapsed = fsm_elapsed_us(fsm);
+    if (elapsed >= 3 * sweep) {
+        LOG_WARN("Line not found on either side, stopping\n");
+        return EV_TIMEOUT;
+    }
+    if (elapsed >= sweep && !ctl->search_reversed) {
+        search_turn(ctl, ctl->last_error >= 0 ? -1 : 1);
+        ctl->search_reversed = true;
+    }
+    return EV_NONE;
+}
+
+// The car waits where the search ended until it is put back on the line
+static void search_failed_entry(Fsm* fsm) {
+    stop_motors(fsm->user);
+}
+
+static int search_failed_tick(Fsm* fsm) {
+    if (check_for_line(fsm->user)) {
+        LOG_INFO("Line found! Resuming line following\n");
+        return EV_LINE_FOUND;
     }
+    return EV_NONE;
+}
+
+// State timing uses the robot I/O clock, so a replay runs on the recorded time
+static int64_t robot_clock(void* clock_ctx) {
+    Controller* ctl = clock_ctx;
+    return ctl->io->now_us(ctl->io_ctx);
+}
+
+// ---- State machine tables ----
+
+static const FsmStateDef robot_states[NUM_STATES] = {
+    [FOLLOWING_LINE]     = {"FOLLOWING_LINE",     FSM_NO_STATE, following_entry,      following_tick,    NULL},
+    [AVOIDING]           = {"AVOIDING",           FSM_NO_STATE, NULL,                 NULL,              avoiding_exit},
+    [STOPPING]           = {"STOPPING",           AVOIDING,     stopping_entry,       stopping_tick,     NULL},
+    [TURNING_RIGHT]      = {"TURNING_RIGHT",      AVOIDING,     turning_right_entry,  turn_tick,         NULL},
+    [CHECK_RIGHT]        = {"CHECK_RIGHT",        AVOIDING,     NULL,                 check_right_tick,  NULL},
+    [DRIVING_PAST]       = {"DRIVING_PAST",       AVOIDING,     NULL,                 driving_past_tick, NULL},
+    [MOVE_FORWARD_SHORT] = {"MOVE_FORWARD_SHORT", DRIVING_PAST, forward_entry,        forward_short_tick, NULL},
+    [CHECK_LEFT]         = {"CHECK_LEFT",         AVOIDING,     NULL,                 check_left_tick,   NULL},
+    [ALIGN_STRAIGHT]     = {"ALIGN_STRAIGHT",     AVOIDING,     align_straight_entry, turn_tick,         NULL},
+    [MOVE_FORWARD]       = {"MOVE_FORWARD",       DRIVING_PAST, forward_entry,        forward_tick,      NULL},
+    [TURNING_LEFT]       = {"TURNING_LEFT",       AVOIDING,     turning_left_entry,   turn_tick,         NULL},
+    [MOVE_FORWARD_MORE]  = {"MOVE_FORWARD_MORE",  DRIVING_PAST, forward_entry,        forward_more_tick, NULL},
+    [FIND_LINE]          = {"FIND_LINE",          FSM_NO_STATE, find_line_entry,      find_line_tick,    NULL},
+    [LINE_SEARCH_FAILED] = {"LINE_SEARCH_FAILED", FSM_NO_STATE, search_failed_entry,  search_failed_tick, NULL},
+};
+
+static const FsmTransition robot_transitions[] = {
+    {FOLLOWING_LINE,     EV_FRONT_OBSTACLE, STOPPING},
+    {FOLLOWING_LINE,     EV_LINE_LOST,      FIND_LINE},
+    {STOPPING,           EV_DONE,           TURNING_RIGHT},
+    {TURNING_RIGHT,      EV_DONE,           CHECK_RIGHT},
+    {CHECK_RIGHT,        EV_SIDE_BLOCKED,   TURNING_LEFT},
+    {CHECK_RIGHT,        EV_SIDE_CLEAR,     MOVE_FORWARD_SHORT},
+    {DRIVING_PAST,       EV_FRONT_OBSTACLE, STOPPING},
+    {MOVE_FORWARD_SHORT, EV_DONE,           CHECK_LEFT},
+    {CHECK_LEFT,         EV_SIDE_BLOCKED,   ALIGN_STRAIGHT},
+    {CHECK_LEFT,         EV_SIDE_CLEAR,     ALIGN_STRAIGHT},
+    {ALIGN_STRAIGHT,     EV_DONE,           MOVE_FORWARD},
+    {MOVE_FORWARD,       EV_SIDE_CLEAR,     TURNING_LEFT},
+    {MOVE_FORWARD,       EV_SIDE_BLOCKED,   FOLLOWING_LINE},
+    {TURNING_LEFT,       EV_DONE,           MOVE_FORWARD_MORE},
+    {MOVE_FORWARD_MORE,  EV_LINE_FOUND,     FOLLOWING_LINE},
+    {MOVE_FORWARD_MORE,  EV_DONE,           FIND_LINE},
+    {FIND_LINE,          EV_LINE_FOUND,     FOLLOWING_LINE},
+    {FIND_LINE,          EV_TIMEOUT,        LINE_SEARCH_FAILED},
+    {LINE_SEARCH_FAILED, EV_LINE_FOUND,     FOLLOWING_LINE},
+};
+
+static const char* const robot_event_names[NUM_EVENTS] = {
+    "NONE", "FRONT_OBSTACLE", "DONE", "SIDE_BLOCKED", "SIDE_CLEAR", "LINE_LOST", "LINE_FOUND", "TIMEOUT"
+};
+
+static const FsmTable robot_table = {
+    robot_states, NUM_STATES,
+    robot_transitions, sizeof(robot_transitions) / sizeof(robot_transitions[0]),
+    robot_event_names, NUM_EVENTS
+};
+
+
+// ---- Controller instances ----
+
+// Start a controller with the default parameters on a robot I/O backend
+void controller_init(Controller* ctl, const RobotIO* io, void* io_ctx) {
+    memset(ctl, 0, sizeof(*ctl));
+    ctl->io = io;
+    ctl->io_ctx = io_ctx;
+    ctl->params = default_params;
+}
+
+// One control iteration. Every state does a bounded amount of work per call and uses
+// deadlines instead of sleeping, so the sensors are sampled on every tick.
+void controller_tick(Controller* ctl) {
+    if (ctl->io->begin_tick) {
+        ctl->io->begin_tick(ctl->io_ctx);
+    }
+    if (!ctl->started) {
+        pid_ctrl_init(&ctl->line_pid, ctl->params.kp, ctl->params.ki, ctl->params.kd, DERIVATIVE_TAU, -MAX_CONTROL, MAX_CONTROL, CONTROL_RATE_LIMIT);
+        if (fsm_init(&ctl->robot, &robot_table, FOLLOWING_LINE, ctl) < 0) {
+            LOG_ERROR("Invalid robot state machine table\n");
+            return;
+        }
+        fsm_set_clock(&ctl->robot, robot_clock, ctl);
+        fsm_start(&ctl->robot);
+        ctl->started = true;
+    }
+
+    PROF_BEGIN(PROF_TICK);
+    TRACE_BEGIN("control_tick");
+    int64_t tick_start = fsm_now_us(&ctl->robot);
+    int tick_state = fsm_state(&ctl->robot);
+    ctl->last_tick_us = tick_start;
+
+    // Pick up parameter changes at the iteration boundary
+    if (ctl->io->refresh_params(ctl->io_ctx, &ctl->params)) {
+        pid_ctrl_set_gains(&ctl->line_pid, ctl->params.kp, ctl->params.ki, ctl->params.kd);
+    }
+
+    sample_sensors(ctl);
+    fsm_tick(&ctl->robot);
+
+    // Track the worst case tick time of the state that ran
+    long tick_us = (long)(fsm_now_us(&ctl->robot) - tick_start);
+    if (tick_us > ctl->max_tick_us[tick_state]) {
+        ctl->max_tick_us[tick_state] = tick_us;
+    }
+    TRACE_END("control_tick");
+    PROF_END(PROF_TICK);
+}
+
+// Load the line following gains from a gains file, returns -1 if it cannot be read
+int controller_load_gains(Controller* ctl, const char* path) {
+    PidGains gains = {ctl->params.kp, ctl->params.ki, ctl->params.kd};
+    if (gains_load(path, &gains) < 0) {
+        return -1;
+    }
+    LOG_INFO("Loaded PID gains from %s: kp %.3f ki %.3f kd %.4f\n", path, gains.kp, gains.ki, gains.kd);
+    ctl->params.kp = gains.kp;
+    ctl->params.ki = gains.ki;
+    ctl->params.kd = gains.kd;
+    pid_ctrl_set_gains(&ctl->line_pid, ctl->params.kp, ctl->params.ki, ctl->params.kd);
+    return 0;
+}
+
+// Replace the control parameters, e.g. with the ones a recording started with
+void controller_set_params(Controller* ctl, const ControlParams* in) {
+    ctl->params = *in;
+    pid_ctrl_set_gains(&ctl->line_pid, ctl->params.kp, ctl->params.ki, ctl->params.kd);
+}
+
+// One tick of the relay experiment, the relay replaces the PID while driving at the base speed.
+// Returns 1 when the experiment has finished and -1 when it was aborted.
+int controller_autotune_tick(Controller* ctl, Autotune* tune) {
+    sample_sensors(ctl);
+    if (check_front_obstacle(ctl)) {
+        LOG_WARN("Obstacle in front, autotune aborted\n");
+        stop_motors(ctl);
+        return -1;
+    }
+
+    double position = controller_line_position(ctl, ctl->sensor_states);
+    double control = -autotune_update(tune, 0.0, position, ctl->io->now_us(ctl->io_ctx));
+    ctl->last_error = position;
+    if (tune->done) {
+        stop_motors(ctl);
+        return tune->done;
+    }
+    run_motors(ctl, ctl->params.base_speed - control, ctl->params.base_speed + control);
+    return 0;
+}
+
+// Fill a flight recorder record with what the last tick saw and commanded
+void controller_record(const Controller* ctl, FrRecord* rec) {
+    memset(rec, 0, sizeof(*rec));
+    rec->ts_us = ctl->last_tick_us;
+    rec->state = ctl->started ? fsm_state(&ctl->robot) : FOLLOWING_LINE;
+    for (int i = 0; i < NUM_SENSORS; i++) {
+        rec->line_mask |= (ctl->sensor_states[i] ? 1 : 0) << i;
+    }
+    if (ctl->distances_valid) {
+        rec->flags |= FR_FLAG_ECHO_VALID;
+        for (int i = 0; i < FR_NUM_ECHO; i++) {
+            rec->distances[i] = ctl->distances[i];
+        }
+    }
+    rec->error = ctl->last_error;
+    rec->p_term = ctl->line_pid.p_term;
+    rec->i_term = ctl->line_pid.i_term;
+    rec->d_term = ctl->line_pid.d_term;
+    rec->control = ctl->line_pid.output;
+    rec->motor_left = ctl->motor_left;
+    rec->motor_right = ctl->motor_right;
+}
+
+// Print the worst case tick time of every state and the latest transitions
+void controller_print_stats(const Controller* ctl, FILE* out) {
+    fprintf(out, "Worst case tick time per state:\n");
+    for (int i = 0; i < NUM_STATES; i++) {
+        // Parent states never run on their own
+        if (i == AVOIDING || i == DRIVING_PAST) continue;
+        fprintf(out, "  %-20s %ld us\n", robot_states[i].name, ctl->max_tick_us[i]);
+    }
+    if (ctl->started) {
+        fsm_dump_trace(&ctl->robot, out, 32);
+    }
+}
+
+// Names of the robot states, indexed by the state numbers in the records
+int pid_state_names(const char** names, int max) {
+    int count = NUM_STATES < max ? NUM_STATES : max;
+    for (int i = 0; i < count; i++) {
+        names[i] = robot_states[i].name;
+    }
+    return count;
+}
+
+// Start a relay autotune experiment on the line error
+void pid_autotune_start(Autotune* tune) {
+    autotune_init(tune, AUTOTUNE_AMPLITUDE, AUTOTUNE_HYSTERESIS, AUTOTUNE_CYCLES);
+}
+
+// ---- The car's controller ----
+
+void pid_control() {
+    controller_tick(car());
+}
+
+int pid_load_gains(const char* path) {
+    return controller_load_gains(car(), path);
+}
+
+void pid_get_params(ControlParams* out) {
+    *out = car()->params;
+}
+
+void pid_set_params(const ControlParams* in) {
+    controller_set_params(car(), in);
+}
+
+int pid_autotune_tick(Autotune* tune) {
+    return controller_autotune_tick(car(), tune);
+}
+
+void pid_record(FrRecord* rec) {
+    controller_record(car(), rec);
+}
+
+void pid_print_stats(FILE* out) {
+    controller_print_stats(car(), out);
 }
@@ -18,8 +18,59 @@ Fernando Abel Malca Luque
 #ifndef PID_H
 #define PID_H
 
-// Function declarations
+#include <stdio.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include "autotune.h"
+#include "pid_controller.h"
+#include "../fsm/fsm.h"
+#include "../params/params.h"
+#include "../recorder/flight_recorder.h"
+#include "../robotio/robotio.h"
+
+// One line following and obstacle avoidance controller
+typedef struct {
+    const RobotIO* io;              // Robot the controller drives, and the context passed to it
+    void* io_ctx;
+    ControlParams params;
+    PidController line_pid;
+    Fsm robot;                      // Behaviour state machine
+    bool started;
+    // Sensor samples taken at the start of every tick
+    int sensor_states[NUM_SENSORS];
+    double distances[NUM_SENSORS];
+    bool distances_valid;
+    bool motors_stopped;            // Timed maneuver of the current state
+    int64_t last_line_us;
+    int64_t last_pid_us;
+    double last_error;
+    bool search_reversed;           // The line search turned back to the other side
+    // Last motor commands and tick time, kept for the flight recorder
+    int motor_left;
+    int motor_right;
+    int64_t last_tick_us;
+    long max_tick_us[FSM_MAX_STATES];  // Worst case tick time per state
+} Controller;
+
+void controller_init(Controller* ctl, const RobotIO* io, void* io_ctx);
+void controller_tick(Controller* ctl);
+int controller_load_gains(Controller* ctl, const char* path);
+void controller_set_params(Controller* ctl, const ControlParams* in);
+double controller_line_position(const Controller* ctl, const int* sensor_states);
+int controller_autotune_tick(Controller* ctl, Autotune* tune);
+void controller_record(const Controller* ctl, FrRecord* rec);
+void controller_print_stats(const Controller* ctl, FILE* out);
+
+// The car's controller, on the robot I/O selected with rio_init
 double calculate_line_position(int* sensor_states);
 void pid_control(void);
+void pid_print_stats(FILE* out);
+int pid_load_gains(const char* path);
+void pid_get_params(ControlParams* out);
+void pid_set_params(const ControlParams* in);
+void pid_record(FrRecord* rec);
+int pid_state_names(const char** names, int max);
+void pid_autotune_start(Autotune* tune);
+int pid_autotune_tick(Autotune* tune);
 
 #endif // PID_H
\ No newline at end of file
@@ -0,0 +1,127 @@
+/**
+Class         : CSC-615-01 - Embedded Linux - Fall 2024
+Team Name     : Wayno
+Github        : nhannguyensf
+Project       : Final Assignment - Robot Car
+File          : pid_check.c
+Description:
+This file checks the Q16.16 PidFixed against the floating point PidController. Both run with the default gains
+of pid_settings.h at the same fixed time step on the line positions the car feeds them: every update holds the
+position controller_line_position computes for a random set of active line sensors, or keeps the last one when
+no sensor sees the line. Short holds exercise the derivative, long ones saturate the output and run into the rate
+limit. Both get the same measurement, the position rounded to Q16.16, and the two outputs must stay within the
+tolerance on every update. Prints the time per update of both.
+Exits with 1 when any update differs by more than the tolerance.
+    pid_check [-n updates] [-t tolerance]
+*
+Team Members:
+Kiran Poudel
+Nhan Nguyen
+Yuvraj Gupta
+Fernando Abel Malca Luque
+
+*
+**/
+#include "pid.h"
+#include "pid_controller.h"
+#include "pid_settings.h"
+#include "../executive/control_exec.h"
+#include <math.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#define CHECK_DT (EXEC_DEFAULT_PERIOD_US / 1e6)
+#define DEFAULT_TOLERANCE 1e-4  // Largest output difference
+
+static int64_t now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (int64_t)ts.tv_sec * 1000000000LL + ts.tv_nsec;
+}
+
+// Line position of the update, that of a random set of active sensors held for a random number of updates
+static double measurement_at(unsigned* seed, int* hold, double* level) {
+    if (*hold <= 0) {
+        Controller ctl;
+        int states[NUM_SENSORS];
+        unsigned mask = rand_r(seed) % (1u << NUM_SENSORS);
+        memset(&ctl, 0, sizeof(ctl));
+        ctl.last_error = *level;
+        for (int i = 0; i < NUM_SENSORS; i++) {
+            states[i] = (mask >> i) & 1;
+        }
+        // Both controllers see the same value
+        *level = PIDFX_TO_DOUBLE(PIDFX_FROM_DOUBLE(controller_line_position(&ctl, states)));
+        *hold = rand_r(seed) % 4 == 0 ? 50 + rand_r(seed) % 200 : 1 + rand_r(seed) % 5;
+    }
+    (*hold)--;
+    return *level;
+}
+
+int main(int argc, char* argv[]) {
+    long updates = 1000000;
+    double tolerance = DEFAULT_TOLERANCE;
+    int opt;
+    while ((opt = getopt(argc, argv, "n:t:")) != -1) {
+        switch (opt) {
+            case 'n': updates = atol(optarg); break;
+            case 't': tolerance = atof(optarg); break;
+            default:
+                fprintf(stderr, "Usage: %s [-n updates] [-t tolerance]\n", argv[0]);
+                return 2;
+        }
+    }
+
+    PidController ref;
+    PidFixed fx;
+    unsigned seed = 1;
+    int hold = 0;
+    double level = 0;
+    double worst = 0;
+    long worst_at = 0;
+    long diverged = 0;
+    pid_ctrl_init(&ref, KP, KI, KD, DERIVATIVE_TAU, -MAX_CONTROL, MAX_CONTROL, CONTROL_RATE_LIMIT);
+    pidfx_init(&fx, KP, KI, KD, DERIVATIVE_TAU, -MAX_CONTROL, MAX_CONTROL, CONTROL_RATE_LIMIT, CHECK_DT);
+    for (long i = 0; i < updates; i++) {
+        double m = measurement_at(&seed, &hold, &level);
+        double diff = fabs(pid_ctrl_update(&ref, 0.0, m, CHECK_DT)
+                           - PIDFX_TO_DOUBLE(pidfx_update(&fx, 0, PIDFX_FROM_DOUBLE(m))));
+        diverged += diff > tolerance;
+        if (diff > worst) {
+            worst = diff;
+            worst_at = i;
+        }
+    }
+    printf("Largest difference %.2e at update %ld of %ld, %ld updates differ by more than %.1e\n", worst, worst_at,
+           updates, diverged, tolerance);
+
+    // Time both on the same measurements
+    static double levels[4096];
+    static int32_t levels_fx[4096];
+    for (int i = 0; i < 4096; i++) {
+        levels[i] = measurement_at(&seed, &hold, &level);
+        levels_fx[i] = PIDFX_FROM_DOUBLE(levels[i]);
+    }
+    volatile double sink = 0;
+    int64_t start = now_ns();
+    for (long i = 0; i < updates; i++) {
+        sink += pid_ctrl_update(&ref, 0.0, levels[i & 4095], CHECK_DT);
+    }
+    double float_ns = (double)(now_ns() - start) / updates;
+    start = now_ns();
+    for (long i = 0; i < updates; i++) {
+        sink += pidfx_update(&fx, 0, levels_fx[i & 4095]);
+    }
+    double fixed_ns = (double)(now_ns() - start) / updates;
+    printf("pid_ctrl_update %.1f ns, pidfx_update %.1f ns\n", float_ns, fixed_ns);
+
+    if (diverged > 0) {
+        printf("FAILED: the outputs differ by more than %.1e\n", tolerance);
+        return 1;
+    }
+    return 0;
+}
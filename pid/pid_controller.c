@@ -0,0 +1,185 @@
+/**
+Class         : CSC-615-01 - Embedded Linux - Fall 2024
+Team Name     : Wayno
+Github        : nhannguyensf
+Project       : Final Assignment - Robot Car
+File          : pid_controller.c
+Description:
+This file contains the reusable PID controller used for line following.
+The floating point controller takes the time step of every update, so the I and D terms do not change with
+the loop rate. The derivative is taken on the measurement (no kick when the setpoint changes) and passed
+through a first order low pass filter, which matters for the 5-level step signal of the line sensors.
+The integral only grows while the P and I terms do not saturate the output in the same direction (conditional
+integration), and the output change per second can be limited to protect the motors.
+The fixed point variant does the same work in Q16.16 for a fixed time step. It has no data dependent
+branches or divisions, so every update takes the same time.
+*
+Team Members:
+Kiran Poudel
+Nhan Nguyen
+Yuvraj Gupta
+Fernando Abel Malca Luque
+
+*
+**/
+#include "pid_controller.h"
+
+static double clamp(double value, double min, double max) {
+    if (value > max) return max;
+    if (value < min) return min;
+    return value;
+}
+
+// Initialize a controller with its gains and limits
+void pid_ctrl_init(PidController* pid, double kp, double ki, double kd, double tau_d,
+                   double out_min, double out_max, double rate_limit) {
+    pid->kp = kp;
+    pid->ki = ki;
+    pid->kd = kd;
+    pid->tau_d = tau_d;
+    pid->out_min = out_min;
+    pid->out_max = out_max;
+    pid->rate_limit = rate_limit;
+    pid_ctrl_reset(pid);
+}
+
+// Change the gains without a bump in the output, the integral is stored already scaled by ki
+void pid_ctrl_set_gains(PidController* pid, double kp, double ki, double kd) {
+    pid->kp = kp;
+    pid->ki = ki;
+    pid->kd = kd;
+}
+
+// Clear the controller state
+void pid_ctrl_reset(PidController* pid) {
+    pid->integral = 0;
+    pid->derivative = 0;
+    pid->prev_measurement = 0;
+    pid->output = 0;
+    pid->initialized = 0;
+    pid->p_term = 0;
+    pid->i_term = 0;
+    pid->d_term = 0;
+}
+
+// Run one controller update with a time step of dt seconds and return the output
+double pid_ctrl_update(PidController* pid, double setpoint, double measurement, double dt) {
+    if (dt <= 0) {
+        return pid->output;
+    }
+
+    double error = setpoint - measurement;
+    double p = pid->kp * error;
+
+    // Derivative on measurement with a first order low pass
+    if (pid->initialized) {
+        double raw = -pid->kd * (measurement - pid->prev_measurement) / dt;
+        if (pid->tau_d > 0) {
+            pid->derivative += (dt / (pid->tau_d + dt)) * (raw - pid->derivative);
+        } else {
+            pid->derivative = raw;
+        }
+    } else {
+        pid->derivative = 0;
+    }
+
+    // Conditional integration: hold the integral while the P and I terms saturate in the direction of the error.
+    // The filtered derivative decays towards zero without reaching it, left in it would decide the test whenever
+    // P and I sit exactly on a limit, and the fixed point variant could not follow its rounding.
+    double unsaturated = p + pid->integral;
+    if (!((unsaturated > pid->out_max && error > 0) || (unsaturated < pid->out_min && error < 0))) {
+        pid->integral += error * (pid->ki * dt);
+        pid->integral = clamp(pid->integral, pid->out_min, pid->out_max);
+    }
+
+    double output = clamp(p + pid->integral + pid->derivative, pid->out_min, pid->out_max);
+
+    // Output rate limit
+    if (pid->initialized && pid->rate_limit > 0) {
+        double max_step = pid->rate_limit * dt;
+        output = clamp(output, pid->output - max_step, pid->output + max_step);
+    }
+
+    pid->p_term = p;
+    pid->i_term = pid->integral;
+    pid->d_term = pid->derivative;
+    pid->prev_measurement = measurement;
+    pid->output = output;
+    pid->initialized = 1;
+    return output;
+}
+
+// ---- Fixed point variant ----
+
+static int32_t fx_mul(int32_t a, int32_t b) {
+    return (int32_t)(((int64_t)a * b) >> PIDFX_SHIFT);
+}
+
+// Branch free min and max, valid while the difference fits in 32 bits
+static int32_t fx_min(int32_t a, int32_t b) {
+    int32_t d = a - b;
+    return b + (d & (d >> 31));
+}
+
+static int32_t fx_max(int32_t a, int32_t b) {
+    int32_t d = a - b;
+    return a - (d & (d >> 31));
+}
+
+static int32_t fx_clamp(int32_t value, int32_t min, int32_t max) {
+    return fx_max(fx_min(value, max), min);
+}
+
+// Initialize a fixed point controller for updates every dt seconds
+void pidfx_init(PidFixed* pid, double kp, double ki, double kd, double tau_d,
+                double out_min, double out_max, double rate_limit, double dt) {
+    pid->kp = PIDFX_FROM_DOUBLE(kp);
+    pid->ki_dt = PIDFX_FROM_DOUBLE(ki * dt);
+    pid->kd_dt = PIDFX_FROM_DOUBLE(kd / dt);
+    pid->alpha = PIDFX_FROM_DOUBLE(tau_d > 0 ? dt / (tau_d + dt) : 1.0);
+    pid->out_min = PIDFX_FROM_DOUBLE(out_min);
+    pid->out_max = PIDFX_FROM_DOUBLE(out_max);
+    // Without a limit the step is simply the full output range
+    pid->rate_step = rate_limit > 0 ? PIDFX_FROM_DOUBLE(rate_limit * dt) : pid->out_max - pid->out_min;
+    pidfx_reset(pid);
+}
+
+void pidfx_reset(PidFixed* pid) {
+    pid->integral = 0;
+    pid->derivative = 0;
+    pid->prev_measurement = 0;
+    pid->output = 0;
+    pid->initialized = 0;
+}
+
+// Run one fixed point update, same steps as pid_ctrl_update without branches
+int32_t pidfx_update(PidFixed* pid, int32_t setpoint, int32_t measurement) {
+    int32_t init = pid->initialized;
+    int32_t error = setpoint - measurement;
+    int32_t p = fx_mul(pid->kp, error);
+
+    int32_t raw = -fx_mul(pid->kd_dt, measurement - pid->prev_measurement);
+    int32_t derivative = pid->derivative + fx_mul(pid->alpha, raw - pid->derivative);
+    derivative &= init;
+
+    // Masks are all ones when the condition holds
+    int32_t unsaturated = p + pid->integral;
+    int32_t above = (pid->out_max - unsaturated) >> 31;
+    int32_t below = (unsaturated - pid->out_min) >> 31;
+    int32_t positive = (-error) >> 31;
+    int32_t negative = error >> 31;
+    int32_t hold = (above & positive) | (below & negative);
+    int32_t integral = pid->integral + (fx_mul(pid->ki_dt, error) & ~hold);
+    integral = fx_clamp(integral, pid->out_min, pid->out_max);
+
+    int32_t output = fx_clamp(p + integral + derivative, pid->out_min, pid->out_max);
+    int32_t step = fx_clamp(output - pid->output, -pid->rate_step, pid->rate_step);
+    output = ((pid->output + step) & init) | (output & ~init);
+
+    pid->integral = integral;
+    pid->derivative = derivative;
+    pid->prev_measurement = measurement;
+    pid->output = output;
+    pid->initialized = -1;
+    return output;
+}
@@ -0,0 +1,85 @@
+/**
+Class         : CSC-615-01 - Embedded Linux - Fall 2024
+Team Name     : Wayno
+Github        : nhannguyensf
+Project       : Final Assignment - Robot Car
+File          : pid_controller.h
+Description:
+This file is the header file for the pid_controller.c file. It declares a reusable PID controller that takes
+the time step explicitly, filters the derivative, stops integrating while P and I saturate the output and limits
+how fast the output can change. A fixed point (Q16.16) variant with a constant execution time is also declared
+for a fixed loop period.
+*
+Team Members:
+Kiran Poudel
+Nhan Nguyen
+Yuvraj Gupta
+Fernando Abel Malca Luque
+
+*
+**/
+#ifndef PID_CONTROLLER_H
+#define PID_CONTROLLER_H
+
+#include <stdint.h>
+
+// Q16.16 fixed point helpers
+#define PIDFX_SHIFT 16
+#define PIDFX_ONE (1 << PIDFX_SHIFT)
+#define PIDFX_FROM_DOUBLE(x) ((int32_t)((x) * PIDFX_ONE + ((x) >= 0 ? 0.5 : -0.5)))
+#define PIDFX_TO_DOUBLE(x) ((double)(x) / PIDFX_ONE)
+
+// Floating point PID controller state and settings
+typedef struct {
+    // Settings
+    double kp;           // Proportional gain
+    double ki;           // Integral gain (per second)
+    double kd;           // Derivative gain (seconds)
+    double tau_d;        // Derivative low pass time constant in seconds, 0 disables the filter
+    double out_min;      // Output limits
+    double out_max;
+    double rate_limit;   // Largest output change per second, 0 disables the limit
+
+    // State
+    double integral;          // Integral term (already scaled by ki)
+    double derivative;        // Filtered derivative term (already scaled by kd)
+    double prev_measurement;  // Measurement of the previous update
+    double output;            // Output of the previous update
+    int initialized;          // Zero until the first update after a reset
+
+    // Terms of the latest update, kept for telemetry
+    double p_term;
+    double i_term;
+    double d_term;
+} PidController;
+
+// Fixed point PID controller for a fixed time step, all values Q16.16
+typedef struct {
+    int32_t kp;
+    int32_t ki_dt;        // ki * dt
+    int32_t kd_dt;        // kd / dt
+    int32_t alpha;        // Derivative filter coefficient dt / (tau_d + dt)
+    int32_t out_min;
+    int32_t out_max;
+    int32_t rate_step;    // Largest output change per update
+
+    int32_t integral;
+    int32_t derivative;
+    int32_t prev_measurement;
+    int32_t output;
+    int32_t initialized;  // 0 or -1 (all bits set) so it can be used as a mask
+} PidFixed;
+
+// Function declarations
+void pid_ctrl_init(PidController* pid, double kp, double ki, double kd, double tau_d,
+                   double out_min, double out_max, double rate_limit);
+void pid_ctrl_set_gains(PidController* pid, double kp, double ki, double kd);
+void pid_ctrl_reset(PidController* pid);
+double pid_ctrl_update(PidController* pid, double setpoint, double measurement, double dt);
+
+void pidfx_init(PidFixed* pid, double kp, double ki, double kd, double tau_d,
+                double out_min, double out_max, double rate_limit, double dt);
+void pidfx_reset(PidFixed* pid);
+int32_t pidfx_update(PidFixed* pid, int32_t setpoint, int32_t measurement);
+
+#endif // PID_CONTROLLER_H
@@ -0,0 +1,45 @@
+/**
+Class         : CSC-615-01 - Embedded Linux - Fall 2024
+Team Name     : Wayno
+Github        : nhannguyensf
+Project       : Final Assignment - Robot Car
+File          : pid_settings.h
+Description:
+This file contains the default settings of the line following controller in pid.c: the PID gains and limits, the
+relay autotune experiment and the weights that turn the line sensors into a line position. The host tools that
+model the controller include it too, so they always run the car's settings.
+*
+Team Members:
+Kiran Poudel
+Nhan Nguyen
+Yuvraj Gupta
+Fernando Abel Malca Luque
+
+*
+**/
+#ifndef PID_SETTINGS_H
+#define PID_SETTINGS_H
+
+// Default parameters, they can be changed at runtime through the shared parameter block.
+// PID constants in per second units. KI and KD were tuned per loop iteration,
+// these are the same gains at the 10 ms control period.
+#define KP 50.0
+#define KI 100.0
+#define KD 0.01
+#define DERIVATIVE_TAU 0.05      // Derivative low pass time constant (s)
+#define CONTROL_RATE_LIMIT 5000  // Largest control change per second
+#define MAX_DT 0.1               // Longest time step fed to the PID (s)
+
+// Relay autotune experiment
+#define AUTOTUNE_AMPLITUDE 30.0  // Relay output in control units
+#define AUTOTUNE_HYSTERESIS 0.25 // Line position band ignored by the relay
+#define AUTOTUNE_CYCLES 4        // Cycles averaged after the first one
+
+// Control limits
+#define MAX_CONTROL 100
+#define BASE_SPEED 60
+
+// Weight of each line sensor in the line position, the position is the mean weight of the active sensors
+#define LINE_POSITION_WEIGHTS {-3.0, -2.0, 0.0, 2.0, 3.0}
+
+#endif // PID_SETTINGS_H
@@ -0,0 +1,208 @@
+/**
+Class         : CSC-615-01 - Embedded Linux - Fall 2024
+Team Name     : Wayno
+Github        : nhannguyensf
+Project       : Final Assignment - Robot Car
+File          : pipeline.c
+Description:
+This file contains the control and actuation stages of the pipeline. The sensor hub pushes every snapshot to the
+snapshot queue; the control stage takes the newest one, skipping any it fell behind on, and runs the tick on it
+through the rio_pipeline backend. The tick's motor command replaces the one in the command slot, a triple buffer, so
+the newest command always reaches the motors however far the actuation thread falls behind, and a stop is never
+lost to a full queue. The actuation thread sleeps on a futex until a command is published, writes the newest one to
+the motors and records the time since its line sensors were captured.
+*
+Team Members:
+Kiran Poudel
+Nhan Nguyen
+Yuvraj Gupta
+Fernando Abel Malca Luque
+
+*
+**/
+#include "pipeline.h"
+#include "spsc.h"
+#include "../executive/control_exec.h"
+#include "../hub/sensor_hub.h"
+#include "../hub/triple_buffer.h"
+#include "../trace/trace.h"
+#include <pthread.h>
+#include <stdatomic.h>
+
+#define ACTUATE_WAIT_US 10000  // The actuation thread checks for a stop at least this often
+
+static SensorSnapshot snapshot_data[PIPELINE_QUEUE_DEPTH];
+static SpscQueue snapshots;  // Sensor hub to control stage
+static SensorSnapshot snapshot;  // Snapshot the control stage is processing
+static MotorCommand command_slots[3];
+static TripleBuffer commands;  // Control stage to actuation stage, the newest command
+static _Atomic uint32_t commands_published = 0;  // The actuation thread waits on it
+static _Atomic uint32_t actuate_sleeping = 0;
+
+static PipelineConfig pipeline_config;
+static pthread_t actuate_thread;
+static _Atomic int running = 0;
+
+static uint64_t processed = 0;
+static uint64_t skipped = 0;   // Snapshots replaced by a newer one before the control stage got to them
+static uint64_t timeouts = 0;  // Waits for a snapshot that took more than two periods
+static ExecHistogram control_time;
+static _Atomic uint64_t written = 0;
+
+// Wait up to timeout_us for a command the actuation thread has not written, false on a timeout or a signal
+static bool wait_command(long timeout_us) {
+    for (int i = 0; i < SPSC_SPIN; i++) {
+        if (triple_fresh(&commands)) return true;
+    }
+    // Sequentially consistent with the publish, either the control stage sees the flag or this sees the command
+    atomic_store(&actuate_sleeping, 1);
+    uint32_t published = atomic_load(&commands_published);
+    if (!triple_fresh(&commands)) {
+        struct timespec timeout = {timeout_us / 1000000, (timeout_us % 1000000) * 1000};
+        syscall(SYS_futex, &commands_published, FUTEX_WAIT_PRIVATE, published, &timeout, NULL, 0);
+    }
+    atomic_store(&actuate_sleeping, 0);
+    return triple_fresh(&commands);
+}
+
+static void* actuate_main(void* arg) {
+    trace_thread_name("actuate");
+    while (atomic_load(&running)) {
+        if (!wait_command(ACTUATE_WAIT_US)) continue;
+        const MotorCommand* cmd = &command_slots[triple_acquire(&commands)];
+        TRACE_BEGIN("actuate");
+        rio_hardware.motor_run(NULL, cmd->left, cmd->right);
+        sensor_hub_record_motor(cmd->sensed_us);
+        TRACE_END("actuate");
+        atomic_fetch_add_explicit(&written, 1, memory_order_relaxed);
+    }
+    return NULL;
+}
+
+void pipeline_default_config(PipelineConfig* config) {
+    config->period_us = EXEC_DEFAULT_PERIOD_US;
+    config->acquire_cpu = PIPELINE_ACQUIRE_CPU;
+    config->actuate_cpu = PIPELINE_ACTUATE_CPU;
+    config->rt_priority = 0;
+}
+
+int pipeline_start(const PipelineConfig* config) {
+    pipeline_config = *config;
+    spsc_init(&snapshots, snapshot_data, PIPELINE_QUEUE_DEPTH, sizeof(SensorSnapshot));
+    triple_init(&commands);
+    atomic_store(&commands_published, 0);
+    atomic_store(&written, 0);
+
+    atomic_store(&running, 1);
+    if (exec_thread_create(&actuate_thread, actuate_main, NULL, config->actuate_cpu, config->rt_priority) < 0) {
+        atomic_store(&running, 0);
+        return -1;
+    }
+
+    SensorHubConfig hub;
+    sensor_hub_default_config(&hub);
+    hub.period_us = config->period_us;
+    hub.cpu = config->acquire_cpu;
+    hub.rt_priority = config->rt_priority;
+    hub.queue = &snapshots;
+    if (sensor_hub_start(&hub) < 0) {
+        atomic_store(&running, 0);
+        pthread_join(actuate_thread, NULL);
+        return -1;
+    }
+    return 0;
+}
+
+void pipeline_run(void (*tick)(void), volatile sig_atomic_t* stop) {
+    long wait_us = 2 * pipeline_config.period_us;
+    struct timespec start, end;
+    while (!*stop) {
+        if (!spsc_pop_wait(&snapshots, &snapshot, wait_us)) {
+            timeouts++;
+            exec_poll_dump();
+            continue;
+        }
+        // React to the newest sensors, older snapshots would only add latency
+        while (spsc_pop(&snapshots, &snapshot)) {
+            skipped++;
+        }
+        clock_gettime(CLOCK_MONOTONIC, &start);
+        sensor_hub_use(&snapshot);
+        tick();
+        clock_gettime(CLOCK_MONOTONIC, &end);
+        exec_hist_add(&control_time, (end.tv_sec - start.tv_sec) * 1000000L + (end.tv_nsec - start.tv_nsec) / 1000);
+        processed++;
+        exec_poll_dump();
+    }
+}
+
+void pipeline_stop(void) {
+    sensor_hub_stop();
+    if (!atomic_load(&running)) return;
+    atomic_store(&running, 0);
+    pthread_join(actuate_thread, NULL);
+}
+
+void pipeline_print_stats(FILE* out) {
+    uint32_t published = atomic_load(&commands_published);
+    uint64_t done = atomic_load(&written);
+    fprintf(out, "Pipeline: %llu snapshots processed, %llu skipped, %llu waits timed out, %llu commands written, "
+            "%llu replaced by a newer one first\n", (unsigned long long)processed,
+            (unsigned long long)skipped, (unsigned long long)timeouts, (unsigned long long)done,
+            (unsigned long long)(published > done ? published - done : 0));
+    exec_hist_print(out, "Control stage time", &control_time);
+}
+
+// ---- Control stage backend ----
+
+static int64_t pipeline_now_us(void* ctx) {
+    return rio_hub.now_us(ctx);
+}
+
+static void pipeline_read_line(void* ctx, int sensor_states[NUM_SENSORS]) {
+    rio_hub.read_line(ctx, sensor_states);
+}
+
+static int pipeline_get_distances(void* ctx, double distances[NUM_SENSORS]) {
+    return rio_hub.get_distances(ctx, distances);
+}
+
+static int pipeline_read_encoders(void* ctx, int32_t counts[RIO_NUM_ENCODERS]) {
+    return rio_hub.read_encoders(ctx, counts);
+}
+
+static int pipeline_read_color(void* ctx, uint16_t rgbc[4]) {
+    return rio_hub.read_color(ctx, rgbc);
+}
+
+static void pipeline_motor_run(void* ctx, int left, int right) {
+    MotorCommand cmd = {
+        .left = left,
+        .right = right,
+        .sensed_us = snapshot.captured_us[HUB_LINE],
+        .seq = snapshot.seq,
+    };
+    command_slots[triple_back(&commands)] = cmd;
+    triple_publish(&commands);
+    atomic_fetch_add(&commands_published, 1);
+    if (atomic_load(&actuate_sleeping)) {
+        syscall(SYS_futex, &commands_published, FUTEX_WAKE_PRIVATE, 1, NULL, NULL, 0);
+    }
+}
+
+static int pipeline_refresh_params(void* ctx, ControlParams* params) {
+    return rio_hub.refresh_params(ctx, params);
+}
+
+// The snapshot comes from the queue, so there is nothing to take at the start of a tick
+const RobotIO rio_pipeline = {
+    .name = "pipeline",
+    .begin_tick = NULL,
+    .now_us = pipeline_now_us,
+    .read_line = pipeline_read_line,
+    .get_distances = pipeline_get_distances,
+    .read_encoders = pipeline_read_encoders,
+    .read_color = pipeline_read_color,
+    .motor_run = pipeline_motor_run,
+    .refresh_params = pipeline_refresh_params,
+};
@@ -0,0 +1,63 @@
+/**
+Class         : CSC-615-01 - Embedded Linux - Fall 2024
+Team Name     : Wayno
+Github        : nhannguyensf
+Project       : Final Assignment - Robot Car
+File          : pipeline.h
+Description:
+This file is the header file for the pipeline.c file. The pipeline splits the control loop into three stages on
+their own CPUs: the sensor hub thread acquires the sensors, the control stage runs the tick on every snapshot it
+receives and the actuation thread writes the motor commands. Snapshots go over a lock-free single producer, single
+consumer queue and the motor command through a slot that always holds the newest one, so a slow motor write never
+delays the next acquisition and never holds back a newer command. The sensor hub's sensor to motor latency
+histogram measures the whole pipeline, the same way it does for the single loop.
+*
+Team Members:
+Kiran Poudel
+Nhan Nguyen
+Yuvraj Gupta
+Fernando Abel Malca Luque
+
+*
+**/
+#ifndef PIPELINE_H
+#define PIPELINE_H
+
+#include <signal.h>
+#include <stdint.h>
+#include <stdio.h>
+#include "../robotio/robotio.h"
+
+#define PIPELINE_QUEUE_DEPTH 8      // Elements of the snapshot queue, a power of two
+#define PIPELINE_ACQUIRE_CPU 1      // Default CPUs of the stages, the control stage runs on the calling thread
+#define PIPELINE_CONTROL_CPU 2
+#define PIPELINE_ACTUATE_CPU 3
+
+typedef struct {
+    long period_us;     // Acquisition period
+    int acquire_cpu;    // -1 for no affinity
+    int actuate_cpu;
+    int rt_priority;    // SCHED_FIFO priority of the acquisition and actuation threads, 0 for normal threads
+} PipelineConfig;
+
+// Motor command from the control stage to the actuation stage
+typedef struct {
+    int left;
+    int right;
+    int64_t sensed_us;  // Capture time of the line sensors the command reacts to
+    uint64_t seq;       // Snapshot the command was computed from
+} MotorCommand;
+
+// Control loop backend of the control stage: sensor reads come from the snapshot being processed, motor commands
+// go to the actuation stage's newest command slot
+extern const RobotIO rio_pipeline;
+
+void pipeline_default_config(PipelineConfig* config);
+// Start the acquisition and actuation stages
+int pipeline_start(const PipelineConfig* config);
+// Run tick on every snapshot until stop is set, on the calling thread
+void pipeline_run(void (*tick)(void), volatile sig_atomic_t* stop);
+void pipeline_stop(void);
+void pipeline_print_stats(FILE* out);
+
+#endif
@@ -0,0 +1,99 @@
+/**
+Class         : CSC-615-01 - Embedded Linux - Fall 2024
+Team Name     : Wayno
+Github        : nhannguyensf
+Project       : Final Assignment - Robot Car
+File          : spsc.h
+Description:
+This file contains a lock-free single producer, single consumer queue of fixed size elements, used to hand data
+between the threads of the pipeline. The producer only writes the tail and the consumer only writes the head, each
+on its own cache line. A consumer with nothing to do spins for SPSC_SPIN attempts and then sleeps on a futex on
+the tail; the producer only makes the wake up system call when a consumer has said it is going to sleep.
+*
+Team Members:
+Kiran Poudel
+Nhan Nguyen
+Yuvraj Gupta
+Fernando Abel Malca Luque
+
+*
+**/
+#ifndef SPSC_H
+#define SPSC_H
+
+#include <linux/futex.h>
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+#include <sys/syscall.h>
+#include <time.h>
+#include <unistd.h>
+
+#define SPSC_CACHE_LINE 64
+#define SPSC_SPIN 200  // Pop attempts before the consumer sleeps
+
+typedef struct {
+    _Atomic uint32_t head;  // Next element to pop, written by the consumer
+    char pad_head[SPSC_CACHE_LINE - sizeof(uint32_t)];
+    _Atomic uint32_t tail;  // Next element to push, written by the producer
+    _Atomic uint32_t sleeping;  // The consumer waits on the tail
+    char pad_tail[SPSC_CACHE_LINE - 2 * sizeof(uint32_t)];
+    uint32_t mask;
+    uint32_t elem_size;
+    unsigned char* data;
+    uint64_t full;  // Pushes refused because the queue was full, producer only
+} SpscQueue;
+
+// Capacity must be a power of two, data must hold capacity elements of elem_size bytes
+static inline void spsc_init(SpscQueue* q, void* data, uint32_t capacity, uint32_t elem_size) {
+    atomic_init(&q->head, 0);
+    atomic_init(&q->tail, 0);
+    atomic_init(&q->sleeping, 0);
+    q->mask = capacity - 1;
+    q->elem_size = elem_size;
+    q->data = data;
+    q->full = 0;
+}
+
+static inline bool spsc_push(SpscQueue* q, const void* elem) {
+    uint32_t tail = atomic_load_explicit(&q->tail, memory_order_relaxed);
+    if (tail - atomic_load_explicit(&q->head, memory_order_acquire) > q->mask) {
+        q->full++;
+        return false;
+    }
+    memcpy(q->data + (size_t)(tail & q->mask) * q->elem_size, elem, q->elem_size);
+    // Sequentially consistent with the consumer's sleeping flag, one of the two sees the other
+    atomic_store(&q->tail, tail + 1);
+    if (atomic_load(&q->sleeping)) {
+        syscall(SYS_futex, &q->tail, FUTEX_WAKE_PRIVATE, 1, NULL, NULL, 0);
+    }
+    return true;
+}
+
+static inline bool spsc_pop(SpscQueue* q, void* elem) {
+    uint32_t head = atomic_load_explicit(&q->head, memory_order_relaxed);
+    if (head == atomic_load_explicit(&q->tail, memory_order_acquire)) {
+        return false;
+    }
+    memcpy(elem, q->data + (size_t)(head & q->mask) * q->elem_size, q->elem_size);
+    atomic_store_explicit(&q->head, head + 1, memory_order_release);
+    return true;
+}
+
+// Pop an element, waiting up to timeout_us for one, returns false on timeout or a signal
+static inline bool spsc_pop_wait(SpscQueue* q, void* elem, long timeout_us) {
+    for (int i = 0; i < SPSC_SPIN; i++) {
+        if (spsc_pop(q, elem)) return true;
+    }
+    atomic_store(&q->sleeping, 1);
+    uint32_t tail = atomic_load(&q->tail);
+    if (tail == atomic_load_explicit(&q->head, memory_order_relaxed)) {
+        struct timespec timeout = {timeout_us / 1000000, (timeout_us % 1000000) * 1000};
+        syscall(SYS_futex, &q->tail, FUTEX_WAIT_PRIVATE, tail, &timeout, NULL, 0);
+    }
+    atomic_store(&q->sleeping, 0);
+    return spsc_pop(q, elem);
+}
+
+#endif
@@ -0,0 +1,186 @@
+/**
+Class         : CSC-615-01 - Embedded Linux - Fall 2024
+Team Name     : Wayno
+Github        : nhannguyensf
+Project       : Final Assignment - Robot Car
+File          : prof.c
+Description:
+This file contains the stage latency profiler. Every stage has a log linear histogram in the style of
+HdrHistogram plus its count, sum, minimum and maximum. A stage is only ever recorded by one thread, so recording
+is a bucket computation and a few relaxed atomic loads and stores without any locked instruction; the dump may
+run at any time and sees every counter whole. The SIGUSR1 handler only posts a semaphore, the dump itself is
+done by a normal priority thread so the control loop never formats text.
+*
+Team Members:
+Kiran Poudel
+Nhan Nguyen
+Yuvraj Gupta
+Fernando Abel Malca Luque
+
+*
+**/
+#include "prof.h"
+
+#ifdef ENABLE_PROFILING
+
+#include <pthread.h>
+#include <semaphore.h>
+#include <stdatomic.h>
+
+typedef struct {
+    _Atomic uint32_t buckets[PROF_NUM_BUCKETS];
+    _Atomic uint64_t count;
+    _Atomic uint64_t sum_ns;
+    _Atomic uint64_t min_ns;
+    _Atomic uint64_t max_ns;
+} ProfHistogram;
+
+static ProfHistogram histograms[PROF_NUM_STAGES];
+
+static const char* const stage_names[PROF_NUM_STAGES] = {
+    "tick", "line_sensors", "echo_read", "echo_ping", "pid", "motors", "recorder",
+};
+
+static sem_t dump_sem;
+static pthread_t dump_thread;
+static int started = 0;
+
+// Single writer increment, cheaper than an atomic read modify write
+#define BUMP(var, n) atomic_store_explicit(&(var), atomic_load_explicit(&(var), memory_order_relaxed) + (n), \
+                                           memory_order_relaxed)
+
+static unsigned bucket_index(uint64_t ns) {
+    if (ns < PROF_SUB_BUCKETS) return (unsigned)ns;
+    unsigned msb = 63 - __builtin_clzll(ns);
+    unsigned shift = msb - PROF_SUB_BITS;
+    unsigned index = (shift + 1) * PROF_SUB_BUCKETS + (unsigned)((ns >> shift) - PROF_SUB_BUCKETS);
+    return index < PROF_NUM_BUCKETS ? index : PROF_NUM_BUCKETS - 1;
+}
+
+// Highest value that falls in a bucket
+static uint64_t bucket_upper(unsigned index) {
+    if (index < PROF_SUB_BUCKETS) return index;
+    unsigned shift = index / PROF_SUB_BUCKETS - 1;
+    uint64_t sub = index % PROF_SUB_BUCKETS + PROF_SUB_BUCKETS;
+    return ((sub + 1) << shift) - 1;
+}
+
+void prof_record(ProfStage stage, uint64_t ns) {
+    ProfHistogram* h = &histograms[stage];
+    BUMP(h->buckets[bucket_index(ns)], 1);
+    uint64_t count = atomic_load_explicit(&h->count, memory_order_relaxed);
+    if (count == 0 || ns < atomic_load_explicit(&h->min_ns, memory_order_relaxed)) {
+        atomic_store_explicit(&h->min_ns, ns, memory_order_relaxed);
+    }
+    if (ns > atomic_load_explicit(&h->max_ns, memory_order_relaxed)) {
+        atomic_store_explicit(&h->max_ns, ns, memory_order_relaxed);
+    }
+    BUMP(h->sum_ns, ns);
+    atomic_store_explicit(&h->count, count + 1, memory_order_release);
+}
+
+// Percentiles of one stage, taken from a copy of its buckets
+typedef struct {
+    uint64_t count, min, max, p50, p90, p99, p999;
+    double mean;
+} ProfSummary;
+
+// The SIGUSR1 dump thread and the exit report can summarize at the same time, so the copy is on the stack (4 KB)
+static void summarize(ProfHistogram* h, ProfSummary* s) {
+    uint32_t buckets[PROF_NUM_BUCKETS];
+    uint64_t total = 0;
+    for (unsigned i = 0; i < PROF_NUM_BUCKETS; i++) {
+        buckets[i] = atomic_load_explicit(&h->buckets[i], memory_order_relaxed);
+        total += buckets[i];
+    }
+    s->count = atomic_load_explicit(&h->count, memory_order_acquire);
+    s->min = atomic_load_explicit(&h->min_ns, memory_order_relaxed);
+    s->max = atomic_load_explicit(&h->max_ns, memory_order_relaxed);
+    s->mean = s->count ? (double)atomic_load_explicit(&h->sum_ns, memory_order_relaxed) / s->count : 0.0;
+
+    const double quantiles[] = {0.50, 0.90, 0.99, 0.999};
+    uint64_t* results[] = {&s->p50, &s->p90, &s->p99, &s->p999};
+    unsigned bucket = 0;
+    uint64_t seen = 0;
+    for (int q = 0; q < 4; q++) {
+        uint64_t rank = (uint64_t)(quantiles[q] * total + 0.5);
+        if (rank == 0) rank = 1;
+        while (bucket < PROF_NUM_BUCKETS && seen + buckets[bucket] < rank) {
+            seen += buckets[bucket++];
+        }
+        uint64_t value = bucket < PROF_NUM_BUCKETS ? bucket_upper(bucket) : s->max;
+        *results[q] = total == 0 ? 0 : (value < s->max ? value : s->max);
+    }
+}
+
+void prof_dump(FILE* out) {
+    fprintf(out, "Stage latency in us:\n");
+    fprintf(out, "  %-14s %10s %9s %9s %9s %9s %9s %9s %9s\n",
+            "stage", "count", "min", "mean", "p50", "p90", "p99", "p99.9", "max");
+    for (int i = 0; i < PROF_NUM_STAGES; i++) {
+        ProfSummary s;
+        summarize(&histograms[i], &s);
+        if (s.count == 0) continue;
+        fprintf(out, "  %-14s %10llu %9.1f %9.1f %9.1f %9.1f %9.1f %9.1f %9.1f\n", stage_names[i],
+                (unsigned long long)s.count, s.min / 1e3, s.mean / 1e3, s.p50 / 1e3, s.p90 / 1e3,
+                s.p99 / 1e3, s.p999 / 1e3, s.max / 1e3);
+    }
+}
+
+void prof_dump_json(FILE* out) {
+    fprintf(out, "{\n  \"unit\": \"ns\",\n  \"stages\": [");
+    int first = 1;
+    for (int i = 0; i < PROF_NUM_STAGES; i++) {
+        ProfSummary s;
+        summarize(&histograms[i], &s);
+        if (s.count == 0) continue;
+        fprintf(out, "%s\n    {\"name\": \"%s\", \"count\": %llu, \"min\": %llu, \"mean\": %.1f, \"p50\": %llu, "
+                     "\"p90\": %llu, \"p99\": %llu, \"p99_9\": %llu, \"max\": %llu}",
+                first ? "" : ",", stage_names[i], (unsigned long long)s.count, (unsigned long long)s.min, s.mean,
+                (unsigned long long)s.p50, (unsigned long long)s.p90, (unsigned long long)s.p99,
+                (unsigned long long)s.p999, (unsigned long long)s.max);
+        first = 0;
+    }
+    fprintf(out, "\n  ]\n}\n");
+}
+
+static void* dump_main(void* arg) {
+    (void)arg;
+    for (;;) {
+        if (sem_wait(&dump_sem) != 0) continue;
+        prof_dump(stdout);
+        fflush(stdout);
+        FILE* json = fopen(PROF_JSON_FILE, "w");
+        if (json) {
+            prof_dump_json(json);
+            fclose(json);
+            printf("Stage latency written to %s\n", PROF_JSON_FILE);
+        }
+    }
+    return NULL;
+}
+
+int prof_init(void) {
+    if (started) return 0;
+    if (sem_init(&dump_sem, 0, 0) != 0) return -1;
+
+    // The dump thread stays at normal priority even when started from a real time thread
+    pthread_attr_t attr;
+    struct sched_param param = {0};
+    pthread_attr_init(&attr);
+    pthread_attr_setinheritsched(&attr, PTHREAD_EXPLICIT_SCHED);
+    pthread_attr_setschedpolicy(&attr, SCHED_OTHER);
+    pthread_attr_setschedparam(&attr, &param);
+    pthread_attr_setdetachstate(&attr, PTHREAD_CREATE_DETACHED);
+    int ret = pthread_create(&dump_thread, &attr, dump_main, NULL);
+    pthread_attr_destroy(&attr);
+    if (ret != 0) return -1;
+    started = 1;
+    return 0;
+}
+
+void prof_request_dump(void) {
+    if (started) sem_post(&dump_sem);
+}
+
+#endif
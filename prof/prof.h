@@ -0,0 +1,84 @@
+/**
+Class         : CSC-615-01 - Embedded Linux - Fall 2024
+Team Name     : Wayno
+Github        : nhannguyensf
+Project       : Final Assignment - Robot Car
+File          : prof.h
+Description:
+This file is the header file for the prof.c file. It declares the stage latency profiler: PROF_BEGIN and
+PROF_END around a stage of the hot path record its duration in a log linear histogram, and a dump with the
+percentiles of every stage is printed as text and written as JSON when the process gets SIGUSR1.
+The profiler only exists when the code is built with ENABLE_PROFILING (make PROFILE=1); otherwise all of the
+macros and functions below compile to nothing.
+*
+Team Members:
+Kiran Poudel
+Nhan Nguyen
+Yuvraj Gupta
+Fernando Abel Malca Luque
+
+*
+**/
+#ifndef PROF_H
+#define PROF_H
+
+#include <stdio.h>
+#include <stdint.h>
+
+// Stages of the hot path
+typedef enum {
+    PROF_TICK,          // Whole pid_control call
+    PROF_LINE_SENSORS,  // read_line_sensors
+    PROF_ECHO_READ,     // getCurrentDistances
+    PROF_ECHO_PING,     // One ultrasonic measurement in the echo thread
+    PROF_PID,           // Line position and PID math
+    PROF_MOTORS,        // Motor_Run I2C writes for both motors
+    PROF_RECORDER,      // Flight recorder record including the encoder reads
+    PROF_NUM_STAGES
+} ProfStage;
+
+// Where the JSON dump goes
+#define PROF_JSON_FILE "car_prof.json"
+
+#ifdef ENABLE_PROFILING
+
+#include <time.h>
+
+// Histogram layout: values below 2^PROF_SUB_BITS ns get a bucket each, above that every power of two is
+// split in 2^PROF_SUB_BITS buckets, so a bucket is at most 1/32 (about 3 %) wide. 1024 buckets reach 68 s.
+#define PROF_SUB_BITS 5
+#define PROF_SUB_BUCKETS (1u << PROF_SUB_BITS)
+#define PROF_NUM_BUCKETS 1024
+
+// CLOCK_MONOTONIC_RAW is not slewed by NTP and is read through the vDSO
+static inline uint64_t prof_now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC_RAW, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ull + ts.tv_nsec;
+}
+
+// Start the thread that prints the dumps
+int prof_init(void);
+// Ask for a dump, safe to call from a signal handler
+void prof_request_dump(void);
+// Add one duration to a stage, each stage must be recorded by a single thread
+void prof_record(ProfStage stage, uint64_t ns);
+// Print the percentiles of every stage
+void prof_dump(FILE* out);
+void prof_dump_json(FILE* out);
+
+#define PROF_BEGIN(stage) uint64_t prof_start_##stage = prof_now_ns()
+#define PROF_END(stage) prof_record(stage, prof_now_ns() - prof_start_##stage)
+
+#else
+
+#define prof_init() 0
+#define prof_request_dump() ((void)0)
+#define prof_dump(out) ((void)(out))
+#define prof_dump_json(out) ((void)(out))
+#define PROF_BEGIN(stage)
+#define PROF_END(stage)
+
+#endif
+
+#endif
@@ -0,0 +1,121 @@
+/**
+Class         : CSC-615-01 - Embedded Linux - Fall 2024
+Team Name     : Wayno
+Github        : nhannguyensf
+Project       : Final Assignment - Robot Car
+File          : flight_recorder.c
+Description:
+This file contains the flight recorder. The recorder file is allocated on disk up front and mapped shared, so
+appending a record is a plain memory copy into the page cache with no system call. Because the pages belong
+to the kernel, everything written before a crash or a SIGKILL is still in the file afterwards. A slot is first
+marked empty, then filled, and its sequence number is stored last, so a record torn by a crash is skipped by
+fr_export instead of being read as garbage.
+*
+Team Members:
+Kiran Poudel
+Nhan Nguyen
+Yuvraj Gupta
+Fernando Abel Malca Luque
+
+*
+**/
+#include "flight_recorder.h"
+#include <fcntl.h>
+#include <stdatomic.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <time.h>
+#include <unistd.h>
+
+static FrHeader* header = NULL;
+static FrRecord* records = NULL;
+static size_t map_size = 0;
+static uint32_t next_seq = 1;
+static uint32_t next_slot = 0;
+
+static int64_t clock_us(clockid_t clock) {
+    struct timespec ts;
+    clock_gettime(clock, &ts);
+    return (int64_t)ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+}
+
+int fr_open(const char* path, uint32_t capacity) {
+    if (header || capacity == 0) return -1;
+
+    // Keep the previous run, it may be the one that needs looking at
+    char old_path[256];
+    snprintf(old_path, sizeof(old_path), "%s.1", path);
+    rename(path, old_path);
+
+    int fd = open(path, O_RDWR | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0) {
+        perror("flight recorder: open");
+        return -1;
+    }
+
+    // Allocate the blocks now so a full disk cannot fault the control loop later
+    map_size = sizeof(FrHeader) + (size_t)capacity * sizeof(FrRecord);
+    int ret = posix_fallocate(fd, 0, map_size);
+    if (ret != 0) {
+        fprintf(stderr, "flight recorder: cannot allocate %zu bytes: %s\n", map_size, strerror(ret));
+        close(fd);
+        return -1;
+    }
+
+    void* addr = mmap(NULL, map_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, 0);
+    close(fd);
+    if (addr == MAP_FAILED) {
+        perror("flight recorder: mmap");
+        return -1;
+    }
+
+    header = addr;
+    records = (FrRecord*)((char*)addr + sizeof(FrHeader));
+    header->magic = FR_MAGIC;
+    header->version = FR_VERSION;
+    header->header_size = sizeof(FrHeader);
+    header->record_size = sizeof(FrRecord);
+    header->capacity = capacity;
+    header->num_states = 0;
+    header->start_mono_us = clock_us(CLOCK_MONOTONIC);
+    header->start_wall_us = clock_us(CLOCK_REALTIME);
+    next_seq = 1;
+    next_slot = 0;
+    return 0;
+}
+
+void fr_set_state_names(const char* const* names, int count) {
+    if (!header) return;
+    if (count > FR_MAX_STATES) count = FR_MAX_STATES;
+    for (int i = 0; i < count; i++) {
+        strncpy(header->state_names[i], names[i], FR_STATE_NAME_LEN - 1);
+        header->state_names[i][FR_STATE_NAME_LEN - 1] = '\0';
+    }
+    header->num_states = count;
+}
+
+void fr_append(const FrRecord* rec) {
+    if (!header) return;
+
+    FrRecord* slot = &records[next_slot];
+    _Atomic uint32_t* seq = (_Atomic uint32_t*)&slot->seq;
+
+    // Invalidate the slot before any field of the old record is overwritten
+    atomic_store_explicit(seq, 0, memory_order_relaxed);
+    atomic_thread_fence(memory_order_release);
+    memcpy((char*)slot + sizeof(slot->seq), (const char*)rec + sizeof(rec->seq), sizeof(FrRecord) - sizeof(rec->seq));
+    atomic_store_explicit(seq, next_seq, memory_order_release);
+
+    // Sequence 0 marks an empty slot, skip it when the counter wraps
+    if (++next_seq == 0) next_seq = 1;
+    if (++next_slot == header->capacity) next_slot = 0;
+}
+
+void fr_close(void) {
+    if (!header) return;
+    msync(header, map_size, MS_SYNC);
+    munmap(header, map_size);
+    header = NULL;
+    records = NULL;
+}
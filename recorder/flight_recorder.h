@@ -0,0 +1,82 @@
+/**
+Class         : CSC-615-01 - Embedded Linux - Fall 2024
+Team Name     : Wayno
+Github        : nhannguyensf
+Project       : Final Assignment - Robot Car
+File          : flight_recorder.h
+Description:
+This file is the header file for the flight_recorder.c file. It declares the flight recorder that keeps one
+compact record per control iteration in a preallocated, memory mapped circular file. The file layout is shared
+with the fr_export tool.
+*
+Team Members:
+Kiran Poudel
+Nhan Nguyen
+Yuvraj Gupta
+Fernando Abel Malca Luque
+
+*
+**/
+#ifndef FLIGHT_RECORDER_H
+#define FLIGHT_RECORDER_H
+
+#include <stdint.h>
+
+// Default recorder file and size, 65536 records are about 11 minutes at 100 Hz
+#define FR_FILE "car.flight"
+#define FR_DEFAULT_RECORDS 65536
+
+#define FR_MAGIC 0x54484c46u  // "FLHT"
+#define FR_VERSION 1
+#define FR_NUM_ECHO 3
+#define FR_MAX_STATES 32
+#define FR_STATE_NAME_LEN 24
+
+// Record flags
+#define FR_FLAG_ECHO_VALID 0x01
+#define FR_FLAG_ENCODER_VALID 0x02
+
+// One control iteration, 64 bytes. seq is written last, a slot with seq 0 is empty or was being written.
+typedef struct {
+    uint32_t seq;
+    uint8_t state;
+    uint8_t line_mask;
+    uint8_t flags;
+    uint8_t reserved;
+    int64_t ts_us;
+    float distances[FR_NUM_ECHO];  // Left, front, right in cm
+    int32_t encoders[2];           // Motor A, motor B counts
+    float error;                   // Line position
+    float p_term;
+    float i_term;
+    float d_term;
+    float control;
+    int16_t motor_left;            // Commanded duty cycle in percent
+    int16_t motor_right;
+} FrRecord;
+
+_Static_assert(sizeof(FrRecord) == 64, "FrRecord layout changed");
+
+// File header, the records follow at offset header_size
+typedef struct {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t header_size;
+    uint32_t record_size;
+    uint32_t capacity;
+    uint32_t num_states;
+    int64_t start_wall_us;  // Wall clock time of the first record's monotonic timestamp
+    int64_t start_mono_us;
+    char state_names[FR_MAX_STATES][FR_STATE_NAME_LEN];
+} FrHeader;
+
+// Create the recorder file with room for capacity records. An existing file is kept as path.1.
+int fr_open(const char* path, uint32_t capacity);
+// Store the names of the state numbers used in the records
+void fr_set_state_names(const char* const* names, int count);
+// Append one record, the seq field is filled in here
+void fr_append(const FrRecord* rec);
+// Flush the records to disk and unmap the file
+void fr_close(void);
+
+#endif
@@ -0,0 +1,139 @@
+/**
+Class         : CSC-615-01 - Embedded Linux - Fall 2024
+Team Name     : Wayno
+Github        : nhannguyensf
+Project       : Final Assignment - Robot Car
+File          : fr_export.c
+Description:
+This file is the host side tool that exports a time window of a flight recorder file as CSV. Records torn by a
+crash are skipped, the rest are put back in order by their sequence number. Times are in seconds since the
+recorder was opened; -l selects the last seconds before the final record, which is usually what is wanted
+after a crash.
+    fr_export [-f from_s] [-t to_s] [-l last_s] [-o out.csv] [file]
+*
+Team Members:
+Kiran Poudel
+Nhan Nguyen
+Yuvraj Gupta
+Fernando Abel Malca Luque
+
+*
+**/
+#include "flight_recorder.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+static int by_seq(const void* a, const void* b) {
+    uint32_t sa = ((const FrRecord*)a)->seq;
+    uint32_t sb = ((const FrRecord*)b)->seq;
+    return (sa > sb) - (sa < sb);
+}
+
+static void usage(const char* name) {
+    fprintf(stderr, "Usage: %s [-f from_s] [-t to_s] [-l last_s] [-o out.csv] [file]\n", name);
+}
+
+int main(int argc, char* argv[]) {
+    double from = -1e300, to = 1e300, last = -1;
+    const char* out_path = NULL;
+    int opt;
+    while ((opt = getopt(argc, argv, "f:t:l:o:")) != -1) {
+        switch (opt) {
+            case 'f': from = atof(optarg); break;
+            case 't': to = atof(optarg); break;
+            case 'l': last = atof(optarg); break;
+            case 'o': out_path = optarg; break;
+            default:
+                usage(argv[0]);
+                return 1;
+        }
+    }
+    const char* path = optind < argc ? argv[optind] : FR_FILE;
+
+    FILE* in = fopen(path, "rb");
+    if (!in) {
+        perror(path);
+        return 1;
+    }
+
+    FrHeader header;
+    if (fread(&header, sizeof(header), 1, in) != 1 || header.magic != FR_MAGIC || header.version != FR_VERSION ||
+        header.header_size != sizeof(FrHeader) || header.record_size != sizeof(FrRecord)) {
+        fprintf(stderr, "%s is not a flight recorder file of this version\n", path);
+        fclose(in);
+        return 1;
+    }
+
+    FrRecord* records = malloc((size_t)header.capacity * sizeof(FrRecord));
+    if (!records) {
+        fclose(in);
+        return 1;
+    }
+    size_t read = fread(records, sizeof(FrRecord), header.capacity, in);
+    fclose(in);
+
+    // Keep the complete records only
+    size_t count = 0;
+    for (size_t i = 0; i < read; i++) {
+        if (records[i].seq != 0) {
+            records[count++] = records[i];
+        }
+    }
+    qsort(records, count, sizeof(FrRecord), by_seq);
+    if (count == 0) {
+        fprintf(stderr, "%s holds no records\n", path);
+        free(records);
+        return 1;
+    }
+
+    if (last >= 0) {
+        double end = (records[count - 1].ts_us - header.start_mono_us) / 1e6;
+        from = end - last;
+        to = end;
+    }
+
+    FILE* out = out_path ? fopen(out_path, "w") : stdout;
+    if (!out) {
+        perror(out_path);
+        free(records);
+        return 1;
+    }
+
+    fprintf(out, "seq,time_s,state,line_mask,dist_left,dist_front,dist_right,enc_a,enc_b,"
+                 "error,p_term,i_term,d_term,control,motor_left,motor_right\n");
+    size_t exported = 0;
+    for (size_t i = 0; i < count; i++) {
+        const FrRecord* r = &records[i];
+        double t = (r->ts_us - header.start_mono_us) / 1e6;
+        if (t < from || t > to) continue;
+
+        char state[FR_STATE_NAME_LEN + 8];
+        if (r->state < header.num_states) {
+            snprintf(state, sizeof(state), "%s", header.state_names[r->state]);
+        } else {
+            snprintf(state, sizeof(state), "%u", r->state);
+        }
+
+        fprintf(out, "%u,%.6f,%s,0x%02x,", r->seq, t, state, r->line_mask);
+        if (r->flags & FR_FLAG_ECHO_VALID) {
+            fprintf(out, "%.1f,%.1f,%.1f,", r->distances[0], r->distances[1], r->distances[2]);
+        } else {
+            fprintf(out, ",,,");
+        }
+        if (r->flags & FR_FLAG_ENCODER_VALID) {
+            fprintf(out, "%d,%d,", r->encoders[0], r->encoders[1]);
+        } else {
+            fprintf(out, ",,");
+        }
+        fprintf(out, "%.4f,%.3f,%.3f,%.3f,%.3f,%d,%d\n", r->error, r->p_term, r->i_term, r->d_term,
+                r->control, r->motor_left, r->motor_right);
+        exported++;
+    }
+
+    if (out != stdout) fclose(out);
+    fprintf(stderr, "Exported %zu of %zu records\n", exported, count);
+    free(records);
+    return 0;
+}
@@ -0,0 +1,374 @@
+/**
+Class         : CSC-615-01 - Embedded Linux - Fall 2024
+Team Name     : Wayno
+Github        : nhannguyensf
+Project       : Final Assignment - Robot Car
+File          : color.c
+Description:
+This file contains the color math of the TCS34725 readings. The floating point path normalizes by the clear
+channel, applies the gamma curve with powf, converts to HSV and matches the hue. The table path gives the same
+answers with integers: the red hue ranges are tested by the hue sector with cross multiplication, and for channels
+already normalized the gamma curve is a 256 entry table and a grid of 32 x 32 x 32 cells holds the color of every
+cell whose 512 values all have the same color, so most are classified with one lookup. Cells on a boundary fall
+back to the integer test. A raw reading is not normalized first, the fraction the float path keeps decides the
+gamma step near every boundary: instead each gamma step has the quotient channel / clear at which the float path
+reaches it, found once by searching the floats, and a channel is compared with it by cross multiplication, so the
+gamma corrected channels are exactly those of the float path. The tables are built once, on first use.
+*
+Team Members:
+Kiran Poudel
+Nhan Nguyen
+Yuvraj Gupta
+Fernando Abel Malca Luque
+
+*
+**/
+#include "color.h"
+#include <math.h>
+#include <pthread.h>
+#include <string.h>
+
+#define COLOR_LUT_CELLS (1 << (3 * COLOR_LUT_BITS))
+#define COLOR_CONFIDENCE_SCALE (100.0 / 255.0)
+
+#define GAMMA_STEP_SHIFT 40    // The quotient thresholds are in units of 2^-GAMMA_STEP_SHIFT
+#define GAMMA_BUCKET_BITS 12   // The quotient range is split in 2^GAMMA_BUCKET_BITS buckets, each narrower than a step
+#define GAMMA_BUCKETS (1 << GAMMA_BUCKET_BITS)
+
+// Smallest quotient channel / clear at which the float path reaches a gamma step
+typedef struct {
+    uint64_t threshold;  // In units of 2^-GAMMA_STEP_SHIFT
+    uint8_t inclusive;   // 1 when a quotient exactly on the threshold reaches the step
+} GammaStep;
+
+static uint8_t gamma_table[256];
+static GammaStep gamma_steps[256];  // Entry k for gamma k, entry 0 is reached by every quotient
+
+// Gamma of the quotients in one bucket, past the one step inside the bucket it is next
+typedef struct {
+    uint8_t level;
+    uint8_t next;
+} GammaBucket;
+
+static GammaBucket gamma_buckets[GAMMA_BUCKETS];
+static uint8_t class_grid[COLOR_LUT_CELLS];  // color_t of the cell, COLOR_LUT_MIXED on a boundary
+static int mixed_cells;
+static pthread_once_t tables_once = PTHREAD_ONCE_INIT;
+
+static const char* const color_names[COLOR_NUM] = {
+    [COLOR_RED] = "red",
+    [COLOR_UNKNOWN] = "unknown",
+    [COLOR_GREEN] = "green",
+    [COLOR_BLUE] = "blue",
+    [COLOR_BLACK] = "black",
+    [COLOR_WHITE] = "white",
+};
+
+const char* color_name(color_t color)
+{
+    return color >= 0 && color < COLOR_NUM ? color_names[color] : "unknown";
+}
+
+color_t color_from_name(const char* name)
+{
+    for (int i = 0; i < COLOR_NUM; i++) {
+        if (strcmp(name, color_names[i]) == 0) return (color_t)i;
+    }
+    return COLOR_UNKNOWN;
+}
+
+// Convert RGB to HSV color space
+hsv_t rgb_to_hsv(uint8_t r, uint8_t g, uint8_t b)
+{
+    float rf = r / 255.0f;
+    float gf = g / 255.0f;
+    float bf = b / 255.0f;
+
+    float max = fmaxf(rf, fmaxf(gf, bf));
+    float min = fminf(rf, fminf(gf, bf));
+    float delta = max - min;
+
+    hsv_t hsv;
+    hsv.brightness = max;
+
+    if (delta == 0.0f){
+        hsv.hue = 0.0f;
+        hsv.saturation = 0.0f;
+        return hsv;
+    }
+
+    hsv.saturation = delta / max;
+
+    if (max == rf){
+        hsv.hue = 60.0f * fmodf(((gf - bf) / delta), 6.0f);
+    }
+    else if (max == gf){
+        hsv.hue = 60.0f * (((bf - rf) / delta) + 2.0f);
+    }
+    else {
+        hsv.hue = 60.0f * (((rf - gf) / delta) + 4.0f);
+    }
+
+    if (hsv.hue < 0.0f){
+        hsv.hue += 360.0f;
+    }
+
+    return hsv;
+}
+
+// Match HSV values to predefined color ranges
+color_match_t get_hsb_color(float hue, float saturation, float brightness) 
+{
+    color_match_t match;
+
+    // Detect Red based on hue range
+    // Typically, Red has a hue around 0° or 360°
+    if ((hue >= 0.0f && hue < 25.0f) || (hue >= 330.0f && hue <= 360.0f)) 
+    {
+        match.color = COLOR_RED;
+        // Confidence based on saturation and brightness
+        match.confidence = (saturation * brightness) * 100.0f;
+    }
+    else 
+    {
+        match.color = COLOR_UNKNOWN;
+        match.confidence = 0.0f;
+    }
+
+    // Ensure confidence doesn't exceed 100%
+    if (match.confidence > 100.0f)
+        match.confidence = 100.0f;
+
+    return match;
+}
+
+// Apply gamma correction to a value
+uint8_t apply_gamma(float value, float gamma)
+{
+    float corrected = powf(value / 255.0f, gamma) * 255.0f;
+    corrected = corrected > 255.0f ? 255.0f : (corrected < 0.0f ? 0.0f : corrected);
+    return (uint8_t)corrected;
+}
+
+// Classify a raw reading in floating point: the channels are normalized by the clear channel, gamma corrected
+// and matched in HSV. This is the reference the tables are checked against.
+color_match_t classify_color_float(uint16_t r, uint16_t g, uint16_t b, uint16_t clear)
+{
+    // Avoid division by zero
+    if (clear == 0)
+    {
+        color_match_t none = {COLOR_UNKNOWN, 0.0};
+        return none;
+    }
+
+    // Normalize RGB values based on clear channel
+    float redNorm = ((float)r / (float)clear) * 255.0f;
+    float greenNorm = ((float)g / (float)clear) * 255.0f;
+    float blueNorm = ((float)b / (float)clear) * 255.0f;
+
+    // Clamp values to [0, 255]
+    redNorm = (redNorm > 255.0f) ? 255.0f : redNorm;
+    greenNorm = (greenNorm > 255.0f) ? 255.0f : greenNorm;
+    blueNorm = (blueNorm > 255.0f) ? 255.0f : blueNorm;
+
+    // Apply gamma correction
+    float gamma = COLOR_GAMMA;
+    uint8_t red = apply_gamma(redNorm, gamma);
+    uint8_t green = apply_gamma(greenNorm, gamma);
+    uint8_t blue = apply_gamma(blueNorm, gamma);
+
+    // Convert RGB to HSV
+    hsv_t hsv = rgb_to_hsv(red, green, blue);
+
+    // Get the matched color
+    return get_hsb_color(hsv.hue, hsv.saturation, hsv.brightness);
+}
+
+// Color of gamma corrected channels, the hue test of get_hsb_color in integers. Only a hue with red as the largest
+// channel can be below 25 or from 330 degrees, there the hue is 60 * (g - b) / delta. A hue of exactly 25 or 330
+// degrees comes out of the float path a rounding error to either side, so those few ties are left to it.
+static color_t classify_corrected(int r, int g, int b)
+{
+    if (r < g || r < b) return COLOR_UNKNOWN;
+    int delta = r - (g < b ? g : b);
+    // Gray has a hue of 0, which get_hsb_color counts as red with no confidence
+    if (delta == 0) return COLOR_RED;
+    int lhs = g >= b ? 12 * (g - b) : 2 * (b - g);
+    int rhs = g >= b ? 5 * delta : delta;
+    if (lhs == rhs) {
+        hsv_t hsv = rgb_to_hsv(r, g, b);
+        return get_hsb_color(hsv.hue, hsv.saturation, hsv.brightness).color;
+    }
+    return lhs < rhs ? COLOR_RED : COLOR_UNKNOWN;
+}
+
+// Gamma corrected channel the float path computes from the quotient the float division gave
+static int float_path_gamma(float quotient)
+{
+    float norm = quotient * 255.0f;
+    norm = norm > 255.0f ? 255.0f : norm;
+    return apply_gamma(norm, COLOR_GAMMA);
+}
+
+static float float_of_bits(uint32_t bits)
+{
+    float value;
+    memcpy(&value, &bits, sizeof(value));
+    return value;
+}
+
+// Whether a quotient exactly i / 2^GAMMA_BUCKET_BITS reaches gamma k
+static int bucket_start_reaches(int i, int k)
+{
+    uint64_t start = (uint64_t)i << (GAMMA_STEP_SHIFT - GAMMA_BUCKET_BITS);
+    return gamma_steps[k].threshold < start || (gamma_steps[k].threshold == start && gamma_steps[k].inclusive);
+}
+
+// The float division rounds the quotient to the nearest float, so it reaches gamma k from the midpoint between the
+// smallest float that does and the float below, or from that midpoint itself when it rounds up (ties to even)
+static void build_gamma_steps(void)
+{
+    uint32_t one = 0x3f800000;  // Bits of 1.0f, positive floats order like their bits
+    gamma_steps[0].threshold = 0;
+    gamma_steps[0].inclusive = 1;
+    for (int k = 1; k < 256; k++) {
+        uint32_t low = 0, high = one;
+        while (high - low > 1) {
+            uint32_t mid = low + (high - low) / 2;
+            if (float_path_gamma(float_of_bits(mid)) >= k) {
+                high = mid;
+            } else {
+                low = mid;
+            }
+        }
+        double midpoint = ((double)float_of_bits(high) + float_of_bits(high - 1)) / 2.0;
+        gamma_steps[k].threshold = (uint64_t)ldexp(midpoint, GAMMA_STEP_SHIFT);
+        gamma_steps[k].inclusive = (high & 1) == 0;
+    }
+
+    // Gamma at the start of every bucket and the largest gamma a quotient inside it can reach. The steps are at
+    // least 1/600 apart, so the gammas in between share one threshold and a single comparison decides; color_check
+    // compares every channel and clear channel pair with the float path.
+    uint64_t width = 1ull << (GAMMA_STEP_SHIFT - GAMMA_BUCKET_BITS);
+    for (int i = 0; i < GAMMA_BUCKETS; i++) {
+        int level = 0, next;
+        while (level < 255 && bucket_start_reaches(i, level + 1)) level++;
+        next = level;
+        while (next < 255 && gamma_steps[next + 1].threshold < (uint64_t)(i + 1) * width) next++;
+        gamma_buckets[i].level = level;
+        gamma_buckets[i].next = next;
+    }
+}
+
+// Whether the float path's gamma of value / clear is at least k
+static inline int reaches_step(uint32_t value, uint32_t clear, int k)
+{
+    return ((uint64_t)value << GAMMA_STEP_SHIFT) + gamma_steps[k].inclusive > gamma_steps[k].threshold * clear;
+}
+
+// Gamma corrected channel of the float path in integers: the bucket of the quotient leaves two candidates, one
+// exact comparison with the step between them decides
+static inline int raw_gamma(uint16_t value, uint16_t clear)
+{
+    if (value >= clear) return 255;
+    GammaBucket bucket = gamma_buckets[((uint32_t)value << GAMMA_BUCKET_BITS) / clear];
+    return reaches_step(value, clear, bucket.next) ? bucket.next : bucket.level;
+}
+
+static inline int grid_index(uint8_t r, uint8_t g, uint8_t b)
+{
+    int shift = 8 - COLOR_LUT_BITS;
+    return ((r >> shift) << (2 * COLOR_LUT_BITS)) | ((g >> shift) << COLOR_LUT_BITS) | (b >> shift);
+}
+
+static void build_tables(void)
+{
+    for (int i = 0; i < 256; i++) {
+        gamma_table[i] = apply_gamma((float)i, COLOR_GAMMA);
+    }
+    build_gamma_steps();
+
+    int span = 1 << (8 - COLOR_LUT_BITS);
+    mixed_cells = 0;
+    for (int cell = 0; cell < COLOR_LUT_CELLS; cell++) {
+        int r0 = (cell >> (2 * COLOR_LUT_BITS)) * span;
+        int g0 = ((cell >> COLOR_LUT_BITS) & ((1 << COLOR_LUT_BITS) - 1)) * span;
+        int b0 = (cell & ((1 << COLOR_LUT_BITS) - 1)) * span;
+        int color = classify_corrected(gamma_table[r0], gamma_table[g0], gamma_table[b0]);
+        for (int r = r0; r < r0 + span && color != COLOR_LUT_MIXED; r++) {
+            for (int g = g0; g < g0 + span && color != COLOR_LUT_MIXED; g++) {
+                for (int b = b0; b < b0 + span; b++) {
+                    if ((int)classify_corrected(gamma_table[r], gamma_table[g], gamma_table[b]) != color) {
+                        color = COLOR_LUT_MIXED;
+                        break;
+                    }
+                }
+            }
+        }
+        class_grid[cell] = color;
+        if (color == COLOR_LUT_MIXED) mixed_cells++;
+    }
+}
+
+void color_tables_init(void)
+{
+    pthread_once(&tables_once, build_tables);
+}
+
+uint8_t color_gamma(uint8_t value)
+{
+    color_tables_init();
+    return gamma_table[value];
+}
+
+int color_lut_mixed_cells(void)
+{
+    color_tables_init();
+    return mixed_cells;
+}
+
+// Match of gamma corrected channels, the color from the grid cell when it has one
+static color_match_t match_corrected(int cell, int gr, int gg, int gb)
+{
+    color_match_t match;
+    match.color = cell != COLOR_LUT_MIXED ? (color_t)cell : classify_corrected(gr, gg, gb);
+    match.confidence = 0.0;
+    if (match.color == COLOR_RED) {
+        // Saturation times brightness is the spread of the channels, red is the largest
+        match.confidence = (gr - (gg < gb ? gg : gb)) * COLOR_CONFIDENCE_SCALE;
+    }
+    return match;
+}
+
+// Classify channels already normalized by the clear channel
+color_match_t classify_normalized(uint8_t r, uint8_t g, uint8_t b)
+{
+    color_tables_init();
+    return match_corrected(class_grid[grid_index(r, g, b)], gamma_table[r], gamma_table[g], gamma_table[b]);
+}
+
+// Classify gamma corrected channels
+color_match_t classify_gamma(uint8_t r, uint8_t g, uint8_t b)
+{
+    return match_corrected(COLOR_LUT_MIXED, r, g, b);
+}
+
+// Classify a raw reading in integers, the gamma corrected channels are those of classify_color_float
+color_match_t classify_color(uint16_t r, uint16_t g, uint16_t b, uint16_t clear)
+{
+    // Avoid division by zero
+    if (clear == 0)
+    {
+        color_match_t none = {COLOR_UNKNOWN, 0.0};
+        return none;
+    }
+    color_tables_init();
+    return classify_gamma(raw_gamma(r, clear), raw_gamma(g, clear), raw_gamma(b, clear));
+}
+
+// Gamma corrected channel of value / clear as classify_color computes it
+uint8_t color_raw_gamma(uint16_t value, uint16_t clear)
+{
+    color_tables_init();
+    return clear == 0 ? 0 : raw_gamma(value, clear);
+}
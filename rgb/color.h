@@ -0,0 +1,72 @@
+/**
+Class         : CSC-615-01 - Embedded Linux - Fall 2024
+Team Name     : Wayno
+Github        : nhannguyensf
+Project       : Final Assignment - Robot Car
+File          : color.h
+Description:
+This file is the header file for the color.c file. It declares the color types and the classification of the
+TCS34725 readings, both the floating point path and the table path that replaces it. The color functions do no
+I/O, so they also build on the host.
+*
+Team Members:
+Kiran Poudel
+Nhan Nguyen
+Yuvraj Gupta
+Fernando Abel Malca Luque
+
+*
+**/
+#ifndef COLOR_H
+#define COLOR_H
+
+#include <stdint.h>
+
+#define COLOR_GAMMA 2.2f     // Standard gamma value for better color accuracy
+#define COLOR_LUT_BITS 5     // Grid cells per normalized channel are 2^COLOR_LUT_BITS
+#define COLOR_LUT_MIXED 0xff // Grid cell whose values do not all have the same color
+
+// Enumerated Types for Colors, the markers after COLOR_UNKNOWN are told apart by a calibration
+typedef enum {
+    COLOR_RED,
+    COLOR_UNKNOWN,
+    COLOR_GREEN,
+    COLOR_BLUE,
+    COLOR_BLACK,
+    COLOR_WHITE,
+    COLOR_NUM
+} color_t;
+
+// Structure to hold HSV values
+typedef struct {
+    float hue;
+    float saturation;
+    float brightness;
+} hsv_t;
+
+// Structure to hold color match information
+typedef struct {
+    color_t color;
+    double confidence;
+} color_match_t;
+
+const char* color_name(color_t color);
+// Color with the given lower case name, COLOR_UNKNOWN for any other name
+color_t color_from_name(const char* name);
+
+// Floating point path
+hsv_t rgb_to_hsv(uint8_t r, uint8_t g, uint8_t b);
+color_match_t get_hsb_color(float hue, float saturation, float brightness);
+uint8_t apply_gamma(float value, float gamma);
+color_match_t classify_color_float(uint16_t r, uint16_t g, uint16_t b, uint16_t clear);
+
+// Table path, the tables are built on the first call or by color_tables_init
+void color_tables_init(void);
+uint8_t color_gamma(uint8_t value);
+color_match_t classify_normalized(uint8_t r, uint8_t g, uint8_t b);
+color_match_t classify_gamma(uint8_t r, uint8_t g, uint8_t b);
+color_match_t classify_color(uint16_t r, uint16_t g, uint16_t b, uint16_t clear);
+uint8_t color_raw_gamma(uint16_t value, uint16_t clear);
+int color_lut_mixed_cells(void);
+
+#endif
@@ -0,0 +1,400 @@
+/**
+Class         : CSC-615-01 - Embedded Linux - Fall 2024
+Team Name     : Wayno
+Github        : nhannguyensf
+Project       : Final Assignment - Robot Car
+File          : color_cal.c
+Description:
+This file contains the calibrated color classifier. The samples of a marker are accumulated into a mean and a
+covariance with Welford's update, and the variance of the grid quantization is added to the covariance so a class
+measured with very little noise still covers the cells around it. color_cal_build inverts the covariances and
+stores the nearest class of every grid cell, so classifying a reading is one lookup plus the distance to the class
+found, which gives the confidence and decides the gate. The gate is left out of the grid, a cell only half inside
+a gate would otherwise lose the readings in that half. A cell keeps the class nearest its center only when that
+class is provably nearer than every other class wherever the other could pass its gate: the distance to the class
+is largest at a corner of the cell, and the distance to another class is bounded from below by its tangent plane
+at the point coordinate descent finds nearest. Other cells are marked COLOR_CAL_MIXED and their readings are
+compared with every class, so the grid gives the same class as color_cal_classify_exact.
+*
+Team Members:
+Kiran Poudel
+Nhan Nguyen
+Yuvraj Gupta
+Fernando Abel Malca Luque
+
+*
+**/
+#include "color_cal.h"
+#include <errno.h>
+#include <math.h>
+#include <stdio.h>
+#include <string.h>
+
+#define CHROMA_CELL (256.0 / (1 << COLOR_CAL_CHROMA_BITS) / 255.0)  // Width of a chroma cell in features
+#define MIN_SAMPLES 3
+#define DESCENT_STEPS 16       // Coordinate descent sweeps towards the point of a cell nearest a class
+#define BOUND_MARGIN 1e-6      // Rounding allowance on the distance bounds of a cell
+
+static const char* const action_names[COLOR_NUM_ACTIONS] = {"none", "log", "stop"};
+
+const char* color_action_name(ColorAction action) {
+    return action >= 0 && action < COLOR_NUM_ACTIONS ? action_names[action] : "?";
+}
+
+// Bit length of the clear channel minus one, the brightness level of the grid
+static inline int clear_level(uint32_t clear) {
+    int level = 31 - __builtin_clz(clear);
+    return level < COLOR_CAL_LEVELS ? level : COLOR_CAL_LEVELS - 1;
+}
+
+static inline int chroma_cell(uint32_t value, uint32_t clear) {
+    uint32_t n = value >= clear ? 255 : ((uint32_t)value * 255) / clear;
+    return n >> (8 - COLOR_CAL_CHROMA_BITS);
+}
+
+int color_cal_features(uint32_t r, uint32_t g, uint32_t b, uint32_t clear, double f[COLOR_CAL_FEATURES]) {
+    if (clear == 0) return -1;
+    f[0] = r >= clear ? 1.0 : (double)r / clear;
+    f[1] = g >= clear ? 1.0 : (double)g / clear;
+    f[2] = b >= clear ? 1.0 : (double)b / clear;
+    f[3] = log2(clear);
+    return 0;
+}
+
+void color_cal_init(ColorCalibration* cal) {
+    memset(cal, 0, sizeof(*cal));
+    cal->gate = COLOR_CAL_GATE;
+    memset(cal->grid, COLOR_CAL_NONE, sizeof(cal->grid));
+}
+
+// Report a line of the calibration file that cannot be read
+static void bad_line(const char* path, int number, const char* line, int* ret) {
+    fprintf(stderr, "color_cal: %s line %d cannot be read: %s%s", path, number, line,
+            strchr(line, '\n') ? "" : "\n");
+    *ret = -1;
+}
+
+int color_cal_load(ColorCalibration* cal, const char* path) {
+    FILE* file = fopen(path, "r");
+    if (!file) return -1;
+    color_cal_init(cal);
+    char line[512];
+    int number = 0;
+    int ret = 0;
+    while (fgets(line, sizeof(line), file)) {
+        char key[16];
+        number++;
+        if (line[0] == '#' || sscanf(line, "%15s", key) != 1) continue;
+        if (strcmp(key, "gate") == 0) {
+            if (sscanf(line, "%*s %lf", &cal->gate) != 1) bad_line(path, number, line, &ret);
+            continue;
+        }
+        if (strcmp(key, "class") != 0 || cal->num_classes == COLOR_CAL_MAX_CLASSES) {
+            bad_line(path, number, line, &ret);
+            continue;
+        }
+        ColorClass* c = &cal->classes[cal->num_classes];
+        double* m = c->mean;
+        double v[10];
+        if (sscanf(line, "%*s %23s %ld %lf %lf %lf %lf %lf %lf %lf %lf %lf %lf %lf %lf %lf %lf", c->name, &c->samples,
+                   &m[0], &m[1], &m[2], &m[3], &v[0], &v[1], &v[2], &v[3], &v[4], &v[5], &v[6], &v[7], &v[8],
+                   &v[9]) != 16) {
+            bad_line(path, number, line, &ret);
+            continue;
+        }
+        // The upper triangle, row by row
+        int k = 0;
+        for (int i = 0; i < COLOR_CAL_FEATURES; i++) {
+            for (int j = i; j < COLOR_CAL_FEATURES; j++) {
+                c->cov[i][j] = c->cov[j][i] = v[k++];
+            }
+        }
+        c->color = color_from_name(c->name);
+        cal->num_classes++;
+    }
+    fclose(file);
+    if (ret < 0) errno = EINVAL;
+    return ret;
+}
+
+int color_cal_save(const ColorCalibration* cal, const char* path) {
+    FILE* file = fopen(path, "w");
+    if (!file) return -1;
+    fprintf(file, "# Color calibration, features red/clear green/clear blue/clear log2(clear)\n");
+    fprintf(file, "# class name samples mean[4] covariance (00 01 02 03 11 12 13 22 23 33)\n");
+    fprintf(file, "gate %.3f\n", cal->gate);
+    for (int c = 0; c < cal->num_classes; c++) {
+        const ColorClass* cls = &cal->classes[c];
+        fprintf(file, "class %s %ld", cls->name, cls->samples);
+        for (int i = 0; i < COLOR_CAL_FEATURES; i++) {
+            fprintf(file, " %.6f", cls->mean[i]);
+        }
+        for (int i = 0; i < COLOR_CAL_FEATURES; i++) {
+            for (int j = i; j < COLOR_CAL_FEATURES; j++) {
+                fprintf(file, " %.6g", cls->cov[i][j]);
+            }
+        }
+        fprintf(file, "\n");
+    }
+    return fclose(file) == 0 ? 0 : -1;
+}
+
+void color_cal_accum_init(ColorCalAccum* accum) {
+    memset(accum, 0, sizeof(*accum));
+}
+
+void color_cal_accum_add(ColorCalAccum* accum, const double f[COLOR_CAL_FEATURES]) {
+    double before[COLOR_CAL_FEATURES];
+    accum->n++;
+    for (int i = 0; i < COLOR_CAL_FEATURES; i++) {
+        before[i] = f[i] - accum->mean[i];
+        accum->mean[i] += before[i] / accum->n;
+    }
+    for (int i = 0; i < COLOR_CAL_FEATURES; i++) {
+        for (int j = 0; j < COLOR_CAL_FEATURES; j++) {
+            accum->m2[i][j] += before[i] * (f[j] - accum->mean[j]);
+        }
+    }
+}
+
+int color_cal_set_class(ColorCalibration* cal, const char* name, const ColorCalAccum* accum) {
+    if (accum->n < MIN_SAMPLES) return -1;
+    int index = 0;
+    while (index < cal->num_classes && strcmp(cal->classes[index].name, name) != 0) index++;
+    if (index == COLOR_CAL_MAX_CLASSES) return -1;
+
+    ColorClass* c = &cal->classes[index];
+    memset(c, 0, sizeof(*c));
+    snprintf(c->name, sizeof(c->name), "%s", name);
+    c->color = color_from_name(c->name);
+    c->samples = accum->n;
+    for (int i = 0; i < COLOR_CAL_FEATURES; i++) {
+        c->mean[i] = accum->mean[i];
+        for (int j = 0; j < COLOR_CAL_FEATURES; j++) {
+            c->cov[i][j] = accum->m2[i][j] / (accum->n - 1);
+        }
+    }
+    // Variance of a value spread evenly over one grid cell
+    for (int i = 0; i < 3; i++) {
+        c->cov[i][i] += CHROMA_CELL * CHROMA_CELL / 12.0;
+    }
+    c->cov[3][3] += 1.0 / 12.0;
+    if (index == cal->num_classes) cal->num_classes++;
+    return 0;
+}
+
+// Gauss-Jordan elimination with partial pivoting, returns -1 for a singular matrix
+static int invert(const double in[COLOR_CAL_FEATURES][COLOR_CAL_FEATURES],
+                  double out[COLOR_CAL_FEATURES][COLOR_CAL_FEATURES]) {
+    enum { N = COLOR_CAL_FEATURES };
+    double a[N][2 * N];
+    for (int i = 0; i < N; i++) {
+        for (int j = 0; j < N; j++) {
+            a[i][j] = in[i][j];
+            a[i][N + j] = i == j;
+        }
+    }
+    for (int col = 0; col < N; col++) {
+        int pivot = col;
+        for (int row = col + 1; row < N; row++) {
+            if (fabs(a[row][col]) > fabs(a[pivot][col])) pivot = row;
+        }
+        if (fabs(a[pivot][col]) < 1e-15) return -1;
+        for (int j = 0; j < 2 * N; j++) {
+            double t = a[col][j];
+            a[col][j] = a[pivot][j];
+            a[pivot][j] = t;
+        }
+        double scale = a[col][col];
+        for (int j = 0; j < 2 * N; j++) a[col][j] /= scale;
+        for (int row = 0; row < N; row++) {
+            if (row == col || a[row][col] == 0.0) continue;
+            double factor = a[row][col];
+            for (int j = 0; j < 2 * N; j++) a[row][j] -= factor * a[col][j];
+        }
+    }
+    for (int i = 0; i < N; i++) {
+        for (int j = 0; j < N; j++) out[i][j] = a[i][N + j];
+    }
+    return 0;
+}
+
+static double distance2(const ColorClass* c, const double f[COLOR_CAL_FEATURES]) {
+    double d[COLOR_CAL_FEATURES];
+    for (int i = 0; i < COLOR_CAL_FEATURES; i++) d[i] = f[i] - c->mean[i];
+    double sum = 0;
+    for (int i = 0; i < COLOR_CAL_FEATURES; i++) {
+        double row = 0;
+        for (int j = 0; j < COLOR_CAL_FEATURES; j++) row += c->inv[i][j] * d[j];
+        sum += d[i] * row;
+    }
+    return sum;
+}
+
+// Nearest class to the features, -1 when none is within the limit
+static int nearest(const ColorCalibration* cal, const double f[COLOR_CAL_FEATURES], double limit, double* best) {
+    int index = -1;
+    *best = limit;
+    for (int c = 0; c < cal->num_classes; c++) {
+        double d = distance2(&cal->classes[c], f);
+        if (d <= *best) {
+            *best = d;
+            index = c;
+        }
+    }
+    return index;
+}
+
+// Largest distance to the class in a cell, a convex function is largest at a corner
+static double max_distance2(const ColorClass* c, const double lo[COLOR_CAL_FEATURES],
+                            const double hi[COLOR_CAL_FEATURES]) {
+    double worst = 0;
+    for (int corner = 0; corner < 1 << COLOR_CAL_FEATURES; corner++) {
+        double f[COLOR_CAL_FEATURES];
+        for (int i = 0; i < COLOR_CAL_FEATURES; i++) {
+            f[i] = (corner >> i) & 1 ? hi[i] : lo[i];
+        }
+        double d = distance2(c, f);
+        if (d > worst) worst = d;
+    }
+    return worst;
+}
+
+// Lower bound of the distance to the class in a cell: the tangent plane of the convex distance at any point stays
+// below it. The plane is taken at the point coordinate descent finds nearest the class, stopping early once the
+// bound exceeds enough.
+static double min_distance2(const ColorClass* c, const double lo[COLOR_CAL_FEATURES],
+                            const double hi[COLOR_CAL_FEATURES], double enough) {
+    double d[COLOR_CAL_FEATURES], d_lo[COLOR_CAL_FEATURES], d_hi[COLOR_CAL_FEATURES];
+    for (int i = 0; i < COLOR_CAL_FEATURES; i++) {
+        d_lo[i] = lo[i] - c->mean[i];
+        d_hi[i] = hi[i] - c->mean[i];
+        d[i] = fmin(fmax(0.0, d_lo[i]), d_hi[i]);
+    }
+    for (int step = 0;; step++) {
+        double bound = 0;
+        for (int i = 0; i < COLOR_CAL_FEATURES; i++) {
+            double slope = 0;
+            for (int j = 0; j < COLOR_CAL_FEATURES; j++) slope += 2.0 * c->inv[i][j] * d[j];
+            bound += 0.5 * slope * d[i] + fmin(slope * (d_lo[i] - d[i]), slope * (d_hi[i] - d[i]));
+        }
+        if (bound > enough || step == DESCENT_STEPS) return bound;
+        for (int i = 0; i < COLOR_CAL_FEATURES; i++) {
+            double sum = 0;
+            for (int j = 0; j < COLOR_CAL_FEATURES; j++) {
+                if (j != i) sum += c->inv[i][j] * d[j];
+            }
+            d[i] = fmin(fmax(-sum / c->inv[i][i], d_lo[i]), d_hi[i]);
+        }
+    }
+}
+
+// Whether the class is the answer of color_cal_classify_exact everywhere in the cell it is inside its gate, and
+// no other class can be the answer anywhere in the cell
+static int cell_is_pure(const ColorCalibration* cal, int index, const double lo[COLOR_CAL_FEATURES],
+                        const double hi[COLOR_CAL_FEATURES]) {
+    double upper = max_distance2(&cal->classes[index], lo, hi);
+    double enough = fmin(cal->gate, upper) + 2 * BOUND_MARGIN;
+    for (int c = 0; c < cal->num_classes; c++) {
+        if (c == index) continue;
+        if (min_distance2(&cal->classes[c], lo, hi, enough) <= enough) return 0;
+    }
+    return 1;
+}
+
+int color_cal_build(ColorCalibration* cal) {
+    for (int c = 0; c < cal->num_classes; c++) {
+        if (invert(cal->classes[c].cov, cal->classes[c].inv) < 0) return -1;
+    }
+    cal->mixed_cells = 0;
+    int cells = 1 << COLOR_CAL_CHROMA_BITS;
+    for (int level = 0; level < COLOR_CAL_LEVELS; level++) {
+        for (int r = 0; r < cells; r++) {
+            for (int g = 0; g < cells; g++) {
+                for (int b = 0; b < cells; b++) {
+                    double f[COLOR_CAL_FEATURES] = {(r + 0.5) * CHROMA_CELL, (g + 0.5) * CHROMA_CELL,
+                                                    (b + 0.5) * CHROMA_CELL, level + 0.5};
+                    // The last level holds every larger clear channel up to 2^32
+                    double lo[COLOR_CAL_FEATURES] = {r * CHROMA_CELL, g * CHROMA_CELL, b * CHROMA_CELL, level};
+                    double hi[COLOR_CAL_FEATURES] = {(r + 1) * CHROMA_CELL, (g + 1) * CHROMA_CELL,
+                                                     (b + 1) * CHROMA_CELL,
+                                                     level == COLOR_CAL_LEVELS - 1 ? 32.0 : level + 1.0};
+                    double d;
+                    int index = nearest(cal, f, INFINITY, &d);
+                    int cell = (level << (3 * COLOR_CAL_CHROMA_BITS)) | (r << (2 * COLOR_CAL_CHROMA_BITS))
+                               | (g << COLOR_CAL_CHROMA_BITS) | b;
+                    if (index >= 0 && !cell_is_pure(cal, index, lo, hi)) {
+                        cal->grid[cell] = COLOR_CAL_MIXED;
+                        cal->mixed_cells++;
+                    } else {
+                        cal->grid[cell] = index < 0 ? COLOR_CAL_NONE : index;
+                    }
+                }
+            }
+        }
+    }
+    return 0;
+}
+
+static ColorCalMatch make_match(const ColorCalibration* cal, int index, double d) {
+    ColorCalMatch match = {index, d, 0.0};
+    if (index >= 0 && d > cal->gate) {
+        match.index = -1;
+    } else if (index >= 0) {
+        match.confidence = 100.0 * (1.0 - d / cal->gate);
+    }
+    return match;
+}
+
+ColorCalMatch color_cal_classify(const ColorCalibration* cal, uint32_t r, uint32_t g, uint32_t b, uint32_t clear) {
+    ColorCalMatch none = {-1, 0.0, 0.0};
+    if (clear == 0) return none;
+    int cell = (clear_level(clear) << (3 * COLOR_CAL_CHROMA_BITS)) | (chroma_cell(r, clear) << (2 * COLOR_CAL_CHROMA_BITS))
+               | (chroma_cell(g, clear) << COLOR_CAL_CHROMA_BITS) | chroma_cell(b, clear);
+    int index = cal->grid[cell];
+    if (index == COLOR_CAL_NONE) return none;
+    if (index == COLOR_CAL_MIXED) return color_cal_classify_exact(cal, r, g, b, clear);
+    double f[COLOR_CAL_FEATURES];
+    color_cal_features(r, g, b, clear, f);
+    return make_match(cal, index, distance2(&cal->classes[index], f));
+}
+
+ColorCalMatch color_cal_classify_exact(const ColorCalibration* cal, uint32_t r, uint32_t g, uint32_t b,
+                                       uint32_t clear) {
+    ColorCalMatch none = {-1, 0.0, 0.0};
+    double f[COLOR_CAL_FEATURES];
+    if (color_cal_features(r, g, b, clear, f) < 0) return none;
+    double d;
+    int index = nearest(cal, f, cal->gate, &d);
+    return make_match(cal, index, d);
+}
+
+void color_actions_default(const ColorCalibration* cal, ColorAction actions[COLOR_CAL_MAX_CLASSES]) {
+    for (int c = 0; c < COLOR_CAL_MAX_CLASSES; c++) {
+        actions[c] = c < cal->num_classes && cal->classes[c].color == COLOR_RED ? COLOR_ACTION_STOP : COLOR_ACTION_NONE;
+    }
+}
+
+int color_actions_load(const char* path, const ColorCalibration* cal, ColorAction actions[COLOR_CAL_MAX_CLASSES]) {
+    color_actions_default(cal, actions);
+    FILE* file = fopen(path, "r");
+    if (!file) return -1;
+    char line[128];
+    int ret = 0;
+    while (fgets(line, sizeof(line), file)) {
+        char name[COLOR_CAL_NAME_LEN];
+        char action[16];
+        if (line[0] == '#' || sscanf(line, "%23s %15s", name, action) != 2) continue;
+        int c = 0;
+        while (c < cal->num_classes && strcmp(cal->classes[c].name, name) != 0) c++;
+        int a = 0;
+        while (a < COLOR_NUM_ACTIONS && strcmp(action_names[a], action) != 0) a++;
+        if (c == cal->num_classes || a == COLOR_NUM_ACTIONS) {
+            ret = -1;
+            continue;
+        }
+        actions[c] = (ColorAction)a;
+    }
+    fclose(file);
+    return ret;
+}
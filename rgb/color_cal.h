@@ -0,0 +1,113 @@
+/**
+Class         : CSC-615-01 - Embedded Linux - Fall 2024
+Team Name     : Wayno
+Github        : nhannguyensf
+Project       : Final Assignment - Robot Car
+File          : color_cal.h
+Description:
+This file is the header file for the color_cal.c file. A calibration holds the colors of the markers the car
+should know as classes, each the mean and covariance of its samples. A sample is described by four features: red,
+green and blue divided by the clear channel, and log2 of the clear channel, which tells black from white. A
+reading belongs to the class with the smallest Mahalanobis distance when that distance is inside the gate.
+Readings are scaled to the reference exposure by color_exposure_scale before they are classified or calibrated.
+Calibration file, written by car -k name and read at start:
+    gate distance_squared
+    class name samples mean[4] covariance (00 01 02 03 11 12 13 22 23 33)
+Actions file, written by hand, one class and what the car does when it sees it (none, log, stop) per line:
+    red stop
+Lines starting with # are comments.
+*
+Team Members:
+Kiran Poudel
+Nhan Nguyen
+Yuvraj Gupta
+Fernando Abel Malca Luque
+
+*
+**/
+#ifndef COLOR_CAL_H
+#define COLOR_CAL_H
+
+#include <stdint.h>
+#include "color.h"
+
+#define COLOR_CAL_FILE "color_cal.conf"
+#define COLOR_ACTIONS_FILE "color_actions.conf"
+#define COLOR_CAL_MAX_CLASSES 16
+#define COLOR_CAL_NAME_LEN 24
+#define COLOR_CAL_FEATURES 4
+#define COLOR_CAL_GATE 16.0         // Default squared distance beyond which a reading matches no class
+#define COLOR_CAL_SAMPLES 50        // Readings taken of a marker by car -k
+// Grid over the features: 16 cells per normalized channel and one level per power of two of the clear channel,
+// which reaches 2^21 for the shortest exposure scaled to the reference one
+#define COLOR_CAL_CHROMA_BITS 4
+#define COLOR_CAL_LEVELS 22
+#define COLOR_CAL_CELLS (COLOR_CAL_LEVELS << (3 * COLOR_CAL_CHROMA_BITS))
+#define COLOR_CAL_NONE 0xff         // Grid cell of a calibration without classes
+#define COLOR_CAL_MIXED 0xfe        // Grid cell the nearest class changes in, classified exactly
+
+typedef enum {
+    COLOR_ACTION_NONE,
+    COLOR_ACTION_LOG,   // Log when the car starts seeing the class
+    COLOR_ACTION_STOP,  // End the run
+    COLOR_NUM_ACTIONS
+} ColorAction;
+
+typedef struct {
+    char name[COLOR_CAL_NAME_LEN];
+    color_t color;     // Named color of the class, COLOR_UNKNOWN for other names
+    long samples;
+    double mean[COLOR_CAL_FEATURES];
+    double cov[COLOR_CAL_FEATURES][COLOR_CAL_FEATURES];
+    double inv[COLOR_CAL_FEATURES][COLOR_CAL_FEATURES];  // Inverse of the covariance, set by color_cal_build
+} ColorClass;
+
+typedef struct {
+    int num_classes;
+    ColorClass classes[COLOR_CAL_MAX_CLASSES];
+    double gate;
+    uint8_t grid[COLOR_CAL_CELLS];  // Nearest class in the whole cell, whatever its distance, or COLOR_CAL_MIXED
+    int mixed_cells;
+} ColorCalibration;
+
+// Running mean and covariance of the samples of one marker
+typedef struct {
+    long n;
+    double mean[COLOR_CAL_FEATURES];
+    double m2[COLOR_CAL_FEATURES][COLOR_CAL_FEATURES];
+} ColorCalAccum;
+
+typedef struct {
+    int index;          // Class in the calibration, -1 when the reading is outside every gate
+    double distance2;   // Squared Mahalanobis distance to the class
+    double confidence;  // 100 at the class mean down to 0 at the gate
+} ColorCalMatch;
+
+// Features of a raw reading, returns -1 when the clear channel is 0
+int color_cal_features(uint32_t r, uint32_t g, uint32_t b, uint32_t clear, double f[COLOR_CAL_FEATURES]);
+
+void color_cal_init(ColorCalibration* cal);
+// Returns -1 with errno from fopen when the file cannot be opened, or EINVAL after printing every line that cannot
+// be read
+int color_cal_load(ColorCalibration* cal, const char* path);
+int color_cal_save(const ColorCalibration* cal, const char* path);
+
+void color_cal_accum_init(ColorCalAccum* accum);
+void color_cal_accum_add(ColorCalAccum* accum, const double f[COLOR_CAL_FEATURES]);
+// Add or replace the class with the given name, returns -1 when there are too few samples or too many classes
+int color_cal_set_class(ColorCalibration* cal, const char* name, const ColorCalAccum* accum);
+
+// Invert the covariances and fill the grid, returns -1 when a covariance cannot be inverted
+int color_cal_build(ColorCalibration* cal);
+// Class of a reading from the grid, with the distance to that class; a mixed cell compares with every class
+ColorCalMatch color_cal_classify(const ColorCalibration* cal, uint32_t r, uint32_t g, uint32_t b, uint32_t clear);
+// Nearest class by comparing with every class, what the grid approximates
+ColorCalMatch color_cal_classify_exact(const ColorCalibration* cal, uint32_t r, uint32_t g, uint32_t b,
+                                       uint32_t clear);
+
+// Read the actions of the classes, classes without a line get none and a class named red gets stop
+int color_actions_load(const char* path, const ColorCalibration* cal, ColorAction actions[COLOR_CAL_MAX_CLASSES]);
+void color_actions_default(const ColorCalibration* cal, ColorAction actions[COLOR_CAL_MAX_CLASSES]);
+const char* color_action_name(ColorAction action);
+
+#endif
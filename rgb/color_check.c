@@ -0,0 +1,285 @@
+/**
+Class         : CSC-615-01 - Embedded Linux - Fall 2024
+Team Name     : Wayno
+Github        : nhannguyensf
+Project       : Final Assignment - Robot Car
+File          : color_check.c
+Description:
+This file checks the table path of the color classification against the floating point path. Every one of the
+2^24 normalized (r, g, b) values is classified both ways, the colors must be equal and the confidences within
+CHECK_TOLERANCE. Raw readings are checked exhaustively in two parts: the gamma corrected channel classify_color
+computes for every channel below every clear channel must be the one the float division and powf give, and every
+one of the 2^24 gamma corrected (r, g, b) values must be classified like the float path does, which together cover
+every raw reading. A random sample of raw readings is then classified both ways as well. Prints the table build
+time and the time per classification.
+With -c the grid of a color calibration is compared with the nearest class found by the distance to every class,
+on random readings spread over the chroma and brightness range, and any reading that differs fails the check.
+Exits with 1 on any difference.
+    color_check [-n raw_samples] [-c color_cal.conf]
+*
+Team Members:
+Kiran Poudel
+Nhan Nguyen
+Yuvraj Gupta
+Fernando Abel Malca Luque
+
+*
+**/
+#include "color.h"
+#include "color_cal.h"
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#define CHECK_TOLERANCE 1e-3
+#define MAX_REPORTS 10
+#define TIMING_SAMPLES 1000000
+
+static int64_t now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (int64_t)ts.tv_sec * 1000000000LL + ts.tv_nsec;
+}
+
+// Float path on channels that are already normalized
+static color_match_t classify_float_normalized(int r, int g, int b) {
+    hsv_t hsv = rgb_to_hsv(apply_gamma((float)r, COLOR_GAMMA), apply_gamma((float)g, COLOR_GAMMA),
+                           apply_gamma((float)b, COLOR_GAMMA));
+    return get_hsb_color(hsv.hue, hsv.saturation, hsv.brightness);
+}
+
+static long check_gamma(void) {
+    long mismatches = 0;
+    for (int i = 0; i < 256; i++) {
+        if (color_gamma(i) != apply_gamma((float)i, COLOR_GAMMA)) {
+            printf("gamma %d: table %d, powf %d\n", i, color_gamma(i), apply_gamma((float)i, COLOR_GAMMA));
+            mismatches++;
+        }
+    }
+    return mismatches;
+}
+
+static long check_exhaustive(void) {
+    long mismatches = 0;
+    for (int r = 0; r < 256; r++) {
+        for (int g = 0; g < 256; g++) {
+            for (int b = 0; b < 256; b++) {
+                color_match_t table = classify_normalized(r, g, b);
+                color_match_t ref = classify_float_normalized(r, g, b);
+                if (table.color == ref.color && fabs(table.confidence - ref.confidence) <= CHECK_TOLERANCE) {
+                    continue;
+                }
+                if (mismatches++ < MAX_REPORTS) {
+                    printf("(%d, %d, %d): table %d %.5f, float %d %.5f\n", r, g, b, table.color,
+                           table.confidence, ref.color, ref.confidence);
+                }
+            }
+        }
+    }
+    return mismatches;
+}
+
+// Gamma corrected channels: classify_gamma against the HSV match of the float path
+static long check_corrected(void) {
+    long mismatches = 0;
+    for (int r = 0; r < 256; r++) {
+        for (int g = 0; g < 256; g++) {
+            for (int b = 0; b < 256; b++) {
+                color_match_t table = classify_gamma(r, g, b);
+                hsv_t hsv = rgb_to_hsv(r, g, b);
+                color_match_t ref = get_hsb_color(hsv.hue, hsv.saturation, hsv.brightness);
+                if (table.color == ref.color && fabs(table.confidence - ref.confidence) <= CHECK_TOLERANCE) {
+                    continue;
+                }
+                if (mismatches++ < MAX_REPORTS) {
+                    printf("corrected (%d, %d, %d): table %d %.5f, float %d %.5f\n", r, g, b, table.color,
+                           table.confidence, ref.color, ref.confidence);
+                }
+            }
+        }
+    }
+    return mismatches;
+}
+
+static float float_of_bits(uint32_t bits) {
+    float value;
+    memcpy(&value, &bits, sizeof(value));
+    return value;
+}
+
+// Every channel below every clear channel: the gamma of classify_color against that of the float quotient. The
+// float path is monotonic in the quotient, so it reaches gamma k from the smallest float quotient that gives k.
+static long check_raw_channels(void) {
+    float step[257];
+    for (int k = 1; k < 256; k++) {
+        uint32_t low = 0, high = 0x3f800000;  // Bits of 0.0f and 1.0f
+        while (high - low > 1) {
+            uint32_t mid = low + (high - low) / 2;
+            float norm = float_of_bits(mid) * 255.0f;
+            if (apply_gamma(norm > 255.0f ? 255.0f : norm, COLOR_GAMMA) >= k) {
+                high = mid;
+            } else {
+                low = mid;
+            }
+        }
+        step[k] = float_of_bits(high);
+    }
+    step[256] = 2.0f;
+
+    long mismatches = 0;
+    for (uint32_t clear = 1; clear <= UINT16_MAX; clear++) {
+        int k = 0;
+        for (uint32_t value = 0; value < clear; value++) {
+            float quotient = (float)value / (float)clear;
+            while (quotient >= step[k + 1]) k++;
+            int table = color_raw_gamma(value, clear);
+            if (table != k && mismatches++ < MAX_REPORTS) {
+                printf("channel %u of clear %u: table gamma %d, float %d\n", value, clear, table, k);
+            }
+        }
+    }
+    return mismatches;
+}
+
+static void random_reading(unsigned* seed, uint16_t rgbc[4]) {
+    // Channels add up to about the clear channel, as on the sensor
+    rgbc[3] = 1 + rand_r(seed) % 65535;
+    for (int c = 0; c < 3; c++) {
+        rgbc[c] = (uint16_t)((uint32_t)rgbc[3] * (rand_r(seed) % 1001) / 1000);
+    }
+}
+
+// Readings with a clear channel spread evenly over its powers of two
+static void random_cal_reading(unsigned* seed, uint32_t rgbc[4]) {
+    int level = rand_r(seed) % COLOR_CAL_LEVELS;
+    rgbc[3] = (1u << level) + rand_r(seed) % (1u << level);
+    for (int c = 0; c < 3; c++) {
+        rgbc[c] = (uint32_t)((uint64_t)rgbc[3] * (rand_r(seed) % 1001) / 1000);
+    }
+}
+
+// Compare the grid of the calibration with the exact nearest class, returns the readings that differ
+static long check_calibration(const char* path, long samples) {
+    static ColorCalibration cal;
+    if (color_cal_load(&cal, path) < 0) {
+        fprintf(stderr, "Cannot read the calibration in %s\n", path);
+        return -1;
+    }
+    int64_t start = now_ns();
+    if (color_cal_build(&cal) < 0) {
+        fprintf(stderr, "A covariance in %s cannot be inverted\n", path);
+        return -1;
+    }
+    printf("Calibration: %d classes, grid built in %.1f ms, %d of %d cells compare with every class\n",
+           cal.num_classes, (now_ns() - start) / 1e6, cal.mixed_cells, COLOR_CAL_CELLS);
+
+    unsigned seed = 2;
+    long differ = 0;
+    long matched = 0;
+    for (long i = 0; i < samples; i++) {
+        uint32_t c[4];
+        random_cal_reading(&seed, c);
+        ColorCalMatch grid = color_cal_classify(&cal, c[0], c[1], c[2], c[3]);
+        ColorCalMatch exact = color_cal_classify_exact(&cal, c[0], c[1], c[2], c[3]);
+        if (exact.index >= 0) matched++;
+        if (grid.index != exact.index) differ++;
+    }
+    printf("Calibrated readings: %ld of %ld differ from the exact nearest class, %ld inside a gate\n", differ,
+           samples, matched);
+
+    static uint32_t readings[TIMING_SAMPLES][4];
+    for (long i = 0; i < TIMING_SAMPLES; i++) {
+        random_cal_reading(&seed, readings[i]);
+    }
+    volatile double sink = 0;
+    start = now_ns();
+    for (long i = 0; i < TIMING_SAMPLES; i++) {
+        sink += color_cal_classify_exact(&cal, readings[i][0], readings[i][1], readings[i][2], readings[i][3])
+                    .distance2;
+    }
+    double exact_ns = (double)(now_ns() - start) / TIMING_SAMPLES;
+    start = now_ns();
+    for (long i = 0; i < TIMING_SAMPLES; i++) {
+        sink += color_cal_classify(&cal, readings[i][0], readings[i][1], readings[i][2], readings[i][3]).distance2;
+    }
+    double grid_ns = (double)(now_ns() - start) / TIMING_SAMPLES;
+    printf("color_cal_classify_exact %.1f ns, color_cal_classify %.1f ns (%.1fx)\n", exact_ns, grid_ns,
+           grid_ns > 0 ? exact_ns / grid_ns : 0.0);
+    return differ;
+}
+
+int main(int argc, char* argv[]) {
+    long raw_samples = 1000000;
+    const char* cal_path = NULL;
+    int opt;
+    while ((opt = getopt(argc, argv, "n:c:")) != -1) {
+        switch (opt) {
+            case 'n': raw_samples = atol(optarg); break;
+            case 'c': cal_path = optarg; break;
+            default:
+                fprintf(stderr, "Usage: %s [-n raw_samples] [-c color_cal.conf]\n", argv[0]);
+                return 2;
+        }
+    }
+
+    int64_t start = now_ns();
+    color_tables_init();
+    printf("Tables built in %.1f ms, %d of %d grid cells fall back to the integer test\n",
+           (now_ns() - start) / 1e6, color_lut_mixed_cells(), 1 << (3 * COLOR_LUT_BITS));
+
+    long gamma_mismatches = check_gamma();
+    long mismatches = check_exhaustive();
+    long corrected_mismatches = check_corrected();
+    start = now_ns();
+    long channel_mismatches = check_raw_channels();
+    printf("Gamma table: %ld of 256 entries differ from powf\n", gamma_mismatches);
+    printf("Normalized values: %ld of %d classifications differ\n", mismatches, 1 << 24);
+    printf("Gamma corrected values: %ld of %d classifications differ\n", corrected_mismatches, 1 << 24);
+    printf("Raw channels: %ld of %u channel and clear channel pairs differ in gamma (%.1f s)\n", channel_mismatches,
+           (uint32_t)UINT16_MAX * (UINT16_MAX + 1) / 2, (now_ns() - start) / 1e9);
+
+    unsigned seed = 1;
+    long color_diffs = 0;
+    double worst_confidence = 0;
+    for (long i = 0; i < raw_samples; i++) {
+        uint16_t c[4];
+        random_reading(&seed, c);
+        color_match_t table = classify_color(c[0], c[1], c[2], c[3]);
+        color_match_t ref = classify_color_float(c[0], c[1], c[2], c[3]);
+        if (table.color != ref.color) {
+            color_diffs++;
+        } else if (fabs(table.confidence - ref.confidence) > worst_confidence) {
+            worst_confidence = fabs(table.confidence - ref.confidence);
+        }
+    }
+    printf("Raw readings: %ld of %ld colors differ, confidence within %.2e\n", color_diffs, raw_samples,
+           worst_confidence);
+
+    // Time both paths on the same readings
+    static uint16_t readings[TIMING_SAMPLES][4];
+    for (long i = 0; i < TIMING_SAMPLES; i++) {
+        random_reading(&seed, readings[i]);
+    }
+    volatile double sink = 0;
+    start = now_ns();
+    for (long i = 0; i < TIMING_SAMPLES; i++) {
+        sink += classify_color_float(readings[i][0], readings[i][1], readings[i][2], readings[i][3]).confidence;
+    }
+    double float_ns = (double)(now_ns() - start) / TIMING_SAMPLES;
+    start = now_ns();
+    for (long i = 0; i < TIMING_SAMPLES; i++) {
+        sink += classify_color(readings[i][0], readings[i][1], readings[i][2], readings[i][3]).confidence;
+    }
+    double table_ns = (double)(now_ns() - start) / TIMING_SAMPLES;
+    printf("classify_color_float %.1f ns, classify_color %.1f ns (%.1fx)\n", float_ns, table_ns,
+           table_ns > 0 ? float_ns / table_ns : 0.0);
+
+    if (cal_path && check_calibration(cal_path, raw_samples) != 0) {
+        return 1;
+    }
+    return gamma_mismatches || mismatches || corrected_mismatches || channel_mismatches || color_diffs
+           || worst_confidence > CHECK_TOLERANCE ? 1 : 0;
+}
@@ -0,0 +1,97 @@
+/**
+Class         : CSC-615-01 - Embedded Linux - Fall 2024
+Team Name     : Wayno
+Github        : nhannguyensf
+Project       : Final Assignment - Robot Car
+File          : color_exposure.c
+Description:
+This file contains the exposure ladder and the auto exposure of the TCS34725. The clear channel of a reading
+predicts the clear channel of every other step by the ratio of their sensitivities. A reading that is too dark
+moves up to the first step predicted to reach COLOR_AE_MIN_CLEAR and a too bright one down to the last step
+predicted below the high limit. A saturated reading only tells that the light is brighter, so it moves to the least
+sensitive step, whose reading places the light for every other step. A step is kept while its readings stay within
+COLOR_AE_HOLD_PERCENT of the range, so reading noise near a limit does not move the exposure back and forth, and a
+reading moves to a shorter integration time only with COLOR_AE_FAST_MARGIN to spare.
+*
+Team Members:
+Kiran Poudel
+Nhan Nguyen
+Yuvraj Gupta
+Fernando Abel Malca Luque
+
+*
+**/
+#include "color_exposure.h"
+
+static const ColorExposure ladder[COLOR_EXPOSURE_STEPS] = {
+    {TCS34725_INTEGRATIONTIME_2_4MS, TCS34725_GAIN_1X},
+    {TCS34725_INTEGRATIONTIME_2_4MS, TCS34725_GAIN_4X},
+    {TCS34725_INTEGRATIONTIME_2_4MS, TCS34725_GAIN_16X},
+    {TCS34725_INTEGRATIONTIME_2_4MS, TCS34725_GAIN_60X},
+    {TCS34725_INTEGRATIONTIME_24MS, TCS34725_GAIN_16X},
+    {TCS34725_INTEGRATIONTIME_24MS, TCS34725_GAIN_60X},
+    {TCS34725_INTEGRATIONTIME_50MS, TCS34725_GAIN_60X},
+    {TCS34725_INTEGRATIONTIME_101MS, TCS34725_GAIN_60X},
+    {TCS34725_INTEGRATIONTIME_240MS, TCS34725_GAIN_60X},
+    {TCS34725_INTEGRATIONTIME_600MS, TCS34725_GAIN_60X},
+};
+
+ColorExposure color_exposure_step(int step) {
+    return ladder[step];
+}
+
+long color_exposure_sensitivity(int step) {
+    return (long)tcs34725_cycles(ladder[step].atime) * tcs34725_gain_factor(ladder[step].gain);
+}
+
+// Clear channel the reading would have had at another step
+static long predict(int from, uint16_t clear, int to) {
+    return (long)clear * color_exposure_sensitivity(to) / color_exposure_sensitivity(from);
+}
+
+static long high_count(int step) {
+    return (long)tcs34725_max_count(ladder[step].atime) * COLOR_AE_HIGH_PERCENT / 100;
+}
+
+int color_exposure_next(int step, uint16_t clear) {
+    if (clear >= tcs34725_max_count(ladder[step].atime)) {
+        // A saturated clear channel only bounds the light from below, the least sensitive step measures it
+        return 0;
+    }
+    if (clear >= high_count(step) * (100 + COLOR_AE_HOLD_PERCENT) / 100) {
+        int next = step;
+        while (next > 0 && (next == step || predict(step, clear, next) >= high_count(next))) next--;
+        return next;
+    }
+    if (clear < COLOR_AE_MIN_CLEAR * (100 - COLOR_AE_HOLD_PERCENT) / 100) {
+        int next = step;
+        while (next < COLOR_EXPOSURE_STEPS - 1 && predict(step, clear, next) < COLOR_AE_MIN_CLEAR
+               && predict(step, clear, next + 1) < high_count(next + 1)) {
+            next++;
+        }
+        return next;
+    }
+    // Close enough to the range, look for the shortest integration time that has margin, with its highest gain
+    int best = step;
+    for (int s = 0; s < step; s++) {
+        long predicted = predict(step, clear, s);
+        if (predicted < COLOR_AE_FAST_MARGIN * COLOR_AE_MIN_CLEAR || predicted >= high_count(s)) continue;
+        if (best != step && ladder[s].atime != ladder[best].atime) break;
+        best = s;
+    }
+    // A lower gain at the same integration time gives no faster readings
+    return ladder[best].atime == ladder[step].atime ? step : best;
+}
+
+void color_exposure_scale(int step, const uint16_t raw[4], uint32_t scaled[4]) {
+    long ref = color_exposure_sensitivity(COLOR_EXPOSURE_REF_STEP);
+    long sensitivity = color_exposure_sensitivity(step);
+    for (int c = 0; c < 4; c++) {
+        scaled[c] = (uint32_t)((uint64_t)raw[c] * ref / sensitivity);
+    }
+}
+
+int color_exposure_apply(int handle, int step) {
+    if (set_integration_time(handle, ladder[step].atime) < 0) return -1;
+    return set_sensor_gain(handle, ladder[step].gain);
+}
@@ -0,0 +1,51 @@
+/**
+Class         : CSC-615-01 - Embedded Linux - Fall 2024
+Team Name     : Wayno
+Github        : nhannguyensf
+Project       : Final Assignment - Robot Car
+File          : color_exposure.h
+Description:
+This file is the header file for the color_exposure.c file. The exposure of the TCS34725 is one step of a ladder
+of integration time and gain settings ordered by sensitivity, all gains of an integration time before the next
+longer one. The auto exposure picks the step from the clear channel of the last reading: the shortest integration
+time whose clear channel stays between COLOR_AE_MIN_CLEAR and COLOR_AE_HIGH_PERCENT of full scale, with some
+hysteresis before it leaves a step. Readings are scaled to the sensitivity of COLOR_EXPOSURE_REF_STEP, the 101 ms,
+60x setting the car used before, so thresholds and calibrations do not depend on the step a reading was taken at.
+*
+Team Members:
+Kiran Poudel
+Nhan Nguyen
+Yuvraj Gupta
+Fernando Abel Malca Luque
+
+*
+**/
+#ifndef COLOR_EXPOSURE_H
+#define COLOR_EXPOSURE_H
+
+#include <stdint.h>
+#include "tcs34725.h"
+
+#define COLOR_EXPOSURE_STEPS 10
+#define COLOR_EXPOSURE_REF_STEP 7    // 101 ms, 60x
+#define COLOR_AE_MIN_CLEAR 200       // Fewest clear counts for a usable chromaticity
+#define COLOR_AE_HIGH_PERCENT 80     // Clear counts above this share of full scale are too close to saturation
+#define COLOR_AE_FAST_MARGIN 2       // A shorter step is taken once it would give this many times COLOR_AE_MIN_CLEAR
+#define COLOR_AE_HOLD_PERCENT 20     // A step is left once the clear channel is this far outside the range
+
+typedef struct {
+    tcs34725_atime_t atime;
+    tcs34725_gain_t gain;
+} ColorExposure;
+
+ColorExposure color_exposure_step(int step);
+// Integration cycles times the gain factor
+long color_exposure_sensitivity(int step);
+// Step to use after a reading with the given clear channel at the current step
+int color_exposure_next(int step, uint16_t clear);
+// Scale a reading taken at the step to the sensitivity of COLOR_EXPOSURE_REF_STEP
+void color_exposure_scale(int step, const uint16_t raw[4], uint32_t scaled[4]);
+// Write the integration time and the gain of the step to the sensor
+int color_exposure_apply(int handle, int step);
+
+#endif
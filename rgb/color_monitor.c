@@ -0,0 +1,240 @@
+/**
+Class         : CSC-615-01 - Embedded Linux - Fall 2024
+Team Name     : Wayno
+Github        : nhannguyensf
+Project       : Final Assignment - Robot Car
+File          : color_monitor.c
+Description:
+This file contains the background color detection. The thread wakes once per integration time of the sensor on
+absolute deadlines, reads the status and the channels in one burst through the robot I/O layer, so a recording
+holds every reading, and, until the first integration has completed (AVALID clear), polls again shortly. The clear
+channel of every reading feeds the auto exposure; after a change of the exposure the next read waits for the
+integration in progress and one full integration at the new setting, and the reading that caused the change is
+dropped since it may be saturated. Every other reading is scaled to the reference exposure and goes into a ring of
+the last COLOR_RING_SIZE readings whose sums are kept up to date, the average is classified with
+color_cal_classify, or classify_color without a calibration, and a change of class needs COLOR_ENTER_COUNT or
+COLOR_LEAVE_COUNT agreeing averages. The class, whether it is red and the time it was first seen are packed into
+one atomic word, so a reader always gets a matching set without a lock.
+*
+Team Members:
+Kiran Poudel
+Nhan Nguyen
+Yuvraj Gupta
+Fernando Abel Malca Luque
+
+*
+**/
+#include "color_monitor.h"
+#include "tcs34725.h"
+#include "color_exposure.h"
+#include "../fsm/fsm.h"
+#include "../robotio/robotio.h"
+#include "../trace/trace.h"
+#include <pthread.h>
+#include <stdatomic.h>
+#include <string.h>
+#include <time.h>
+
+static pthread_t monitor_thread;
+static _Atomic int running = 0;
+static int sensor_handle = -1;
+static long integration_us;
+static const ColorCalibration* calibration;
+// Time the class was first seen shifted left by 9, the red flag in bit 8 and the class plus one below, 0 for none
+static _Atomic uint64_t class_word = 0;
+static _Atomic uint64_t readings = 0;
+static _Atomic uint64_t not_valid = 0;
+static _Atomic uint64_t errors = 0;
+static _Atomic uint64_t changes = 0;
+static _Atomic uint64_t exposure_changes = 0;
+static _Atomic int exposure_step = COLOR_EXPOSURE_REF_STEP;
+static _Atomic int64_t reading_us = 0;
+
+void color_filter_init(ColorFilter* filter, const ColorCalibration* cal) {
+    memset(filter, 0, sizeof(*filter));
+    filter->cal = cal;
+    filter->cls = -1;
+    filter->candidate = -1;
+}
+
+// Class of the running average, -1 when no class is confident enough
+static int classify_average(const ColorFilter* filter) {
+    uint32_t avg[4];
+    for (int c = 0; c < 4; c++) {
+        avg[c] = filter->sums[c] / filter->count;
+    }
+    if (filter->cal) {
+        ColorCalMatch match = color_cal_classify(filter->cal, avg[0], avg[1], avg[2], avg[3]);
+        if (match.index < 0) return -1;
+        // The threshold to stay in a class is lower than the one to enter it
+        double threshold = match.index == filter->cls ? COLOR_LEAVE_CONFIDENCE : COLOR_ENTER_CONFIDENCE;
+        return match.confidence >= threshold ? match.index : -1;
+    }
+    // The red test only looks at the channels relative to the clear channel, which fits 16 bits after a shift
+    while (avg[3] > UINT16_MAX) {
+        for (int c = 0; c < 4; c++) avg[c] >>= 1;
+    }
+    color_match_t match = classify_color(avg[0], avg[1], avg[2], avg[3]);
+    double threshold = filter->cls == 0 ? COLOR_LEAVE_CONFIDENCE : COLOR_ENTER_CONFIDENCE;
+    return match.color == COLOR_RED && match.confidence >= threshold ? 0 : -1;
+}
+
+int color_filter_add(ColorFilter* filter, const uint32_t rgbc[4]) {
+    uint32_t* slot = filter->samples[filter->next];
+    for (int c = 0; c < 4; c++) {
+        if (filter->count == COLOR_RING_SIZE) {
+            filter->sums[c] -= slot[c];
+        }
+        slot[c] = rgbc[c];
+        filter->sums[c] += rgbc[c];
+    }
+    filter->next = (filter->next + 1) % COLOR_RING_SIZE;
+    if (filter->count < COLOR_RING_SIZE) {
+        filter->count++;
+    }
+
+    int cls = classify_average(filter);
+    if (cls == filter->cls) {
+        filter->streak = 0;
+        return 0;
+    }
+    if (cls != filter->candidate || filter->streak == 0) {
+        filter->candidate = cls;
+        filter->streak = 0;
+    }
+    filter->streak++;
+    if (filter->streak < (cls >= 0 ? COLOR_ENTER_COUNT : COLOR_LEAVE_COUNT)) {
+        return 0;
+    }
+    filter->cls = cls;
+    filter->red = cls >= 0 && (!filter->cal || filter->cal->classes[cls].color == COLOR_RED);
+    filter->streak = 0;
+    return 1;
+}
+
+static void add_us(struct timespec* ts, long us) {
+    ts->tv_nsec += us * 1000L;
+    while (ts->tv_nsec >= 1000000000L) {
+        ts->tv_nsec -= 1000000000L;
+        ts->tv_sec++;
+    }
+}
+
+static void* monitor_main(void* arg) {
+    ColorFilter filter;
+    color_filter_init(&filter, calibration);
+    trace_thread_name("color");
+
+    struct timespec next;
+    clock_gettime(CLOCK_MONOTONIC, &next);
+    long wait_us = COLOR_AVALID_POLL_US;
+    while (atomic_load(&running)) {
+        add_us(&next, wait_us);
+        clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &next, NULL);
+
+        uint16_t raw[4];
+        TRACE_BEGIN("color_read");
+        int ret = rio_read_color(raw);
+        TRACE_END("color_read");
+        if (ret == TCS34725_NOT_VALID) {
+            atomic_fetch_add(&not_valid, 1);
+            wait_us = COLOR_AVALID_POLL_US;
+            continue;
+        }
+        // Once the channels are valid every integration time brings a new reading
+        wait_us = integration_us;
+        if (ret < 0) {
+            atomic_fetch_add(&errors, 1);
+            continue;
+        }
+        atomic_fetch_add(&readings, 1);
+        int step = atomic_load_explicit(&exposure_step, memory_order_relaxed);
+        int next_step = color_exposure_next(step, raw[3]);
+        if (next_step != step) {
+            if (color_exposure_apply(sensor_handle, next_step) < 0) {
+                atomic_fetch_add(&errors, 1);
+                continue;
+            }
+            long next_us = tcs34725_integration_us(color_exposure_step(next_step).atime);
+            wait_us = integration_us + next_us;
+            integration_us = next_us;
+            atomic_store_explicit(&exposure_step, next_step, memory_order_relaxed);
+            atomic_fetch_add(&exposure_changes, 1);
+            continue;
+        }
+        uint32_t rgbc[4];
+        color_exposure_scale(step, raw, rgbc);
+        int changed = color_filter_add(&filter, rgbc);
+        atomic_store_explicit(&reading_us, fsm_monotonic_us(NULL), memory_order_relaxed);
+        if (changed) {
+            uint64_t word = 0;
+            if (filter.cls >= 0) {
+                word = ((uint64_t)fsm_monotonic_us(NULL) << 9) | ((uint64_t)filter.red << 8) | (filter.cls + 1);
+            }
+            atomic_store_explicit(&class_word, word, memory_order_release);
+            atomic_fetch_add(&changes, 1);
+        }
+    }
+    return NULL;
+}
+
+int color_monitor_start(int handle, int step, const ColorCalibration* cal) {
+    if (atomic_load(&running)) return 0;
+    sensor_handle = handle;
+    calibration = cal;
+    atomic_store(&exposure_step, step);
+    integration_us = tcs34725_integration_us(color_exposure_step(step).atime);
+    atomic_store(&class_word, 0);
+
+    // The monitor runs as a normal thread even when it is started from a real time thread
+    pthread_attr_t attr;
+    struct sched_param param = {0};
+    pthread_attr_init(&attr);
+    pthread_attr_setinheritsched(&attr, PTHREAD_EXPLICIT_SCHED);
+    pthread_attr_setschedpolicy(&attr, SCHED_OTHER);
+    pthread_attr_setschedparam(&attr, &param);
+
+    atomic_store(&running, 1);
+    int ret = pthread_create(&monitor_thread, &attr, monitor_main, NULL);
+    pthread_attr_destroy(&attr);
+    if (ret != 0) {
+        atomic_store(&running, 0);
+        return -1;
+    }
+    return 0;
+}
+
+void color_monitor_stop(void) {
+    if (!atomic_load(&running)) return;
+    atomic_store(&running, 0);
+    pthread_join(monitor_thread, NULL);
+}
+
+int color_monitor_class(int64_t* since_us) {
+    uint64_t word = atomic_load_explicit(&class_word, memory_order_acquire);
+    if (since_us) {
+        *since_us = (int64_t)(word >> 9);
+    }
+    return (int)(word & 0xff) - 1;
+}
+
+bool color_monitor_red(int64_t* since_us) {
+    uint64_t word = atomic_load_explicit(&class_word, memory_order_acquire);
+    if (since_us) {
+        *since_us = (int64_t)(word >> 9);
+    }
+    return (word >> 8) & 1;
+}
+
+int64_t color_monitor_reading_us(void) {
+    return atomic_load_explicit(&reading_us, memory_order_relaxed);
+}
+
+void color_monitor_get_stats(ColorMonitorStats* out) {
+    out->readings = atomic_load(&readings);
+    out->not_valid = atomic_load(&not_valid);
+    out->errors = atomic_load(&errors);
+    out->changes = atomic_load(&changes);
+    out->exposure_changes = atomic_load(&exposure_changes);
+    out->exposure_step = atomic_load(&exposure_step);
+}
@@ -0,0 +1,74 @@
+/**
+Class         : CSC-615-01 - Embedded Linux - Fall 2024
+Team Name     : Wayno
+Github        : nhannguyensf
+Project       : Final Assignment - Robot Car
+File          : color_monitor.h
+Description:
+This file is the header file for the color_monitor.c file. The color monitor reads the TCS34725 on its own thread
+once per integration, adjusts the exposure to the light, keeps a running average of the last readings and
+classifies it with hysteresis, so a single noisy reading neither starts nor ends a detection. With a calibration
+the average is matched against its classes, without one the built in red test is the only class. The control loop
+only reads the published result, which takes one atomic load instead of the half second detect_color blocks for.
+*
+Team Members:
+Kiran Poudel
+Nhan Nguyen
+Yuvraj Gupta
+Fernando Abel Malca Luque
+
+*
+**/
+#ifndef COLOR_MONITOR_H
+#define COLOR_MONITOR_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "color_cal.h"
+
+#define COLOR_RING_SIZE 4            // Readings in the running average
+#define COLOR_ENTER_CONFIDENCE 25.0  // Confidence an average needs to count as a class
+#define COLOR_LEAVE_CONFIDENCE 10.0  // The published class is kept until the confidence drops below this
+#define COLOR_ENTER_COUNT 3          // Consecutive averages of a class before it is published
+#define COLOR_LEAVE_COUNT 3          // Consecutive averages of no class before the class is withdrawn
+#define COLOR_AVALID_POLL_US 2400    // Poll interval until the first integration has completed
+
+// Running average and hysteresis of the readings
+typedef struct {
+    uint32_t samples[COLOR_RING_SIZE][4];  // Red, green, blue, clear at the reference exposure
+    uint32_t sums[4];
+    int count;
+    int next;
+    const ColorCalibration* cal;  // NULL for the built in red test, whose class is 0
+    int cls;        // Published class, -1 for none
+    bool red;       // The published class is red
+    int candidate;  // Class of the averages that disagree with the published one
+    int streak;     // Consecutive averages of the candidate
+} ColorFilter;
+
+typedef struct {
+    uint64_t readings;
+    uint64_t not_valid;  // Reads before the first integration had completed
+    uint64_t errors;
+    uint64_t changes;    // Times the published classification changed
+    uint64_t exposure_changes;
+    int exposure_step;   // Current step of the exposure ladder
+} ColorMonitorStats;
+
+void color_filter_init(ColorFilter* filter, const ColorCalibration* cal);
+// Add a reading scaled to the reference exposure, returns 1 when the classification changed
+int color_filter_add(ColorFilter* filter, const uint32_t rgbc[4]);
+
+// Start reading the sensor behind the handle, exposure_step is the step of the exposure ladder the sensor is set to.
+// The calibration must have been built and stay unchanged until the monitor is stopped, NULL uses the red test.
+int color_monitor_start(int handle, int exposure_step, const ColorCalibration* cal);
+void color_monitor_stop(void);
+// Class seen, -1 for none, since_us is the time on the fsm_monotonic_us clock it was first published
+int color_monitor_class(int64_t* since_us);
+// true while the class seen is red
+bool color_monitor_red(int64_t* since_us);
+// Time of the last reading that went into the classification, 0 before the first one
+int64_t color_monitor_reading_us(void);
+void color_monitor_get_stats(ColorMonitorStats* out);
+
+#endif
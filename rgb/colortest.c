@@ -1,4 +1,5 @@
 #include "tcs34725.h"
+#include "../bus/bus.h"
 #include <pigpio.h>
 #include <stdio.h>
 #include <signal.h>
@@ -21,12 +22,13 @@ int main()
         printf("Failed to initialize pigpio.\n");
         return EXIT_FAILURE;
     }
+    bus_init(&bus_real_backend);
 
     // Setup signal tcs34725rs for graceful termination
     signal(SIGINT, signal_handler);
 
     // Initialize the TCS34725 sensor
-    int tcs34725 = init_TCS34725("101ms", "60X");
+    int tcs34725 = init_TCS34725(TCS34725_INTEGRATIONTIME_101MS, TCS34725_GAIN_60X);
     if (tcs34725 < 0) {
         gpioTerminate();
         return EXIT_FAILURE;
@@ -36,7 +38,7 @@ int main()
     int current_brightness = 100;
     if (set_led_brightness(LED_PIN, current_brightness) < 0) {
         printf("Failed to set initial LED brightness.\n");
-        i2cClose(tcs34725);
+        bus_i2c_close(tcs34725);
         gpioTerminate();
         return EXIT_FAILURE;
     }
@@ -54,7 +56,7 @@ int main()
     }
 
     // Cleanup
-    i2cClose(tcs34725);
+    bus_i2c_close(tcs34725);
     gpioTerminate();
     printf("Terminated.\n");
     return EXIT_SUCCESS;
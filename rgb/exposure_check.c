@@ -0,0 +1,148 @@
+/**
+Class         : CSC-615-01 - Embedded Linux - Fall 2024
+Team Name     : Wayno
+Github        : nhannguyensf
+Project       : Final Assignment - Robot Car
+File          : exposure_check.c
+Description:
+This file checks the auto exposure of color_exposure.c on a simulated sensor. The light is swept over five
+decades, from darker than the longest step can bring into range to brighter than the shortest one can, and at
+every level the exposure starts from each step of the ladder. The clear channel of a reading is the light times
+the sensitivity of the step, clipped at the full scale of the integration time. Under steady light every run must
+settle within CHECK_SETTLE_READINGS readings. With random jitter on the light no run may come back to a step it
+left; a reading near a limit can still move the exposure late, which is counted. Every run must end on a step the
+auto exposure keeps at the light without jitter, within COLOR_AE_HOLD_PERCENT of the range, wherever a step of the
+ladder can reach the range.
+Exits with 1 when any run fails.
+    exposure_check [-n levels] [-j jitter_percent]
+*
+Team Members:
+Kiran Poudel
+Nhan Nguyen
+Yuvraj Gupta
+Fernando Abel Malca Luque
+
+*
+**/
+#include "color_exposure.h"
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#define CHECK_DECADES 5
+#define CHECK_LIGHT_MIN 0.005         // Clear counts per unit of sensitivity at the darkest level
+#define CHECK_SETTLE_READINGS 3       // Readings after which the step must not change any more
+#define CHECK_RUN_READINGS 30
+
+// color_exposure_apply is never called on the host, the sensor writes it refers to do nothing
+int set_integration_time(int handle, tcs34725_atime_t atime) {
+    return 0;
+}
+
+int set_sensor_gain(int handle, tcs34725_gain_t gain) {
+    return 0;
+}
+
+static long high_count(int step) {
+    return (long)tcs34725_max_count(color_exposure_step(step).atime) * COLOR_AE_HIGH_PERCENT / 100;
+}
+
+// Whether the auto exposure keeps the step for a reading with this clear channel
+static int held(int step, uint16_t clear) {
+    return clear >= COLOR_AE_MIN_CLEAR * (100 - COLOR_AE_HOLD_PERCENT) / 100
+           && clear < high_count(step) * (100 + COLOR_AE_HOLD_PERCENT) / 100;
+}
+
+// Clear channel of a reading at the step, the jitter is a fraction of the light
+static uint16_t read_clear(unsigned* seed, double light, int step, double jitter) {
+    double noise = 1.0 + jitter * ((rand_r(seed) % 2001) / 1000.0 - 1.0);
+    double clear = light * noise * color_exposure_sensitivity(step);
+    long max = tcs34725_max_count(color_exposure_step(step).atime);
+    return clear >= max ? (uint16_t)max : (uint16_t)lround(clear);
+}
+
+// Whether some step brings the light into range
+static int reachable(double light) {
+    for (int s = 0; s < COLOR_EXPOSURE_STEPS; s++) {
+        double clear = light * color_exposure_sensitivity(s);
+        if (clear >= COLOR_AE_MIN_CLEAR && clear < high_count(s)) return 1;
+    }
+    return 0;
+}
+
+typedef struct {
+    long runs;
+    long slow;          // Runs that changed the step after CHECK_SETTLE_READINGS readings
+    long oscillating;   // Runs that came back to a step they left
+    long out_of_range;  // Runs that ended on a step the auto exposure would leave, with the range in reach
+    int worst_settle;
+} Sweep;
+
+// Run the auto exposure from every step at every light level
+static void sweep(int levels, double jitter, Sweep* out) {
+    unsigned seed = 1;
+    memset(out, 0, sizeof(*out));
+    for (int level = 0; level < levels; level++) {
+        double light = CHECK_LIGHT_MIN * pow(10.0, (double)CHECK_DECADES * level / (levels - 1));
+        int in_reach = reachable(light);
+        for (int start = 0; start < COLOR_EXPOSURE_STEPS; start++) {
+            int step = start;
+            int settle = 0;
+            int visited[COLOR_EXPOSURE_STEPS] = {0};
+            int revisited = 0;
+            visited[step] = 1;
+            for (int reading = 1; reading <= CHECK_RUN_READINGS; reading++) {
+                int next = color_exposure_next(step, read_clear(&seed, light, step, jitter));
+                if (next == step) continue;
+                settle = reading;
+                if (visited[next]) revisited = 1;
+                visited[next] = 1;
+                step = next;
+            }
+            // The step the run ended on must be kept at the light without the jitter
+            uint16_t clear = read_clear(&seed, light, step, 0.0);
+
+            out->runs++;
+            if (settle > out->worst_settle) out->worst_settle = settle;
+            if (settle > CHECK_SETTLE_READINGS) out->slow++;
+            if (revisited) out->oscillating++;
+            if (in_reach && !held(step, clear)) {
+                out->out_of_range++;
+                if (out->out_of_range <= 5) {
+                    printf("Light %.4g from step %d ends at step %d with clear %u\n", light, start, step, clear);
+                }
+            }
+        }
+    }
+}
+
+int main(int argc, char* argv[]) {
+    int levels = 1000;
+    double jitter = 0.05;
+    int opt;
+    while ((opt = getopt(argc, argv, "n:j:")) != -1) {
+        switch (opt) {
+            case 'n': levels = atoi(optarg); break;
+            case 'j': jitter = atof(optarg) / 100.0; break;
+            default:
+                fprintf(stderr, "Usage: %s [-n levels] [-j jitter_percent]\n", argv[0]);
+                return 2;
+        }
+    }
+    if (levels < 2) levels = 2;
+
+    Sweep steady, noisy;
+    sweep(levels, 0.0, &steady);
+    sweep(levels, jitter, &noisy);
+    printf("Light from %.4g to %.4g over %d levels, %ld runs each\n", CHECK_LIGHT_MIN,
+           CHECK_LIGHT_MIN * pow(10.0, CHECK_DECADES), levels, steady.runs);
+    printf("Steady light: settled after at most %d readings, %ld runs took more than %d, %ld came back to a step "
+           "they left, %ld ended out of range\n", steady.worst_settle, steady.slow, CHECK_SETTLE_READINGS,
+           steady.oscillating, steady.out_of_range);
+    printf("%.0f%% jitter: %ld runs changed the step after %d readings, %ld came back to a step they left, "
+           "%ld ended out of range\n", jitter * 100.0, noisy.slow, CHECK_SETTLE_READINGS, noisy.oscillating,
+           noisy.out_of_range);
+    return steady.slow || steady.oscillating || steady.out_of_range || noisy.oscillating || noisy.out_of_range ? 1 : 0;
+}
@@ -19,15 +19,18 @@ Fernando Abel Malca Luque
 #define TCS34725_H
 
 #include <stdint.h>
+#include "color.h"
 
 // I2C Address and Commands
 #define TCS34725_ADDR         0x29
 #define TCS34725_CMD          0x80
+#define TCS34725_CMD_AUTO_INC 0x20  // Auto-increment: the register address advances on every byte of a transfer
 #define TCS34725_PON          0x01
 #define TCS34725_AEN          0x02
 #define TCS34725_ENABLE       0x00
 #define TCS34725_ATIME        0x01
 #define TCS34725_CONTROL      0x0F
+#define TCS34725_STATUS       0x13
 #define TCS34725_CDATAL       0x14
 #define TCS34725_CDATH        0x15
 #define TCS34725_RDATAL       0x16
@@ -37,20 +40,36 @@ Fernando Abel Malca Luque
 #define TCS34725_BDATAL       0x1A
 #define TCS34725_BDATH        0x1B
 
-// Integration Times
-#define TCS34725_INTEGRATIONTIME_2_4MS  0xFF
-#define TCS34725_INTEGRATIONTIME_24MS   0xF6
-#define TCS34725_INTEGRATIONTIME_50MS   0xEB
-#define TCS34725_INTEGRATIONTIME_101MS  0xD6
-#define TCS34725_INTEGRATIONTIME_240MS  0x9C
-#define TCS34725_INTEGRATIONTIME_600MS  0x06
-
-// Gain Settings
-#define TCS34725_GAIN_1X    0x00
-#define TCS34725_GAIN_4X    0x01
-#define TCS34725_GAIN_16X   0x02
-#define TCS34725_GAIN_60X   0x03
-#define TCS34725_GAIN_64X   0x06
+// STATUS bit set once an integration has completed since the RGBC channels were enabled
+#define TCS34725_STATUS_AVALID 0x01
+
+// A burst read from STATUS covers the status and the eight data registers CDATAL..BDATAH
+#define TCS34725_BURST_LEN 9
+
+// read_color_data result when no integration has completed yet
+#define TCS34725_NOT_VALID (-2)
+
+// Integration times, the ATIME register value. Every step below 256 is one 2.4 ms integration cycle.
+typedef enum {
+    TCS34725_INTEGRATIONTIME_2_4MS = 0xFF,  // 1 cycle
+    TCS34725_INTEGRATIONTIME_24MS = 0xF6,   // 10 cycles
+    TCS34725_INTEGRATIONTIME_50MS = 0xEB,   // 21 cycles
+    TCS34725_INTEGRATIONTIME_101MS = 0xD6,  // 42 cycles
+    TCS34725_INTEGRATIONTIME_154MS = 0xC0,  // 64 cycles
+    TCS34725_INTEGRATIONTIME_240MS = 0x9C,  // 100 cycles
+    TCS34725_INTEGRATIONTIME_600MS = 0x06   // 250 cycles
+} tcs34725_atime_t;
+
+// Gain settings, the AGAIN field of the CONTROL register
+typedef enum {
+    TCS34725_GAIN_1X = 0x00,
+    TCS34725_GAIN_4X = 0x01,
+    TCS34725_GAIN_16X = 0x02,
+    TCS34725_GAIN_60X = 0x03
+} tcs34725_gain_t;
+
+#define TCS34725_CYCLE_US 2400
+#define TCS34725_COUNTS_PER_CYCLE 1024  // A channel saturates at 1024 counts per cycle, at most 65535
 
 // Delay
 #define SENSOR_ENABLE_DELAY_US 2400
@@ -70,34 +89,46 @@ Fernando Abel Malca Luque
 // PWM Output Mode
 #define PI_PWM_OUTPUT 2
 
-// Enumerated Types for Colors
-typedef enum {
-    COLOR_RED,
-    COLOR_UNKNOWN
-} color_t;
-
-// Structure to hold HSV values
-typedef struct {
-    float hue;
-    float saturation;
-    float brightness;
-} hsv_t;
-
-// Structure to hold color match information
-typedef struct {
-    color_t color;
-    double confidence;
-} color_match_t;
+// Unpack a burst read from STATUS, returns 0 when the channels hold a completed integration
+static inline int tcs34725_decode_burst(const uint8_t data[TCS34725_BURST_LEN], uint16_t* r, uint16_t* g, uint16_t* b, uint16_t* clear)
+{
+    *clear = data[1] | (data[2] << 8);
+    *r = data[3] | (data[4] << 8);
+    *g = data[5] | (data[6] << 8);
+    *b = data[7] | (data[8] << 8);
+    return (data[0] & TCS34725_STATUS_AVALID) ? 0 : TCS34725_NOT_VALID;
+}
+
+static inline int tcs34725_cycles(tcs34725_atime_t atime)
+{
+    return 256 - atime;
+}
+
+static inline long tcs34725_integration_us(tcs34725_atime_t atime)
+{
+    return (long)tcs34725_cycles(atime) * TCS34725_CYCLE_US;
+}
+
+// Highest count a channel can reach with the integration time
+static inline uint16_t tcs34725_max_count(tcs34725_atime_t atime)
+{
+    long max = (long)tcs34725_cycles(atime) * TCS34725_COUNTS_PER_CYCLE;
+    return max > 65535 ? 65535 : (uint16_t)max;
+}
+
+static inline int tcs34725_gain_factor(tcs34725_gain_t gain)
+{
+    static const int factors[] = {1, 4, 16, 60};
+    return factors[gain & 0x03];
+}
 
 // Function Declarations
-int init_TCS34725(const char *integration_time_str, const char *gain_str);
+int init_TCS34725(tcs34725_atime_t atime, tcs34725_gain_t gain);
+int set_integration_time(int handle, tcs34725_atime_t atime);
 int read_color_data(int handle, uint16_t* r, uint16_t* g, uint16_t* b, uint16_t* clear);
-hsv_t rgb_to_hsv(uint8_t r, uint8_t g, uint8_t b);
-color_match_t get_hsb_color(float hue, float saturation, float brightness);
 int set_led_brightness(int gpio, int percentage);
-uint8_t apply_gamma(float value, float gamma);
 int read_average_color_data(int handle, uint16_t* r, uint16_t* g, uint16_t* b, uint16_t* clear, int num_readings, int delay_us);
-int set_sensor_gain(int handle, const char *gain_str);
+int set_sensor_gain(int handle, tcs34725_gain_t gain);
 const char* detect_color(int handle);
 int detect_and_adjust_led(int handle, int *result);
 
@@ -0,0 +1,128 @@
+/**
+Class         : CSC-615-01 - Embedded Linux - Fall 2024
+Team Name     : Wayno
+Github        : nhannguyensf
+Project       : Final Assignment - Robot Car
+File          : rio_replay.c
+Description:
+This file is the host side replay of a recording made with car -R. The recorded sensor reads and clock are fed
+back through pid_control as fast as the CPU allows, every motor command is compared with the recorded one and
+the time pid_control takes per iteration is measured. The exit status is 0 only when the replay went through the
+whole recording with identical motor commands, so it can be used as a regression check after a change to the
+control code. -s overrides a parameter of the recorded run to see how the commands would have changed.
+    rio_replay [-v] [-n max_reports] [-s name=value]... [recording]
+*
+Team Members:
+Kiran Poudel
+Nhan Nguyen
+Yuvraj Gupta
+Fernando Abel Malca Luque
+
+*
+**/
+#include "robotio.h"
+#include "pid.h"
+#include "tlog.h"
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#define MAX_OVERRIDES 16
+
+static int64_t now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (int64_t)ts.tv_sec * 1000000000LL + ts.tv_nsec;
+}
+
+// Apply a name=value override to the parameters, -1 for an unknown name or an out of range value
+static int apply_override(ControlParams* params, const char* arg) {
+    char name[64];
+    const char* eq = strchr(arg, '=');
+    if (!eq || eq == arg || (size_t)(eq - arg) >= sizeof(name)) return -1;
+    memcpy(name, arg, eq - arg);
+    name[eq - arg] = '\0';
+    int index = params_find(name);
+    if (index < 0) return -1;
+    return params_set_field(params, index, atof(eq + 1));
+}
+
+int main(int argc, char* argv[]) {
+    int verbose = 0;
+    int max_reports = 10;
+    const char* overrides[MAX_OVERRIDES];
+    int num_overrides = 0;
+    int opt;
+    while ((opt = getopt(argc, argv, "vn:s:")) != -1) {
+        switch (opt) {
+            case 'v':
+                verbose = 1;
+                break;
+            case 'n':
+                max_reports = atoi(optarg);
+                break;
+            case 's':
+                if (num_overrides == MAX_OVERRIDES) {
+                    fprintf(stderr, "At most %d overrides\n", MAX_OVERRIDES);
+                    return 2;
+                }
+                overrides[num_overrides++] = optarg;
+                break;
+            default:
+                fprintf(stderr, "Usage: %s [-v] [-n max_reports] [-s name=value]... [recording]\n", argv[0]);
+                return 2;
+        }
+    }
+    const char* path = optind < argc ? argv[optind] : RIO_FILE;
+
+    RioFileHeader header;
+    if (rio_replay_open(path, &header) < 0) {
+        return 2;
+    }
+    ControlParams params = header.params;
+    for (int i = 0; i < num_overrides; i++) {
+        if (apply_override(&params, overrides[i]) < 0) {
+            fprintf(stderr, "Invalid override %s, unknown parameter or value out of range\n", overrides[i]);
+            return 2;
+        }
+    }
+
+    // The controller's messages are only shown with -v
+    if (!verbose && tlog_init("/dev/null", 0) < 0) {
+        fprintf(stderr, "Could not silence the control messages\n");
+    }
+    rio_init(&rio_replay, NULL);
+    rio_replay_set_report(stdout, max_reports);
+    pid_set_params(&params);
+
+    uint64_t ticks = 0;
+    int64_t total_ns = 0;
+    int64_t max_ns = 0;
+    while (!rio_replay_done()) {
+        int64_t start = now_ns();
+        pid_control();
+        int64_t elapsed = now_ns() - start;
+        total_ns += elapsed;
+        if (elapsed > max_ns) max_ns = elapsed;
+        ticks++;
+    }
+    tlog_shutdown();
+    rio_replay_close();
+
+    double recorded_s = rio_replay_time_us() / 1e6;
+    printf("Replayed %llu iterations, %.3f s of driving, in %.3f ms (%.0fx real time)\n",
+           (unsigned long long)ticks, recorded_s, total_ns / 1e6,
+           total_ns > 0 ? recorded_s * 1e9 / total_ns : 0.0);
+    printf("pid_control took %.2f us on average, %.2f us at most\n",
+           ticks ? total_ns / 1e3 / ticks : 0.0, max_ns / 1e3);
+    printf("Motor commands: %llu compared, %llu different\n",
+           (unsigned long long)rio_replay_motor_checks(), (unsigned long long)rio_replay_mismatches());
+
+    const char* error = rio_replay_error();
+    if (error) {
+        printf("Replay stopped early: %s\n", error);
+        return 1;
+    }
+    return rio_replay_mismatches() == 0 ? 0 : 1;
+}
@@ -0,0 +1,455 @@
+/**
+Class         : CSC-615-01 - Embedded Linux - Fall 2024
+Team Name     : Wayno
+Github        : nhannguyensf
+Project       : Final Assignment - Robot Car
+File          : robotio.c
+Description:
+This file contains the robot I/O layer: the calls of the control code go to the selected backend and, while
+recording, are appended to the recording file. The file is a header with the starting parameters followed by
+records of a small header and the payload of their type, written through a large stdio buffer so the control
+loop only copies memory. The replay backend reads the records back in order. Inputs return what was recorded,
+clock reads return the recorded time, and every motor command is compared with the recorded one. A call the
+recording does not have at that point means the controller took another path, which stops the replay.
+*
+Team Members:
+Kiran Poudel
+Nhan Nguyen
+Yuvraj Gupta
+Fernando Abel Malca Luque
+
+*
+**/
+#include "robotio.h"
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define RIO_BUFFER_SIZE (256 * 1024)
+
+static const RobotIO* io = NULL;
+static void* io_ctx = NULL;
+
+static const char* const type_names[RIO_NUM_TYPES] = {
+    "tick", "clock", "line", "distances", "encoders", "color", "motors", "params",
+};
+
+const char* rio_type_name(int type) {
+    return type >= 0 && type < RIO_NUM_TYPES ? type_names[type] : "unknown";
+}
+
+void rio_init(const RobotIO* selected, void* selected_ctx) {
+    io = selected;
+    io_ctx = selected_ctx;
+}
+
+// ---- Recording ----
+
+static FILE* record_file = NULL;
+static char* record_buffer = NULL;
+static _Atomic int recording = 0;
+static uint32_t record_ticks = 0;
+static pthread_mutex_t record_lock = PTHREAD_MUTEX_INITIALIZER;
+
+// Append one record, the file is closed on the first failed write
+static void record_at(int64_t ts_us, RioType type, int ret, const void* payload, unsigned size) {
+    RioRecordHeader header = {ts_us, (uint16_t)type, (uint16_t)size, ret};
+    pthread_mutex_lock(&record_lock);
+    if (record_file) {
+        if (fwrite(&header, sizeof(header), 1, record_file) != 1 ||
+            (size > 0 && fwrite(payload, size, 1, record_file) != 1)) {
+            fprintf(stderr, "robotio: recording write failed, recording stopped\n");
+            atomic_store(&recording, 0);
+            fclose(record_file);
+            record_file = NULL;
+        }
+    }
+    pthread_mutex_unlock(&record_lock);
+}
+
+// Timestamps come from the backend clock without being recorded as clock reads
+static void record(RioType type, int ret, const void* payload, unsigned size) {
+    record_at(io->now_us(io_ctx), type, ret, payload, size);
+}
+
+int rio_record_start(const char* path, const ControlParams* params) {
+    rio_record_stop();
+    FILE* file = fopen(path, "wb");
+    if (!file) {
+        perror("robotio: fopen");
+        return -1;
+    }
+    record_buffer = malloc(RIO_BUFFER_SIZE);
+    if (record_buffer) {
+        setvbuf(file, record_buffer, _IOFBF, RIO_BUFFER_SIZE);
+    }
+
+    RioFileHeader header;
+    memset(&header, 0, sizeof(header));
+    header.magic = RIO_MAGIC;
+    header.version = RIO_VERSION;
+    header.start_us = io->now_us(io_ctx);
+    header.params = *params;
+    if (fwrite(&header, sizeof(header), 1, file) != 1) {
+        fclose(file);
+        free(record_buffer);
+        record_buffer = NULL;
+        return -1;
+    }
+
+    pthread_mutex_lock(&record_lock);
+    record_file = file;
+    record_ticks = 0;
+    pthread_mutex_unlock(&record_lock);
+    atomic_store(&recording, 1);
+    return 0;
+}
+
+void rio_record_stop(void) {
+    atomic_store(&recording, 0);
+    pthread_mutex_lock(&record_lock);
+    if (record_file) {
+        fclose(record_file);
+        record_file = NULL;
+    }
+    free(record_buffer);
+    record_buffer = NULL;
+    pthread_mutex_unlock(&record_lock);
+}
+
+#define RECORDING() atomic_load_explicit(&recording, memory_order_relaxed)
+
+// ---- Calls used by the control code ----
+
+void rio_begin_tick(void) {
+    if (io->begin_tick) {
+        io->begin_tick(io_ctx);
+    }
+    if (RECORDING()) {
+        uint32_t tick = record_ticks++;
+        record(RIO_TICK, 0, &tick, sizeof(tick));
+    }
+}
+
+int64_t rio_now_us(void) {
+    int64_t now = io->now_us(io_ctx);
+    if (RECORDING()) {
+        record_at(now, RIO_CLOCK, 0, NULL, 0);
+    }
+    return now;
+}
+
+void rio_read_line(int sensor_states[NUM_SENSORS]) {
+    io->read_line(io_ctx, sensor_states);
+    if (RECORDING()) {
+        uint8_t mask = 0;
+        for (int i = 0; i < NUM_SENSORS; i++) {
+            mask |= (sensor_states[i] ? 1 : 0) << i;
+        }
+        record(RIO_LINE, 0, &mask, sizeof(mask));
+    }
+}
+
+int rio_get_distances(double distances[NUM_SENSORS]) {
+    int ret = io->get_distances(io_ctx, distances);
+    if (RECORDING()) {
+        record(RIO_DISTANCES, ret, distances, NUM_SENSORS * sizeof(double));
+    }
+    return ret;
+}
+
+int rio_read_encoders(int32_t counts[RIO_NUM_ENCODERS]) {
+    int ret = io->read_encoders(io_ctx, counts);
+    if (RECORDING()) {
+        record(RIO_ENCODERS, ret, counts, RIO_NUM_ENCODERS * sizeof(int32_t));
+    }
+    return ret;
+}
+
+int rio_read_color(uint16_t rgbc[4]) {
+    int ret = io->read_color(io_ctx, rgbc);
+    if (RECORDING()) {
+        record(RIO_COLOR, ret, rgbc, 4 * sizeof(uint16_t));
+    }
+    return ret;
+}
+
+void rio_motor_run(int left, int right) {
+    io->motor_run(io_ctx, left, right);
+    if (RECORDING()) {
+        int32_t motors[2] = {left, right};
+        record(RIO_MOTORS, 0, motors, sizeof(motors));
+    }
+}
+
+int rio_refresh_params(ControlParams* params) {
+    int changed = io->refresh_params(io_ctx, params);
+    if (changed && RECORDING()) {
+        record(RIO_PARAMS, 0, params, sizeof(*params));
+    }
+    return changed;
+}
+
+// The selected backend seen through the calls above, with the recording
+static void selected_begin_tick(void* ctx) {
+    rio_begin_tick();
+}
+
+static int64_t selected_now_us(void* ctx) {
+    return rio_now_us();
+}
+
+static void selected_read_line(void* ctx, int sensor_states[NUM_SENSORS]) {
+    rio_read_line(sensor_states);
+}
+
+static int selected_get_distances(void* ctx, double distances[NUM_SENSORS]) {
+    return rio_get_distances(distances);
+}
+
+static int selected_read_encoders(void* ctx, int32_t counts[RIO_NUM_ENCODERS]) {
+    return rio_read_encoders(counts);
+}
+
+static int selected_read_color(void* ctx, uint16_t rgbc[4]) {
+    return rio_read_color(rgbc);
+}
+
+static void selected_motor_run(void* ctx, int left, int right) {
+    rio_motor_run(left, right);
+}
+
+static int selected_refresh_params(void* ctx, ControlParams* params) {
+    return rio_refresh_params(params);
+}
+
+const RobotIO rio_selected = {
+    .name = "selected",
+    .begin_tick = selected_begin_tick,
+    .now_us = selected_now_us,
+    .read_line = selected_read_line,
+    .get_distances = selected_get_distances,
+    .read_encoders = selected_read_encoders,
+    .read_color = selected_read_color,
+    .motor_run = selected_motor_run,
+    .refresh_params = selected_refresh_params,
+};
+
+// ---- Replay backend ----
+
+static FILE* replay_file = NULL;
+static RioFileHeader replay_header;
+static RioRecordHeader next_header;
+static RioPayload next_payload;
+static int have_next = 0;
+static int replay_eof = 0;
+static int replay_failed = 0;
+static char replay_message[160];
+static uint32_t replay_ticks = 0;
+static int64_t replay_clock_us = 0;
+static uint64_t motor_checks = 0;
+static uint64_t motor_mismatches = 0;
+static FILE* report_out = NULL;
+static int report_max = 0;
+
+// Read the next record into next_header and next_payload, returns 0 at the end of the file
+static int peek_record(void) {
+    if (have_next) return 1;
+    if (replay_eof || !replay_file) return 0;
+    if (fread(&next_header, sizeof(next_header), 1, replay_file) != 1) {
+        replay_eof = 1;
+        return 0;
+    }
+    memset(&next_payload, 0, sizeof(next_payload));
+    if (next_header.size > sizeof(next_payload) ||
+        (next_header.size > 0 && fread(&next_payload, next_header.size, 1, replay_file) != 1)) {
+        replay_eof = 1;
+        return 0;
+    }
+    have_next = 1;
+    return 1;
+}
+
+// Peek past the reads made outside pid_control, returns 0 at the end of the file
+static int peek_relevant(void) {
+    while (peek_record()) {
+        if (next_header.type >= RIO_NUM_TYPES || !((1u << next_header.type) & RIO_SKIPPABLE)) {
+            return 1;
+        }
+        have_next = 0;
+    }
+    return 0;
+}
+
+// Take the next record, which must be of the given type
+static int take(RioType type, RioPayload* payload) {
+    if (replay_failed) return -1;
+    // Skippable records are passed over unless they are the ones asked for
+    while (peek_record() && next_header.type != type && next_header.type < RIO_NUM_TYPES &&
+           ((1u << next_header.type) & RIO_SKIPPABLE)) {
+        have_next = 0;
+    }
+    if (!peek_record()) {
+        replay_failed = 1;
+        snprintf(replay_message, sizeof(replay_message), "recording ended in tick %u while reading %s",
+                 replay_ticks, rio_type_name(type));
+        return -1;
+    }
+    if (next_header.type != type) {
+        replay_failed = 1;
+        snprintf(replay_message, sizeof(replay_message),
+                 "tick %u at %.6f s: the controller read %s where the recording has %s", replay_ticks,
+                 (replay_clock_us - replay_header.start_us) / 1e6, rio_type_name(type),
+                 rio_type_name(next_header.type));
+        return -1;
+    }
+    if (payload) *payload = next_payload;
+    have_next = 0;
+    return next_header.ret;
+}
+
+static void replay_begin_tick(void* ctx) {
+    RioPayload payload;
+    if (take(RIO_TICK, &payload) >= 0) {
+        replay_ticks = payload.tick;
+    }
+}
+
+static int64_t replay_now_us(void* ctx) {
+    if (take(RIO_CLOCK, NULL) >= 0) {
+        replay_clock_us = next_header.ts_us;
+    }
+    return replay_clock_us;
+}
+
+static void replay_read_line(void* ctx, int sensor_states[NUM_SENSORS]) {
+    RioPayload payload = {0};
+    take(RIO_LINE, &payload);
+    for (int i = 0; i < NUM_SENSORS; i++) {
+        sensor_states[i] = (payload.line_mask >> i) & 1;
+    }
+}
+
+static int replay_get_distances(void* ctx, double distances[NUM_SENSORS]) {
+    RioPayload payload;
+    int ret = take(RIO_DISTANCES, &payload);
+    if (ret >= 0) {
+        memcpy(distances, payload.distances, NUM_SENSORS * sizeof(double));
+    }
+    return replay_failed ? -1 : ret;
+}
+
+static int replay_read_encoders(void* ctx, int32_t counts[RIO_NUM_ENCODERS]) {
+    RioPayload payload;
+    int ret = take(RIO_ENCODERS, &payload);
+    if (ret >= 0) {
+        memcpy(counts, payload.encoders, sizeof(payload.encoders));
+    }
+    return replay_failed ? -1 : ret;
+}
+
+static int replay_read_color(void* ctx, uint16_t rgbc[4]) {
+    RioPayload payload;
+    int ret = take(RIO_COLOR, &payload);
+    if (ret >= 0) {
+        memcpy(rgbc, payload.color, sizeof(payload.color));
+    }
+    return replay_failed ? -1 : ret;
+}
+
+static void replay_motor_run(void* ctx, int left, int right) {
+    RioPayload payload;
+    if (take(RIO_MOTORS, &payload) < 0) return;
+    motor_checks++;
+    if (payload.motors[0] == left && payload.motors[1] == right) return;
+    if (report_out && motor_mismatches < (uint64_t)report_max) {
+        fprintf(report_out, "tick %u at %.6f s: motors %d %d, recorded %d %d\n", replay_ticks,
+                (replay_clock_us - replay_header.start_us) / 1e6, left, right, payload.motors[0],
+                payload.motors[1]);
+    }
+    motor_mismatches++;
+}
+
+// Parameter changes are optional records, they only appear where the recorded run saw one
+static int replay_refresh_params(void* ctx, ControlParams* params) {
+    if (replay_failed || !peek_relevant() || next_header.type != RIO_PARAMS) return 0;
+    RioPayload payload;
+    take(RIO_PARAMS, &payload);
+    *params = payload.params;
+    return 1;
+}
+
+int rio_replay_open(const char* path, RioFileHeader* header) {
+    rio_replay_close();
+    replay_file = fopen(path, "rb");
+    if (!replay_file) {
+        perror("robotio: fopen");
+        return -1;
+    }
+    if (fread(&replay_header, sizeof(replay_header), 1, replay_file) != 1 || replay_header.magic != RIO_MAGIC ||
+        replay_header.version != RIO_VERSION) {
+        fprintf(stderr, "robotio: %s is not a recording of this version\n", path);
+        fclose(replay_file);
+        replay_file = NULL;
+        return -1;
+    }
+    have_next = 0;
+    replay_eof = 0;
+    replay_failed = 0;
+    replay_message[0] = '\0';
+    replay_ticks = 0;
+    replay_clock_us = replay_header.start_us;
+    motor_checks = 0;
+    motor_mismatches = 0;
+    if (header) *header = replay_header;
+    return 0;
+}
+
+void rio_replay_close(void) {
+    if (replay_file) {
+        fclose(replay_file);
+        replay_file = NULL;
+    }
+}
+
+int rio_replay_done(void) {
+    return replay_failed || !peek_relevant();
+}
+
+uint32_t rio_replay_tick(void) {
+    return replay_ticks;
+}
+
+int64_t rio_replay_time_us(void) {
+    return replay_clock_us - replay_header.start_us;
+}
+
+uint64_t rio_replay_motor_checks(void) {
+    return motor_checks;
+}
+
+uint64_t rio_replay_mismatches(void) {
+    return motor_mismatches;
+}
+
+const char* rio_replay_error(void) {
+    return replay_failed ? replay_message : NULL;
+}
+
+void rio_replay_set_report(FILE* out, int max_reports) {
+    report_out = out;
+    report_max = max_reports;
+}
+
+const RobotIO rio_replay = {
+    .name = "replay",
+    .begin_tick = replay_begin_tick,
+    .now_us = replay_now_us,
+    .read_line = replay_read_line,
+    .get_distances = replay_get_distances,
+    .read_encoders = replay_read_encoders,
+    .read_color = replay_read_color,
+    .motor_run = replay_motor_run,
+    .refresh_params = replay_refresh_params,
+};
@@ -0,0 +1,131 @@
+/**
+Class         : CSC-615-01 - Embedded Linux - Fall 2024
+Team Name     : Wayno
+Github        : nhannguyensf
+Project       : Final Assignment - Robot Car
+File          : robotio.h
+Description:
+This file is the header file for the robotio.c file. It declares the robot I/O layer the control code uses for
+everything it reads or commands: the clock, the line sensors, the echo distances, the encoder counts, the color
+sensor, the motors and the live parameters. The calls go to a backend, the hardware on the car or a recording
+being replayed. While recording, every call is appended to a file with its timestamp, so a run can be fed back
+through pid_control on the host with a virtual clock and the motor commands compared bit for bit.
+*
+Team Members:
+Kiran Poudel
+Nhan Nguyen
+Yuvraj Gupta
+Fernando Abel Malca Luque
+
+*
+**/
+#ifndef ROBOTIO_H
+#define ROBOTIO_H
+
+#include <stdint.h>
+#include <stdio.h>
+#include "../line-sensor/line_sensor.h"
+#include "../params/params.h"
+
+#define RIO_FILE "car.rio"
+#define RIO_MAGIC 0x314f4952u  // "RIO1"
+#define RIO_VERSION 1
+#define RIO_NUM_ENCODERS 2
+
+// Kind of a recorded call
+typedef enum {
+    RIO_TICK,       // Start of a control iteration
+    RIO_CLOCK,      // Clock read, the value is the timestamp
+    RIO_LINE,       // Line sensor levels
+    RIO_DISTANCES,  // getCurrentDistances result
+    RIO_ENCODERS,   // Encoder counts
+    RIO_COLOR,      // Raw color reading
+    RIO_MOTORS,     // Motor command, the output compared on replay
+    RIO_PARAMS,     // Live parameter change
+    RIO_NUM_TYPES
+} RioType;
+
+// Reads made outside pid_control, a replay of pid_control passes over them
+#define RIO_SKIPPABLE ((1u << RIO_ENCODERS) | (1u << RIO_COLOR))
+
+// Start of a recording
+typedef struct {
+    uint32_t magic;
+    uint32_t version;
+    int64_t start_us;
+    ControlParams params;  // Parameters the run started with
+} RioFileHeader;
+
+// Every record is this header followed by size bytes of payload
+typedef struct {
+    int64_t ts_us;   // Time of the call on the run's clock
+    uint16_t type;
+    uint16_t size;
+    int32_t ret;     // Return value of the call
+} RioRecordHeader;
+
+// Payload of a record, only the member of its type is stored
+typedef union {
+    uint32_t tick;
+    uint8_t line_mask;
+    double distances[NUM_SENSORS];
+    int32_t encoders[RIO_NUM_ENCODERS];
+    uint16_t color[4];  // Red, green, blue, clear
+    int32_t motors[2];  // Left, right
+    ControlParams params;
+} RioPayload;
+
+// Backend that performs the calls
+typedef struct {
+    const char* name;
+    void (*begin_tick)(void* ctx);  // Optional
+    int64_t (*now_us)(void* ctx);
+    void (*read_line)(void* ctx, int sensor_states[NUM_SENSORS]);
+    int (*get_distances)(void* ctx, double distances[NUM_SENSORS]);
+    int (*read_encoders)(void* ctx, int32_t counts[RIO_NUM_ENCODERS]);
+    int (*read_color)(void* ctx, uint16_t rgbc[4]);
+    void (*motor_run)(void* ctx, int left, int right);
+    int (*refresh_params)(void* ctx, ControlParams* params);
+} RobotIO;
+
+extern const RobotIO rio_hardware;
+extern const RobotIO rio_replay;
+// The backend selected with rio_init, through the rio_ calls and so recorded
+extern const RobotIO rio_selected;
+
+// Select the backend and the context passed to it, must be called before the control code runs
+void rio_init(const RobotIO* io, void* ctx);
+
+// Calls used by the control code
+void rio_begin_tick(void);
+int64_t rio_now_us(void);
+void rio_read_line(int sensor_states[NUM_SENSORS]);
+int rio_get_distances(double distances[NUM_SENSORS]);
+int rio_read_encoders(int32_t counts[RIO_NUM_ENCODERS]);
+int rio_read_color(uint16_t rgbc[4]);
+void rio_motor_run(int left, int right);
+int rio_refresh_params(ControlParams* params);
+
+// Record every call to a file until rio_record_stop
+int rio_record_start(const char* path, const ControlParams* params);
+void rio_record_stop(void);
+
+// Hardware backend: handle of the color sensor, -1 while it is not open
+void rio_hw_set_color_handle(int handle);
+// Hardware backend: read both encoder counters for the following reads, which fail until the first call
+void rio_hw_poll_encoders(void);
+
+// Replay backend
+int rio_replay_open(const char* path, RioFileHeader* header);
+void rio_replay_close(void);
+int rio_replay_done(void);          // No control iteration left in the recording
+uint32_t rio_replay_tick(void);     // Iteration being replayed
+int64_t rio_replay_time_us(void);   // Recorded time of the last clock read since the start
+uint64_t rio_replay_motor_checks(void);
+uint64_t rio_replay_mismatches(void);
+const char* rio_replay_error(void); // Why the replay stopped early, NULL if it did not
+void rio_replay_set_report(FILE* out, int max_reports);
+
+const char* rio_type_name(int type);
+
+#endif
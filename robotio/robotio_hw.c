@@ -0,0 +1,85 @@
+/**
+Class         : CSC-615-01 - Embedded Linux - Fall 2024
+Team Name     : Wayno
+Github        : nhannguyensf
+Project       : Final Assignment - Robot Car
+File          : robotio_hw.c
+Description:
+This file contains the hardware backend of the robot I/O layer, a thin mapping onto the sensor and motor
+drivers of the car. Reading both encoder counters takes about 0.8 ms of bit banged SPI, so the control tick does
+not read them: rio_hw_poll_encoders reads them on its own schedule and the backend returns the counts read last.
+*
+Team Members:
+Kiran Poudel
+Nhan Nguyen
+Yuvraj Gupta
+Fernando Abel Malca Luque
+
+*
+**/
+#include "robotio.h"
+#include "../motor/MotorDriver.h"
+#include "../echoSensor/echoSensor.h"
+#include "../encoder/ls7336r.h"
+#include "../rgb/tcs34725.h"
+#include "../fsm/fsm.h"
+#include <stdbool.h>
+#include <string.h>
+
+static int color_handle = -1;
+static int32_t encoder_counts[RIO_NUM_ENCODERS];
+static bool encoders_valid = false;
+
+void rio_hw_set_color_handle(int handle) {
+    color_handle = handle;
+}
+
+void rio_hw_poll_encoders(void) {
+    encoder_counts[0] = readLS7336RCounter(SPI0_CE0);
+    encoder_counts[1] = readLS7336RCounter(SPI0_CE1);
+    encoders_valid = true;
+}
+
+static int64_t hw_now_us(void* ctx) {
+    return fsm_monotonic_us(NULL);
+}
+
+static void hw_read_line(void* ctx, int sensor_states[NUM_SENSORS]) {
+    read_line_sensors(sensor_states);
+}
+
+static int hw_get_distances(void* ctx, double distances[NUM_SENSORS]) {
+    return getCurrentDistances(distances);
+}
+
+static int hw_read_encoders(void* ctx, int32_t counts[RIO_NUM_ENCODERS]) {
+    if (!encoders_valid) return -1;
+    memcpy(counts, encoder_counts, sizeof(encoder_counts));
+    return 0;
+}
+
+static int hw_read_color(void* ctx, uint16_t rgbc[4]) {
+    if (color_handle < 0) return -1;
+    return read_color_data(color_handle, &rgbc[0], &rgbc[1], &rgbc[2], &rgbc[3]);
+}
+
+static void hw_motor_run(void* ctx, int left, int right) {
+    Motor_Run(MOTORA, left);
+    Motor_Run(MOTORB, right);
+}
+
+static int hw_refresh_params(void* ctx, ControlParams* params) {
+    return params_refresh(params);
+}
+
+const RobotIO rio_hardware = {
+    .name = "hardware",
+    .begin_tick = NULL,
+    .now_us = hw_now_us,
+    .read_line = hw_read_line,
+    .get_distances = hw_get_distances,
+    .read_encoders = hw_read_encoders,
+    .read_color = hw_read_color,
+    .motor_run = hw_motor_run,
+    .refresh_params = hw_refresh_params,
+};
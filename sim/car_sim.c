@@ -0,0 +1,254 @@
+/**
+Class         : CSC-615-01 - Embedded Linux - Fall 2024
+Team Name     : Wayno
+Github        : nhannguyensf
+Project       : Final Assignment - Robot Car
+File          : car_sim.c
+Description:
+This file runs the unmodified control code of the car on the simulated car. pid_control is called once per
+control period on the virtual clock, the encoders are read after it as the car does, and the physics is advanced
+to the next period, as fast as the CPU allows. At the end it reports the lap times, the cross track error of the
+axle center, the times the sensors lost the line and how much faster than real time the run was.
+With -W the echo sensors see the obstacles of a world file, the state changes of the avoidance sequence and the
+collisions are listed, and the car may leave the line further while it drives around them. -b casts the given
+number of echo rays from random poses in the world and reports how many the world answers per millisecond.
+-P overrides a control parameter, e.g. the maneuver times, which are tuned for the car rather than the model.
+    car_sim [-t track_file] [-w line_width] [-l laps] [-T max_seconds] [-p period_us] [-s start_cm]
+            [-o offset_cm] [-g gains_file] [-P name=value]... [-W world_file] [-b rays] [-v]
+Without -t the track is an oval of two 100 cm straights and bends of 40 cm radius. sim/examples holds the same
+oval as a track file and a room around it as a world file; make simulate drives them and fails unless the car
+completes its laps, which it does at about 0.42 cm RMS cross track error. The exit status is 0 when all laps were
+driven, 1 when the run ended early, 2 for invalid options or input files and 3 when the car stopped because its
+line search failed. A search only turns the car in place, so it fails when the avoidance sequence leaves the car
+beside the line rather than facing it, as sim/examples/post.world does with the maneuver times of the car: make
+simulate checks that this run stops within its first 30 s instead of searching until the time runs out.
+*
+Team Members:
+Kiran Poudel
+Nhan Nguyen
+Yuvraj Gupta
+Fernando Abel Malca Luque
+
+*
+**/
+#include "sim.h"
+#include "pid.h"
+#include "tlog.h"
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#define OVAL_STRAIGHT 100.0
+#define OVAL_RADIUS 40.0
+#define OFF_TRACK_CM 25.0  // The run is stopped once the car is this far from the line
+#define OFF_TRACK_AVOID_CM 80.0  // Same with obstacles, which the avoidance sequence drives around
+#define MAX_STATE_CHANGES 64     // State changes listed for a run with obstacles
+#define MAX_OVERRIDES 16
+#define SEARCH_FAILED_STATE "LINE_SEARCH_FAILED"  // The controller stopped the car after a failed line search
+
+static int64_t now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (int64_t)ts.tv_sec * 1000000000LL + ts.tv_nsec;
+}
+
+// Apply a name=value override to the parameters, -1 for an unknown name or an out of range value
+static int apply_override(ControlParams* params, const char* arg) {
+    char name[64];
+    const char* eq = strchr(arg, '=');
+    if (!eq || eq == arg || (size_t)(eq - arg) >= sizeof(name)) return -1;
+    memcpy(name, arg, eq - arg);
+    name[eq - arg] = '\0';
+    int index = params_find(name);
+    if (index < 0) return -1;
+    return params_set_field(params, index, atof(eq + 1));
+}
+
+// Cast rays from random points of the world in random directions and report the rate
+static void bench_rays(World* world, long count) {
+    unsigned seed = 1;
+    double span_x = world->width * WORLD_CELL_CM, span_y = world->height * WORLD_CELL_CM;
+    double sum = 0;
+    int64_t start = now_ns();
+    for (long i = 0; i < count; i++) {
+        double x = world->origin_x + span_x * rand_r(&seed) / RAND_MAX;
+        double y = world->origin_y + span_y * rand_r(&seed) / RAND_MAX;
+        double angle = 6.283185307 * rand_r(&seed) / RAND_MAX;
+        sum += world_cast(world, x, y, angle, SIM_ECHO_MAX_CM, NULL);
+    }
+    double ms = (now_ns() - start) / 1e6;
+    printf("Cast %ld rays in %.2f ms: %.0f rays/ms, mean range %.1f cm\n", count, ms, ms > 0 ? count / ms : 0.0,
+           count ? sum / count : 0.0);
+}
+
+int main(int argc, char* argv[]) {
+    const char* track_file = NULL;
+    const char* gains_file = NULL;
+    const char* world_file = NULL;
+    long bench = 0;
+    const char* overrides[MAX_OVERRIDES];
+    int num_overrides = 0;
+    double line_width = TRACK_LINE_WIDTH_CM;
+    int laps = 3;
+    double max_seconds = 120.0;
+    long period_us = 10000;
+    double start = NAN;
+    double offset = 0.0;
+    int verbose = 0;
+    int opt;
+    while ((opt = getopt(argc, argv, "t:w:l:T:p:s:o:g:P:W:b:v")) != -1) {
+        switch (opt) {
+            case 't': track_file = optarg; break;
+            case 'w': line_width = atof(optarg); break;
+            case 'l': laps = atoi(optarg); break;
+            case 'T': max_seconds = atof(optarg); break;
+            case 'p': period_us = atol(optarg); break;
+            case 's': start = atof(optarg); break;
+            case 'o': offset = atof(optarg); break;
+            case 'g': gains_file = optarg; break;
+            case 'P':
+                if (num_overrides == MAX_OVERRIDES) {
+                    fprintf(stderr, "At most %d overrides\n", MAX_OVERRIDES);
+                    return 2;
+                }
+                overrides[num_overrides++] = optarg;
+                break;
+            case 'W': world_file = optarg; break;
+            case 'b': bench = atol(optarg); break;
+            case 'v': verbose = 1; break;
+            default:
+                fprintf(stderr, "Usage: %s [-t track_file] [-w line_width] [-l laps] [-T max_seconds] "
+                                "[-p period_us] [-s start_cm] [-o offset_cm] [-g gains_file] [-P name=value]... "
+                                "[-W world_file] [-b rays] [-v]\n", argv[0]);
+                return 2;
+        }
+    }
+    if (period_us <= 0 || laps <= 0 || max_seconds <= 0) {
+        fprintf(stderr, "period, laps and time must be positive\n");
+        return 2;
+    }
+    if (bench > 0 && !world_file) {
+        fprintf(stderr, "-b needs a world to cast the rays in\n");
+        return 2;
+    }
+
+    Track track;
+    if (track_file ? track_load(&track, track_file, line_width) < 0
+                   : track_oval(&track, OVAL_STRAIGHT, OVAL_RADIUS, line_width) < 0) {
+        fprintf(stderr, "Could not build the track\n");
+        return 2;
+    }
+    // The oval starts in the middle of its bottom straight
+    if (isnan(start)) {
+        start = track_file ? 0.0 : track.length - OVAL_STRAIGHT / 2;
+    }
+
+    World world;
+    if (world_file && world_load(&world, world_file) < 0) {
+        fprintf(stderr, "Could not load the world\n");
+        track_free(&track);
+        return 2;
+    }
+    if (world_file && bench > 0) {
+        bench_rays(&world, bench);
+    }
+
+    SimModel model;
+    Sim sim;
+    sim_default_model(&model);
+    sim_init(&sim, &track, &model, start, offset);
+    if (world_file) {
+        sim_set_world(&sim, &world);
+    }
+
+    // The controller's messages are only shown with -v
+    if (!verbose && tlog_init("/dev/null", 0) < 0) {
+        fprintf(stderr, "Could not silence the control messages\n");
+    }
+    rio_init(&sim_io, &sim);
+    if (gains_file && pid_load_gains(gains_file) < 0) {
+        fprintf(stderr, "Could not read %s, using the default gains\n", gains_file);
+    }
+    ControlParams params;
+    pid_get_params(&params);
+    for (int i = 0; i < num_overrides; i++) {
+        if (apply_override(&params, overrides[i]) < 0) {
+            fprintf(stderr, "Invalid override %s, unknown parameter or value out of range\n", overrides[i]);
+            return 2;
+        }
+    }
+    pid_set_params(&params);
+
+    const SimStats* stats = &sim.stats;
+    const SimCar* car = &sim.car;
+    int64_t max_us = (int64_t)(max_seconds * 1e6);
+    int64_t wall_start = now_ns();
+    int off_track = 0;
+    double off_track_cm = world_file ? OFF_TRACK_AVOID_CM : OFF_TRACK_CM;
+    const char* state_names[FR_MAX_STATES];
+    int num_states = pid_state_names(state_names, FR_MAX_STATES);
+    int search_failed_state = -1;
+    for (int i = 0; i < num_states; i++) {
+        if (strcmp(state_names[i], SEARCH_FAILED_STATE) == 0) search_failed_state = i;
+    }
+    int last_state = -1;
+    int state_changes = 0;
+    int search_failed = 0;
+    while (stats->laps < laps && car->time_us < max_us) {
+        pid_control();
+        int32_t counts[RIO_NUM_ENCODERS];
+        rio_read_encoders(counts);
+        FrRecord rec;
+        pid_record(&rec);
+        if (world_file && rec.state != last_state && rec.state < num_states && state_changes++ < MAX_STATE_CHANGES) {
+            printf("%8.2f s  %-20s front %6.1f  left %6.1f  right %6.1f cm\n", car->time_us / 1e6,
+                   state_names[rec.state], rec.distances[1], rec.distances[0], rec.distances[2]);
+        }
+        last_state = rec.state;
+        // Nothing moves the car back onto the line in the simulator
+        if (rec.state == search_failed_state) {
+            search_failed = 1;
+            break;
+        }
+        sim_advance(&sim, period_us);
+        if (stats->error_max > off_track_cm) {
+            off_track = 1;
+            break;
+        }
+    }
+    double wall_s = (now_ns() - wall_start) / 1e9;
+    sim_finish(&sim);
+    tlog_shutdown();
+
+    double sim_s = car->time_us / 1e6;
+    printf("Track %s: %.1f cm, line %.1f cm wide\n", track_file ? track_file : "oval", track.length, line_width);
+    for (int i = 0; i < stats->laps && i < (int)(sizeof(stats->lap_times) / sizeof(stats->lap_times[0])); i++) {
+        printf("  Lap %d: %.2f s\n", i + 1, stats->lap_times[i]);
+    }
+    printf("Simulated %.2f s in %.3f s (%.0fx real time), %.1f cm along the track\n", sim_s, wall_s,
+           wall_s > 0 ? sim_s / wall_s : 0.0, stats->progress);
+    printf("Cross track error: %.3f cm RMS, %.3f cm max\n",
+           stats->samples ? sqrt(stats->error_sq_sum / stats->samples) : 0.0, stats->error_max);
+    printf("Line lost %d times, %.2f s in total, longest %.2f s\n", stats->line_losses, stats->line_lost_s,
+           stats->longest_loss_s);
+    int32_t counts[RIO_NUM_ENCODERS];
+    sim_io.read_encoders(&sim, counts);
+    printf("Encoders: left %d, right %d counts\n", counts[0], counts[1]);
+    if (world_file) {
+        printf("World %s: %d primitives, %llu pings, %llu rays, %d collisions\n", world_file, world.num_primitives,
+               (unsigned long long)stats->pings, (unsigned long long)stats->rays, stats->collisions);
+        world_free(&world);
+    }
+    if (off_track) {
+        printf("The car left the track at %.2f s\n", sim_s);
+    }
+    if (search_failed) {
+        printf("The line search gave up at %.2f s, the car stopped\n", sim_s);
+    }
+    track_free(&track);
+    if (search_failed) return 3;
+    return stats->laps >= laps ? 0 : 1;
+}
@@ -0,0 +1,306 @@
+/**
+Class         : CSC-615-01 - Embedded Linux - Fall 2024
+Team Name     : Wayno
+Github        : nhannguyensf
+Project       : Final Assignment - Robot Car
+File          : sim.c
+Description:
+This file contains the simulated car. The motor commands are turned into the duty cycle the PCA9685 actually
+produces (pulse * 40 - 1 out of 4096), and each wheel approaches the speed of that duty cycle with the motor time
+constant. The ground under a wheel can only follow it within the traction limit, the difference is wheel slip.
+The car moves with the ground speeds of its wheels, while the encoders count what the wheels turned. The physics
+runs in SIM_STEP_US steps between control iterations, and the statistics are taken once per control period.
+The echo sensors follow the poll thread of echoSensor.c on the physics clock: a ping is cast from the pose at its
+trigger, its echo pulse is measured the way getDistance polls it, and the distance is published when the ping
+ends, then the thread sleeps before the next sensor. The control code thus sees readings as stale as on the car.
+*
+Team Members:
+Kiran Poudel
+Nhan Nguyen
+Yuvraj Gupta
+Fernando Abel Malca Luque
+
+*
+**/
+#include "sim.h"
+#include <math.h>
+#include <string.h>
+
+#ifndef M_PI
+#define M_PI 3.14159265358979323846
+#endif
+
+static const SimEchoMount echo_mounts[SIM_ECHO_NUM_MOUNTS] = {
+    {6.0, 6.5, 90.0}, {12.0, 0.0, 0.0}, {6.0, -6.5, -90.0},
+};
+
+void sim_default_model(SimModel* out) {
+    out->wheel_base = SIM_WHEEL_BASE_CM;
+    out->full_speed = SIM_FULL_SPEED_CM_S;
+    out->dead_band = SIM_DEAD_BAND;
+    out->motor_tau = SIM_MOTOR_TAU_S;
+    out->max_accel = SIM_MAX_ACCEL_CM_S2;
+}
+
+void sim_init(Sim* sim, const Track* sim_track, const SimModel* sim_model, double start_arc, double offset) {
+    sim->track = sim_track;
+    sim->model = *sim_model;
+    memset(&sim->car, 0, sizeof(sim->car));
+    memset(&sim->stats, 0, sizeof(sim->stats));
+    double x, y, heading;
+    track_point(sim->track, start_arc, &x, &y, &heading);
+    sim->car.x = x - offset * sin(heading);
+    sim->car.y = y + offset * cos(heading);
+    sim->car.heading = heading;
+    track_project(sim->track, sim->car.x, sim->car.y, &sim->last_arc);
+    sim->last_lap_s = 0;
+    sim->line_lost = 0;
+    sim->colliding = 0;
+    sim->world = NULL;
+}
+
+void sim_set_world(Sim* sim, World* sim_world) {
+    sim->world = sim_world;
+    // The poll thread starts with the left sensor; until a sensor is pinged its reading is 0, as on the car
+    memset(sim->echo_distances, 0, sizeof(sim->echo_distances));
+    sim->echo_sensor = 0;
+    sim->echo_in_flight = 0;
+    sim->echo_start_us = sim->car.time_us;
+}
+
+// Wheel speed the PCA9685 duty cycle of a command drives the motor to
+static double commanded_speed(const Sim* sim, int command) {
+    int pulse = command < 0 ? -command : command;
+    if (pulse > 100) pulse = 100;
+    if (pulse == 0) return 0.0;  // PCA9685_SetPwmDutyCycle sets the full off bit
+    double duty = (pulse * (4096 / 100) - 1) / 4096.0;
+    if (duty <= sim->model.dead_band) return 0.0;
+    double speed = (duty - sim->model.dead_band) / (1.0 - sim->model.dead_band) * sim->model.full_speed;
+    return command < 0 ? -speed : speed;
+}
+
+// Move the ground speed towards the wheel speed within the traction limit
+static double traction(const Sim* sim, double ground, double wheel, double dt) {
+    double limit = sim->model.max_accel * dt;
+    double change = wheel - ground;
+    if (change > limit) change = limit;
+    if (change < -limit) change = -limit;
+    return ground + change;
+}
+
+static void step(Sim* sim, double dt) {
+    double lag = dt / sim->model.motor_tau;
+    sim->car.wheel_left += (commanded_speed(sim, sim->car.command_left) - sim->car.wheel_left) * lag;
+    sim->car.wheel_right += (commanded_speed(sim, sim->car.command_right) - sim->car.wheel_right) * lag;
+    sim->car.ground_left = traction(sim, sim->car.ground_left, sim->car.wheel_left, dt);
+    sim->car.ground_right = traction(sim, sim->car.ground_right, sim->car.wheel_right, dt);
+    sim->car.travel_left += sim->car.wheel_left * dt;
+    sim->car.travel_right += sim->car.wheel_right * dt;
+
+    double v = (sim->car.ground_left + sim->car.ground_right) / 2.0;
+    double w = (sim->car.ground_right - sim->car.ground_left) / sim->model.wheel_base;
+    sim->car.x += v * cos(sim->car.heading) * dt;
+    sim->car.y += v * sin(sim->car.heading) * dt;
+    sim->car.heading += w * dt;
+}
+
+void sim_line_sensors(const Sim* sim, int sensor_states[NUM_SENSORS]) {
+    double c = cos(sim->car.heading), s = sin(sim->car.heading);
+    double bar_x = sim->car.x + LINE_SENSOR_LOOKAHEAD_CM * c;
+    double bar_y = sim->car.y + LINE_SENSOR_LOOKAHEAD_CM * s;
+    for (int i = 0; i < NUM_SENSORS; i++) {
+        double left = (i - (NUM_SENSORS - 1) / 2.0) * LINE_SENSOR_SPACING_CM;
+        double x = bar_x - left * s;
+        double y = bar_y + left * c;
+        sensor_states[i] = track_coverage(sim->track, x, y, LINE_SENSOR_SPOT_CM) >= 0.5;
+    }
+}
+
+// Time from the trigger until a wait loop of getDistance that polls every SIM_ECHO_POLL_US sees an edge
+static int64_t polled(int64_t edge_us) {
+    return (edge_us + SIM_ECHO_POLL_US - 1) / SIM_ECHO_POLL_US * SIM_ECHO_POLL_US;
+}
+
+double sim_echo_ping(Sim* sim, int sensor, int64_t* duration_us) {
+    const SimEchoMount* mount = &echo_mounts[sensor];
+    double c = cos(sim->car.heading), s = sin(sim->car.heading);
+    double x = sim->car.x + mount->forward * c - mount->left * s;
+    double y = sim->car.y + mount->forward * s + mount->left * c;
+    double axis = sim->car.heading + mount->angle * M_PI / 180.0;
+    double half = SIM_ECHO_HALF_ANGLE_DEG * M_PI / 180.0;
+    double max_incidence = SIM_ECHO_MAX_INCIDENCE_DEG * M_PI / 180.0;
+
+    // The first echo back is the closest surface in the beam that reflects towards the sensor
+    double range = INFINITY;
+    for (int i = 0; i < SIM_ECHO_RAYS; i++) {
+        double angle = axis - half + 2.0 * half * i / (SIM_ECHO_RAYS - 1);
+        double incidence;
+        double d = world_cast(sim->world, x, y, angle, SIM_ECHO_MAX_CM, &incidence);
+        if (d < SIM_ECHO_MAX_CM && incidence <= max_incidence && d < range) range = d;
+    }
+    sim->stats.pings++;
+    sim->stats.rays += SIM_ECHO_RAYS;
+    if (range < SIM_ECHO_MIN_CM) range = SIM_ECHO_MIN_CM;
+    int64_t pulse_us = isinf(range) ? SIM_ECHO_NO_ECHO_US : (int64_t)llround(2.0 * range / SIM_SOUND_CM_PER_US);
+
+    // The trigger pulse takes one poll, then each wait loop gives up after SIM_ECHO_POLL_LIMIT polls
+    int64_t timeout_us = (int64_t)SIM_ECHO_POLL_LIMIT * SIM_ECHO_POLL_US;
+    int64_t rise_us = polled(SIM_ECHO_BURST_US);
+    if (rise_us >= timeout_us) {
+        *duration_us = SIM_ECHO_POLL_US + timeout_us;
+        return -1;
+    }
+    int64_t fall_us = polled(SIM_ECHO_BURST_US + pulse_us);
+    if (fall_us - rise_us >= timeout_us) {
+        *duration_us = SIM_ECHO_POLL_US + rise_us + timeout_us;
+        return -1;
+    }
+    *duration_us = SIM_ECHO_POLL_US + fall_us;
+    return (fall_us - rise_us) * SIM_SOUND_CM_PER_US / 2.0;
+}
+
+// Run the poll thread of echoSensor.c up to the current time
+static void update_echo(Sim* sim) {
+    for (;;) {
+        if (!sim->echo_in_flight) {
+            if (sim->car.time_us < sim->echo_start_us) return;
+            int64_t duration_us;
+            sim->echo_reading = sim_echo_ping(sim, sim->echo_sensor, &duration_us);
+            sim->echo_done_us = sim->echo_start_us + duration_us;
+            sim->echo_in_flight = 1;
+        }
+        if (sim->car.time_us < sim->echo_done_us) return;
+        sim->echo_distances[sim->echo_sensor] = sim->echo_reading;
+        sim->echo_in_flight = 0;
+        sim->echo_start_us = sim->echo_done_us + SIM_ECHO_PING_GAP_US;
+        if (++sim->echo_sensor == SIM_ECHO_NUM_MOUNTS) {
+            sim->echo_sensor = 0;
+            sim->echo_start_us += SIM_ECHO_CYCLE_GAP_US;
+        }
+    }
+}
+
+static void update_collisions(Sim* sim) {
+    double x = sim->car.x + SIM_CAR_FORWARD_CM * cos(sim->car.heading);
+    double y = sim->car.y + SIM_CAR_FORWARD_CM * sin(sim->car.heading);
+    int hit = world_collides(sim->world, x, y, SIM_CAR_RADIUS_CM);
+    if (hit && !sim->colliding) sim->stats.collisions++;
+    sim->colliding = hit;
+}
+
+static void end_line_loss(Sim* sim, double now_s) {
+    double lost = now_s - sim->loss_start_s;
+    sim->line_lost = 0;
+    sim->stats.line_lost_s += lost;
+    if (lost > sim->stats.longest_loss_s) sim->stats.longest_loss_s = lost;
+}
+
+static void update_stats(Sim* sim) {
+    double now_s = sim->car.time_us / 1e6;
+    double arc;
+    double error = track_project(sim->track, sim->car.x, sim->car.y, &arc);
+    sim->stats.error_sq_sum += error * error;
+    if (fabs(error) > sim->stats.error_max) sim->stats.error_max = fabs(error);
+    sim->stats.samples++;
+
+    // Progress along the track, wrapping at the start line
+    double delta = arc - sim->last_arc;
+    if (delta > sim->track->length / 2) delta -= sim->track->length;
+    if (delta < -sim->track->length / 2) delta += sim->track->length;
+    sim->stats.progress += delta;
+    sim->last_arc = arc;
+    while (sim->stats.progress >= (sim->stats.laps + 1) * sim->track->length) {
+        if (sim->stats.laps < (int)(sizeof(sim->stats.lap_times) / sizeof(sim->stats.lap_times[0]))) {
+            sim->stats.lap_times[sim->stats.laps] = now_s - sim->last_lap_s;
+        }
+        sim->last_lap_s = now_s;
+        sim->stats.laps++;
+    }
+
+    int sensors[NUM_SENSORS];
+    sim_line_sensors(sim, sensors);
+    int any = 0;
+    for (int i = 0; i < NUM_SENSORS; i++) any |= sensors[i];
+    if (!any && !sim->line_lost) {
+        sim->line_lost = 1;
+        sim->loss_start_s = now_s;
+        sim->stats.line_losses++;
+    } else if (any && sim->line_lost) {
+        end_line_loss(sim, now_s);
+    }
+}
+
+void sim_advance(Sim* sim, int64_t period_us) {
+    for (int64_t t = 0; t < period_us; t += SIM_STEP_US) {
+        int64_t step_us = period_us - t < SIM_STEP_US ? period_us - t : SIM_STEP_US;
+        step(sim, step_us / 1e6);
+        sim->car.time_us += step_us;
+        if (sim->world) update_echo(sim);
+    }
+    if (sim->world) update_collisions(sim);
+    update_stats(sim);
+}
+
+void sim_finish(Sim* sim) {
+    if (sim->line_lost) {
+        end_line_loss(sim, sim->car.time_us / 1e6);
+    }
+}
+
+// ---- Robot I/O backend ----
+
+static int64_t sim_now_us(void* ctx) {
+    Sim* sim = ctx;
+    return sim->car.time_us;
+}
+
+// Latest published readings, like getCurrentDistances; without a world every echo times out
+static void sim_read_line(void* ctx, int sensor_states[NUM_SENSORS]) {
+    sim_line_sensors(ctx, sensor_states);
+}
+
+static int sim_get_distances(void* ctx, double distances[NUM_SENSORS]) {
+    Sim* sim = ctx;
+    for (int i = 0; i < NUM_SENSORS; i++) {
+        distances[i] = -1;
+    }
+    if (sim->world) {
+        for (int i = 0; i < SIM_ECHO_NUM_MOUNTS; i++) {
+            distances[i] = sim->echo_distances[i];
+        }
+    }
+    return 0;
+}
+
+static int sim_read_encoders(void* ctx, int32_t counts[RIO_NUM_ENCODERS]) {
+    Sim* sim = ctx;
+    counts[0] = (int32_t)llround(sim->car.travel_left / SIM_WHEEL_CIRCUMFERENCE * SIM_COUNTS_PER_REVOLUTION);
+    counts[1] = (int32_t)llround(sim->car.travel_right / SIM_WHEEL_CIRCUMFERENCE * SIM_COUNTS_PER_REVOLUTION);
+    return 0;
+}
+
+static int sim_read_color(void* ctx, uint16_t rgbc[4]) {
+    return -1;
+}
+
+static void sim_motor_run(void* ctx, int left, int right) {
+    Sim* sim = ctx;
+    sim->car.command_left = left;
+    sim->car.command_right = right;
+}
+
+static int sim_refresh_params(void* ctx, ControlParams* params) {
+    return 0;
+}
+
+const RobotIO sim_io = {
+    .name = "sim",
+    .begin_tick = NULL,
+    .now_us = sim_now_us,
+    .read_line = sim_read_line,
+    .get_distances = sim_get_distances,
+    .read_encoders = sim_read_encoders,
+    .read_color = sim_read_color,
+    .motor_run = sim_motor_run,
+    .refresh_params = sim_refresh_params,
+};
@@ -0,0 +1,151 @@
+/**
+Class         : CSC-615-01 - Embedded Linux - Fall 2024
+Team Name     : Wayno
+Github        : nhannguyensf
+Project       : Final Assignment - Robot Car
+File          : sim.h
+Description:
+This file is the header file for the sim.c file. It declares the simulated car: a differential drive whose
+wheels follow the PCA9685 duty cycle through a dead band and a first order motor lag, with the traction limit of
+the tires letting the wheels slip under hard acceleration. The five line sensors see the rasterized track under
+their spots, and the LS7366R counts follow the wheel rotation, slip included. In a world of obstacles the three
+HC-SR04 sensors are pinged one after the other on the schedule of the echo thread, each ping casting rays across
+its beam; the reading shows up when getDistance would return it, quantized by its polling loop. sim_io is the
+robot I/O backend that lets the unmodified control code drive the simulated car on a virtual clock. Each Sim is
+its own car, so several controllers can each drive one on their own thread. A World is not shared: casting rays
+stamps its primitives.
+*
+Team Members:
+Kiran Poudel
+Nhan Nguyen
+Yuvraj Gupta
+Fernando Abel Malca Luque
+
+*
+**/
+#ifndef SIM_H
+#define SIM_H
+
+#include <stdint.h>
+#include "track.h"
+#include "world.h"
+#include "../echoSensor/echoSensor.h"
+#include "../robotio/robotio.h"
+
+#define SIM_STEP_US 1000  // Physics time step
+
+// Encoder geometry of encoder/motor.h, which needs pigpio and is not built on the host
+#define SIM_COUNTS_PER_REVOLUTION 540
+#define SIM_WHEEL_CIRCUMFERENCE (3.141592654 * 6.5)
+
+// HC-SR04 and the getDistance loops of echoSensor.c
+#define SIM_ECHO_HALF_ANGLE_DEG 15.0     // Half the beam opening
+#define SIM_ECHO_RAYS 7                  // Rays cast across the beam per ping
+#define SIM_ECHO_MIN_CM 2.0
+#define SIM_ECHO_MAX_CM 400.0
+#define SIM_ECHO_MAX_INCIDENCE_DEG 60.0  // Surfaces hit more obliquely reflect the burst away
+#define SIM_SOUND_CM_PER_US 0.0343
+#define SIM_ECHO_BURST_US 460            // Trigger to rising echo, the 40 kHz burst and the module's processing
+#define SIM_ECHO_NO_ECHO_US 38000        // Echo pulse of a ping that heard nothing
+#define SIM_ECHO_POLL_US 60              // One usleep(1) of the wait loops, timer slack included
+#define SIM_ECHO_POLL_LIMIT 10000        // Iterations before a wait loop gives up and returns -1
+#define SIM_ECHO_PING_GAP_US 20000       // Sleep after each ping
+#define SIM_ECHO_CYCLE_GAP_US 10000      // Extra sleep after the three pings
+
+// Defaults of the car model, sim_default_model
+#define SIM_WHEEL_BASE_CM 14.0
+#define SIM_FULL_SPEED_CM_S 52.0         // Wheel speed at 100 % duty cycle
+#define SIM_DEAD_BAND 0.08
+#define SIM_MOTOR_TAU_S 0.08
+#define SIM_MAX_ACCEL_CM_S2 250.0
+
+#define SIM_CAR_FORWARD_CM 4.0           // The body is a disk centered this far ahead of the axle
+#define SIM_CAR_RADIUS_CM 11.0
+
+// Where the HC-SR04 sensors sit on the car, in the order of sensorPins in echoSensor.c (left, front, right)
+#define SIM_ECHO_NUM_MOUNTS 3
+
+typedef struct {
+    double forward;           // Ahead of the axle center (cm)
+    double left;              // To the left of the axle center (cm)
+    double angle;             // Degrees to the left of straight ahead
+} SimEchoMount;
+
+// Physical parameters of the car
+typedef struct {
+    double wheel_base;        // Distance between the wheels (cm)
+    double full_speed;        // Wheel speed at 100 % duty cycle (cm/s)
+    double dead_band;         // Duty cycle fraction below which the motors do not turn
+    double motor_tau;         // Motor time constant (s)
+    double max_accel;         // Largest ground acceleration the tires transmit (cm/s^2)
+} SimModel;
+
+// State of the car
+typedef struct {
+    double x, y, heading;     // Axle center (cm) and direction (rad)
+    double wheel_left;        // Speed of the wheel surfaces (cm/s), what the encoders see
+    double wheel_right;
+    double ground_left;       // Speed of the wheels over the floor (cm/s)
+    double ground_right;
+    double travel_left;       // Wheel surface travel (cm)
+    double travel_right;
+    int command_left;         // Last duty cycle commands (percent)
+    int command_right;
+    int64_t time_us;
+} SimCar;
+
+// Statistics of a run
+typedef struct {
+    int laps;
+    double lap_times[64];     // Seconds per lap
+    double progress;          // Distance driven along the track (cm)
+    double error_sq_sum;      // Cross track error samples of the axle center
+    double error_max;
+    uint64_t samples;
+    int line_losses;          // Times all five sensors lost the line
+    double line_lost_s;       // Total time without the line
+    double longest_loss_s;
+    int collisions;           // Times the body ran into an obstacle
+    uint64_t pings;           // Simulated echo pings and the rays cast for them
+    uint64_t rays;
+} SimStats;
+
+// One simulated car, instances are independent of each other
+typedef struct {
+    const Track* track;
+    SimModel model;
+    SimCar car;
+    SimStats stats;
+    World* world;                 // Obstacles, NULL without
+    double last_arc;              // Progress and line losses
+    double last_lap_s;
+    int line_lost;
+    double loss_start_s;
+    int colliding;
+    // Echo poll thread
+    double echo_distances[SIM_ECHO_NUM_MOUNTS];
+    int echo_sensor;              // Sensor pinged now or next
+    int echo_in_flight;
+    int64_t echo_start_us;        // Trigger of the next ping
+    int64_t echo_done_us;         // End of the ping in flight
+    double echo_reading;
+} Sim;
+
+void sim_default_model(SimModel* model);
+// Place the car on the track at a distance along it, offset to the left of the line
+void sim_init(Sim* sim, const Track* track, const SimModel* model, double start_arc, double offset);
+// Obstacles the echo sensors see, NULL leaves the sensors unconnected so every read times out; set after sim_init
+void sim_set_world(Sim* sim, World* world);
+// Advance the physics by one control period and update the statistics
+void sim_advance(Sim* sim, int64_t period_us);
+// Close a line loss still open at the end of the run, call before reading the final statistics
+void sim_finish(Sim* sim);
+// Sensor levels the car sees right now
+void sim_line_sensors(const Sim* sim, int sensor_states[NUM_SENSORS]);
+// Distance one ping of an echo sensor would report from the current pose, -1 on a timeout
+double sim_echo_ping(Sim* sim, int sensor, int64_t* duration_us);
+
+// Robot I/O backend, the context is the Sim
+extern const RobotIO sim_io;
+
+#endif
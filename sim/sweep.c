@@ -0,0 +1,396 @@
+/**
+Class         : CSC-615-01 - Embedded Linux - Fall 2024
+Team Name     : Wayno
+Github        : nhannguyensf
+Project       : Final Assignment - Robot Car
+File          : sweep.c
+Description:
+This file runs batches of simulated laps to tune the control parameters. Every configuration is a set of
+parameter values, driven by its own controller on its own simulated car over every track, and the configurations
+are shared out to one worker thread per core. A configuration is scored by its lap time (the mean lap time on
+each track, summed over the tracks) and its stability (the worst RMS cross track error on any track). The output
+ranks them by each and lists the Pareto front, the configurations no other one beats on both.
+    sweep [-j workers] [-n samples] [-S seed] [-r name=min:max[:steps]]... [-t track]... [-W world_file]
+          [-l laps] [-T max_seconds] [-p period_us] [-k top] [-o results.csv]
+When every -r range has a number of steps the sweep runs the full grid, otherwise -n random samples of the
+ranges. A track is a track file or oval:straight:radius; the default tracks are oval:100:40 and oval:60:25.
+A configuration fails if the car does not finish its laps in time or leaves the line by more than 25 cm, 80 cm
+in a world with obstacles.
+*
+Team Members:
+Kiran Poudel
+Nhan Nguyen
+Yuvraj Gupta
+Fernando Abel Malca Luque
+
+*
+**/
+#include "sim.h"
+#include "pid.h"
+#include "tlog.h"
+#include <math.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#define MAX_RANGES 8
+#define MAX_TRACKS 8
+#define MAX_WORKERS 64
+#define MAX_CONFIGS 1000000
+#define OFF_TRACK_CM 25.0
+#define OFF_TRACK_AVOID_CM 80.0  // With obstacles, which the avoidance sequence drives around
+
+// Range of one swept parameter
+typedef struct {
+    int index;          // Parameter number in params.c
+    double min;
+    double max;
+    int steps;          // Grid points, 0 to sample uniformly
+} Range;
+
+// Outcome of one configuration
+typedef struct {
+    double values[MAX_RANGES];
+    int failed;         // Track number + 1 of the first track it failed on
+    double lap_time;    // Sum over the tracks of the mean lap time (s)
+    double rms;         // Worst RMS cross track error (cm)
+    double error_max;
+    int line_losses;
+} Result;
+
+static Range ranges[MAX_RANGES];
+static int num_ranges = 0;
+static Track tracks[MAX_TRACKS];
+static double starts[MAX_TRACKS];
+static const char* track_names[MAX_TRACKS];
+static int num_tracks = 0;
+static const char* world_file = NULL;
+static int laps = 2;
+static int64_t max_us = 60000000;
+static long period_us = 10000;
+
+static Result* results = NULL;
+static int num_configs = 0;
+static _Atomic int next_config = 0;
+
+static int64_t now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (int64_t)ts.tv_sec * 1000000000LL + ts.tv_nsec;
+}
+
+// name=min:max[:steps]
+static int parse_range(const char* arg, Range* range) {
+    char name[64];
+    const char* eq = strchr(arg, '=');
+    if (!eq || eq == arg || (size_t)(eq - arg) >= sizeof(name)) return -1;
+    memcpy(name, arg, eq - arg);
+    name[eq - arg] = '\0';
+    range->index = params_find(name);
+    range->steps = 0;
+    int n = sscanf(eq + 1, "%lf:%lf:%d", &range->min, &range->max, &range->steps);
+    if (range->index < 0 || n < 2 || range->max < range->min || range->steps < 0) return -1;
+    // Every value of the range must be one the parameter accepts
+    if (params_check(range->index, range->min) < 0 || params_check(range->index, range->max) < 0) return -1;
+    return 0;
+}
+
+// A track file or oval:straight:radius; the oval starts in the middle of its bottom straight
+static int load_track(const char* spec, Track* track, double* start) {
+    double straight, radius;
+    if (sscanf(spec, "oval:%lf:%lf", &straight, &radius) == 2) {
+        if (track_oval(track, straight, radius, TRACK_LINE_WIDTH_CM) < 0) return -1;
+        *start = track->length - straight / 2;
+        return 0;
+    }
+    *start = 0.0;
+    return track_load(track, spec, TRACK_LINE_WIDTH_CM);
+}
+
+// Drive one configuration over every track
+static void run_config(Result* result, World* world) {
+    // The defaults of a new controller with the swept values
+    Controller ctl;
+    controller_init(&ctl, &sim_io, NULL);
+    ControlParams params = ctl.params;
+    for (int i = 0; i < num_ranges; i++) {
+        params_set_field(&params, ranges[i].index, result->values[i]);
+    }
+
+    SimModel model;
+    sim_default_model(&model);
+    double off_track_cm = world ? OFF_TRACK_AVOID_CM : OFF_TRACK_CM;
+    for (int t = 0; t < num_tracks && !result->failed; t++) {
+        Sim sim;
+        sim_init(&sim, &tracks[t], &model, starts[t], 0.0);
+        if (world) {
+            sim_set_world(&sim, world);
+        }
+        controller_init(&ctl, &sim_io, &sim);
+        controller_set_params(&ctl, &params);
+        while (sim.stats.laps < laps && sim.car.time_us < max_us && sim.stats.error_max <= off_track_cm) {
+            controller_tick(&ctl);
+            sim_advance(&sim, period_us);
+        }
+        sim_finish(&sim);
+        if (sim.stats.laps < laps) {
+            result->failed = t + 1;
+            break;
+        }
+        double lap_sum = 0;
+        for (int i = 0; i < laps; i++) {
+            lap_sum += sim.stats.lap_times[i];
+        }
+        double rms = sqrt(sim.stats.error_sq_sum / sim.stats.samples);
+        result->lap_time += lap_sum / laps;
+        if (rms > result->rms) result->rms = rms;
+        if (sim.stats.error_max > result->error_max) result->error_max = sim.stats.error_max;
+        result->line_losses += sim.stats.line_losses;
+    }
+}
+
+static void* worker(void* arg) {
+    World world;
+    World* own_world = NULL;
+    // Casting rays writes to the world, so every worker loads its own copy
+    if (world_file && world_load(&world, world_file) == 0) {
+        own_world = &world;
+    }
+    for (;;) {
+        int i = atomic_fetch_add(&next_config, 1);
+        if (i >= num_configs) break;
+        run_config(&results[i], own_world);
+    }
+    if (own_world) {
+        world_free(own_world);
+    }
+    return NULL;
+}
+
+// Fill the parameter values of every configuration, the grid when every range has steps
+static int make_configs(int samples, unsigned seed) {
+    int grid = num_ranges > 0;
+    long count = 1;
+    for (int i = 0; i < num_ranges; i++) {
+        if (ranges[i].steps == 0) grid = 0;
+        else count *= ranges[i].steps;
+        if (count > MAX_CONFIGS) count = MAX_CONFIGS + 1;
+    }
+    if (!grid) count = num_ranges > 0 ? samples : 1;
+    if (count > MAX_CONFIGS) {
+        fprintf(stderr, "More than %d configurations\n", MAX_CONFIGS);
+        return -1;
+    }
+    num_configs = (int)count;
+    results = calloc(num_configs, sizeof(Result));
+    if (!results) return -1;
+
+    for (int c = 0; c < num_configs; c++) {
+        int rest = c;
+        for (int i = 0; i < num_ranges; i++) {
+            const Range* r = &ranges[i];
+            if (grid) {
+                int step = rest % r->steps;
+                rest /= r->steps;
+                results[c].values[i] = r->steps > 1 ? r->min + (r->max - r->min) * step / (r->steps - 1) : r->min;
+            } else {
+                results[c].values[i] = r->min + (r->max - r->min) * rand_r(&seed) / (double)RAND_MAX;
+            }
+        }
+    }
+    return 0;
+}
+
+static int by_lap_time(const void* a, const void* b) {
+    const Result* x = *(const Result* const*)a;
+    const Result* y = *(const Result* const*)b;
+    if (x->lap_time != y->lap_time) return x->lap_time < y->lap_time ? -1 : 1;
+    return x->rms < y->rms ? -1 : x->rms > y->rms;
+}
+
+static int by_rms(const void* a, const void* b) {
+    const Result* x = *(const Result* const*)a;
+    const Result* y = *(const Result* const*)b;
+    if (x->rms != y->rms) return x->rms < y->rms ? -1 : 1;
+    return x->lap_time < y->lap_time ? -1 : x->lap_time > y->lap_time;
+}
+
+static void print_header(FILE* out) {
+    for (int i = 0; i < num_ranges; i++) {
+        fprintf(out, " %14s", params_info(ranges[i].index)->name);
+    }
+    fprintf(out, " %9s %9s %9s %6s\n", "lap s", "rms cm", "max cm", "lost");
+}
+
+static void print_result(FILE* out, const Result* r) {
+    for (int i = 0; i < num_ranges; i++) {
+        fprintf(out, " %14.7g", r->values[i]);
+    }
+    fprintf(out, " %9.3f %9.3f %9.3f %6d\n", r->lap_time, r->rms, r->error_max, r->line_losses);
+}
+
+static int write_csv(const char* path) {
+    FILE* out = fopen(path, "w");
+    if (!out) {
+        perror("sweep: fopen");
+        return -1;
+    }
+    for (int i = 0; i < num_ranges; i++) {
+        fprintf(out, "%s,", params_info(ranges[i].index)->name);
+    }
+    fprintf(out, "failed_track,lap_time_s,rms_cm,max_cm,line_losses\n");
+    for (int c = 0; c < num_configs; c++) {
+        const Result* r = &results[c];
+        for (int i = 0; i < num_ranges; i++) {
+            fprintf(out, "%.6g,", r->values[i]);
+        }
+        fprintf(out, "%d,%.4f,%.4f,%.4f,%d\n", r->failed, r->lap_time, r->rms, r->error_max, r->line_losses);
+    }
+    return fclose(out);
+}
+
+int main(int argc, char* argv[]) {
+    long cores = sysconf(_SC_NPROCESSORS_ONLN);
+    int workers = cores > 0 ? (int)cores : 1;
+    int samples = 200;
+    unsigned seed = 1;
+    int top = 5;
+    double max_seconds = 60.0;
+    const char* csv_file = NULL;
+    const char* track_specs[MAX_TRACKS];
+    int num_specs = 0;
+    int opt;
+    while ((opt = getopt(argc, argv, "j:n:S:r:t:W:l:T:p:k:o:")) != -1) {
+        switch (opt) {
+            case 'j': workers = atoi(optarg); break;
+            case 'n': samples = atoi(optarg); break;
+            case 'S': seed = (unsigned)strtoul(optarg, NULL, 10); break;
+            case 'r':
+                if (num_ranges == MAX_RANGES || parse_range(optarg, &ranges[num_ranges]) < 0) {
+                    fprintf(stderr, "Invalid range %s, at most %d of name=min:max[:steps] within the range of the parameter\n", optarg, MAX_RANGES);
+                    return 2;
+                }
+                num_ranges++;
+                break;
+            case 't':
+                if (num_specs == MAX_TRACKS) {
+                    fprintf(stderr, "At most %d tracks\n", MAX_TRACKS);
+                    return 2;
+                }
+                track_specs[num_specs++] = optarg;
+                break;
+            case 'W': world_file = optarg; break;
+            case 'l': laps = atoi(optarg); break;
+            case 'T': max_seconds = atof(optarg); break;
+            case 'p': period_us = atol(optarg); break;
+            case 'k': top = atoi(optarg); break;
+            case 'o': csv_file = optarg; break;
+            default:
+                fprintf(stderr, "Usage: %s [-j workers] [-n samples] [-S seed] [-r name=min:max[:steps]]... "
+                                "[-t track]... [-W world_file] [-l laps] [-T max_seconds] [-p period_us] "
+                                "[-k top] [-o results.csv]\n", argv[0]);
+                return 2;
+        }
+    }
+    int max_laps = (int)(sizeof(((SimStats*)0)->lap_times) / sizeof(double));
+    if (workers <= 0 || samples <= 0 || laps <= 0 || laps > max_laps || max_seconds <= 0 || period_us <= 0) {
+        fprintf(stderr, "workers, samples, time and period must be positive and laps between 1 and %d\n", max_laps);
+        return 2;
+    }
+    if (workers > MAX_WORKERS) workers = MAX_WORKERS;
+    max_us = (int64_t)(max_seconds * 1e6);
+
+    if (num_specs == 0) {
+        track_specs[num_specs++] = "oval:100:40";
+        track_specs[num_specs++] = "oval:60:25";
+    }
+    for (num_tracks = 0; num_tracks < num_specs; num_tracks++) {
+        track_names[num_tracks] = track_specs[num_tracks];
+        if (load_track(track_specs[num_tracks], &tracks[num_tracks], &starts[num_tracks]) < 0) {
+            fprintf(stderr, "Could not build the track %s\n", track_specs[num_tracks]);
+            return 2;
+        }
+    }
+    if (make_configs(samples, seed) < 0) {
+        return 2;
+    }
+    if (workers > num_configs) workers = num_configs;
+
+    // The controllers' messages would only slow the workers down
+    if (tlog_init("/dev/null", 0) < 0) {
+        fprintf(stderr, "Could not silence the control messages\n");
+    }
+    printf("%d configurations on %d tracks, %d laps each, %d workers\n", num_configs, num_tracks, laps, workers);
+    int64_t start = now_ns();
+    pthread_t threads[MAX_WORKERS];
+    int started = 0;
+    for (int i = 0; i < workers; i++) {
+        pthread_attr_t attr;
+        pthread_attr_init(&attr);
+        pthread_attr_setinheritsched(&attr, PTHREAD_EXPLICIT_SCHED);
+        pthread_attr_setschedpolicy(&attr, SCHED_OTHER);
+        if (pthread_create(&threads[started], &attr, worker, NULL) == 0) {
+            started++;
+        }
+        pthread_attr_destroy(&attr);
+    }
+    if (started == 0) {
+        worker(NULL);
+    }
+    for (int i = 0; i < started; i++) {
+        pthread_join(threads[i], NULL);
+    }
+    double wall_s = (now_ns() - start) / 1e9;
+    tlog_shutdown();
+
+    // Rank the configurations that finished every track
+    Result** ranked = malloc(num_configs * sizeof(Result*));
+    if (!ranked) return 2;
+    int num_ranked = 0;
+    for (int c = 0; c < num_configs; c++) {
+        if (!results[c].failed) ranked[num_ranked++] = &results[c];
+    }
+    printf("%d runs in %.2f s (%.0f runs/s), %d configurations failed\n", num_configs * num_tracks, wall_s,
+           wall_s > 0 ? num_configs * num_tracks / wall_s : 0.0, num_configs - num_ranked);
+    for (int t = 0; t < num_tracks; t++) {
+        printf("  Track %d: %s, %.1f cm\n", t + 1, track_names[t], tracks[t].length);
+    }
+    int shown = top < num_ranked ? top : num_ranked;
+
+    qsort(ranked, num_ranked, sizeof(Result*), by_rms);
+    printf("\nMost stable:\n");
+    print_header(stdout);
+    for (int i = 0; i < shown; i++) print_result(stdout, ranked[i]);
+
+    qsort(ranked, num_ranked, sizeof(Result*), by_lap_time);
+    printf("\nFastest:\n");
+    print_header(stdout);
+    for (int i = 0; i < shown; i++) print_result(stdout, ranked[i]);
+
+    // In lap time order, a configuration is on the front when it is steadier than every faster one
+    printf("\nPareto front of lap time and stability:\n");
+    print_header(stdout);
+    double best_rms = INFINITY;
+    for (int i = 0; i < num_ranked; i++) {
+        if (ranked[i]->rms < best_rms) {
+            best_rms = ranked[i]->rms;
+            print_result(stdout, ranked[i]);
+        }
+    }
+
+    int status = 0;
+    if (csv_file && write_csv(csv_file) != 0) {
+        fprintf(stderr, "Could not write %s\n", csv_file);
+        status = 1;
+    }
+    free(ranked);
+    free(results);
+    for (int t = 0; t < num_tracks; t++) {
+        track_free(&tracks[t]);
+    }
+    return num_ranked > 0 ? status : 1;
+}
@@ -0,0 +1,232 @@
+/**
+Class         : CSC-615-01 - Embedded Linux - Fall 2024
+Team Name     : Wayno
+Github        : nhannguyensf
+Project       : Final Assignment - Robot Car
+File          : track.c
+Description:
+This file contains the track model of the simulator: loading a polyline, rasterizing it at TRACK_CELL_CM with the
+width of the tape, and projecting a point onto the center line.
+*
+Team Members:
+Kiran Poudel
+Nhan Nguyen
+Yuvraj Gupta
+Fernando Abel Malca Luque
+
+*
+**/
+#include "track.h"
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifndef M_PI
+#define M_PI 3.14159265358979323846
+#endif
+
+// Distance from a point to the segment of points i and i + 1, t is the position along the segment
+static double segment_distance(const Track* track, int i, double px, double py, double* t) {
+    int j = (i + 1) % track->num_points;
+    double dx = track->x[j] - track->x[i];
+    double dy = track->y[j] - track->y[i];
+    double len2 = dx * dx + dy * dy;
+    double u = len2 > 0 ? ((px - track->x[i]) * dx + (py - track->y[i]) * dy) / len2 : 0.0;
+    if (u < 0) u = 0;
+    if (u > 1) u = 1;
+    if (t) *t = u;
+    double cx = track->x[i] + u * dx - px;
+    double cy = track->y[i] + u * dy - py;
+    return sqrt(cx * cx + cy * cy);
+}
+
+// Mark every cell within half the line width of a segment
+static void rasterize_segment(Track* track, int i) {
+    int j = (i + 1) % track->num_points;
+    double half = track->line_width / 2.0;
+    double min_x = fmin(track->x[i], track->x[j]) - half;
+    double max_x = fmax(track->x[i], track->x[j]) + half;
+    double min_y = fmin(track->y[i], track->y[j]) - half;
+    double max_y = fmax(track->y[i], track->y[j]) + half;
+    int c0 = (int)floor((min_x - track->origin_x) / TRACK_CELL_CM);
+    int c1 = (int)ceil((max_x - track->origin_x) / TRACK_CELL_CM);
+    int r0 = (int)floor((min_y - track->origin_y) / TRACK_CELL_CM);
+    int r1 = (int)ceil((max_y - track->origin_y) / TRACK_CELL_CM);
+    for (int r = r0 < 0 ? 0 : r0; r <= r1 && r < track->height; r++) {
+        for (int c = c0 < 0 ? 0 : c0; c <= c1 && c < track->width; c++) {
+            double px = track->origin_x + (c + 0.5) * TRACK_CELL_CM;
+            double py = track->origin_y + (r + 0.5) * TRACK_CELL_CM;
+            if (segment_distance(track, i, px, py, NULL) <= half) {
+                track->cells[(size_t)r * track->width + c] = 1;
+            }
+        }
+    }
+}
+
+// Compute the distances along the track and the raster once the points are set, frees the track on a failure
+static int track_build(Track* track, double line_width) {
+    track->line_width = line_width;
+    track->arc = malloc(track->num_points * sizeof(double));
+    if (!track->arc) {
+        track_free(track);
+        return -1;
+    }
+
+    double min_x = track->x[0], max_x = track->x[0], min_y = track->y[0], max_y = track->y[0];
+    track->length = 0;
+    for (int i = 0; i < track->num_points; i++) {
+        int j = (i + 1) % track->num_points;
+        track->arc[i] = track->length;
+        track->length += hypot(track->x[j] - track->x[i], track->y[j] - track->y[i]);
+        min_x = fmin(min_x, track->x[i]);
+        max_x = fmax(max_x, track->x[i]);
+        min_y = fmin(min_y, track->y[i]);
+        max_y = fmax(max_y, track->y[i]);
+    }
+
+    track->origin_x = min_x - TRACK_MARGIN_CM;
+    track->origin_y = min_y - TRACK_MARGIN_CM;
+    track->width = (int)ceil((max_x - min_x + 2 * TRACK_MARGIN_CM) / TRACK_CELL_CM);
+    track->height = (int)ceil((max_y - min_y + 2 * TRACK_MARGIN_CM) / TRACK_CELL_CM);
+    track->cells = calloc((size_t)track->width * track->height, 1);
+    if (!track->cells) {
+        track_free(track);
+        return -1;
+    }
+    for (int i = 0; i < track->num_points; i++) {
+        rasterize_segment(track, i);
+    }
+    return 0;
+}
+
+static int track_alloc(Track* track, int num_points) {
+    memset(track, 0, sizeof(*track));
+    track->x = malloc(num_points * sizeof(double));
+    track->y = malloc(num_points * sizeof(double));
+    if (!track->x || !track->y) {
+        track_free(track);
+        return -1;
+    }
+    return 0;
+}
+
+int track_load(Track* track, const char* path, double line_width) {
+    FILE* file = fopen(path, "r");
+    if (!file) {
+        perror("track: fopen");
+        return -1;
+    }
+    if (track_alloc(track, TRACK_MAX_POINTS) < 0) {
+        fclose(file);
+        return -1;
+    }
+
+    char line[128];
+    while (fgets(line, sizeof(line), file)) {
+        double x, y;
+        if (line[0] == '#' || sscanf(line, "%lf %lf", &x, &y) != 2) continue;
+        if (track->num_points == TRACK_MAX_POINTS) {
+            fprintf(stderr, "track: more than %d points in %s\n", TRACK_MAX_POINTS, path);
+            fclose(file);
+            track_free(track);
+            return -1;
+        }
+        track->x[track->num_points] = x;
+        track->y[track->num_points] = y;
+        track->num_points++;
+    }
+    fclose(file);
+    if (track->num_points < 3) {
+        fprintf(stderr, "track: %s needs at least 3 points\n", path);
+        track_free(track);
+        return -1;
+    }
+    return track_build(track, line_width);
+}
+
+int track_oval(Track* track, double straight, double radius, double line_width) {
+    // One point per cm of arc on the bends
+    int bend_points = (int)ceil(M_PI * radius);
+    if (track_alloc(track, 2 * bend_points + 2) < 0) return -1;
+    int n = 0;
+    // Right bend then left bend, counter clockwise; the straights join their ends
+    for (int half = 0; half < 2; half++) {
+        double cx = half == 0 ? straight : 0.0;
+        double start = half == 0 ? -M_PI / 2 : M_PI / 2;
+        for (int i = 0; i <= bend_points; i++) {
+            double a = start + M_PI * i / bend_points;
+            track->x[n] = cx + radius * cos(a);
+            track->y[n] = radius + radius * sin(a);
+            n++;
+        }
+    }
+    track->num_points = n;
+    return track_build(track, line_width);
+}
+
+void track_free(Track* track) {
+    free(track->x);
+    free(track->y);
+    free(track->arc);
+    free(track->cells);
+    memset(track, 0, sizeof(*track));
+}
+
+int track_on_line(const Track* track, double x, double y) {
+    int c = (int)floor((x - track->origin_x) / TRACK_CELL_CM);
+    int r = (int)floor((y - track->origin_y) / TRACK_CELL_CM);
+    if (c < 0 || r < 0 || c >= track->width || r >= track->height) return 0;
+    return track->cells[(size_t)r * track->width + c];
+}
+
+double track_coverage(const Track* track, double x, double y, double diameter) {
+    double radius = diameter / 2.0;
+    int steps = (int)ceil(radius / TRACK_CELL_CM);
+    int inside = 0, covered = 0;
+    for (int i = -steps; i <= steps; i++) {
+        for (int j = -steps; j <= steps; j++) {
+            double dx = i * TRACK_CELL_CM, dy = j * TRACK_CELL_CM;
+            if (dx * dx + dy * dy > radius * radius) continue;
+            inside++;
+            covered += track_on_line(track, x + dx, y + dy);
+        }
+    }
+    return inside ? (double)covered / inside : (double)track_on_line(track, x, y);
+}
+
+double track_project(const Track* track, double x, double y, double* arc) {
+    double best = INFINITY, best_t = 0;
+    int best_i = 0;
+    for (int i = 0; i < track->num_points; i++) {
+        double t;
+        double d = segment_distance(track, i, x, y, &t);
+        if (d < best) {
+            best = d;
+            best_t = t;
+            best_i = i;
+        }
+    }
+    int j = (best_i + 1) % track->num_points;
+    double dx = track->x[j] - track->x[best_i];
+    double dy = track->y[j] - track->y[best_i];
+    if (arc) *arc = track->arc[best_i] + best_t * hypot(dx, dy);
+    // Left of the direction of travel when the cross product is positive
+    double cross = dx * (y - track->y[best_i]) - dy * (x - track->x[best_i]);
+    return cross >= 0 ? best : -best;
+}
+
+void track_point(const Track* track, double arc, double* x, double* y, double* heading) {
+    arc = fmod(arc, track->length);
+    if (arc < 0) arc += track->length;
+    int i = 0;
+    while (i + 1 < track->num_points && track->arc[i + 1] <= arc) i++;
+    int j = (i + 1) % track->num_points;
+    double dx = track->x[j] - track->x[i];
+    double dy = track->y[j] - track->y[i];
+    double len = hypot(dx, dy);
+    double t = len > 0 ? (arc - track->arc[i]) / len : 0.0;
+    *x = track->x[i] + t * dx;
+    *y = track->y[i] + t * dy;
+    *heading = atan2(dy, dx);
+}
@@ -0,0 +1,62 @@
+/**
+Class         : CSC-615-01 - Embedded Linux - Fall 2024
+Team Name     : Wayno
+Github        : nhannguyensf
+Project       : Final Assignment - Robot Car
+File          : track.h
+Description:
+This file is the header file for the track.c file. A track is a closed polyline along the center of the tape,
+in cm. It is rasterized once into a grid of cells covered by the tape, so the line sensors only do table lookups,
+and the polyline itself is used to measure how far along the track the car is and how far off the line it is.
+A track file has one "x y" point per line, lines starting with # are comments and the last point connects back
+to the first.
+*
+Team Members:
+Kiran Poudel
+Nhan Nguyen
+Yuvraj Gupta
+Fernando Abel Malca Luque
+
+*
+**/
+#ifndef TRACK_H
+#define TRACK_H
+
+#include <stdint.h>
+
+#define TRACK_LINE_WIDTH_CM 1.9   // Electrical tape
+#define TRACK_CELL_CM 0.1         // Raster resolution
+#define TRACK_MARGIN_CM 30.0      // Floor kept around the line
+#define TRACK_MAX_POINTS 4096
+
+typedef struct {
+    int num_points;
+    double* x;
+    double* y;
+    double* arc;          // Distance along the track at each point
+    double length;
+    double line_width;
+    // Raster of the tape
+    double origin_x;
+    double origin_y;
+    int width;
+    int height;
+    uint8_t* cells;       // 1 where the floor is covered by the tape
+} Track;
+
+int track_load(Track* track, const char* path, double line_width);
+// Oval of two straights joined by half circles
+int track_oval(Track* track, double straight, double radius, double line_width);
+void track_free(Track* track);
+
+// 1 when the point is on the tape, points outside the raster are floor
+int track_on_line(const Track* track, double x, double y);
+// Fraction of a disk covered by the tape
+double track_coverage(const Track* track, double x, double y, double diameter);
+// Closest point of the center line: returns the signed distance to it, positive when the point is to the left
+// of the direction of travel, and stores the distance along the track of the closest point in arc
+double track_project(const Track* track, double x, double y, double* arc);
+// Point and direction of travel at a distance along the track
+void track_point(const Track* track, double arc, double* x, double* y, double* heading);
+
+#endif
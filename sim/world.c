@@ -0,0 +1,348 @@
+/**
+Class         : CSC-615-01 - Embedded Linux - Fall 2024
+Team Name     : Wayno
+Github        : nhannguyensf
+Project       : Final Assignment - Robot Car
+File          : world.c
+Description:
+This file contains the obstacle world of the simulator. The primitives are binned once into a uniform grid of
+WORLD_CELL_CM cells, and a ray walks the grid cell by cell (Amanatides and Woo), testing only the primitives
+binned in the cells it crosses. A primitive spanning several cells is tested once per ray thanks to its stamp,
+and the walk stops as soon as the closest hit lies within the current cell.
+*
+Team Members:
+Kiran Poudel
+Nhan Nguyen
+Yuvraj Gupta
+Fernando Abel Malca Luque
+
+*
+**/
+#include "world.h"
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifndef M_PI
+#define M_PI 3.14159265358979323846
+#endif
+
+// Distance from a point to a wall
+static double wall_distance(const WorldPrimitive* p, double px, double py) {
+    double dx = p->x2 - p->x1;
+    double dy = p->y2 - p->y1;
+    double len2 = dx * dx + dy * dy;
+    double u = len2 > 0 ? ((px - p->x1) * dx + (py - p->y1) * dy) / len2 : 0.0;
+    if (u < 0) u = 0;
+    if (u > 1) u = 1;
+    return hypot(p->x1 + u * dx - px, p->y1 + u * dy - py);
+}
+
+// Distance from a point to the outline of a primitive, 0 inside a circle
+static double primitive_distance(const WorldPrimitive* p, double px, double py) {
+    if (p->shape == WORLD_CIRCLE) {
+        double d = hypot(px - p->x1, py - p->y1) - p->radius;
+        return d > 0 ? d : 0.0;
+    }
+    return wall_distance(p, px, py);
+}
+
+// Cells touched by the bounding box of a primitive
+static void primitive_cells(const World* world, const WorldPrimitive* p, int* c0, int* c1, int* r0, int* r1) {
+    double min_x, max_x, min_y, max_y;
+    if (p->shape == WORLD_CIRCLE) {
+        min_x = p->x1 - p->radius;
+        max_x = p->x1 + p->radius;
+        min_y = p->y1 - p->radius;
+        max_y = p->y1 + p->radius;
+    } else {
+        min_x = fmin(p->x1, p->x2);
+        max_x = fmax(p->x1, p->x2);
+        min_y = fmin(p->y1, p->y2);
+        max_y = fmax(p->y1, p->y2);
+    }
+    *c0 = (int)floor((min_x - world->origin_x) / WORLD_CELL_CM);
+    *c1 = (int)floor((max_x - world->origin_x) / WORLD_CELL_CM);
+    *r0 = (int)floor((min_y - world->origin_y) / WORLD_CELL_CM);
+    *r1 = (int)floor((max_y - world->origin_y) / WORLD_CELL_CM);
+    if (*c0 < 0) *c0 = 0;
+    if (*r0 < 0) *r0 = 0;
+    if (*c1 >= world->width) *c1 = world->width - 1;
+    if (*r1 >= world->height) *r1 = world->height - 1;
+}
+
+// A wall is only binned in the cells it passes through, a circle in every cell of its bounding box
+static int primitive_in_cell(const World* world, const WorldPrimitive* p, int c, int r) {
+    if (p->shape == WORLD_CIRCLE) return 1;
+    const double half_diagonal = WORLD_CELL_CM * 0.7072;
+    double cx = world->origin_x + (c + 0.5) * WORLD_CELL_CM;
+    double cy = world->origin_y + (r + 0.5) * WORLD_CELL_CM;
+    return wall_distance(p, cx, cy) <= half_diagonal;
+}
+
+// Bin the primitives into the grid: count the items of each cell, then fill them in
+static int world_build(World* world) {
+    double min_x = 0, max_x = 0, min_y = 0, max_y = 0;
+    for (int i = 0; i < world->num_primitives; i++) {
+        const WorldPrimitive* p = &world->primitives[i];
+        double lo_x = p->shape == WORLD_CIRCLE ? p->x1 - p->radius : fmin(p->x1, p->x2);
+        double hi_x = p->shape == WORLD_CIRCLE ? p->x1 + p->radius : fmax(p->x1, p->x2);
+        double lo_y = p->shape == WORLD_CIRCLE ? p->y1 - p->radius : fmin(p->y1, p->y2);
+        double hi_y = p->shape == WORLD_CIRCLE ? p->y1 + p->radius : fmax(p->y1, p->y2);
+        if (i == 0 || lo_x < min_x) min_x = lo_x;
+        if (i == 0 || hi_x > max_x) max_x = hi_x;
+        if (i == 0 || lo_y < min_y) min_y = lo_y;
+        if (i == 0 || hi_y > max_y) max_y = hi_y;
+    }
+    world->origin_x = min_x - WORLD_CELL_CM;
+    world->origin_y = min_y - WORLD_CELL_CM;
+    world->width = world->num_primitives ? (int)ceil((max_x - min_x) / WORLD_CELL_CM) + 2 : 0;
+    world->height = world->num_primitives ? (int)ceil((max_y - min_y) / WORLD_CELL_CM) + 2 : 0;
+
+    size_t num_cells = (size_t)world->width * world->height;
+    world->first = calloc(num_cells + 1, sizeof(int));
+    world->stamps = calloc(world->num_primitives + 1, sizeof(uint32_t));
+    if (!world->first || !world->stamps) return -1;
+
+    for (int pass = 0; pass < 2; pass++) {
+        for (int i = 0; i < world->num_primitives; i++) {
+            const WorldPrimitive* p = &world->primitives[i];
+            int c0, c1, r0, r1;
+            primitive_cells(world, p, &c0, &c1, &r0, &r1);
+            for (int r = r0; r <= r1; r++) {
+                for (int c = c0; c <= c1; c++) {
+                    if (!primitive_in_cell(world, p, c, r)) continue;
+                    size_t cell = (size_t)r * world->width + c;
+                    if (pass == 0) {
+                        world->first[cell + 1]++;
+                    } else {
+                        world->items[world->first[cell]++] = i;
+                    }
+                }
+            }
+        }
+        if (pass == 0) {
+            for (size_t cell = 0; cell < num_cells; cell++) {
+                world->first[cell + 1] += world->first[cell];
+            }
+            world->items = malloc((world->first[num_cells] + 1) * sizeof(int));
+            if (!world->items) return -1;
+        } else {
+            // Filling moved each start to the end of its cell, shift them back
+            for (size_t cell = num_cells; cell > 0; cell--) {
+                world->first[cell] = world->first[cell - 1];
+            }
+            world->first[0] = 0;
+        }
+    }
+    world->ray_count = 0;
+    return 0;
+}
+
+static int add_primitive(World* world, WorldPrimitive p) {
+    if (world->num_primitives == WORLD_MAX_PRIMITIVES) {
+        fprintf(stderr, "world: more than %d primitives\n", WORLD_MAX_PRIMITIVES);
+        return -1;
+    }
+    world->primitives[world->num_primitives++] = p;
+    return 0;
+}
+
+static int add_wall(World* world, double x1, double y1, double x2, double y2) {
+    WorldPrimitive p = {WORLD_WALL, x1, y1, x2, y2, 0.0};
+    return add_primitive(world, p);
+}
+
+int world_load(World* world, const char* path) {
+    memset(world, 0, sizeof(*world));
+    FILE* file = fopen(path, "r");
+    if (!file) {
+        perror("world: fopen");
+        return -1;
+    }
+    world->primitives = malloc(WORLD_MAX_PRIMITIVES * sizeof(WorldPrimitive));
+    if (!world->primitives) {
+        fclose(file);
+        return -1;
+    }
+
+    char line[128];
+    int line_number = 0;
+    int result = 0;
+    while (result == 0 && fgets(line, sizeof(line), file)) {
+        line_number++;
+        char kind[16];
+        double a, b, c, d, e;
+        if (line[0] == '#' || sscanf(line, "%15s", kind) != 1) continue;
+        if (strcmp(kind, "circle") == 0 && sscanf(line, "%*s %lf %lf %lf", &a, &b, &c) == 3 && c > 0) {
+            WorldPrimitive p = {WORLD_CIRCLE, a, b, a, b, c};
+            result = add_primitive(world, p);
+        } else if (strcmp(kind, "wall") == 0 && sscanf(line, "%*s %lf %lf %lf %lf", &a, &b, &c, &d) == 4) {
+            result = add_wall(world, a, b, c, d);
+        } else if (strcmp(kind, "box") == 0 && sscanf(line, "%*s %lf %lf %lf %lf %lf", &a, &b, &c, &d, &e) == 5) {
+            // Corners of the rotated box, joined by four walls
+            double ca = cos(e * M_PI / 180.0), sa = sin(e * M_PI / 180.0);
+            double hx[4] = {-c / 2, c / 2, c / 2, -c / 2};
+            double hy[4] = {-d / 2, -d / 2, d / 2, d / 2};
+            double x[4], y[4];
+            for (int k = 0; k < 4; k++) {
+                x[k] = a + hx[k] * ca - hy[k] * sa;
+                y[k] = b + hx[k] * sa + hy[k] * ca;
+            }
+            for (int k = 0; k < 4 && result == 0; k++) {
+                result = add_wall(world, x[k], y[k], x[(k + 1) % 4], y[(k + 1) % 4]);
+            }
+        } else {
+            fprintf(stderr, "world: %s:%d: cannot parse \"%s\"\n", path, line_number, kind);
+            result = -1;
+        }
+    }
+    fclose(file);
+    if (result == 0) result = world_build(world);
+    if (result < 0) world_free(world);
+    return result;
+}
+
+void world_free(World* world) {
+    free(world->primitives);
+    free(world->stamps);
+    free(world->first);
+    free(world->items);
+    memset(world, 0, sizeof(*world));
+}
+
+// Distance along a ray to a primitive, INFINITY when it is missed; nx, ny is the surface normal at the hit
+static double intersect(const WorldPrimitive* p, double x, double y, double dx, double dy, double* nx, double* ny) {
+    if (p->shape == WORLD_CIRCLE) {
+        double ox = x - p->x1, oy = y - p->y1;
+        double b = ox * dx + oy * dy;
+        double c = ox * ox + oy * oy - p->radius * p->radius;
+        if (c <= 0) {
+            // Starting inside the circle
+            *nx = -dx;
+            *ny = -dy;
+            return 0.0;
+        }
+        double disc = b * b - c;
+        if (b > 0 || disc < 0) return INFINITY;
+        double t = -b - sqrt(disc);
+        *nx = (ox + t * dx) / p->radius;
+        *ny = (oy + t * dy) / p->radius;
+        return t;
+    }
+    double ex = p->x2 - p->x1, ey = p->y2 - p->y1;
+    double denom = dx * ey - dy * ex;
+    if (denom == 0) return INFINITY;  // Parallel to the wall
+    double wx = p->x1 - x, wy = p->y1 - y;
+    double t = (wx * ey - wy * ex) / denom;
+    double u = (wx * dy - wy * dx) / denom;
+    if (t < 0 || u < 0 || u > 1) return INFINITY;
+    double len = hypot(ex, ey);
+    *nx = -ey / len;
+    *ny = ex / len;
+    return t;
+}
+
+// Next ray stamp; the stamps are cleared when the counter wraps
+static uint32_t next_ray(World* world) {
+    if (++world->ray_count == 0) {
+        memset(world->stamps, 0, world->num_primitives * sizeof(uint32_t));
+        world->ray_count = 1;
+    }
+    return world->ray_count;
+}
+
+double world_cast(World* world, double x, double y, double angle, double max_range, double* incidence) {
+    double dx = cos(angle), dy = sin(angle);
+    if (incidence) *incidence = 0.0;
+    if (world->num_primitives == 0) return max_range;
+
+    // Clip the ray to the grid
+    double grid_w = world->width * WORLD_CELL_CM, grid_h = world->height * WORLD_CELL_CM;
+    double lx = x - world->origin_x, ly = y - world->origin_y;
+    double t_enter = 0.0, t_leave = max_range;
+    double start[2] = {lx, ly}, dir[2] = {dx, dy}, size[2] = {grid_w, grid_h};
+    for (int axis = 0; axis < 2; axis++) {
+        if (dir[axis] == 0) {
+            if (start[axis] < 0 || start[axis] >= size[axis]) return max_range;
+            continue;
+        }
+        double t0 = (0 - start[axis]) / dir[axis];
+        double t1 = (size[axis] - start[axis]) / dir[axis];
+        if (t0 > t1) {
+            double swap = t0;
+            t0 = t1;
+            t1 = swap;
+        }
+        if (t0 > t_enter) t_enter = t0;
+        if (t1 < t_leave) t_leave = t1;
+    }
+    if (t_enter >= t_leave) return max_range;
+
+    // Cell of the entry point and the distances to the next cell boundaries
+    int c = (int)floor((lx + t_enter * dx) / WORLD_CELL_CM);
+    int r = (int)floor((ly + t_enter * dy) / WORLD_CELL_CM);
+    if (c < 0) c = 0;
+    if (r < 0) r = 0;
+    if (c >= world->width) c = world->width - 1;
+    if (r >= world->height) r = world->height - 1;
+    int step_c = dx > 0 ? 1 : -1;
+    int step_r = dy > 0 ? 1 : -1;
+    double delta_c = dx != 0 ? WORLD_CELL_CM / fabs(dx) : INFINITY;
+    double delta_r = dy != 0 ? WORLD_CELL_CM / fabs(dy) : INFINITY;
+    double next_c = dx != 0 ? ((c + (dx > 0)) * WORLD_CELL_CM - lx) / dx : INFINITY;
+    double next_r = dy != 0 ? ((r + (dy > 0)) * WORLD_CELL_CM - ly) / dy : INFINITY;
+
+    uint32_t ray = next_ray(world);
+    double best = max_range, best_nx = 0, best_ny = 0;
+    for (;;) {
+        size_t cell = (size_t)r * world->width + c;
+        for (int k = world->first[cell]; k < world->first[cell + 1]; k++) {
+            int i = world->items[k];
+            if (world->stamps[i] == ray) continue;
+            world->stamps[i] = ray;
+            double nx = 0, ny = 0;
+            double t = intersect(&world->primitives[i], x, y, dx, dy, &nx, &ny);
+            if (t < best) {
+                best = t;
+                best_nx = nx;
+                best_ny = ny;
+            }
+        }
+        double cell_exit = next_c < next_r ? next_c : next_r;
+        if (best <= cell_exit || cell_exit >= t_leave) break;
+        if (next_c < next_r) {
+            c += step_c;
+            next_c += delta_c;
+        } else {
+            r += step_r;
+            next_r += delta_r;
+        }
+        if (c < 0 || r < 0 || c >= world->width || r >= world->height) break;
+    }
+    if (incidence && best < max_range) {
+        *incidence = acos(fmin(1.0, fabs(dx * best_nx + dy * best_ny)));
+    }
+    return best;
+}
+
+int world_collides(World* world, double x, double y, double radius) {
+    if (world->num_primitives == 0) return 0;
+    WorldPrimitive disk = {WORLD_CIRCLE, x, y, x, y, radius};
+    int c0, c1, r0, r1;
+    primitive_cells(world, &disk, &c0, &c1, &r0, &r1);
+    uint32_t ray = next_ray(world);
+    for (int r = r0; r <= r1; r++) {
+        for (int c = c0; c <= c1; c++) {
+            size_t cell = (size_t)r * world->width + c;
+            for (int k = world->first[cell]; k < world->first[cell + 1]; k++) {
+                int i = world->items[k];
+                if (world->stamps[i] == ray) continue;
+                world->stamps[i] = ray;
+                if (primitive_distance(&world->primitives[i], x, y) <= radius) return 1;
+            }
+        }
+    }
+    return 0;
+}
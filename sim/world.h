@@ -0,0 +1,67 @@
+/**
+Class         : CSC-615-01 - Embedded Linux - Fall 2024
+Team Name     : Wayno
+Github        : nhannguyensf
+Project       : Final Assignment - Robot Car
+File          : world.h
+Description:
+This file is the header file for the world.c file. The world holds the obstacles of a simulation as primitives
+(circles for posts and cans, walls as line segments, rotated boxes as four walls) in a uniform grid, so a ray only
+tests the primitives of the cells it passes through. A world file has one primitive per line, in cm and degrees:
+    circle x y radius
+    wall x1 y1 x2 y2
+    box center_x center_y width height angle
+Lines starting with # are comments.
+*
+Team Members:
+Kiran Poudel
+Nhan Nguyen
+Yuvraj Gupta
+Fernando Abel Malca Luque
+
+*
+**/
+#ifndef WORLD_H
+#define WORLD_H
+
+#include <stdint.h>
+
+#define WORLD_CELL_CM 10.0
+#define WORLD_MAX_PRIMITIVES 1024
+
+typedef enum {
+    WORLD_CIRCLE,
+    WORLD_WALL
+} WorldShape;
+
+typedef struct {
+    WorldShape shape;
+    double x1, y1;    // Circle center, or wall start
+    double x2, y2;    // Wall end
+    double radius;
+} WorldPrimitive;
+
+typedef struct {
+    int num_primitives;
+    WorldPrimitive* primitives;
+    uint32_t* stamps;        // Last ray that tested each primitive
+    uint32_t ray_count;
+    // Uniform grid, the primitives of cell c are items[first[c]] .. items[first[c + 1] - 1]
+    double origin_x;
+    double origin_y;
+    int width;
+    int height;
+    int* first;
+    int* items;
+} World;
+
+int world_load(World* world, const char* path);
+void world_free(World* world);
+
+// Distance to the first primitive along a ray from (x, y) in direction angle, up to max_range.
+// Returns max_range when nothing is hit; incidence is the angle between the ray and the surface normal.
+double world_cast(World* world, double x, double y, double angle, double max_range, double* incidence);
+// 1 when a disk of the given radius overlaps a primitive
+int world_collides(World* world, double x, double y, double radius);
+
+#endif
@@ -0,0 +1,158 @@
+/**
+Class         : CSC-615-01 - Embedded Linux - Fall 2024
+Team Name     : Wayno
+Github        : nhannguyensf
+Project       : Final Assignment - Robot Car
+File          : trace.c
+Description:
+This file contains the timeline tracer. Every thread gets its own event buffer the first time it traces, so
+recording an event is a clock read and three stores into memory only that thread writes. The buffers are rings
+that keep the latest TRACE_BUFFER_EVENTS events of each thread. trace_write turns them into Chrome trace event
+JSON with one track per thread; spans whose begin was already overwritten are left out.
+*
+Team Members:
+Kiran Poudel
+Nhan Nguyen
+Yuvraj Gupta
+Fernando Abel Malca Luque
+
+*
+**/
+#define _GNU_SOURCE
+#include "trace.h"
+
+#ifdef ENABLE_TRACING
+
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/syscall.h>
+#include <time.h>
+#include <unistd.h>
+
+typedef struct {
+    int64_t ts_ns;
+    const char* name;
+    double value;
+    char phase;  // 'B' begin, 'E' end, 'C' counter
+} TraceEvent;
+
+typedef struct {
+    int tid;
+    char name[32];
+    _Atomic uint32_t count;  // Events written so far, the ring index is count % TRACE_BUFFER_EVENTS
+    TraceEvent events[TRACE_BUFFER_EVENTS];
+} TraceBuffer;
+
+static TraceBuffer* buffers[TRACE_MAX_THREADS];
+static _Atomic int num_buffers = 0;
+static _Thread_local TraceBuffer* thread_buffer = NULL;
+static _Thread_local int thread_failed = 0;
+
+static int64_t now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (int64_t)ts.tv_sec * 1000000000LL + ts.tv_nsec;
+}
+
+// Buffer of the calling thread, allocated on its first event
+static TraceBuffer* get_buffer(void) {
+    if (thread_buffer || thread_failed) return thread_buffer;
+
+    int slot = atomic_fetch_add(&num_buffers, 1);
+    TraceBuffer* buffer = slot < TRACE_MAX_THREADS ? calloc(1, sizeof(TraceBuffer)) : NULL;
+    if (!buffer) {
+        thread_failed = 1;
+        return NULL;
+    }
+    buffer->tid = (int)syscall(SYS_gettid);
+    pthread_getname_np(pthread_self(), buffer->name, sizeof(buffer->name));
+    buffers[slot] = buffer;
+    thread_buffer = buffer;
+    return buffer;
+}
+
+static void add_event(char phase, const char* name, double value) {
+    TraceBuffer* buffer = get_buffer();
+    if (!buffer) return;
+    uint32_t count = atomic_load_explicit(&buffer->count, memory_order_relaxed);
+    TraceEvent* event = &buffer->events[count % TRACE_BUFFER_EVENTS];
+    event->ts_ns = now_ns();
+    event->name = name;
+    event->value = value;
+    event->phase = phase;
+    atomic_store_explicit(&buffer->count, count + 1, memory_order_release);
+}
+
+void trace_begin(const char* name) {
+    add_event('B', name, 0.0);
+}
+
+void trace_end(const char* name) {
+    add_event('E', name, 0.0);
+}
+
+void trace_counter(const char* name, double value) {
+    add_event('C', name, value);
+}
+
+void trace_thread_name(const char* name) {
+    TraceBuffer* buffer = get_buffer();
+    if (!buffer) return;
+    strncpy(buffer->name, name, sizeof(buffer->name) - 1);
+    buffer->name[sizeof(buffer->name) - 1] = '\0';
+}
+
+int trace_write(const char* path) {
+    FILE* out = fopen(path, "w");
+    if (!out) {
+        perror("trace: fopen");
+        return -1;
+    }
+
+    int pid = (int)getpid();
+    int first = 1;
+    fprintf(out, "{\"displayTimeUnit\": \"ns\", \"traceEvents\": [");
+
+    int count = atomic_load(&num_buffers);
+    if (count > TRACE_MAX_THREADS) count = TRACE_MAX_THREADS;
+    for (int i = 0; i < count; i++) {
+        TraceBuffer* buffer = buffers[i];
+        if (!buffer) continue;
+
+        fprintf(out, "%s\n{\"name\": \"thread_name\", \"ph\": \"M\", \"pid\": %d, \"tid\": %d, "
+                     "\"args\": {\"name\": \"%s\"}}", first ? "" : ",", pid, buffer->tid, buffer->name);
+        first = 0;
+
+        uint32_t end = atomic_load_explicit(&buffer->count, memory_order_acquire);
+        uint32_t start = end > TRACE_BUFFER_EVENTS ? end - TRACE_BUFFER_EVENTS : 0;
+        int depth = 0;
+        for (uint32_t n = start; n < end; n++) {
+            const TraceEvent* event = &buffer->events[n % TRACE_BUFFER_EVENTS];
+            double ts_us = event->ts_ns / 1000.0;
+            if (event->phase == 'C') {
+                fprintf(out, ",\n{\"name\": \"%s\", \"ph\": \"C\", \"ts\": %.3f, \"pid\": %d, \"tid\": %d, "
+                             "\"args\": {\"value\": %g}}", event->name, ts_us, pid, buffer->tid, event->value);
+                continue;
+            }
+            if (event->phase == 'B') {
+                depth++;
+            } else if (depth == 0) {
+                continue;  // Its begin was overwritten
+            } else {
+                depth--;
+            }
+            fprintf(out, ",\n{\"name\": \"%s\", \"ph\": \"%c\", \"ts\": %.3f, \"pid\": %d, \"tid\": %d}",
+                    event->name, event->phase, ts_us, pid, buffer->tid);
+        }
+    }
+
+    fprintf(out, "\n]}\n");
+    fclose(out);
+    return 0;
+}
+
+#endif
@@ -0,0 +1,58 @@
+/**
+Class         : CSC-615-01 - Embedded Linux - Fall 2024
+Team Name     : Wayno
+Github        : nhannguyensf
+Project       : Final Assignment - Robot Car
+File          : trace.h
+Description:
+This file is the header file for the trace.c file. It declares the timeline tracer: TRACE_BEGIN and TRACE_END
+mark a span on the calling thread, TRACE_COUNTER records a value over time. At exit the events of all threads
+are written in the Chrome trace event JSON format, which chrome://tracing and ui.perfetto.dev open directly.
+The tracer only exists when the code is built with ENABLE_TRACING (make TRACE=1); otherwise the macros and
+functions below compile to nothing. Span and counter names must be string literals.
+*
+Team Members:
+Kiran Poudel
+Nhan Nguyen
+Yuvraj Gupta
+Fernando Abel Malca Luque
+
+*
+**/
+#ifndef TRACE_H
+#define TRACE_H
+
+// Where the trace of a run goes
+#define TRACE_FILE "car_trace.json"
+
+#ifdef ENABLE_TRACING
+
+// Events kept per thread, older events are overwritten
+#define TRACE_BUFFER_EVENTS 65536
+// Maximum number of threads that can trace
+#define TRACE_MAX_THREADS 16
+
+void trace_begin(const char* name);
+void trace_end(const char* name);
+void trace_counter(const char* name, double value);
+// Name the calling thread in the timeline
+void trace_thread_name(const char* name);
+// Write the events of all threads, call it once the other threads have stopped
+int trace_write(const char* path);
+
+#define TRACE_BEGIN(name) trace_begin(name)
+#define TRACE_END(name) trace_end(name)
+#define TRACE_COUNTER(name, value) trace_counter(name, value)
+
+#else
+
+#define trace_thread_name(name) ((void)0)
+#define trace_write(path) 0
+#define TRACE_BEGIN(name) ((void)0)
+#define TRACE_END(name) ((void)0)
+// sizeof keeps the arguments referenced without evaluating them
+#define TRACE_COUNTER(name, value) ((void)sizeof(name), (void)sizeof(value))
+
+#endif
+
+#endif